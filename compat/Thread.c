@@ -69,11 +69,20 @@
  * Thread.h may include <pthread.h>
  * ------------------------------------------------------------------- */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // CPU_SET
+#endif
 #include "headers.h"
 
 #include "Thread.h"
 #include "Locale.h"
 #include "util.h"
+#if HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#if HAVE_DECL_CPU_SET
+#include <sched.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -105,6 +114,12 @@ void reporttype_text(struct ReportHeader *reporthdr, char *rs) {
     case SERVER_RELAY_REPORT:
 	strncpy(rs,"server", REPORTTXTMAX);
 	break;
+    case CONNECT_RATE_REPORT:
+	strncpy(rs,"connect rate", REPORTTXTMAX);
+	break;
+    case TRANSACTION_REPORT:
+	strncpy(rs,"transaction", REPORTTXTMAX);
+	break;
     default :
 	strncpy(rs,"unknown", REPORTTXTMAX);
     }
@@ -179,6 +194,16 @@ int nonterminating_num = 0;
 // condition to protect updating the above and alerting on
 // changes to above
 struct Condition thread_sNum_cond;
+#if HAVE_SYS_EVENTFD_H
+// eventfd signaled when a traffic thread ends (see thread_trafficdone_fd)
+static int thread_trfcdone_fd = -1;
+#endif
+static void thread_run(struct thread_Settings* thread);
+#if defined(HAVE_POSIX_THREAD)
+static bool thread_pool_dispatch(struct thread_Settings* thread);
+static bool thread_pool_stop(struct thread_Settings* thread);
+static void thread_pool_destroy(void);
+#endif
 
 
 /* -------------------------------------------------------------------
@@ -187,6 +212,9 @@ struct Condition thread_sNum_cond;
  * ------------------------------------------------------------------- */
 void thread_init() {
     Condition_Initialize(&thread_sNum_cond);
+#if HAVE_SYS_EVENTFD_H
+    thread_trfcdone_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
 #if defined(sun)
     /* Solaris apparently doesn't default to timeslicing threads,
      * as such we force it to play nice. This may not work perfectly
@@ -200,7 +228,16 @@ void thread_init() {
  * Destroy the thread subsystems variables.
  * ------------------------------------------------------------------- */
 void thread_destroy() {
+#if defined(HAVE_POSIX_THREAD)
+    thread_pool_destroy();
+#endif
     Condition_Destroy(&thread_sNum_cond);
+#if HAVE_SYS_EVENTFD_H
+    if (thread_trfcdone_fd >= 0) {
+	close(thread_trfcdone_fd);
+	thread_trfcdone_fd = -1;
+    }
+#endif
 }
 
 /* -------------------------------------------------------------------
@@ -232,8 +269,13 @@ void thread_start(struct thread_Settings* thread) {
         Condition_Unlock(thread_sNum_cond);
 
 #if defined(HAVE_POSIX_THREAD)
-        // pthreads -- spawn new thread
-        if (pthread_create(&thread->mTID, NULL, thread_run_wrapper, thread) != 0) {
+	// pthreads -- run in the traffic thread pool or spawn new thread
+	if (((thread->mThreadMode == kMode_Client) || (thread->mThreadMode == kMode_Server)) && \
+	    thread_pool_dispatch(thread)) {
+#if HAVE_THREAD_DEBUG
+	    thread_debug("Thread_start(%p mode=%x) to thread pool", (void *)thread, thread->mThreadMode);
+#endif
+	} else if (pthread_create(&thread->mTID, NULL, thread_run_wrapper, thread) != 0) {
             WARN(1, "pthread_create");
 
             // decrement thread count
@@ -318,6 +360,11 @@ void thread_stop(struct thread_Settings* thread) {
 
             // Cancel
 #if   defined(HAVE_POSIX_THREAD)
+            // a pool worker is replaced once its thread's cancelled (see thread_pool_respawn)
+            if (thread_pool_stop(thread)) {
+                Settings_Destroy(thread);
+                return;
+            }
             // Cray J90 doesn't have pthread_cancel; Iperf works okay without
 #ifdef HAVE_PTHREAD_CANCEL
             pthread_cancel(thread->mTID);
@@ -345,8 +392,24 @@ DWORD WINAPI
 void*
 #endif
 thread_run_wrapper(void* paramPtr) {
-    bool signal_on_exit = false;
     struct thread_Settings* thread = (struct thread_Settings*) paramPtr;
+#ifdef HAVE_POSIX_THREAD
+    // detach Thread. If someone already joined it will not do anything
+    // If none has then it will free resources upon return from this
+    // function (Run_Wrapper)
+    pthread_detach(pthread_self());
+#endif
+    thread_run(thread);
+    return 0;
+} // end run_wrapper
+
+/* -------------------------------------------------------------------
+ * Run the thread object's body in this thread, then decrement the thread
+ * count, start any runNext and destroy the object.  It's run by
+ * thread_run_wrapper or by a traffic thread pool worker.
+ * ------------------------------------------------------------------- */
+static void thread_run (struct thread_Settings* thread) {
+    bool signal_on_exit = false;
 
     // which type of object are we
     switch (thread->mThreadMode) {
@@ -383,13 +446,6 @@ thread_run_wrapper(void* paramPtr) {
             } break;
     }
 
-#ifdef HAVE_POSIX_THREAD
-    // detach Thread. If someone already joined it will not do anything
-    // If none has then it will free resources upon return from this
-    // function (Run_Wrapper)
-    pthread_detach(thread->mTID);
-#endif
-
     // decrement thread count and send condition signal
     Condition_Lock(thread_sNum_cond);
     thread_sNum--;
@@ -403,6 +459,16 @@ thread_run_wrapper(void* paramPtr) {
     if (thread->runNext != NULL) {
         thread_start(thread->runNext);
     }
+#if HAVE_SYS_EVENTFD_H
+    // wake a listener waiting for traffic threads to finish, after
+    // the runNext start so it's counted when the listener checks
+    if (signal_on_exit && (thread_trfcdone_fd >= 0)) {
+	uint64_t one = 1;
+	if (write(thread_trfcdone_fd, &one, sizeof(one)) < 0) {
+	    WARN_errno(errno != EAGAIN, "eventfd write");
+	}
+    }
+#endif
     // Destroy this thread object
     Settings_Destroy(thread);
     // signal the reporter thread now that thread state has changed
@@ -412,8 +478,203 @@ thread_run_wrapper(void* paramPtr) {
 	thread_debug("Signal sent to reporter thread");
 #endif
     }
-    return 0;
-} // end run_wrapper
+} // end thread_run
+
+#if defined(HAVE_POSIX_THREAD)
+/* -------------------------------------------------------------------
+ * Traffic thread pool (--thread-pool)
+ *
+ * Persistent workers that run the client and server thread bodies
+ * rather than a pthread_create per flow.  A thread is only handed to
+ * an idle worker, otherwise thread_start creates one as before, so the
+ * flows of a test always run concurrently.  The thread counts are
+ * maintained by thread_start and thread_run the same either way.  A
+ * thread takes its worker's id when dispatched so thread_stop can find
+ * it.  A worker whose thread is stopped (thread_stop per a FAIL exits
+ * or cancels it) is replaced by a new one in its place.
+ * ------------------------------------------------------------------- */
+struct ThreadPoolWorker {
+    pthread_t tid;
+    struct thread_Settings *job; // handed by thread_pool_dispatch
+    int running; // the job's thread_run has started
+};
+static struct {
+    struct Condition await;
+    struct ThreadPoolWorker *workers;
+    int size;
+    int idle;
+    int shutdown;
+    int pincpus;
+} thread_pool;
+static int thread_pool_active = 0;
+
+static void* thread_pool_worker(void *arg);
+
+// Start worker ix, called with the pool locked
+static int thread_pool_spawn (int ix) {
+    struct ThreadPoolWorker *worker = &thread_pool.workers[ix];
+    worker->job = NULL;
+    worker->running = 0;
+    if (pthread_create(&worker->tid, NULL, thread_pool_worker, (void *) (intptr_t) ix) != 0) {
+	WARN(1, "pthread_create thread pool");
+	worker->tid = thread_zeroid();
+	return 0;
+    }
+    // count it idle first, it may be handed a thread before it waits
+    thread_pool.idle++;
+    return 1;
+}
+
+// Cleanup handler of a worker whose thread exited or was cancelled, i.e. per thread_stop
+static void thread_pool_respawn (void *arg) {
+    int ix = (int) (intptr_t) arg;
+    Condition_Lock(thread_pool.await);
+    thread_pool.workers[ix].tid = thread_zeroid();
+    if (!thread_pool.shutdown)
+	thread_pool_spawn(ix);
+    Condition_Unlock(thread_pool.await);
+}
+
+static void* thread_pool_worker (void *arg) {
+    int ix = (int) (intptr_t) arg;
+    struct ThreadPoolWorker *worker = &thread_pool.workers[ix];
+    int oldstate;
+    pthread_detach(pthread_self());
+    // only the threads the worker runs can be cancelled, not its waits on the pool
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldstate);
+#if HAVE_DECL_CPU_SET
+    if (thread_pool.pincpus) {
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpus > 0) {
+	    cpu_set_t myset;
+	    CPU_ZERO(&myset);
+	    CPU_SET((int) (ix % ncpus), &myset);
+	    WARN_errno(sched_setaffinity(0, sizeof(myset), &myset) != 0, "sched_setaffinity");
+	}
+    }
+#endif
+    Condition_Lock(thread_pool.await);
+    while (1) {
+	while (!worker->job && !thread_pool.shutdown) {
+	    Condition_Wait(&thread_pool.await);
+	}
+	if (!worker->job)
+	    break;
+	struct thread_Settings *thread = worker->job;
+	worker->running = 1;
+	Condition_Unlock(thread_pool.await);
+	pthread_cleanup_push(thread_pool_respawn, arg);
+	pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &oldstate);
+	thread_run(thread);
+	// thread_stop no longer cancels the worker for this thread, act on a cancel that raced the end of its run
+	Condition_Lock(thread_pool.await);
+	worker->job = NULL;
+	Condition_Unlock(thread_pool.await);
+	pthread_testcancel();
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldstate);
+	pthread_cleanup_pop(0);
+	Condition_Lock(thread_pool.await);
+	worker->running = 0;
+	thread_pool.idle++;
+    }
+    worker->tid = thread_zeroid();
+    Condition_Unlock(thread_pool.await);
+    return NULL;
+}
+
+void thread_pool_init (int workers, int pincpus) {
+    if (thread_pool_active || (workers <= 0))
+	return;
+    thread_pool.workers = (struct ThreadPoolWorker *) calloc(workers, sizeof(struct ThreadPoolWorker));
+    if (!thread_pool.workers) {
+	WARN(1, "thread pool out of memory");
+	return;
+    }
+    Condition_Initialize(&thread_pool.await);
+    thread_pool.size = workers;
+    thread_pool.idle = 0;
+    thread_pool.shutdown = 0;
+    thread_pool.pincpus = pincpus;
+    thread_pool_active = 1;
+    int ix;
+    Condition_Lock(thread_pool.await);
+    for (ix = 0; ix < workers; ix++) {
+	if (!thread_pool_spawn(ix))
+	    break;
+    }
+    Condition_Unlock(thread_pool.await);
+}
+
+// Release the idle workers, busy ones exit after their thread
+static void thread_pool_destroy (void) {
+    if (thread_pool_active) {
+	Condition_Lock(thread_pool.await);
+	thread_pool.shutdown = 1;
+	Condition_Broadcast(&thread_pool.await);
+	Condition_Unlock(thread_pool.await);
+	thread_pool_active = 0;
+    }
+}
+
+// Hand a traffic thread to an idle worker, returns false if there isn't one
+static bool thread_pool_dispatch (struct thread_Settings* thread) {
+    bool dispatched = false;
+    if (thread_pool_active && !isRealtime(thread)) {
+	Condition_Lock(thread_pool.await);
+	if (thread_pool.idle > 0) {
+	    int ix;
+	    for (ix = 0; ix < thread_pool.size; ix++) {
+		struct ThreadPoolWorker *worker = &thread_pool.workers[ix];
+		if (!worker->job && !worker->running && !thread_equalid(worker->tid, thread_zeroid())) {
+		    worker->job = thread;
+		    thread->mTID = worker->tid;
+		    thread_pool.idle--;
+		    Condition_Broadcast(&thread_pool.await);
+		    dispatched = true;
+		    break;
+		}
+	    }
+	}
+	Condition_Unlock(thread_pool.await);
+    }
+    return dispatched;
+}
+
+/*
+ * Stop a pooled thread for thread_stop from another thread, a thread
+ * its worker hasn't started is taken back and a running one is
+ * cancelled, under the pool lock so the cancel can't land on the
+ * worker's next thread.  Returns false if thread isn't pooled
+ */
+static bool thread_pool_stop (struct thread_Settings* thread) {
+    bool stopped = false;
+    if (thread_pool_active) {
+	Condition_Lock(thread_pool.await);
+	int ix;
+	for (ix = 0; ix < thread_pool.size; ix++) {
+	    struct ThreadPoolWorker *worker = &thread_pool.workers[ix];
+	    if (worker->job == thread) {
+		if (!worker->running) {
+		    // the worker stays idle
+		    worker->job = NULL;
+		    thread_pool.idle++;
+		} else {
+#ifdef HAVE_PTHREAD_CANCEL
+		    pthread_cancel(worker->tid);
+#endif
+		}
+		stopped = true;
+		break;
+	    }
+	}
+	Condition_Unlock(thread_pool.await);
+    }
+    return stopped;
+}
+#else
+void thread_pool_init (int workers, int pincpus) {
+}
+#endif
 
 /* -------------------------------------------------------------------
  * Wait for all thread object's execution to complete. Depends on the
@@ -534,6 +795,20 @@ int thread_numtrafficthreads(void) {
     return thread_trfc_sNum;
 }
 
+/*
+ * A file descriptor readable (an eventfd) after a traffic thread ends
+ * or -1 when not supported.  It's for waiting on thread_numtrafficthreads
+ * without polling.  The reader drains it and should still use a timeout
+ * as one wake up is consumed by one reader.
+ */
+int thread_trafficdone_fd(void) {
+#if HAVE_SYS_EVENTFD_H
+    return thread_trfcdone_fd;
+#else
+    return -1;
+#endif
+}
+
 /* -------------------------------------------------------------------
  * Support for realtime scheduling of threads
  * ------------------------------------------------------------------- */
@@ -561,6 +836,222 @@ void thread_setscheduler(struct thread_Settings *thread) {
 #endif // SCHED
 }
 
+/* -------------------------------------------------------------------
+ * CPU affinity of the traffic and reporter threads (--affinity)
+ *
+ * Traffic threads take the cpus of the list round robin in the order
+ * they start.  Per auto the list is the cpus of the numa node of the
+ * bound device, read from sysfs, and the reporter runs on that node
+ * too.  A traffic thread pins itself before it allocates its buffer
+ * and packet ring so, per first touch, their pages are node local.
+ * ------------------------------------------------------------------- */
+#if HAVE_DECL_CPU_SET
+static struct {
+    int *cpus;
+    int count;
+    int next;
+    Mutex lock;
+    cpu_set_t reporter;
+    char placement[256];
+} thread_affinity;
+
+// parse a cpu list, e.g. 0-3,8,10-11, the format of sysfs and taskset -c
+static int thread_cpulist_parse (const char *list, cpu_set_t *set) {
+    const char *cur = list;
+    CPU_ZERO(set);
+    while (*cur && (*cur != '\n')) {
+	char *end;
+	long first = strtol(cur, &end, 10);
+	long last = first;
+	if (end == cur)
+	    return -1;
+	if (*end == '-') {
+	    cur = end + 1;
+	    last = strtol(cur, &end, 10);
+	    if (end == cur)
+		return -1;
+	}
+	if ((first < 0) || (last < first) || (last >= CPU_SETSIZE))
+	    return -1;
+	for (long cpu = first; cpu <= last; cpu++) {
+	    CPU_SET(cpu, set);
+	}
+	cur = end;
+	if (*cur == ',')
+	    cur++;
+	else if (*cur && (*cur != '\n'))
+	    return -1;
+    }
+    return CPU_COUNT(set);
+}
+
+static void thread_cpulist_sprint (cpu_set_t *set, char *buf, size_t len) {
+    size_t n = 0;
+    buf[0] = '\0';
+    for (int cpu = 0; (cpu < CPU_SETSIZE) && (n < len); cpu++) {
+	if (!CPU_ISSET(cpu, set))
+	    continue;
+	int last = cpu;
+	while (((last + 1) < CPU_SETSIZE) && CPU_ISSET(last + 1, set))
+	    last++;
+	if (last > cpu)
+	    n += snprintf(buf + n, len - n, "%s%d-%d", (n ? "," : ""), cpu, last);
+	else
+	    n += snprintf(buf + n, len - n, "%s%d", (n ? "," : ""), cpu);
+	cpu = last;
+    }
+}
+
+static int thread_device_numa_node (const char *device, cpu_set_t *set) {
+    char path[128];
+    char cpulist[1024];
+    int node = -1;
+    FILE *fp;
+    snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", device);
+    if ((fp = fopen(path, "r")) != NULL) {
+	if (fscanf(fp, "%d", &node) != 1)
+	    node = -1;
+	fclose(fp);
+    }
+    if (node < 0)
+	return -1;
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if ((fp = fopen(path, "r")) == NULL)
+	return -1;
+    if (!fgets(cpulist, sizeof(cpulist), fp) || (thread_cpulist_parse(cpulist, set) <= 0))
+	node = -1;
+    fclose(fp);
+    return node;
+}
+
+int thread_affinity_init (const char *traffic, const char *reporter, const char *device) {
+    cpu_set_t online, set, unavail;
+    char tbuf[96] = "";
+    char rbuf[96] = "";
+    char where[64] = "";
+    if (sched_getaffinity(0, sizeof(online), &online) != 0) {
+	WARN_errno(1, "sched_getaffinity");
+	return -1;
+    }
+    CPU_ZERO(&thread_affinity.reporter);
+    if (traffic) {
+	if (strcmp(traffic, "auto") == 0) {
+	    int node;
+	    if (!device) {
+		fprintf(stderr, "ERROR: --affinity auto requires a bound device, e.g. -c <host>%%<dev> or -B <ip>%%<dev>\n");
+		return -1;
+	    }
+	    if ((node = thread_device_numa_node(device, &set)) < 0) {
+		// e.g. a virtual device or a system without numa
+		fprintf(stderr, "WARN: no numa node found for device %s, using all cpus\n", device);
+		set = online;
+		snprintf(where, sizeof(where), " (%s has no numa node)", device);
+	    } else {
+		CPU_AND(&set, &set, &online);
+		snprintf(where, sizeof(where), " (numa node %d of %s)", node, device);
+	    }
+	    if (!reporter)
+		thread_affinity.reporter = set;
+	} else if (thread_cpulist_parse(traffic, &set) <= 0) {
+	    fprintf(stderr, "ERROR: invalid --affinity cpu list %s, expected e.g. 0-3,8 or auto\n", traffic);
+	    return -1;
+	}
+	CPU_XOR(&unavail, &set, &online);
+	CPU_AND(&unavail, &unavail, &set);
+	if (CPU_COUNT(&unavail) || !CPU_COUNT(&set)) {
+	    thread_cpulist_sprint(&unavail, tbuf, sizeof(tbuf));
+	    fprintf(stderr, "ERROR: --affinity cpu(s) %s not available\n", (tbuf[0] ? tbuf : traffic));
+	    return -1;
+	}
+	thread_affinity.count = CPU_COUNT(&set);
+	thread_affinity.cpus = (int *) calloc(thread_affinity.count, sizeof(int));
+	if (!thread_affinity.cpus) {
+	    WARN(1, "affinity out of memory");
+	    return -1;
+	}
+	int ix = 0;
+	for (int cpu = 0; (cpu < CPU_SETSIZE) && (ix < thread_affinity.count); cpu++) {
+	    if (CPU_ISSET(cpu, &set))
+		thread_affinity.cpus[ix++] = cpu;
+	}
+	thread_cpulist_sprint(&set, tbuf, sizeof(tbuf));
+    }
+    if (reporter) {
+	if (thread_cpulist_parse(reporter, &thread_affinity.reporter) <= 0) {
+	    fprintf(stderr, "ERROR: invalid --reporter-affinity cpu list %s, expected e.g. 4 or 4-5\n", reporter);
+	    return -1;
+	}
+	CPU_AND(&set, &thread_affinity.reporter, &online);
+	if (!CPU_EQUAL(&set, &thread_affinity.reporter)) {
+	    fprintf(stderr, "ERROR: --reporter-affinity cpu(s) %s not available\n", reporter);
+	    return -1;
+	}
+    }
+    thread_cpulist_sprint(&thread_affinity.reporter, rbuf, sizeof(rbuf));
+    snprintf(thread_affinity.placement, sizeof(thread_affinity.placement), "CPU affinity:%s%s%s%s%s%s\n", \
+	     (tbuf[0] ? " traffic threads round robin on cpus " : ""), tbuf, where, \
+	     ((tbuf[0] && rbuf[0]) ? "," : ""), (rbuf[0] ? " reporter on cpus " : ""), rbuf);
+    thread_affinity.next = 0;
+    Mutex_Initialize(&thread_affinity.lock);
+    return 0;
+}
+
+void thread_affinity_destroy (void) {
+    if (thread_affinity.placement[0]) {
+	Mutex_Destroy(&thread_affinity.lock);
+	FREE_ARRAY(thread_affinity.cpus);
+	thread_affinity.count = 0;
+	thread_affinity.placement[0] = '\0';
+    }
+}
+
+int thread_setaffinity (struct thread_Settings *thread) {
+    int rc = -1;
+    if (isIncomingCPU(thread) && (thread->mIncomingCPU >= 0)) {
+	// --incoming-cpu, a server thread follows its flow's RX queue
+	cpu_set_t myset;
+	CPU_ZERO(&myset);
+	CPU_SET(thread->mIncomingCPU, &myset);
+	rc = sched_setaffinity(0, sizeof(myset), &myset);
+	WARN_errno(rc != 0, "sched_setaffinity");
+    } else if (isAffinity(thread) && (thread_affinity.count > 0)) {
+	cpu_set_t myset;
+	Mutex_Lock(&thread_affinity.lock);
+	int cpu = thread_affinity.cpus[thread_affinity.next++ % thread_affinity.count];
+	Mutex_Unlock(&thread_affinity.lock);
+	CPU_ZERO(&myset);
+	CPU_SET(cpu, &myset);
+	rc = sched_setaffinity(0, sizeof(myset), &myset);
+	WARN_errno(rc != 0, "sched_setaffinity");
+    }
+    return rc;
+}
+
+void thread_setaffinity_reporter (struct thread_Settings *thread) {
+    if (isAffinity(thread) && CPU_COUNT(&thread_affinity.reporter)) {
+	WARN_errno(sched_setaffinity(0, sizeof(thread_affinity.reporter), &thread_affinity.reporter) != 0, "sched_setaffinity");
+    }
+}
+
+const char *thread_affinity_placement (void) {
+    return (thread_affinity.placement[0] ? thread_affinity.placement : NULL);
+}
+#else
+int thread_affinity_init (const char *traffic, const char *reporter, const char *device) {
+    return 0;
+}
+void thread_affinity_destroy (void) {
+}
+int thread_setaffinity (struct thread_Settings *thread) {
+    return -1;
+}
+void thread_setaffinity_reporter (struct thread_Settings *thread) {
+}
+const char *thread_affinity_placement (void) {
+    return NULL;
+}
+#endif
+
 /*
  * -------------------------------------------------------------------
  * Allow another thread to execute. If no other threads are runable this
@@ -96,6 +96,36 @@ private:
     bool InProgress(void);
     void PostNullEvent(void);
     void AwaitServerCloseEvent(void);
+#if HAVE_SYS_EPOLL_H
+    void ConnectRate(void);
+    bool connect_rate_start(int efd, struct ConnectSlot *slot, int slotid);
+    void connect_rate_done(struct ConnectSlot *slot, int err);
+    struct ConnectRateInfo myConnectRate[2];
+    void RunTcpRR(void);
+    int tcprr_connect(void);
+    bool tcprr_write(struct RRConn *conn);
+    bool tcprr_read(struct RRConn *conn);
+    void tcprr_done(struct RRConn *conn);
+    bool tcprr_service(int efd, struct RRConn *conn, int connid, bool readable);
+    bool rr_running;
+    int rr_outstanding;
+    uint32_t rr_burst_id;
+    Timestamp rr_next;
+    void RunFlows(void);
+    bool flows_next(struct RRConn *conn);
+    void flows_done(struct RRConn *conn);
+    bool flows_connect(int efd, struct RRConn *conn, int connid);
+    bool flows_connected(int efd, struct RRConn *conn, int connid);
+    struct FlowInfo myFlows[2];
+    intmax_t flows_queued;
+    intmax_t flows_samplesize;
+#endif
+    void RunUDPEcho(void);
+    int udpecho_send(struct UDPEcho *echo, int count);
+    int udpecho_recv(struct UDPEcho *echo);
+    struct TransactionInfo myTransactions[2];
+    void rpm_phase(double elapsed);
+    Timestamp rpm_epoch;
     bool connected;
     ReportStruct scratchpad;
     ReportStruct *reportstruct;
@@ -123,6 +153,9 @@ private:
     void RunUDP(void);
     // client connect
     void PeerXchange(void);
+    void PostConnectionReport(double connecttime);
+    int SendFirstPayloadTFO(int len);
+    bool tfo_deferred;
     thread_Settings *mSettings;
 #if WIN32
     SOCKET mySocket;
@@ -131,6 +164,8 @@ private:
 #endif
     struct ReporterData *myReport;
     char* mBuf;
+    char* verifyPattern; // --payload-verify, see payload_verify.h
+    uintmax_t verifyOffset;
     Timestamp mEndTime;
     Timestamp lastPacketTime;
     Timestamp now;
@@ -60,6 +60,8 @@
 #include "Timestamp.hpp"
 
 class Listener;
+struct UDPDemuxTable;
+struct UDPDemuxFlow;
 
 class Listener {
 public:
@@ -80,6 +82,8 @@ private:
     thread_Settings *mSettings;
     thread_Settings *server;
     Timestamp mEndTime;
+    int mEpollFd;
+    int mTimerFd;
     bool apply_client_settings_udp(thread_Settings *server);
     bool apply_client_settings_tcp(thread_Settings *server);
     bool apply_client_settings(thread_Settings *server);
@@ -90,6 +94,18 @@ private:
     int udp_accept(thread_Settings *server);
     bool L2_setup(thread_Settings *server, int sockfd);
     void UDPSingleServer(thread_Settings *server);
+    void epoll_setup(void);
+    int epoll_timedwait(struct timeval *timeout);
+    bool wait_listen_socket(struct timeval *timeout);
+    void wait_traffic_done(unsigned long delay);
+    void start_listeners(void);
+    void listener_affinity(void);
+    void udp_demux(bool mMode_Time);
+    struct UDPDemuxFlow *udp_demux_newflow(iperf_sockaddr *peer, Socklen_t size_peer, char *buf, int rxlen, struct timeval *rxtime);
+    intmax_t udp_demux_packetid(struct UDPDemuxFlow *flow, char *buf);
+    void udp_demux_packet(struct UDPDemuxFlow *flow, char *buf, int rxlen, struct timeval *rxtime);
+    void udp_demux_endflow(struct UDPDemuxFlow *flow, struct timeval *endtime);
+    void udp_demux_freeflow(struct UDPDemuxFlow *flow);
     bool test_permit_key(uint32_t flags, thread_Settings *server, int keyoffset);
 #if WIN32
     SOCKET ListenSocket;
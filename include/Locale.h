@@ -143,6 +143,8 @@ extern const char client_fq_pacing[];
  * Legacy reports
  * ------------------------------------------------------------------- */
 
+extern const char scenario_group_start[];
+
 extern const char report_bw_header[];
 
 extern const char report_sumcnt_bw_header[];
@@ -173,6 +175,12 @@ extern const char client_write_size[];
 
 extern const char server_read_size[];
 
+extern const char report_incoming_cpu[];
+
+extern const char report_incoming_cpu_napi[];
+
+extern const char report_busypoll[];
+
 extern const char report_bw_enhanced_format[];
 
 extern const char report_write_enhanced_isoch_format[];
@@ -281,6 +289,40 @@ extern const char report_sumcnt_udp_fullduplex_header[];
 
 extern const char report_sumcnt_udp_fullduplex_format[];
 
+/* -------------------------------------------------------------------
+ * Interval series (deferred interval) reports
+ * ------------------------------------------------------------------- */
+
+extern const char report_interval_series_header[];
+
+extern const char report_interval_series_format[];
+
+extern const char report_interval_series_write[];
+
+extern const char report_interval_series_tcpinfo[];
+
+extern const char report_interval_series_datagrams[];
+
+extern const char report_interval_series_read[];
+
+extern const char report_interval_series_udp_read[];
+
+extern const char report_interval_series_latency[];
+
+extern const char report_interval_series_json_format[];
+
+extern const char report_interval_series_json_write[];
+
+extern const char report_interval_series_json_tcpinfo[];
+
+extern const char report_interval_series_json_datagrams[];
+
+extern const char report_interval_series_json_read[];
+
+extern const char report_interval_series_json_udp_read[];
+
+extern const char report_interval_series_json_latency[];
+
 /* -------------------------------------------------------------------
  * Misc reports
  * ------------------------------------------------------------------- */
@@ -291,6 +333,12 @@ extern const char report_sumcnt_outoforder[];
 
 extern const char report_l2statistics[];
 
+extern const char report_payloadverify[];
+
+extern const char report_seqwindow[];
+
+extern const char report_lossruns[];
+
 extern const char report_sum_outoforder[];
 
 extern const char report_peer[];
@@ -307,6 +355,8 @@ extern const char report_datagrams[];
 
 extern const char report_sumcnt_datagrams[];
 
+extern const char report_sumlabel_datagrams[];
+
 extern const char report_sum_datagrams[];
 
 extern const char server_reporting[];
@@ -61,6 +61,8 @@
 // forward declarations found in Settings.hpp
 struct thread_Settings;
 struct server_hdr;
+struct IntervalSeries;
+struct PacketTrace;
 
 #include "Settings.hpp"
 
@@ -149,6 +151,10 @@ struct WriteStats {
 #define L2UNKNOWN  0x01
 #define L2LENERR   0x02
 #define L2CSUMERR  0x04
+#define L2ERRORS   (L2UNKNOWN | L2LENERR | L2CSUMERR)
+// --payload-verify, the read was checked and whether it matched
+#define L2PAYLOADCHK 0x08
+#define L2PAYLOADERR 0x10
 
 enum WriteErrType {
     WriteNoErr  = 0,
@@ -166,6 +172,67 @@ struct L2Stats {
     intmax_t tot_unknown;
     intmax_t tot_udpcsumerr;
     intmax_t tot_lengtherr;
+    intmax_t payloadchk;
+    intmax_t payloaderr;
+    intmax_t tot_payloadchk;
+    intmax_t tot_payloaderr;
+};
+
+/*
+ * Sliding sequence window for UDP servers (enhanced reports), one bit
+ * per packet id behind the highest id received.  A packet id below the
+ * highest is then either a duplicate (bit already set) or a late
+ * arrival (a loss that got recovered.)  Reorder distance is the
+ * highest id minus the late id, binned log2, the last bin being
+ * beyond the window.
+ */
+#define SEQWINDOW_BITS 4096
+#define SEQWINDOW_REORDERBINS 13
+struct SeqWindow {
+    uint64_t bitmap[SEQWINDOW_BITS / 64];
+    intmax_t head; // highest packet id received
+    intmax_t dups;
+    intmax_t late;
+    intmax_t beyond;
+    intmax_t maxreorder;
+    intmax_t reorder[SEQWINDOW_REORDERBINS];
+    intmax_t tot_dups;
+    intmax_t tot_late;
+    intmax_t tot_beyond;
+    intmax_t tot_maxreorder;
+    intmax_t tot_reorder[SEQWINDOW_REORDERBINS];
+};
+
+/*
+ * Loss run (burst) and gap (run of received packets between loss runs)
+ * statistics for UDP servers (enhanced reports), in packet id order.  An
+ * id is counted as received or lost once it's LOSSRUN_SETTLE behind the
+ * highest id (per the sequence window's bitmap) so late packets within
+ * that reorder window aren't taken as loss.  The final report counts the
+ * rest.  These also give a fit of the (two state) Gilbert-Elliott
+ * model with a lossless good state and a lossy bad state, i.e.
+ * p = P(good->bad) = runs / received and r = P(bad->good) = runs / lost
+ */
+#define LOSSRUN_BINS 12 // log2 bins, the last is 2048 and up
+#define LOSSRUN_SETTLE 256 // must be less than SEQWINDOW_BITS
+struct LossRunCounters {
+    intmax_t runs;
+    intmax_t lost;
+    intmax_t maxrun;
+    intmax_t received;
+    intmax_t gaps;
+    intmax_t gapsum;
+    intmax_t mingap;
+    intmax_t maxgap;
+    intmax_t bins[LOSSRUN_BINS];
+};
+
+struct LossRuns {
+    intmax_t goodrun; // received packets since the last loss run
+    intmax_t lossrun; // lost packets of a run yet to end
+    intmax_t settled; // the highest packet id counted
+    struct LossRunCounters interval;
+    struct LossRunCounters total;
 };
 
 /*
@@ -177,7 +244,10 @@ enum ReportType {
     SUM_REPORT,
     SETTINGS_REPORT,
     CONNECTION_REPORT,
-    SERVER_RELAY_REPORT
+    SERVER_RELAY_REPORT,
+    CONNECT_RATE_REPORT,
+    TRANSACTION_REPORT,
+    FLOW_REPORT
 };
 
 enum ReportSubType {
@@ -220,6 +290,7 @@ struct ReportCommon {
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
     int WritePrefetch;
 #endif
+    int BusyPoll;
     int winsize_requested;
     unsigned int FQPacingRate;
     int HistBins;
@@ -266,6 +337,95 @@ struct ConnectionInfo {
     char peerversion[PEERVERBUFSIZE];
     struct MeanMinMaxStats connect_times;
     int MSS;
+    int tfo; // data in the SYN was acked, -1 is unknown
+    int incoming_cpu; // --incoming-cpu, -1 is unknown
+    unsigned int napi_id;
+};
+
+// Connect failure classes of the --connect-rate engine
+enum ConnectFail {
+    CONNECTFAIL_REFUSED = 0,
+    CONNECTFAIL_TIMEOUT,
+    CONNECTFAIL_UNREACH,
+    CONNECTFAIL_RESET,
+    CONNECTFAIL_LOCAL,
+    CONNECTFAIL_OTHER,
+    CONNECTFAIL_MAX
+};
+
+struct ConnectRateInfo {
+    int transferID;
+    int final;
+    int threads;
+    double iStart;
+    double iEnd;
+    double rate; // offered rate, zero is closed loop
+    intmax_t tries;
+    intmax_t overruns; // open loop arrivals with every connect slot busy
+    intmax_t fails[CONNECTFAIL_MAX];
+    struct MeanMinMaxStats connect_times; // units ms
+    struct histogram *latency_histogram; // final reports only
+    int histogram_pdf; // also output the histogram per --histograms
+};
+
+struct TransactionInfo {
+    int transferID;
+    int final;
+    int threads;
+    double iStart;
+    double iEnd;
+    int request;
+    int response;
+    int depth; // requests in flight per connection
+    int conns;
+    intmax_t requests; // requests written
+    struct MeanMinMaxStats rtt; // units ms, a count of completed transactions
+    struct histogram *latency_histogram;
+    int histogram_pdf;
+    int udpecho; // --udp-echo, the requests are probes and the transactions their echoes
+    intmax_t fwd_lost; // client to server per the echoes
+    intmax_t fwd_outoforder;
+    intmax_t rev_lost; // server to client per the echo ids
+    intmax_t rev_outoforder;
+    int rpm; // --rpm probe, 1 while idle and 2 once the bulk flows run
+    struct MeanMinMaxStats idle_rtt; // units ms, the idle baseline
+    struct histogram *idle_histogram;
+};
+
+// --rpm, the probe's idle and loaded rtts output with the bulk flows' final sum
+struct RPMInfo {
+    int probe; // the probe's final is in
+    int bulk; // the bulk flows' final is out
+    double idle; // mean rtts, units ms
+    double loaded;
+    double iStart; // the bulk flows' loaded period
+    double iEnd;
+    char id[64]; // of the bulk flows' final, e.g. [SUM]
+};
+
+// --flows, one per completed flow
+struct FlowSample {
+    double fct; // units seconds
+    int size;
+};
+
+struct FlowInfo {
+    int transferID;
+    int final;
+    double iStart;
+    double iEnd;
+    double load; // offered, a fraction of the link rate
+    double linkrate; // units bits per second
+    int pool; // connections of the pool, zero is a fresh connection per flow
+    int periodic;
+    intmax_t arrivals;
+    intmax_t done;
+    intmax_t overruns; // arrivals with no connection to take them
+    intmax_t fails; // connects or flows which failed, or didn't complete
+    intmax_t bytes; // of the completed flows
+    struct MeanMinMaxStats fct; // units ms
+    struct FlowSample *samples; // the final report's completed flows
+    intmax_t samplecnt;
 };
 
 struct ShiftIntCounter {
@@ -282,6 +442,7 @@ struct ShiftCounters {
     struct ShiftUintCounter Bytes;
     struct ShiftIntCounter Lost;
     struct ShiftIntCounter OutofOrder;
+    struct ShiftIntCounter Recovered; // UDP sums, the flows' lost packets which arrived late
     struct ShiftIntCounter Datagrams;
     struct ShiftIntCounter IPG;
 };
@@ -325,6 +486,7 @@ struct ReportTimeStamps {
     double iStart;
     double iEnd;
     double significant_partial;
+    double startOffset; // startTime on a shared report clock, e.g. --scenario's
     struct timeval startTime;
     struct timeval matchTime;
     struct timeval packetTime;
@@ -338,6 +500,21 @@ struct ReportTimeStamps {
 #endif
 };
 
+// --busy-poll read times, set by the server thread before its final packet
+struct BusyPollStats {
+    double spin; // in the spinning peeks waiting for data
+    double recv; // in the reads
+    uintmax_t polls; // peeks that found nothing
+};
+
+// --incoming-cpu of a UDP flow, known only after its first reads, set by the server thread
+struct IncomingCPUStats {
+    bool found;
+    bool pinned; // the server thread's affinity was set to the cpu
+    int cpu;
+    unsigned int napi_id;
+};
+
 struct TransferInfo {
     struct ReportCommon *common;
     struct ReportTimeStamps ts;
@@ -362,12 +539,18 @@ struct TransferInfo {
     struct histogram *framelatency_histogram;
     struct TransitStats frame;
     struct L2Stats l2counts;
+    struct SeqWindow *seqwindow;
+    struct LossRuns *lossruns;
+    struct IntervalSeries *series; // deferred interval output, see interval_series.h
+    struct BusyPollStats busypoll;
+    struct IncomingCPUStats incomingcpu;
     // Packet and frame state info
     uint32_t matchframeID;
     uint32_t frameID;
     char csv_peer[CSVPEERLIMIT];
     bool final;
     bool burstid_transition;
+    bool labeled; // a --scenario group sum, see InitGroupSumReport()
 };
 
 struct SumReport {
@@ -377,6 +560,14 @@ struct SumReport {
     void (*transfer_protocol_sum_handler) (struct TransferInfo *stats, int final);
     struct BarrierMutex fullduplex_barrier;
     int sum_fd_set;
+    int tableheld; // held by an active host table entry
+    int finished; // final sum output done
+    // --scenario, a group sum adds to the scenario wide sum, its parent
+    struct SumReport *parent;
+    uintmax_t parent_bytes; // totals already added to the parent
+    struct WriteStats parent_write;
+    struct SumReport **groups; // scenario wide sum, the group sums yet to finish
+    int groupcnt;
 };
 
 struct ReporterData {
@@ -387,7 +578,11 @@ struct ReporterData {
     int (*transfer_interval_handler) (struct ReporterData *data, struct ReportStruct *packet);
 
     struct PacketRing *packetring;
+    struct PacketTrace *trace; // --trace-file, written by the traffic thread
     int reporter_thread_suspends; // used to detect CPU bound systems
+    // stateless reports of the traffic thread, e.g. --tcp-rr's, output in order with this one
+    struct ReportHeader *inorder_head;
+    struct ReportHeader *inorder_tail;
 
     // group sum and full duplext reports
     struct SumReport *GroupSumReport;
@@ -417,12 +612,21 @@ typedef void (* report_serverstatistics)( struct ConnectionInfo *, struct Transf
 
 void SetSumHandlers (struct thread_Settings *inSettings, struct SumReport* sumreport);
 struct SumReport* InitSumReport(struct thread_Settings *inSettings, int inID, int fullduplex);
+struct SumReport* InitScenarioSumReport(struct thread_Settings *inSettings, int groups, struct timeval *start);
+struct SumReport* InitGroupSumReport(struct thread_Settings *inSettings, int inID, const char *label, struct SumReport *parent);
 struct ReportHeader* InitIndividualReport(struct thread_Settings *inSettings);
 struct ReportHeader* InitConnectionReport(struct thread_Settings *inSettings, double ct);
 struct ConnectionInfo* InitConnectOnlyReport(struct thread_Settings *thread);
 struct ReportHeader *InitSettingsReport(struct thread_Settings *inSettings);
 struct ReportHeader* InitServerRelayUDPReport(struct thread_Settings *inSettings, struct server_hdr *server);
+struct ReportHeader* InitConnectRateReport(struct thread_Settings *inSettings, struct ConnectRateInfo *stats);
+void ConnectRateStatsReset(struct ConnectRateInfo *stats);
+struct ReportHeader* InitTransactionReport(struct thread_Settings *inSettings, struct TransactionInfo *stats);
+void TransactionStatsReset(struct TransactionInfo *stats);
+struct ReportHeader* InitFlowReport(struct thread_Settings *inSettings, struct FlowInfo *stats);
+void FlowStatsReset(struct FlowInfo *stats);
 void PostReport(struct ReportHeader *reporthdr);
+void PostReportInOrder(struct ReporterData *data, struct ReportHeader *reporthdr);
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
 bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet, struct tcp_info *tcp_stats);
 #else
@@ -432,11 +636,17 @@ int EndJob(struct ReportHeader *reporthdr,  struct ReportStruct *packet);
 void FreeReport(struct ReportHeader *reporthdr);
 void FreeSumReport (struct SumReport *sumreport);
 void FreeConnectionReport(struct ConnectionInfo *reporthdr);
+void FreeConnectRateReport(struct ConnectRateInfo *report);
+void FreeTransactionReport(struct TransactionInfo *report);
+void FreeFlowReport(struct FlowInfo *report);
 void ReportServerUDP(struct thread_Settings *inSettings, struct server_hdr *server);
 void ReportConnections(struct thread_Settings *inSettings );
 void reporter_dump_job_queue(void);
 void IncrSumReportRefCounter(struct SumReport *sumreport);
 int DecrSumReportRefCounter(struct SumReport *sumreport);
+void HoldSumReport(struct SumReport *sumreport);
+void ReleaseSumReport(struct SumReport *sumreport);
+int FinishSumReport(struct SumReport *sumreport);
 
 extern struct AwaitMutex reporter_state;
 extern struct AwaitMutex threads_start;
@@ -549,8 +759,16 @@ void reporter_peerversion (struct ConnectionInfo *report, uint32_t upper, uint32
 void PrintMSS(struct ReporterData *data);
 void reporter_default_heading_flags(int);
 void reporter_connect_printf_tcp_final(struct ConnectionInfo *report);
+void reporter_print_connect_rate_report(struct ConnectRateInfo *report);
+void reporter_print_transaction_report(struct TransactionInfo *report);
+void reporter_print_flow_report(struct FlowInfo *report);
+void reporter_print_rpm_report(struct RPMInfo *report);
+void reporter_print_busypoll_report(struct TransferInfo *stats);
+void reporter_print_incomingcpu_report(struct TransferInfo *stats);
+void reporter_print_payloadverify_report(struct TransferInfo *stats);
 
 void write_UDP_AckFIN(struct TransferInfo *stats);
+void sendto_UDP_AckFIN(struct TransferInfo *stats);
 
 int reporter_process_transfer_report (struct ReporterData *this_ireport);
 int reporter_process_report (struct ReportHeader *reporthdr);
@@ -59,6 +59,9 @@
 #include "util.h"
 #include "Timestamp.hpp"
 
+// reads of a UDP flow to look for its receive cpu (--incoming-cpu)
+#define INCOMINGCPU_TRIES 8
+
 /* ------------------------------------------------------------------- */
 class Server {
 public:
@@ -77,6 +80,8 @@ private:
     thread_Settings *mSettings;
     char* mBuf;
     int mBufLen;
+    char* verifyPattern; // --payload-verify, see payload_verify.h
+    uintmax_t verifyOffset;
     Timestamp mEndTime;
     Timestamp now;
     ReportStruct scratchpad;
@@ -87,14 +92,22 @@ private:
     inline void SetFullDuplexReportStartTime(void);
     inline void SetReportStartTime();
     int ReadWithRxTimestamp(void);
-    bool ReadPacketID(void);
+    bool ReadPacketID(char *buf);
+    void RunUDPEcho(void);
+    void IncomingCPU(void);
+    void BusyPollSpin(void);
+    void BusyPollRead(void);
+    void FinishUDP(void);
     void L2_processing(void);
     int L2_quintuple_filter(void);
     void udp_isoch_processing(int);
     bool InProgress(void);
+    bool WriteTcpRRResponse(struct TCP_burst_payload *request);
     int SkipFirstPayload(void);
     Timestamp connect_done;
     bool peerclose;
+    int incomingcpu_tries;
+    struct timespec busypoll_mark; // end of the spin, start of the read
     bool isburst;
 #if WIN32
     SOCKET mySocket;
@@ -79,6 +79,8 @@ extern "C" {
 #define SMALLEST_INTERVAL 100 // 100 usec
 #define SMALLEST_INTERVAL_SEC 0.0001 // 5ms
 #endif
+// Deferred output (--interval-series) supports smaller intervals
+#define SMALLEST_SERIES_INTERVAL 100 // 100 usec
 
 #define SLOPSECS 2
 // maximum  difference allowed between the tx (client) start time and the
@@ -95,6 +97,24 @@ extern "C" {
 #define NEARCONGEST_DEFAULT 0.5
 #define DEFAULT_PERMITKEY_LIFE 20.0 // units is seconds
 #define TESTEXCHANGETIMEOUT (4 * 1000000) // 4 secs, units is microseconds
+#define CONNECTRATE_INFLIGHT 256 // default connects in flight per thread for --connect-rate
+#define CONNECTRATE_TIMEOUT 3.0 // units is seconds, allows for a SYN retransmit
+#define TFO_QUEUE_DEFAULT 256 // listener's queue of pending TFO connects
+#define BUSYPOLL_DEFAULT 50 // --busy-poll usecs
+#define BUSYPOLL_SPINMAX 0.1 // seconds a spin waits before the blocking read
+#define TCPRR_DRAIN_TIMEOUT 1.0 // units is seconds, wait for outstanding responses at the end of a --tcp-rr test
+#define UDPECHO_DRAIN_TIMEOUT 0.5 // units is seconds, wait for outstanding echoes at the end of a --udp-echo test
+#define UDPECHO_BATCH 64 // probes or echoes per sendmmsg/recvmmsg of --udp-echo
+#define RPM_PROBE_RATE 100 // default probes per second of --rpm
+#define RPM_IDLE_TIME 2.0 // default seconds of the --rpm idle baseline ahead of the bulk flows
+#define RPM_PROBE_TCP 0
+#define RPM_PROBE_UDP 1
+#define FLOWS_LOAD 0.5 // default --flow-load, a fraction of the -b link rate
+#define FLOWS_POISSON 0
+#define FLOWS_PERIODIC 1
+#define FLOWS_INFLIGHT 256 // fresh connections per thread at once of --flows
+#define FLOWS_QUEUE 256 // flows waiting or in flight per --flow-pool connection
+#define FLOWS_DRAIN_TIMEOUT 2.0 // units is seconds, wait for outstanding flows at the end of a --flows test
 #ifndef MAXTTL
 #define MAXTTL 255
 #endif
@@ -163,7 +183,13 @@ struct thread_Settings {
     char*  mSSMMulticastStr;        // --ssm-host
     char*  mIsochronousStr;         // --isochronous
     char*  mHistogramStr;         // --histograms (packets)
+    char*  mTraceFileName;          // --trace-file
+    char*  mFlowSizes;              // --flows, a CDF file or <kind>:<params>
+    char*  mScenario;               // --scenario file of flow groups
+    char*  mAffinity;               // --affinity cpu list or auto
+    char*  mReporterAffinity;       // --reporter-affinity cpu list
     char*  mTransferIDStr;          //
+    struct SettingsStrings* mStrings; // copy on write strings, see Settings_Copy
     FILE*  Extractor_file;
     struct ReportHeader* reporthdr;
     struct SumReport* mSumReport;
@@ -244,6 +270,19 @@ struct thread_Settings {
     int incrsrcip;
     int incrsrcport;
     int connectonly_count;
+    double mConnectRate; // --connect-rate
+    int mConnectInflight;
+    int mRRRequest; // --tcp-rr
+    int mRRResponse;
+    int mRRDepth; // requests in flight per connection
+    int mRRConns; // connections per traffic thread
+    double mRRRate; // requests per second, zero is closed loop (the --rpm probe)
+    int mRPMProbe; // --rpm, RPM_PROBE_TCP or RPM_PROBE_UDP
+    int mRPMRate; // probes per second
+    double mRPMIdle; // seconds of idle baseline
+    double mFlowLoad; // --flow-load, fraction of the -b link rate
+    int mFlowArrivals; // FLOWS_POISSON or FLOWS_PERIODIC
+    int mFlowPool; // --flow-pool connections, zero is a fresh connection per flow
     char* mCongestion;
     int mHistBins;
     int mHistBinsize;
@@ -263,13 +302,25 @@ struct thread_Settings {
     int recvflags; // used to set recv flags,e.g. MSG_TRUNC with L
     double mVariance; //vbr variance
     uintmax_t mFQPacingRate;
+    uintmax_t mTraceFileSize; // --trace-size
     struct timeval txholdback_timer;
     struct timeval txstart_epoch;
+    struct timeval rpm_load_epoch; // --rpm, when the bulk flows start
+    struct timeval report_epoch; // zero of the report times when shared by threads, e.g. --rpm's or --scenario's
     struct timeval accept_time;
     struct Condition awake_me;
     struct PacketRing *ackring;
     struct BarrierMutex *connects_done;
+    struct ScenarioGroup *mScenarioGroup; // --scenario, the flow group of the thread
     int numreportstructs;
+    int mDemuxThreads; // --udp-demux
+    int mListeners; // --listeners
+    int mListenerIndex;
+    int mThreadPool; // --thread-pool
+    int mTFOQueue; // --tcp-fastopen
+    int mIncomingCPU; // --incoming-cpu, SO_INCOMING_CPU of the accepted socket
+    unsigned int mNapiID; // and its SO_INCOMING_NAPI_ID
+    int mBusyPoll; // --busy-poll, SO_BUSY_POLL usecs
     int32_t peer_version_u;
     int32_t peer_version_l;
     double connecttime;
@@ -368,6 +419,23 @@ struct thread_Settings {
 #define FLAG_SMALLTRIPTIME  0x00000004
 #define FLAG_RXCLAMP        0x00000008
 #define FLAG_WRITEPREFETCH  0x00000010
+#define FLAG_INTERVALSERIES 0x00000020
+#define FLAG_SERIESJSON     0x00000040
+#define FLAG_UDPDEMUX       0x00000080
+#define FLAG_LISTENERCPU    0x00000100
+#define FLAG_THREADPOOLCPU  0x00000200
+#define FLAG_TCPFASTOPEN    0x00000400
+#define FLAG_TCPRR          0x00000800
+#define FLAG_UDPECHO        0x00001000
+#define FLAG_RPM            0x00002000
+#define FLAG_RPMPROBE       0x00004000
+#define FLAG_FLOWS          0x00008000
+#define FLAG_SCENARIO       0x00010000
+#define FLAG_AFFINITY       0x00020000
+#define FLAG_INCOMINGCPU    0x00040000
+#define FLAG_BUSYPOLL       0x00080000
+#define FLAG_BUSYPOLLSPIN   0x00100000
+#define FLAG_PAYLOADVERIFY  0x00200000
 
 #define isBuflenSet(settings)      ((settings->flags & FLAG_BUFLENSET) != 0)
 #define isCompat(settings)         ((settings->flags & FLAG_COMPAT) != 0)
@@ -433,6 +501,23 @@ struct thread_Settings {
 #define isSumServerDstIP(settings) ((settings->flags_extend2 & FLAG_SUMDSTIP) != 0)
 #define isRxClamp(settings)        ((settings->flags_extend2 & FLAG_RXCLAMP) != 0)
 #define isWritePrefetch(settings) ((settings->flags_extend2 & FLAG_WRITEPREFETCH) != 0)
+#define isIntervalSeries(settings) ((settings->flags_extend2 & FLAG_INTERVALSERIES) != 0)
+#define isIntervalSeriesJSON(settings) ((settings->flags_extend2 & FLAG_SERIESJSON) != 0)
+#define isUDPDemux(settings)       ((settings->flags_extend2 & FLAG_UDPDEMUX) != 0)
+#define isListenerCPU(settings)    ((settings->flags_extend2 & FLAG_LISTENERCPU) != 0)
+#define isThreadPoolCPU(settings)  ((settings->flags_extend2 & FLAG_THREADPOOLCPU) != 0)
+#define isTcpFastOpen(settings)    ((settings->flags_extend2 & FLAG_TCPFASTOPEN) != 0)
+#define isTcpRR(settings)          ((settings->flags_extend2 & FLAG_TCPRR) != 0)
+#define isUDPEcho(settings)        ((settings->flags_extend2 & FLAG_UDPECHO) != 0)
+#define isRPM(settings)            ((settings->flags_extend2 & FLAG_RPM) != 0)
+#define isRPMProbe(settings)       ((settings->flags_extend2 & FLAG_RPMPROBE) != 0)
+#define isFlows(settings)          ((settings->flags_extend2 & FLAG_FLOWS) != 0)
+#define isScenario(settings)       ((settings->flags_extend2 & FLAG_SCENARIO) != 0)
+#define isAffinity(settings)       ((settings->flags_extend2 & FLAG_AFFINITY) != 0)
+#define isIncomingCPU(settings)    ((settings->flags_extend2 & FLAG_INCOMINGCPU) != 0)
+#define isBusyPoll(settings)       ((settings->flags_extend2 & FLAG_BUSYPOLL) != 0)
+#define isBusyPollSpin(settings)   ((settings->flags_extend2 & FLAG_BUSYPOLLSPIN) != 0)
+#define isPayloadVerify(settings)  ((settings->flags_extend2 & FLAG_PAYLOADVERIFY) != 0)
 
 #define setBuflenSet(settings)     settings->flags |= FLAG_BUFLENSET
 #define setCompat(settings)        settings->flags |= FLAG_COMPAT
@@ -495,6 +580,23 @@ struct thread_Settings {
 #define setSumServerDstIP(settings) settings->flags_extend2 |= FLAG_SUMDSTIP
 #define setRxClamp(settings)       settings->flags_extend2 |= FLAG_RXCLAMP
 #define setWritePrefetch(settings) settings->flags_extend2 |= FLAG_WRITEPREFETCH
+#define setIntervalSeries(settings) settings->flags_extend2 |= FLAG_INTERVALSERIES
+#define setIntervalSeriesJSON(settings) settings->flags_extend2 |= FLAG_SERIESJSON
+#define setUDPDemux(settings)      settings->flags_extend2 |= FLAG_UDPDEMUX
+#define setListenerCPU(settings)   settings->flags_extend2 |= FLAG_LISTENERCPU
+#define setThreadPoolCPU(settings) settings->flags_extend2 |= FLAG_THREADPOOLCPU
+#define setTcpFastOpen(settings)   settings->flags_extend2 |= FLAG_TCPFASTOPEN
+#define setTcpRR(settings)         settings->flags_extend2 |= FLAG_TCPRR
+#define setUDPEcho(settings)       settings->flags_extend2 |= FLAG_UDPECHO
+#define setRPM(settings)           settings->flags_extend2 |= FLAG_RPM
+#define setRPMProbe(settings)      settings->flags_extend2 |= FLAG_RPMPROBE
+#define setFlows(settings)         settings->flags_extend2 |= FLAG_FLOWS
+#define setScenario(settings)      settings->flags_extend2 |= FLAG_SCENARIO
+#define setAffinity(settings)      settings->flags_extend2 |= FLAG_AFFINITY
+#define setIncomingCPU(settings)   settings->flags_extend2 |= FLAG_INCOMINGCPU
+#define setBusyPoll(settings)      settings->flags_extend2 |= FLAG_BUSYPOLL
+#define setBusyPollSpin(settings)  settings->flags_extend2 |= FLAG_BUSYPOLLSPIN
+#define setPayloadVerify(settings) settings->flags_extend2 |= FLAG_PAYLOADVERIFY
 
 #define unsetBuflenSet(settings)   settings->flags &= ~FLAG_BUFLENSET
 #define unsetCompat(settings)      settings->flags &= ~FLAG_COMPAT
@@ -556,6 +658,22 @@ struct thread_Settings {
 #define unsetSumServerDstIP(settings) settings->flags_extend2 &= ~FLAG_SUMDSTIP
 #define unsetRxClamp(settings)       settings->flags_extend2 &= ~FLAG_RXCLAMP
 #define unsetWritePrefetch(settings) settings->flags_extend2 &= ~FLAG_WRITEPREFETCH
+#define unsetIntervalSeries(settings) settings->flags_extend2 &= ~FLAG_INTERVALSERIES
+#define unsetIntervalSeriesJSON(settings) settings->flags_extend2 &= ~FLAG_SERIESJSON
+#define unsetUDPDemux(settings)    settings->flags_extend2 &= ~FLAG_UDPDEMUX
+#define unsetListenerCPU(settings) settings->flags_extend2 &= ~FLAG_LISTENERCPU
+#define unsetThreadPoolCPU(settings) settings->flags_extend2 &= ~FLAG_THREADPOOLCPU
+#define unsetTcpFastOpen(settings) settings->flags_extend2 &= ~FLAG_TCPFASTOPEN
+#define unsetTcpRR(settings)       settings->flags_extend2 &= ~FLAG_TCPRR
+#define unsetUDPEcho(settings)     settings->flags_extend2 &= ~FLAG_UDPECHO
+#define unsetRPM(settings)         settings->flags_extend2 &= ~FLAG_RPM
+#define unsetRPMProbe(settings)    settings->flags_extend2 &= ~FLAG_RPMPROBE
+#define unsetFlows(settings)       settings->flags_extend2 &= ~FLAG_FLOWS
+#define unsetScenario(settings)    settings->flags_extend2 &= ~FLAG_SCENARIO
+#define unsetAffinity(settings)    settings->flags_extend2 &= ~FLAG_AFFINITY
+#define unsetIncomingCPU(settings) settings->flags_extend2 &= ~FLAG_INCOMINGCPU
+#define unsetBusyPoll(settings)    settings->flags_extend2 &= ~(FLAG_BUSYPOLL | FLAG_BUSYPOLLSPIN)
+#define unsetPayloadVerify(settings) settings->flags_extend2 &= ~FLAG_PAYLOADVERIFY
 
 // set to defaults
 void Settings_Initialize(struct thread_Settings* main);
@@ -581,6 +699,9 @@ void Settings_GetUpperCaseArg(const char *,char *);
 // generate settings for listener instance
 void Settings_GenerateListenerSettings(struct thread_Settings *client, struct thread_Settings **listener);
 
+// generate settings for the --rpm latency probe thread
+void Settings_GenerateRPMProbeSettings(struct thread_Settings *client, struct thread_Settings **probe);
+
 // generate settings for speaker instance
 void Settings_GenerateClientSettings(struct thread_Settings *server, struct thread_Settings **client, void * mBuf);
 
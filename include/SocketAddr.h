@@ -100,6 +100,8 @@ extern "C" {
     int SockAddr_isZeroAddress(iperf_sockaddr *inSockAddr);
     void SockAddr_incrAddress( iperf_sockaddr *inSockAddr, int value);
     int SockAddr_Ifrname(struct thread_Settings *inSettings);
+    void SockAddr_Ifcache_Initialize(void);
+    void SockAddr_Ifcache_Destroy(void);
 #ifdef HAVE_LINUX_FILTER_H
     int SockAddr_Accept_BPF(int socket, uint16_t port);
     int SockAddr_Drop_All_BPF(int socket);
@@ -109,6 +109,8 @@ extern Mutex packetringdebug_mutex;
 // initialize or destroy the thread subsystem
 void thread_init();
 void thread_destroy();
+// persistent workers for the client and server threads (--thread-pool)
+void thread_pool_init(int workers, int pincpus);
 
 // start or stop a thread executing
 void thread_start_all(struct thread_Settings* thread);
@@ -119,6 +121,7 @@ void thread_stop(struct thread_Settings* thread);
 void thread_joinall(void);
 int thread_numuserthreads(void);
 int thread_numtrafficthreads(void);
+int thread_trafficdone_fd(void);
 
 // set a thread to be ignorable, so joinall won't wait on it
 void thread_setignore(void);
@@ -153,13 +156,21 @@ void*thread_run_wrapper(void* paramPtr);
 #if HAVE_SCHED_SETSCHEDULER
 void thread_setscheduler(struct thread_Settings *thread);
 #endif
+// cpu affinity of the traffic and reporter threads (--affinity)
+int thread_affinity_init(const char *traffic, const char *reporter, const char *device);
+void thread_affinity_destroy(void);
+int thread_setaffinity(struct thread_Settings *thread); // zero when the thread was pinned
+void thread_setaffinity_reporter(struct thread_Settings *thread);
+const char *thread_affinity_placement(void);
 
 void thread_rest (void);
 
 // defined in launch.cpp
+struct ScenarioGroup;
 void server_spawn(struct thread_Settings* thread);
 void client_spawn(struct thread_Settings* thread);
 void client_init(struct thread_Settings* clients);
+struct thread_Settings *scenario_init(struct thread_Settings *clients, struct ScenarioGroup *groups, int argc, char **argv);
 void listener_spawn(struct thread_Settings* thread);
 void listeners_init(struct thread_Settings* listeners);
 void writeack_server_spawn(struct thread_Settings* thread);
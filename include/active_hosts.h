@@ -59,10 +59,9 @@
 #include "Mutex.h"
 
 /*
- * A List entry that consists of a sockaddr
- * a pointer to the Audience that sockaddr is
- * associated with and a pointer to the next
- * entry
+ * A table entry that consists of a sockaddr (the host key)
+ * a pointer to the sum report that host is associated with
+ * and the number of active threads using it
  */
 struct Iperf_ListEntry {
     iperf_sockaddr host;
@@ -73,12 +72,26 @@ struct Iperf_ListEntry {
 #else
     int socket;
 #endif
-    struct Iperf_ListEntry *next;
 };
 
-struct Iperf_Table {
+/*
+ * The table is split into stripes selected by the host hash, each stripe
+ * is an open addressing (linear probe) hash table with its own lock
+ * so lookups for different hosts don't serialize on one mutex
+ */
+#define ACTIVE_TABLE_STRIPES 16  // must be a power of 2
+#define ACTIVE_STRIPE_MINSLOTS 16 // must be a power of 2
+
+struct Iperf_TableStripe {
     Mutex my_mutex;
-    struct Iperf_ListEntry *root;
+    struct Iperf_ListEntry **slots;
+    int size;
+    int count;
+};
+
+struct Iperf_Table {
+    Mutex my_mutex; // protects the counters below
+    struct Iperf_TableStripe stripes[ACTIVE_TABLE_STRIPES];
     int count;
     int total_count;
     int groupid;
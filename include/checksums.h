@@ -45,6 +45,15 @@
  * The checksum calculation is defined in RFC 768 
  * hints as to how to calculate it efficiently are in RFC 1071
  *
+ * The one's complement sum is done by a kernel which accumulates
+ * 32 bit words into 64 bit lanes (AVX2 or SSE2 on x86, NEON on
+ * aarch64, selected at runtime) and folds to 16 bits once at the
+ * end.  The scalar kernel sums 16 bit words, one at a time, and is
+ * the reference the others are checked against (see checkchecksums.)
+ * Partial sums are in memory (network) order, an odd length pads
+ * the last byte with a zero octet so only the final chunk of a
+ * buffer may be odd.
+ *
  * by Robert J. McMahon (rjmcmahon@rjmcmahon.com, bob.mcmahon@broadcom.com)
  * -------------------------------------------------------------------
  */
@@ -54,7 +63,21 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+typedef uint64_t (*csum_kernel_fn)(const void *buf, int len, uint64_t sum);
+
+// Scalar, 16 bits at a time, reference implementation
+extern uint64_t csum_partial_scalar(const void *buf, int len, uint64_t sum);
+// Dispatched to the best kernel for this cpu
+extern uint64_t csum_partial(const void *buf, int len, uint64_t sum);
+extern uint16_t csum_fold(uint64_t sum);
+extern const char *csum_kernel_name(void);
+// All the kernels supported by this cpu, best first, for tests and benchmarks
+extern int csum_kernel_list(csum_kernel_fn *kernels, const char **names, int max);
+
+// These return zero on checksum success, non zero otherwise
 uint32_t udpchecksum(const void *l3pdu, const void *udp_hdr, int udplen, int v6);
+uint32_t udpchecksum_scalar(const void *l3pdu, const void *udp_hdr, int udplen, int v6);
+uint32_t ipv4checksum(const void *l3pdu);
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
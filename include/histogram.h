@@ -79,4 +79,5 @@ extern int histogram_insert(struct histogram *h, float value, struct timeval *ts
 extern void histogram_clear(struct histogram *h);
 extern void histogram_add(struct histogram *to, struct histogram *from);
 extern void histogram_print(struct histogram *h, double, double);
+extern double histogram_percentile(struct histogram *h, double pct);
 #endif // HISTOGRAMC_H
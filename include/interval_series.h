@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * interval_series.h
+ * Deferred output of interval reports
+ *
+ * Rather than format and print every interval report in the reporter
+ * thread, append the interval's deltas as a fixed size record to a
+ * preallocated time series and render the whole series as text or
+ * JSON when the final report is output.  This keeps sub millisecond
+ * interval reporting (-i) from perturbing the traffic under test.
+ * -------------------------------------------------------------------
+ */
+#ifndef INTERVALSERIES_H
+#define INTERVALSERIES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERVALSERIES_DEFAULTCOUNT 65536
+#define INTERVALSERIES_MAXPREALLOC  (1 << 22)
+
+struct TransferInfo;
+struct thread_Settings;
+
+// One sample per interval, keep this fixed size and free of pointers
+struct IntervalSample {
+    double iStart;
+    double iEnd;
+    uintmax_t bytes;
+    intmax_t datagrams;
+    intmax_t lost;
+    intmax_t outoforder;
+    double jitter;
+    double minTransit;
+    double meanTransit;
+    double maxTransit;
+    int cntTransit;
+    int calls;  // reads or writes
+    int errors;
+    int retry;
+    int cwnd;
+    int rtt;
+};
+
+struct IntervalSeries {
+    struct IntervalSample *samples;
+    size_t count;
+    size_t capacity;
+    uintmax_t dropped;
+    char label[64];
+    // the report's (deferred) output handler used for the final report
+    void (*output_handler) (struct TransferInfo *stats);
+};
+
+extern size_t interval_series_count(struct thread_Settings *inSettings);
+extern struct IntervalSeries *interval_series_init(size_t capacity, const char *label);
+extern void interval_series_free(struct IntervalSeries *series);
+extern void interval_series_output(struct TransferInfo *stats);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // INTERVALSERIES_H
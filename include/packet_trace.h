@@ -0,0 +1,158 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * packet_trace.h
+ * Per packet binary trace capture (--trace-file)
+ *
+ * Each traffic thread writes its ReportStruct stream into its own
+ * memory mapped, preallocated file.  The file is a ring of fixed size
+ * blocks which are overwritten oldest first, i.e. the file rotates in
+ * place and never grows.  The capture path does no stdio nor syscalls,
+ * it's a handful of stores per packet.
+ *
+ * File layout (host byte order)
+ *
+ *   struct packet_trace_hdr             (PACKETTRACE_HDRSIZE bytes)
+ *   block[0] ... block[blockcnt - 1]    (blockbytes each)
+ *
+ * A block is a struct packet_trace_block header followed by columns
+ * of blocksize entries each, in this order:
+ *
+ *   int64_t  packetID[]
+ *   int64_t  sentTime[]    usecs since the epoch
+ *   int64_t  packetTime[]  usecs since the epoch
+ *   int64_t  frameID[]
+ *   int32_t  length[]
+ *   int32_t  l2errors[]
+ *
+ * A block with a seqno of zero is unused, otherwise seqno orders the
+ * blocks oldest to newest (seqno starts at 1.)
+ * -------------------------------------------------------------------
+ */
+#ifndef PACKETTRACE_H
+#define PACKETTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PACKETTRACE_MAGIC      0x52545049 // "IPTR"
+#define PACKETTRACE_VERSION    1
+#define PACKETTRACE_HDRSIZE    4096
+#define PACKETTRACE_BLOCKSIZE  16384 // records per block
+#define PACKETTRACE_DEFAULTSIZE (64 * 1024 * 1024)
+
+#define PACKETTRACE_UDP        0x01
+#define PACKETTRACE_SERVER     0x02
+#define PACKETTRACE_ISOCH      0x04
+
+struct packet_trace_hdr {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdrsize;
+    uint32_t blocksize;
+    uint32_t blockcnt;
+    uint64_t blockbytes;
+    int32_t transferID;
+    uint32_t flags;
+    int64_t startTime; // usecs since the epoch
+    uint64_t seqno; // seqno of the newest block
+};
+
+struct packet_trace_block {
+    uint64_t seqno;
+    uint32_t count;
+    uint32_t pad;
+    int64_t firstTime;
+    int64_t lastTime;
+};
+
+// Column accessors, blk points at the block header
+#define PACKETTRACE_PACKETID(blk, n)   ((int64_t *) ((char *) (blk) + sizeof(struct packet_trace_block)))
+#define PACKETTRACE_SENTTIME(blk, n)   (PACKETTRACE_PACKETID(blk, n) + (n))
+#define PACKETTRACE_PACKETTIME(blk, n) (PACKETTRACE_SENTTIME(blk, n) + (n))
+#define PACKETTRACE_FRAMEID(blk, n)    (PACKETTRACE_PACKETTIME(blk, n) + (n))
+#define PACKETTRACE_LENGTH(blk, n)     ((int32_t *) (PACKETTRACE_FRAMEID(blk, n) + (n)))
+#define PACKETTRACE_L2ERRORS(blk, n)   (PACKETTRACE_LENGTH(blk, n) + (n))
+#define PACKETTRACE_RECORDSIZE         (4 * sizeof(int64_t) + 2 * sizeof(int32_t))
+
+struct PacketTrace {
+    int fd;
+    char *map;
+    size_t mapsize;
+    struct packet_trace_hdr *hdr;
+    struct packet_trace_block *block; // current block
+    uint32_t blockix;
+    uint32_t count; // records in the current block
+    // cached column pointers of the current block
+    int64_t *packetID;
+    int64_t *sentTime;
+    int64_t *packetTime;
+    int64_t *frameID;
+    int32_t *length;
+    int32_t *l2errors;
+};
+
+// Read only (offline) access to a trace file
+struct PacketTraceReader {
+    int fd;
+    char *map;
+    size_t mapsize;
+    struct packet_trace_hdr *hdr;
+    uint32_t blockcnt; // blocks with records
+    struct packet_trace_block **blocks; // oldest to newest
+    uint64_t records;
+};
+
+struct ReportStruct;
+
+extern size_t packet_trace_blockbytes(uint32_t blocksize);
+extern struct PacketTrace *packet_trace_open(const char *filename, size_t filesize, int transferID, uint32_t flags);
+extern void packet_trace_insert(struct PacketTrace *trace, struct ReportStruct *packet);
+extern void packet_trace_close(struct PacketTrace *trace);
+extern struct PacketTraceReader *packet_trace_reader_open(const char *filename);
+extern void packet_trace_reader_close(struct PacketTraceReader *reader);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // PACKETTRACE_H
@@ -0,0 +1,85 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * payload_verify.h
+ * Payload integrity checks (--payload-verify)
+ *
+ * The client sends a seeded pattern, PAYLOADVERIFY_PERIOD bytes long,
+ * in place of the usual filler.  A TCP stream carries the pattern per
+ * its byte offset after the test header and a UDP datagram carries a
+ * window of it per its packet ID after PAYLOADVERIFY_UDPOFFSET.  The
+ * pattern is extended past the period so any window is contiguous,
+ * i.e. the client writes straight from it and the server's check is
+ * a single memcmp() of the read against it.  The libc memcmp() is
+ * vectorized (SSE2/AVX2/NEON) so the check runs at memory speed.
+ * -------------------------------------------------------------------
+ */
+#ifndef PAYLOADVERIFY_H
+#define PAYLOADVERIFY_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PAYLOADVERIFY_PERIOD 65536 // bytes, must be a power of two
+#define PAYLOADVERIFY_SEED   0x6970657266327076ULL
+
+// a datagram's window of the pattern, neighboring packet IDs land far apart
+static inline int payload_verify_phase (intmax_t packetID) {
+    return (int) (((uintmax_t) packetID * 40503) & (PAYLOADVERIFY_PERIOD - 1));
+}
+
+// returns nonzero if the buffer doesn't match the pattern from phase
+static inline int payload_verify_check (const char *buf, int len, const char *pattern, int phase) {
+    return (memcmp(buf, pattern + phase, len) != 0);
+}
+
+extern char *payload_verify_pattern(int maxlen);
+extern void payload_verify_free(char *pattern);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // PAYLOADVERIFY_H
@@ -90,7 +90,7 @@ extern "C" {
 #define HEADER_L2LENCHECK     0x0004
 #define HEADER_NOUDPFIN       0x0008
 #define HEADER_TRIPTIME       0x0010
-#define HEADER_UNUSED2        0x0020
+#define HEADER_TCPRR          0x0020
 #define HEADER_ISOCH_SETTINGS 0x0040
 #define HEADER_UNITS_PPS      0x0080
 #define HEADER_BWSET          0x0100
@@ -99,6 +99,8 @@ extern "C" {
 #define HEADER_FULLDUPLEX     0x0800
 #define HEADER_EPOCH_START    0x1000
 #define HEADER_PERIODICBURST  0x2000
+#define HEADER_UDPECHO        0x4000
+#define HEADER_PAYLOADVERIFY  0x8000
 
 // later features
 #define HDRXACKMAX 2500000 // default 2.5 seconds, units microseconds
@@ -136,6 +138,22 @@ struct UDP_datagram {
     uint32_t id2;
 };
 
+/*
+ * --udp-echo reply, the server reflects the client's UDP_datagram
+ * header untouched so the client can compute RTT from its own send
+ * timestamp, i.e. no clock sync is needed. The echo_id is the
+ * server's own sequence space so reverse loss and reordering can be
+ * told apart from forward loss, which the server reports as
+ * cumulative counts (all fields network byte order)
+ */
+struct UDP_echo_payload {
+    struct UDP_datagram probe;
+    uint32_t echo_id;
+    uint32_t fwd_lost;
+    uint32_t fwd_outoforder;
+    uint32_t reserved;
+};
+
 struct hdr_typelen {
     int32_t type;
     int32_t length;
@@ -258,7 +276,7 @@ struct client_hdrext_starttime_fq {
  *                +--------+--------+--------+--------+
  *           20   |        tv_usec (read-ack)         |
  *                +--------+--------+--------+--------+
- *           21   |        reserved                   |
+ *           21   |        reply size (tcp-rr)        |
  *                +--------+--------+--------+--------+
  *           22   |        reserved                   |
  *                +--------+--------+--------+--------+
@@ -267,6 +285,9 @@ struct client_hdrext_starttime_fq {
  *           24   |        reserved                   |
  *                +--------+--------+--------+--------+
  *
+ * With --tcp-rr the burst is a request and the server writes back a
+ * response of reply size bytes which leads with this same header,
+ * i.e. the burst id and the write timestamp are echoed to the client.
  */
 struct TCP_oneway_triptime {
     uint32_t write_tv_sec;
@@ -288,7 +309,7 @@ struct TCP_burst_payload {
     uint32_t seqno_lower;
     uint32_t seqno_upper;
     struct TCP_oneway_triptime writeacktt;
-    uint32_t reserved1;
+    uint32_t reply_size;
     uint32_t reserved2;
     uint32_t reserved3;
     uint32_t reserved4;
@@ -553,6 +574,8 @@ struct server_hdr {
 #define SIZEOF_TCPHDRMSG_EXT (sizeof(struct client_tcp_testhdr))
 #define MINMBUFALLOCSIZE (int) (sizeof(struct client_tcp_testhdr))
 #define MINTRIPTIMEPLAYOAD (int) (sizeof(struct client_udp_testhdr) - sizeof(struct client_hdrext_isoch_settings))
+// --payload-verify, a datagram's pattern starts after the largest test header
+#define PAYLOADVERIFY_UDPOFFSET (int) (sizeof(struct client_udp_testhdr))
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
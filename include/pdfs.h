@@ -53,6 +53,35 @@ extern "C" {
 float normal(float mean, float variance);
 float lognormal(float mu, float sigma);
 float box_muller(void);
+
+/*
+ * A general sampler, either one of the parametric distributions or an
+ * empirical one per a CDF file of <value> <cumulative probability>
+ * lines, sampled by inverse transform with linear interpolation
+ */
+enum pdf_kind {
+    PDF_CONSTANT,
+    PDF_NORMAL,
+    PDF_LOGNORMAL,
+    PDF_EXPONENTIAL,
+    PDF_EMPIRICAL
+};
+
+struct pdf_sampler {
+    enum pdf_kind kind;
+    double mean;
+    double sigma;
+    int points; // empirical only
+    double *values;
+    double *cdf;
+};
+
+struct pdf_sampler *pdf_sampler_init(enum pdf_kind kind, double mean, double sigma);
+struct pdf_sampler *pdf_sampler_load(const char *filename);
+struct pdf_sampler *pdf_sampler_parse(const char *spec);
+double pdf_sample(struct pdf_sampler *pdf);
+double pdf_sampler_mean(struct pdf_sampler *pdf);
+void pdf_sampler_free(struct pdf_sampler *pdf);
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
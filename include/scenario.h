@@ -0,0 +1,85 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * scenario.h
+ * Flow groups of a --scenario file, run in one process with one reporter
+ *
+ * A scenario file is INI like, a [name] line starts a group followed by
+ * its keys, # or ; start a comment
+ *
+ *   [bulk]
+ *   options = -P 4 -i 1
+ *   start = 0
+ *   duration = 10
+ *
+ * The options of a group are client options applied after those of the
+ * command line, start is the group's offset in seconds from the scenario
+ * start and duration is its -t.  Each group has a sum labeled by its
+ * name which also feeds the scenario wide [SUM]
+ * ------------------------------------------------------------------- */
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Condition.h"
+#include "Mutex.h"
+
+#define SCENARIO_LINEMAX 1024
+
+struct ScenarioGroup {
+    char *name;
+    char *options;              // client options of the group
+    double start;               // seconds from the scenario start
+    double duration;            // the group's -t, zero keeps the command line's
+    struct timeval start_time;
+    int threads;                // traffic threads not yet done
+    Mutex lock;
+    struct BarrierMutex connects_done;
+    struct SumReport *sum_report;
+    struct ScenarioGroup *next;
+};
+
+int scenario_load(const char *filename, struct ScenarioGroup **groups);
+struct thread_Settings *scenario_group_settings(struct ScenarioGroup *group, int argc, char **argv);
+void scenario_group_remove(struct thread_Settings *thread);
+void scenario_free(struct ScenarioGroup *groups);
+#endif // SCENARIO_H
@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * transit_kernel.h
+ * Batch (array) versions of the one way transit statistics
+ *
+ * reporter_handle_packet_oneway_transit() updates min/max/sum, a
+ * Welford mean/variance and the RFC 1889 jitter one packet at a
+ * time.  The kernel does the same over an array of transits: min, max,
+ * sum and a two pass mean/m2 are vectorized (AVX2 or SSE2 on x86,
+ * NEON on aarch64, selected at runtime) and the batch is merged into
+ * the running stats with the parallel (Chan) Welford merge.  Only the
+ * jitter needs a sequential pass.
+ *
+ * A stats struct with a zero cntTransit starts a new series, i.e. its
+ * first transit doesn't update the jitter and m2 starts at zero.  Set
+ * flowstart when the series starts with the flow's very first transit,
+ * m2 is then seeded with that transit squared as the live reporter does
+ * (flowstart is cleared once used.)
+ *
+ * Results vs the scalar recurrence: cnt, min, max, lastTransit and
+ * jitter are bit for bit the same.  sum, mean and m2 differ only by
+ * the summation order, the relative difference is bounded by
+ * TRANSIT_KERNEL_TOLERANCE (see checktransit for the check.)
+ * -------------------------------------------------------------------
+ */
+#ifndef TRANSIT_KERNEL_H
+#define TRANSIT_KERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRANSIT_KERNEL_TOLERANCE 1e-9
+
+// Units follow struct TransferInfo, transits in seconds, mean and m2 in usecs
+struct transit_stats {
+    intmax_t cntTransit;
+    double minTransit;
+    double maxTransit;
+    double sumTransit;
+    double meanTransit;
+    double m2Transit;
+    double lastTransit;
+    double jitter;
+    int flowstart;
+};
+
+typedef void (*transit_kernel_fn)(const double *transit, size_t n, struct transit_stats *stats);
+
+// Scalar, per packet, reference implementation
+extern void transit_kernel_scalar(const double *transit, size_t n, struct transit_stats *stats);
+// Dispatched to the best kernel for this cpu
+extern void transit_kernel_batch(const double *transit, size_t n, struct transit_stats *stats);
+extern const char *transit_kernel_name(void);
+// All the kernels supported by this cpu, NULL terminated, for tests and benchmarks
+extern int transit_kernel_list(transit_kernel_fn *kernels, const char **names, int max);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif // TRANSIT_KERNEL_H
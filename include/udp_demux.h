@@ -0,0 +1,103 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * udp_demux.h
+ * Per flow state for the single socket UDP server (--udp-demux)
+ *
+ * A demux thread reads datagrams of many UDP flows from one unconnected
+ * socket and finds the flow by the peer address in an open addressing
+ * hash table owned by that thread, i.e. no locks.  Idle flows are
+ * expired by a hashed timer wheel.  Flows aren't moved in the wheel per
+ * packet, rather a flow is checked when its slot comes due and is
+ * rescheduled if it has seen traffic since.
+ * ------------------------------------------------------------------- */
+#ifndef UDPDEMUX_H
+#define UDPDEMUX_H
+
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+
+#define UDPDEMUX_BATCH 64              // datagrams per recvmmsg
+#define UDPDEMUX_IDLETIMEOUT 5         // seconds without traffic before a flow is expired
+#define UDPDEMUX_WHEELSLOTS 256        // must be a power of 2
+#define UDPDEMUX_WHEELTICK 100000      // usecs per wheel slot
+#define UDPDEMUX_MINSLOTS 64           // must be a power of 2
+
+struct UDPDemuxFlow {
+    iperf_sockaddr peer;
+    Socklen_t size_peer;
+    uint32_t hash;
+    struct thread_Settings *settings;
+    struct ReportHeader *job;
+    struct ReporterData *report;
+    struct ReportStruct packet;
+    struct timeval lastTime;    // time of the last datagram
+    bool done;                  // final report done (or flow not accounted)
+    long expire;                // wheel tick the flow is due
+    struct UDPDemuxFlow *wheel_next;
+    struct UDPDemuxFlow *wheel_prev;
+};
+
+struct UDPDemuxTable {
+    struct UDPDemuxFlow **slots;
+    int size;
+    int count;
+    struct thread_Settings *settings; // for FAIL
+};
+
+struct UDPDemuxWheel {
+    struct UDPDemuxFlow *slots[UDPDEMUX_WHEELSLOTS];
+    struct timeval start;
+    long tick;                  // last tick processed
+};
+
+void udp_demux_table_init(struct UDPDemuxTable *table, struct thread_Settings *settings);
+void udp_demux_table_destroy(struct UDPDemuxTable *table);
+struct UDPDemuxFlow *udp_demux_lookup(struct UDPDemuxTable *table, iperf_sockaddr *peer);
+void udp_demux_insert(struct UDPDemuxTable *table, struct UDPDemuxFlow *flow);
+void udp_demux_remove(struct UDPDemuxTable *table, struct UDPDemuxFlow *flow);
+
+void udp_demux_wheel_init(struct UDPDemuxWheel *wheel, struct timeval *now);
+void udp_demux_wheel_schedule(struct UDPDemuxWheel *wheel, struct UDPDemuxFlow *flow, struct timeval *due);
+void udp_demux_wheel_cancel(struct UDPDemuxWheel *wheel, struct UDPDemuxFlow *flow);
+struct UDPDemuxFlow *udp_demux_wheel_advance(struct UDPDemuxWheel *wheel, struct timeval *now);
+#endif // UDPDEMUX_H
@@ -72,6 +72,8 @@ int getsock_tcp_windowsize(int inSock, int inSend);
 
 void setsock_tcp_mss(int inSock, int inMSS);
 int  getsock_tcp_mss(int inSock);
+int  getsock_tcp_fastopen(int inSock);
+int  getsock_incoming_cpu(int inSock, unsigned int *napi_id);
 bool setsock_blocking(int fd, bool blocking);
 #if HAVE_DECL_TCP_WINDOW_CLAMP
 int  getsock_tcp_windowclamp(int inSock);
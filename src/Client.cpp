@@ -67,6 +67,13 @@
 #include "version.h"
 #include "payloads.h"
 #include "active_hosts.h"
+#include "scenario.h"
+#include "payload_verify.h"
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#define CONNECTRATE_EPOLL 1
+#endif
 
 // const double kSecs_to_usecs = 1e6;
 const double kSecs_to_nsecs = 1e9;
@@ -81,12 +88,15 @@ Client::Client (thread_Settings *inSettings) {
 #endif
     mSettings = inSettings;
     mBuf = NULL;
+    verifyPattern = NULL;
+    verifyOffset = 0;
     myJob = NULL;
     myReport = NULL;
     framecounter = NULL;
     one_report = false;
     udp_payload_minimum = 1;
     apply_first_udppkt_delay = false;
+    tfo_deferred = false;
 
     memset(&scratchpad, 0, sizeof(struct ReportStruct));
     reportstruct = &scratchpad;
@@ -105,6 +115,10 @@ Client::Client (thread_Settings *inSettings) {
 #endif
     FAIL_errno(mBuf == NULL, "No memory for buffer\n", mSettings);
     pattern(mBuf, mSettings->mBufLen);
+    if (isPayloadVerify(mSettings)) {
+	verifyPattern = payload_verify_pattern(payloadsize);
+	FAIL_errno(verifyPattern == NULL, "No memory for payload verify pattern\n", mSettings);
+    }
     if (isFileInput(mSettings)) {
         if (!isSTDIN(mSettings))
             Extractor_Initialize(mSettings->mFileName, mSettings->mBufLen, mSettings);
@@ -132,6 +146,7 @@ Client::~Client () {
 		 (isServerReverse(mSettings) ? "true" : "false"), (isFullDuplex(mSettings) ? "true" : "false"));
 #endif
     DELETE_ARRAY(mBuf);
+    payload_verify_free(verifyPattern);
     DELETE_PTR(framecounter);
 } // end ~Client
 
@@ -171,6 +186,15 @@ bool Client::my_connect (bool close_on_fail) {
     // connect socket
     connected = false;
     if (!isUDP(mSettings)) {
+#if HAVE_DECL_TCP_FASTOPEN_CONNECT
+	// with a cached cookie connect() is deferred to the first write,
+	// which sends the test header in the SYN
+	if (isTcpFastOpen(mSettings)) {
+	    int one = 1;
+	    rc = setsockopt(mySocket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, reinterpret_cast<char*>(&one), sizeof(one));
+	    WARN_errno(rc == SOCKET_ERROR, "setsockopt TCP_FASTOPEN_CONNECT");
+	}
+#endif
 	int trycnt = mSettings->mConnectRetries + 1;
 	while (trycnt > 0) {
 	    connect_start.setnow();
@@ -191,6 +215,15 @@ bool Client::my_connect (bool close_on_fail) {
 		connecttime = 1e3 * connect_done.subSec(connect_start);
 		mSettings->connecttime = connecttime;
 		connected = true;
+#if HAVE_DECL_TCP_FASTOPEN_CONNECT && defined(HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS)
+		if (isTcpFastOpen(mSettings)) {
+		    struct tcp_info tcp_info_buf;
+		    Socklen_t len = sizeof(tcp_info_buf);
+		    if ((getsockopt(mySocket, IPPROTO_TCP, TCP_INFO, reinterpret_cast<char *>(&tcp_info_buf), &len) == 0) && \
+			(tcp_info_buf.tcpi_state == TCP_SYN_SENT))
+			tfo_deferred = true;
+		}
+#endif
 		break;
 	    }
 	}
@@ -226,9 +259,16 @@ bool Client::my_connect (bool close_on_fail) {
 	PostReport(tmp);
 	setNoSettReport(mSettings);
     }
-    // Post the connect report unless peer version exchange is set
+    // Post the connect report unless peer version exchange is set or
+    // the connect is deferred to the first write per TCP fast open
+    if (!tfo_deferred)
+	PostConnectionReport(connecttime);
+    return connected;
+} // end Connect
+
+void Client::PostConnectionReport (double connecttime) {
     if (isConnectionReport(mSettings) && !isSumOnly(mSettings) && !isPeerVerDetect(mSettings)) {
-	if (connected) {
+	if (connecttime >= 0) {
 	    struct ReportHeader *reporthdr = InitConnectionReport(mSettings, connecttime);
 	    struct ConnectionInfo *cr = static_cast<struct ConnectionInfo *>(reporthdr->this_report);
 	    cr->connect_timestamp.tv_sec = connect_start.getSecs();
@@ -239,8 +279,7 @@ bool Client::my_connect (bool close_on_fail) {
 	    PostReport(InitConnectionReport(mSettings, -1));
 	}
     }
-    return connected;
-} // end Connect
+}
 
 bool Client::isConnected () const {
 #ifdef HAVE_THREAD_DEBUG
@@ -320,6 +359,8 @@ int Client::StartSynch () {
 		    }
 		}
 	    }
+	} else if (tfo_deferred) {
+	    reportstruct->packetLen = SendFirstPayloadTFO(0);
 	}
 	if (isTxStartTime(mSettings)) {
 	    clock_usleep_abstime(&mSettings->txstart_epoch);
@@ -367,6 +408,8 @@ inline void Client::SetFullDuplexReportStartTime () {
     assert(fullduplexstats != NULL);
     if (TimeZero(fullduplexstats->ts.startTime)) {
 	fullduplexstats->ts.startTime = myReport->info.ts.startTime;
+	fullduplexstats->ts.startOffset = myReport->info.ts.startOffset;
+	fullduplexstats->ts.iEnd = myReport->info.ts.iEnd;
 	if (isModeTime(mSettings)) {
 	    fullduplexstats->ts.nextTime = myReport->info.ts.nextTime;
 	}
@@ -382,6 +425,11 @@ inline void Client::SetReportStartTime () {
     myReport->info.ts.startTime.tv_usec = now.getUsecs();
     myReport->info.ts.IPGstart = myReport->info.ts.startTime;
     myReport->info.ts.prevpacketTime = myReport->info.ts.startTime;
+    if (!TimeZero(mSettings->report_epoch)) {
+	// threads sharing a report clock, the first interval ends at the thread's next tick on it
+	myReport->info.ts.startOffset = TimeDifference(myReport->info.ts.startTime, mSettings->report_epoch);
+	myReport->info.ts.iEnd = myReport->info.ts.startOffset;
+    }
     if (!TimeZero(myReport->info.ts.intervalTime)) {
 	myReport->info.ts.nextTime = myReport->info.ts.startTime;
 	TimeAdd(myReport->info.ts.nextTime, myReport->info.ts.intervalTime);
@@ -395,6 +443,8 @@ inline void Client::SetReportStartTime () {
 	Mutex_Lock(&myReport->GroupSumReport->reference.lock);
 	if (TimeZero(sumstats->ts.startTime)) {
 	    sumstats->ts.startTime = myReport->info.ts.startTime;
+	    sumstats->ts.startOffset = myReport->info.ts.startOffset;
+	    sumstats->ts.iEnd = myReport->info.ts.iEnd;
 	    if (isModeTime(mSettings)) {
 		sumstats->ts.nextTime = myReport->info.ts.nextTime;
 	    }
@@ -418,6 +468,12 @@ void Client::ConnectPeriodic () {
 	end.add(amount_usec); // add in micro seconds
     }
     setNoConnectSync(mSettings);
+#ifdef CONNECTRATE_EPOLL
+    if (mSettings->mConnectInflight > 0) {
+	ConnectRate();
+	return;
+    }
+#endif
     int num_connects = -1;
     if (!(mSettings->mInterval > 0)) {
 	if (mSettings->connectonly_count < 0)
@@ -449,6 +505,1071 @@ void Client::ConnectPeriodic () {
 	}
     } while (num_connects && !sInterupted && (next.before(end) || (isModeTime(mSettings) && !(mSettings->mInterval > 0))));
 }
+
+static inline void meanminmax_update (struct MeanMinMaxStats *stats, double value) {
+    stats->sum += value;
+    stats->cnt++;
+    stats->vd = value - stats->mean;
+    stats->mean += stats->vd / stats->cnt;
+    stats->m2 += stats->vd * (value - stats->mean);
+    if (value < stats->min)
+	stats->min = value;
+    if (value > stats->max)
+	stats->max = value;
+}
+
+// RTT histogram of the --tcp-rr transactions or --udp-echo probes
+static struct histogram *transaction_histogram (struct thread_Settings *settings) {
+    char name[] = "T8";
+    if (isHistogram(settings)) {
+	return histogram_init(settings->mHistBins, settings->mHistBinsize, 0, pow(10, settings->mHistUnits), \
+			      settings->mHistci_lower, settings->mHistci_upper, settings->mTransferID, name);
+    }
+    if (isRPMProbe(settings)) {
+	// 10 usec bins out to 1 second, a loaded queue can be deep
+	return histogram_init(100000, 1, 0, 1e5, 5, 95, settings->mTransferID, name);
+    }
+    // 1 usec bins out to 100 ms
+    return histogram_init(100000, 1, 0, 1e6, 5, 95, settings->mTransferID, name);
+}
+
+// --rpm, the probes so far were the idle baseline and those from here on run under load
+void Client::rpm_phase (double elapsed) {
+    struct TransactionInfo *total = &myTransactions[1];
+    total->idle_rtt = total->rtt;
+    total->idle_histogram = total->latency_histogram;
+    total->latency_histogram = transaction_histogram(mSettings);
+    TransactionStatsReset(total);
+    total->iStart = elapsed;
+    total->rpm = 2;
+}
+
+#ifdef CONNECTRATE_EPOLL
+/*
+ * The --connect-rate engine keeps up to mConnectInflight non-blocking
+ * connects outstanding per thread and takes their completions from
+ * epoll.  A rate > 0 is open loop, i.e. arrivals follow the schedule
+ * regardless of completions and an arrival which finds every slot busy
+ * is counted as an overrun.  A rate of zero is closed loop, a connect
+ * starts as soon as a slot frees up.  Connects are closed with a RST so
+ * the client doesn't run out of ports per TIME_WAIT.
+ */
+struct ConnectSlot {
+    int fd;
+    Timestamp start;
+};
+
+static inline int connect_fail_class (int err) {
+    switch (err) {
+    case ECONNREFUSED:
+	return CONNECTFAIL_REFUSED;
+    case ETIMEDOUT:
+	return CONNECTFAIL_TIMEOUT;
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+    case EHOSTDOWN:
+    case ENETDOWN:
+	return CONNECTFAIL_UNREACH;
+    case ECONNRESET:
+    case ECONNABORTED:
+    case EPIPE:
+	return CONNECTFAIL_RESET;
+    case EADDRNOTAVAIL:
+    case EADDRINUSE:
+    case EAGAIN:
+    case EMFILE:
+    case ENFILE:
+    case ENOBUFS:
+    case ENOMEM:
+	return CONNECTFAIL_LOCAL;
+    default:
+	return CONNECTFAIL_OTHER;
+    }
+}
+
+static inline void connect_rate_update (struct ConnectRateInfo *stats, double connect_time) {
+    meanminmax_update(&stats->connect_times, connect_time);
+}
+
+// Close a connect slot and account for it in both the interval and the totals
+void Client::connect_rate_done (struct ConnectSlot *slot, int err) {
+    if (!err) {
+	double connect_time = now.subSec(slot->start);
+	connect_rate_update(&myConnectRate[0], 1e3 * connect_time);
+	connect_rate_update(&myConnectRate[1], 1e3 * connect_time);
+	if (myConnectRate[1].latency_histogram)
+	    histogram_insert(myConnectRate[1].latency_histogram, connect_time, NULL);
+    } else {
+	int fail = connect_fail_class(err);
+	myConnectRate[0].fails[fail]++;
+	myConnectRate[1].fails[fail]++;
+    }
+    struct linger linger = {1, 0};
+    setsockopt(slot->fd, SOL_SOCKET, SO_LINGER, reinterpret_cast<char *>(&linger), sizeof(linger));
+    close(slot->fd);
+    slot->fd = INVALID_SOCKET;
+}
+
+// Start a non-blocking connect in the slot, returns false on an immediate failure
+bool Client::connect_rate_start (int efd, struct ConnectSlot *slot, int slotid) {
+    int domain = (SockAddr_isIPv6(&mSettings->peer) ?
+#ifdef HAVE_IPV6
+                  AF_INET6
+#else
+                  AF_INET
+#endif
+                  : AF_INET);
+    myConnectRate[0].tries++;
+    myConnectRate[1].tries++;
+    slot->start.setnow();
+    slot->fd = socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (slot->fd == INVALID_SOCKET) {
+	int fail = connect_fail_class(errno);
+	myConnectRate[0].fails[fail]++;
+	myConnectRate[1].fails[fail]++;
+	return false;
+    }
+    mSettings->mSock = slot->fd;
+    SetSocketOptions(mSettings);
+    mSettings->mSock = INVALID_SOCKET;
+    if ((mSettings->mLocalhost != NULL) && \
+	(bind(slot->fd, reinterpret_cast<sockaddr*>(&mSettings->local), SockAddr_get_sizeof_sockaddr(&mSettings->local)) == SOCKET_ERROR)) {
+	now.setnow();
+	connect_rate_done(slot, errno);
+	return false;
+    }
+    int rc = connect(slot->fd, reinterpret_cast<sockaddr*>(&mSettings->peer), SockAddr_get_sizeof_sockaddr(&mSettings->peer));
+    if ((rc == SOCKET_ERROR) && (errno == EINPROGRESS)) {
+	struct epoll_event ev;
+	ev.events = EPOLLOUT;
+	ev.data.u32 = slotid;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, slot->fd, &ev) == 0)
+	    return true;
+    }
+    now.setnow();
+    connect_rate_done(slot, ((rc == SOCKET_ERROR) ? errno : 0));
+    return (rc != SOCKET_ERROR);
+}
+
+void Client::ConnectRate () {
+    int inflight = mSettings->mConnectInflight;
+    double spacing = (mSettings->mConnectRate > 0) ? (1.0 / mSettings->mConnectRate) : 0;
+    intmax_t remaining = (mSettings->connectonly_count > 0) ? mSettings->connectonly_count : -1;
+    intmax_t arrivals = 0;
+    int outstanding = 0;
+    int ix;
+    if (isReport(mSettings) && isSettingsReport(mSettings)) {
+	struct ReportHeader *tmp = InitSettingsReport(mSettings);
+	assert(tmp!=NULL);
+	PostReport(tmp);
+	setNoSettReport(mSettings);
+    }
+    int efd = epoll_create1(EPOLL_CLOEXEC);
+    if (efd < 0) {
+	WARN_errno(1, "epoll_create1");
+	return;
+    }
+    SockAddr_remoteAddr(mSettings);
+    if (mSettings->mLocalhost != NULL)
+	SockAddr_localAddr(mSettings);
+    struct ConnectSlot *slots = new struct ConnectSlot[inflight];
+    int *freeslots = new int[inflight];
+    struct epoll_event *events = new struct epoll_event[inflight];
+    int nfree = inflight;
+    for (ix = 0; ix < inflight; ix++) {
+	slots[ix].fd = INVALID_SOCKET;
+	freeslots[ix] = inflight - 1 - ix;
+    }
+    // [0] is the interval, [1] the totals
+    for (ix = 0; ix < 2; ix++) {
+	memset(&myConnectRate[ix], 0, sizeof(struct ConnectRateInfo));
+	ConnectRateStatsReset(&myConnectRate[ix]);
+	myConnectRate[ix].transferID = mSettings->mTransferID;
+	myConnectRate[ix].rate = mSettings->mConnectRate;
+    }
+    myConnectRate[1].final = 1;
+    {
+	char name[] = "C8";
+	if (isHistogram(mSettings)) {
+	    myConnectRate[1].latency_histogram = histogram_init(mSettings->mHistBins, mSettings->mHistBinsize, 0, \
+								pow(10, mSettings->mHistUnits), mSettings->mHistci_lower, \
+								mSettings->mHistci_upper, mSettings->mTransferID, name);
+	    myConnectRate[1].histogram_pdf = 1;
+	} else {
+	    // 10 usec bins out to the connect timeout
+	    myConnectRate[1].latency_histogram = histogram_init(static_cast<unsigned int>(CONNECTRATE_TIMEOUT * 1e5), 10, 0, 1e6, \
+								5, 95, mSettings->mTransferID, name);
+	}
+    }
+    Timestamp start;
+    Timestamp end;
+    Timestamp nextarrival;
+    Timestamp nextreport;
+    Timestamp nextsweep;
+    Timestamp drain;
+    if (isModeTime(mSettings))
+	end.add(mSettings->mAmount / 100.0);
+    if (mSettings->mInterval > 0)
+	nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+    bool arriving = true;
+    while (!sInterupted && (arriving || outstanding)) {
+	now.setnow();
+	if (arriving && ((remaining == 0) || (isModeTime(mSettings) && !now.before(end)))) {
+	    arriving = false;
+	    drain = now;
+	    drain.add(CONNECTRATE_TIMEOUT);
+	}
+	if (arriving && (spacing > 0)) {
+	    while (!now.before(nextarrival) && (remaining != 0)) {
+		if (nfree) {
+		    int slotid = freeslots[--nfree];
+		    connect_rate_start(efd, &slots[slotid], slotid);
+		    if (slots[slotid].fd == INVALID_SOCKET)
+			freeslots[nfree++] = slotid;
+		    else
+			outstanding++;
+		} else {
+		    myConnectRate[0].overruns++;
+		    myConnectRate[1].overruns++;
+		}
+		if (remaining > 0)
+		    remaining--;
+		nextarrival = start;
+		nextarrival.add(++arrivals * spacing);
+	    }
+	} else if (arriving) {
+	    while (nfree && (remaining != 0)) {
+		int slotid = freeslots[--nfree];
+		bool started = connect_rate_start(efd, &slots[slotid], slotid);
+		if (slots[slotid].fd == INVALID_SOCKET)
+		    freeslots[nfree++] = slotid;
+		else
+		    outstanding++;
+		if (remaining > 0)
+		    remaining--;
+		if (!started)
+		    break;
+	    }
+	}
+	// wait for completions no longer than the next arrival, report or timeout sweep
+	int timeout = 10;
+	if (arriving && (spacing > 0) && (remaining != 0)) {
+	    long usecs = nextarrival.subUsec(now);
+	    if (usecs < timeout * 1000)
+		timeout = (usecs > 0) ? static_cast<int>((usecs + 999) / 1000) : 0;
+	}
+	int n = epoll_wait(efd, events, inflight, timeout);
+	if ((n < 0) && (errno != EINTR)) {
+	    WARN_errno(1, "epoll_wait");
+	    break;
+	}
+	now.setnow();
+	for (ix = 0; ix < n; ix++) {
+	    int slotid = events[ix].data.u32;
+	    int err = 0;
+	    Socklen_t len = sizeof(err);
+	    if (getsockopt(slots[slotid].fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err), &len) < 0)
+		err = errno;
+	    connect_rate_done(&slots[slotid], err);
+	    freeslots[nfree++] = slotid;
+	    outstanding--;
+	}
+	// connects outstanding longer than the timeout, or past the drain time, fail as timeouts
+	if (outstanding && (!now.before(nextsweep) || (!arriving && !now.before(drain)))) {
+	    for (ix = 0; ix < inflight; ix++) {
+		if ((slots[ix].fd != INVALID_SOCKET) && \
+		    ((now.subSec(slots[ix].start) > CONNECTRATE_TIMEOUT) || (!arriving && !now.before(drain)))) {
+		    connect_rate_done(&slots[ix], ETIMEDOUT);
+		    freeslots[nfree++] = ix;
+		    outstanding--;
+		}
+	    }
+	    nextsweep = now;
+	    nextsweep.add(0.01);
+	}
+	if ((mSettings->mInterval > 0) && !now.before(nextreport) && (arriving || outstanding)) {
+	    myConnectRate[0].iEnd = nextreport.subSec(start);
+	    PostReport(InitConnectRateReport(mSettings, &myConnectRate[0]));
+	    ConnectRateStatsReset(&myConnectRate[0]);
+	    myConnectRate[0].iStart = myConnectRate[0].iEnd;
+	    nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+	}
+    }
+    now.setnow();
+    for (ix = 0; ix < inflight; ix++) {
+	if (slots[ix].fd != INVALID_SOCKET)
+	    connect_rate_done(&slots[ix], ETIMEDOUT);
+    }
+    myConnectRate[0].iEnd = now.subSec(start);
+    // only post the trailing interval if it saw attempts or completions
+    intmax_t done = myConnectRate[0].connect_times.cnt;
+    for (ix = 0; ix < CONNECTFAIL_MAX; ix++)
+	done += myConnectRate[0].fails[ix];
+    if ((mSettings->mInterval > 0) && (myConnectRate[0].iEnd > myConnectRate[0].iStart) && \
+	(myConnectRate[0].tries || done))
+	PostReport(InitConnectRateReport(mSettings, &myConnectRate[0]));
+    myConnectRate[1].iEnd = myConnectRate[0].iEnd;
+    PostReport(InitConnectRateReport(mSettings, &myConnectRate[1]));
+    close(efd);
+    DELETE_ARRAY(slots);
+    DELETE_ARRAY(freeslots);
+    DELETE_ARRAY(events);
+}
+#endif
+
+#if HAVE_SYS_EPOLL_H
+/*
+ * The --tcp-rr engine runs request/response transactions over
+ * mRRConns connections per thread with up to mRRDepth requests in
+ * flight on each.  A request is a TCP burst of mRRRequest bytes whose
+ * header carries the size of the response.  The server echoes the
+ * header at the front of the response so the round trip is taken
+ * against the request's write timestamp.  Sockets are non-blocking and
+ * serviced from epoll, a connection only asks for EPOLLOUT when a
+ * request write would block.
+ */
+struct FlowPending {
+    Timestamp arrival;
+    int size;
+};
+
+struct RRConn {
+    int fd;
+    int inflight; // requests written, or being written, with no response yet
+    int txsize; // bytes of the current request
+    int txleft; // bytes of the current request yet to be written
+    bool wantout;
+    struct TCP_burst_payload txhdr;
+    int rxoff; // bytes of the response header read
+    int rxleft; // bytes of the response payload yet to be read
+    struct TCP_burst_payload rxhdr;
+    // --flows, a ring of the connection's flows, those in flight ahead of those yet to be written
+    struct FlowPending *flows;
+    int flowcap;
+    int flowhead;
+    int flowcnt;
+    bool connecting;
+};
+
+// Connect another transaction socket and send it the test header, returns the socket
+int Client::tcprr_connect () {
+    int domain = (SockAddr_isIPv6(&mSettings->peer) ?
+#ifdef HAVE_IPV6
+                  AF_INET6
+#else
+                  AF_INET
+#endif
+                  : AF_INET);
+    int fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    WARN_errno(fd == INVALID_SOCKET, "tcp-rr socket");
+    if (fd == INVALID_SOCKET)
+	return fd;
+    mSettings->mSock = fd;
+    SetSocketOptions(mSettings);
+    mSettings->mSock = mySocket;
+    int rc = 0;
+    if (mSettings->mLocalhost != NULL) {
+	// any port of -B was taken by the first connection
+	iperf_sockaddr local = mSettings->local;
+	SockAddr_setPortAny(&local);
+	rc = bind(fd, reinterpret_cast<sockaddr*>(&local), SockAddr_get_sizeof_sockaddr(&local));
+	WARN_errno(rc == SOCKET_ERROR, "tcp-rr bind");
+    }
+    if (rc != SOCKET_ERROR) {
+	rc = connect(fd, reinterpret_cast<sockaddr*>(&mSettings->peer), SockAddr_get_sizeof_sockaddr(&mSettings->peer));
+	WARN_errno(rc == SOCKET_ERROR, "tcp-rr connect");
+    }
+    if (rc != SOCKET_ERROR) {
+	int len = Settings_GenerateClientHdr(mSettings, (void *) mBuf, \
+					     (isTxStartTime(mSettings) ? mSettings->txstart_epoch : myReport->info.ts.startTime));
+	rc = ((len > 0) && (writen(fd, mBuf, len) == len)) ? 0 : SOCKET_ERROR;
+	WARN_errno(rc == SOCKET_ERROR, "tcp-rr send_hdr");
+	if ((rc != SOCKET_ERROR) && isPeerVerDetect(mSettings)) {
+	    client_hdr_ack ack;
+	    if (recvn(fd, reinterpret_cast<char *>(&ack), sizeof(client_hdr_ack), 0) != sizeof(client_hdr_ack)) {
+		WARN_errno(1, "tcp-rr recvack");
+		rc = SOCKET_ERROR;
+	    }
+	}
+    }
+    if (rc == SOCKET_ERROR) {
+	close(fd);
+	fd = INVALID_SOCKET;
+    }
+    return fd;
+}
+
+// Write requests until the connection's pipeline is full or the socket would block
+bool Client::tcprr_write (struct RRConn *conn) {
+    const int hdrlen = static_cast<int>(sizeof(struct TCP_burst_payload));
+    while (true) {
+	if ((conn->txleft == 0) && conn->flows) {
+	    if (!flows_next(conn))
+		break;
+	} else if (conn->txleft == 0) {
+	    if (!rr_running || (conn->inflight >= mSettings->mRRDepth))
+		break;
+	    if (mSettings->mRRRate > 0) {
+		// paced requests, a schedule which fell behind restarts from now
+		if (now.before(rr_next))
+		    break;
+		rr_next.add(1.0 / mSettings->mRRRate);
+		if (rr_next.before(now)) {
+		    rr_next = now;
+		    rr_next.add(1.0 / mSettings->mRRRate);
+		}
+	    }
+	    struct TCP_burst_payload *hdr = &conn->txhdr;
+	    uint32_t id = rr_burst_id++;
+	    hdr->start_tv_sec = htonl(myReport->info.ts.startTime.tv_sec);
+	    hdr->start_tv_usec = htonl(myReport->info.ts.startTime.tv_usec);
+	    hdr->send_tt.write_tv_sec = htonl(now.getSecs());
+	    hdr->send_tt.write_tv_usec = htonl(now.getUsecs());
+	    hdr->burst_id = htonl(id);
+	    hdr->burst_size = htonl(mSettings->mRRRequest);
+	    hdr->seqno_lower = htonl(id);
+	    hdr->reply_size = htonl(mSettings->mRRResponse);
+	    conn->txleft = mSettings->mRRRequest;
+	    conn->txsize = conn->txleft;
+	    conn->inflight++;
+	    rr_outstanding++;
+	    myTransactions[0].requests++;
+	    myTransactions[1].requests++;
+	    if (isModeAmount(mSettings)) {
+		if (mSettings->mAmount > static_cast<uintmax_t>(mSettings->mRRRequest)) {
+		    mSettings->mAmount -= mSettings->mRRRequest;
+		} else {
+		    mSettings->mAmount = 0;
+		    rr_running = false;
+		}
+	    }
+	}
+	// the header then filler from mBuf
+	struct iovec iov[2];
+	int iovcnt = 0;
+	int offset = conn->txsize - conn->txleft;
+	int bodyleft = conn->txleft;
+	if (offset < hdrlen) {
+	    iov[0].iov_base = reinterpret_cast<char *>(&conn->txhdr) + offset;
+	    iov[0].iov_len = hdrlen - offset;
+	    bodyleft -= hdrlen - offset;
+	    iovcnt++;
+	}
+	if (bodyleft > 0) {
+	    iov[iovcnt].iov_base = mBuf;
+	    iov[iovcnt].iov_len = (bodyleft < mSettings->mBufLen) ? bodyleft : mSettings->mBufLen;
+	    iovcnt++;
+	}
+	int n = writev(conn->fd, iov, iovcnt);
+	if (n < 0) {
+	    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+		conn->wantout = true;
+		return true;
+	    } else if (errno == EINTR) {
+		continue;
+	    }
+	    WARN_errno(1, "tcp-rr write");
+	    return false;
+	}
+	conn->txleft -= n;
+	totLen += n;
+	reportstruct->packetLen = n;
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+	reportstruct->sentTime = reportstruct->packetTime;
+	reportstruct->emptyreport = 0;
+	reportstruct->errwrite = WriteNoErr;
+	if (!one_report)
+	    myReportPacket();
+    }
+    conn->wantout = false;
+    return true;
+}
+
+// A response completed, its echoed header has the request's write time
+void Client::tcprr_done (struct RRConn *conn) {
+    Timestamp sent;
+    sent.set(ntohl(conn->rxhdr.send_tt.write_tv_sec), ntohl(conn->rxhdr.send_tt.write_tv_usec));
+    double rtt = now.subSec(sent);
+    if (rtt < 0)
+	rtt = 0;
+    meanminmax_update(&myTransactions[0].rtt, 1e3 * rtt);
+    meanminmax_update(&myTransactions[1].rtt, 1e3 * rtt);
+    histogram_insert(myTransactions[0].latency_histogram, rtt, NULL);
+    histogram_insert(myTransactions[1].latency_histogram, rtt, NULL);
+    if (conn->inflight > 0) {
+	conn->inflight--;
+	rr_outstanding--;
+    }
+}
+
+// Read and parse the responses, false on a peer close or an error
+bool Client::tcprr_read (struct RRConn *conn) {
+    const int hdrlen = static_cast<int>(sizeof(struct TCP_burst_payload));
+    while (true) {
+	int rc = recv(conn->fd, mBuf, mSettings->mBufLen, 0);
+	if (rc <= 0) {
+	    if (rc == 0)
+		return false;
+	    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+		return true;
+	    WARN_errno(1, "tcp-rr read");
+	    return false;
+	}
+	char *p = mBuf;
+	int n = rc;
+	while (n > 0) {
+	    if (conn->rxoff < hdrlen) {
+		int len = ((hdrlen - conn->rxoff) < n) ? (hdrlen - conn->rxoff) : n;
+		memcpy(reinterpret_cast<char *>(&conn->rxhdr) + conn->rxoff, p, len);
+		conn->rxoff += len;
+		p += len;
+		n -= len;
+		if (conn->rxoff < hdrlen)
+		    break;
+		int size = ntohl(conn->rxhdr.burst_size);
+		conn->rxleft = (size > hdrlen) ? (size - hdrlen) : 0;
+	    } else {
+		int len = (conn->rxleft < n) ? conn->rxleft : n;
+		conn->rxleft -= len;
+		p += len;
+		n -= len;
+	    }
+	    if (conn->rxleft == 0) {
+		if (conn->flows)
+		    flows_done(conn);
+		else
+		    tcprr_done(conn);
+		conn->rxoff = 0;
+	    }
+	}
+	// a short read drained the socket, epoll will say when there is more
+	if (rc < mSettings->mBufLen)
+	    return true;
+    }
+}
+
+// Service a connection, false once it's closed or the test's connection saw the peer close
+bool Client::tcprr_service (int efd, struct RRConn *conn, int connid, bool readable) {
+    bool wantout = conn->wantout;
+    bool ok = true;
+    if (readable)
+	ok = tcprr_read(conn);
+    if (ok)
+	ok = tcprr_write(conn);
+    if (!ok) {
+	// the other connections carry on, the first connection is also the test's
+	epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+	if (conn->fd != mySocket)
+	    close(conn->fd);
+	else
+	    peerclose = true;
+	conn->fd = INVALID_SOCKET;
+	rr_outstanding -= conn->inflight;
+	conn->inflight = 0;
+    } else if (conn->wantout != wantout) {
+	struct epoll_event ev;
+	ev.events = EPOLLIN | (conn->wantout ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	ev.data.u32 = connid;
+	epoll_ctl(efd, EPOLL_CTL_MOD, conn->fd, &ev);
+    }
+    return ok;
+}
+
+void Client::RunTcpRR () {
+    int nconns = mSettings->mRRConns;
+    int active = 0;
+    int ix;
+    int efd = epoll_create1(EPOLL_CLOEXEC);
+    if (efd < 0) {
+	WARN_errno(1, "epoll_create1");
+	FinishTrafficActions();
+	return;
+    }
+    struct RRConn *conns = new struct RRConn[nconns];
+    struct epoll_event *events = new struct epoll_event[nconns];
+    memset(conns, 0, sizeof(struct RRConn) * nconns);
+    for (ix = 0; ix < nconns; ix++) {
+	conns[ix].fd = (ix == 0) ? mySocket : tcprr_connect();
+	if (conns[ix].fd == INVALID_SOCKET)
+	    continue;
+	setsock_blocking(conns[ix].fd, false);
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u32 = ix;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, conns[ix].fd, &ev) == 0) {
+	    active++;
+	} else {
+	    WARN_errno(1, "epoll_ctl");
+	    if (ix)
+		close(conns[ix].fd);
+	    conns[ix].fd = INVALID_SOCKET;
+	}
+    }
+    // [0] is the interval, [1] the totals
+    for (ix = 0; ix < 2; ix++) {
+	memset(&myTransactions[ix], 0, sizeof(struct TransactionInfo));
+	TransactionStatsReset(&myTransactions[ix]);
+	myTransactions[ix].transferID = mSettings->mTransferID;
+	myTransactions[ix].request = mSettings->mRRRequest;
+	myTransactions[ix].response = mSettings->mRRResponse;
+	myTransactions[ix].depth = mSettings->mRRDepth;
+	myTransactions[ix].conns = active;
+	myTransactions[ix].histogram_pdf = isHistogram(mSettings);
+	myTransactions[ix].latency_histogram = transaction_histogram(mSettings);
+    }
+    myTransactions[1].final = 1;
+    if (isRPMProbe(mSettings)) {
+	myTransactions[1].rpm = 1;
+	rpm_epoch.set(mSettings->rpm_load_epoch.tv_sec, mSettings->rpm_load_epoch.tv_usec);
+    }
+    rr_running = true;
+    rr_outstanding = 0;
+    rr_burst_id = 1;
+    Timestamp start;
+    Timestamp nextreport;
+    Timestamp drain;
+    bool draining = false;
+    if (mSettings->mInterval > 0)
+	nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+    now.setnow();
+    rr_next = now;
+    for (ix = 0; ix < nconns; ix++) {
+	if ((conns[ix].fd != INVALID_SOCKET) && !tcprr_write(&conns[ix])) {
+	    peerclose = true;
+	    break;
+	}
+    }
+    while (!sInterupted && !peerclose && active && (rr_running || rr_outstanding)) {
+	if (rr_running && isModeTime(mSettings) && !now.before(mEndTime))
+	    rr_running = false;
+	if (!rr_running) {
+	    if (!draining) {
+		draining = true;
+		drain = now;
+		drain.add(TCPRR_DRAIN_TIMEOUT);
+	    } else if (!now.before(drain)) {
+		break;
+	    }
+	}
+	int timeout = 10;
+	if (rr_running && (mSettings->mRRRate > 0)) {
+	    // wake up for the next paced request
+	    long usecs = rr_next.subUsec(now);
+	    if (usecs < 0)
+		usecs = 0;
+	    if (usecs < 10000)
+		timeout = static_cast<int>((usecs + 999) / 1000);
+	}
+	int n = epoll_wait(efd, events, nconns, timeout);
+	if ((n < 0) && (errno != EINTR)) {
+	    WARN_errno(1, "epoll_wait");
+	    break;
+	}
+	now.setnow();
+	if (isRPMProbe(mSettings) && (myTransactions[1].rpm == 1) && !now.before(rpm_epoch))
+	    rpm_phase(now.subSec(start));
+	for (int jx = 0; jx < n; jx++) {
+	    struct RRConn *conn = &conns[events[jx].data.u32];
+	    if ((conn->fd != INVALID_SOCKET) && \
+		!tcprr_service(efd, conn, events[jx].data.u32, (events[jx].events & (EPOLLIN | EPOLLERR | EPOLLHUP))))
+		active--;
+	}
+	if (rr_running && (mSettings->mRRRate > 0) && !now.before(rr_next)) {
+	    for (ix = 0; ix < nconns; ix++) {
+		if ((conns[ix].fd != INVALID_SOCKET) && !conns[ix].wantout && !tcprr_service(efd, &conns[ix], ix, false))
+		    active--;
+	    }
+	}
+	// the tick at the end time is left to the trailing interval, which takes the drained responses too
+	if ((mSettings->mInterval > 0) && !now.before(nextreport) && (!isModeTime(mSettings) || nextreport.before(mEndTime))) {
+	    myTransactions[0].iEnd = nextreport.subSec(start);
+	    PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[0]));
+	    TransactionStatsReset(&myTransactions[0]);
+	    myTransactions[0].latency_histogram = transaction_histogram(mSettings);
+	    myTransactions[0].iStart = myTransactions[0].iEnd;
+	    nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+	}
+    }
+    now.setnow();
+    myTransactions[0].iEnd = now.subSec(start);
+    // responses drained after the stop count in the trailing interval too
+    if ((mSettings->mInterval > 0) && (myTransactions[0].iEnd > myTransactions[0].iStart) && \
+	(myTransactions[0].requests || myTransactions[0].rtt.cnt))
+	PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[0]));
+    myTransactions[1].iEnd = myTransactions[0].iEnd;
+    PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[1]));
+    if (myTransactions[0].latency_histogram)
+	histogram_delete(myTransactions[0].latency_histogram);
+    for (ix = 1; ix < nconns; ix++) {
+	if (conns[ix].fd != INVALID_SOCKET) {
+	    shutdown(conns[ix].fd, SHUT_WR);
+	    close(conns[ix].fd);
+	}
+    }
+    close(efd);
+    DELETE_ARRAY(conns);
+    DELETE_ARRAY(events);
+    // the test's socket goes back to blocking for the server close event
+    setsock_blocking(mySocket, true);
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    FinishTrafficActions();
+}
+
+/*
+ * The --flows workload opens flows of sizes drawn from a distribution,
+ * e.g. an empirical CDF, with poisson or periodic arrivals at a load
+ * which is a fraction of the -b link rate.  A flow is a --tcp-rr
+ * request of the flow's size answered with a bare header, its
+ * completion time (fct) runs from its arrival to the answer.  Flows run
+ * over a pool of connections, queued behind one another on the least
+ * loaded one, or each over a fresh connection whose connect is part of
+ * its fct.  Open loop, an arrival which finds every slot or queue full
+ * is counted as an overrun.
+ */
+
+// Start the next flow queued on the connection, false when every queued flow is written
+bool Client::flows_next (struct RRConn *conn) {
+    if (conn->inflight >= conn->flowcnt)
+	return false;
+    struct FlowPending *flow = &conn->flows[(conn->flowhead + conn->inflight) % conn->flowcap];
+    struct TCP_burst_payload *hdr = &conn->txhdr;
+    uint32_t id = rr_burst_id++;
+    hdr->start_tv_sec = htonl(myReport->info.ts.startTime.tv_sec);
+    hdr->start_tv_usec = htonl(myReport->info.ts.startTime.tv_usec);
+    hdr->send_tt.write_tv_sec = htonl(now.getSecs());
+    hdr->send_tt.write_tv_usec = htonl(now.getUsecs());
+    hdr->burst_id = htonl(id);
+    hdr->burst_size = htonl(flow->size);
+    hdr->seqno_lower = htonl(id);
+    hdr->reply_size = htonl(sizeof(struct TCP_burst_payload));
+    conn->txleft = flow->size;
+    conn->txsize = flow->size;
+    conn->inflight++;
+    rr_outstanding++;
+    return true;
+}
+
+// The connection's oldest flow was answered, responses come back in order
+void Client::flows_done (struct RRConn *conn) {
+    struct FlowPending *flow = &conn->flows[conn->flowhead];
+    double fct = now.subSec(flow->arrival);
+    if (fct < 0)
+	fct = 0;
+    for (int ix = 0; ix < 2; ix++) {
+	myFlows[ix].done++;
+	myFlows[ix].bytes += flow->size;
+	meanminmax_update(&myFlows[ix].fct, 1e3 * fct);
+    }
+    if (myFlows[1].samplecnt == flows_samplesize) {
+	intmax_t size = flows_samplesize ? (2 * flows_samplesize) : 1024;
+	struct FlowSample *samples = static_cast<struct FlowSample *>(realloc(myFlows[1].samples, size * sizeof(struct FlowSample)));
+	if (samples) {
+	    myFlows[1].samples = samples;
+	    flows_samplesize = size;
+	}
+    }
+    if (myFlows[1].samplecnt < flows_samplesize) {
+	myFlows[1].samples[myFlows[1].samplecnt].fct = fct;
+	myFlows[1].samples[myFlows[1].samplecnt].size = flow->size;
+	myFlows[1].samplecnt++;
+    }
+    conn->flowhead = (conn->flowhead + 1) % conn->flowcap;
+    conn->flowcnt--;
+    flows_queued--;
+    if (conn->inflight > 0) {
+	conn->inflight--;
+	rr_outstanding--;
+    }
+}
+
+// Start a fresh connection for a flow, the test header goes out once it's connected
+bool Client::flows_connect (int efd, struct RRConn *conn, int connid) {
+    int domain = (SockAddr_isIPv6(&mSettings->peer) ?
+#ifdef HAVE_IPV6
+                  AF_INET6
+#else
+                  AF_INET
+#endif
+                  : AF_INET);
+    conn->fd = socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn->fd == INVALID_SOCKET)
+	return false;
+    mSettings->mSock = conn->fd;
+    SetSocketOptions(mSettings);
+    mSettings->mSock = mySocket;
+    int rc = 0;
+    if (mSettings->mLocalhost != NULL) {
+	iperf_sockaddr local = mSettings->local;
+	SockAddr_setPortAny(&local);
+	rc = bind(conn->fd, reinterpret_cast<sockaddr*>(&local), SockAddr_get_sizeof_sockaddr(&local));
+    }
+    if (rc != SOCKET_ERROR) {
+	rc = connect(conn->fd, reinterpret_cast<sockaddr*>(&mSettings->peer), SockAddr_get_sizeof_sockaddr(&mSettings->peer));
+	if ((rc == SOCKET_ERROR) && (errno == EINPROGRESS))
+	    rc = 0;
+    }
+    if (rc != SOCKET_ERROR) {
+	// a connect which completed at once still gets its EPOLLOUT
+	struct epoll_event ev;
+	ev.events = EPOLLOUT;
+	ev.data.u32 = connid;
+	rc = epoll_ctl(efd, EPOLL_CTL_ADD, conn->fd, &ev);
+    }
+    if (rc == SOCKET_ERROR) {
+	close(conn->fd);
+	conn->fd = INVALID_SOCKET;
+	return false;
+    }
+    conn->connecting = true;
+    conn->wantout = false;
+    conn->inflight = 0;
+    conn->txleft = 0;
+    conn->rxoff = 0;
+    conn->rxleft = 0;
+    conn->flowhead = 0;
+    conn->flowcnt = 0;
+    return true;
+}
+
+// A fresh connection completed its connect, send the test header
+bool Client::flows_connected (int efd, struct RRConn *conn, int connid) {
+    int err = 0;
+    Socklen_t errlen = sizeof(err);
+    if ((getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err), &errlen) < 0) || err)
+	return false;
+    int len = Settings_GenerateClientHdr(mSettings, (void *) mBuf, \
+					 (isTxStartTime(mSettings) ? mSettings->txstart_epoch : myReport->info.ts.startTime));
+    // the socket's send buffer is empty so the header goes out whole or not at all
+    if ((len <= 0) || (write(conn->fd, mBuf, len) != len))
+	return false;
+    conn->connecting = false;
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = connid;
+    return (epoll_ctl(efd, EPOLL_CTL_MOD, conn->fd, &ev) == 0);
+}
+
+void Client::RunFlows () {
+    struct pdf_sampler *sizes = pdf_sampler_parse(mSettings->mFlowSizes);
+    int efd = epoll_create1(EPOLL_CLOEXEC);
+    if (!sizes || (efd < 0)) {
+	WARN_errno(efd < 0, "epoll_create1");
+	if (efd >= 0)
+	    close(efd);
+	pdf_sampler_free(sizes);
+	FinishTrafficActions();
+	return;
+    }
+    const int hdrlen = static_cast<int>(sizeof(struct TCP_burst_payload));
+    bool fresh = (mSettings->mFlowPool == 0);
+    int nconns = fresh ? FLOWS_INFLIGHT : mSettings->mFlowPool;
+    int flowcap = fresh ? 1 : FLOWS_QUEUE;
+    int active = 0;
+    int ix;
+    struct RRConn *conns = new struct RRConn[nconns];
+    struct FlowPending *pending = new struct FlowPending[nconns * flowcap];
+    struct epoll_event *events = new struct epoll_event[nconns];
+    int *freeconns = new int[nconns];
+    int nfree = 0;
+    memset(conns, 0, sizeof(struct RRConn) * nconns);
+    for (ix = 0; ix < nconns; ix++) {
+	conns[ix].fd = INVALID_SOCKET;
+	conns[ix].flows = &pending[ix * flowcap];
+	conns[ix].flowcap = flowcap;
+	if (fresh) {
+	    freeconns[nfree++] = nconns - 1 - ix;
+	    continue;
+	}
+	conns[ix].fd = (ix == 0) ? mySocket : tcprr_connect();
+	if (conns[ix].fd == INVALID_SOCKET)
+	    continue;
+	setsock_blocking(conns[ix].fd, false);
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u32 = ix;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, conns[ix].fd, &ev) == 0) {
+	    active++;
+	} else {
+	    WARN_errno(1, "epoll_ctl");
+	    if (ix)
+		close(conns[ix].fd);
+	    conns[ix].fd = INVALID_SOCKET;
+	}
+    }
+    // [0] is the interval, [1] the totals
+    for (ix = 0; ix < 2; ix++) {
+	memset(&myFlows[ix], 0, sizeof(struct FlowInfo));
+	FlowStatsReset(&myFlows[ix]);
+	myFlows[ix].transferID = mSettings->mTransferID;
+	myFlows[ix].load = mSettings->mFlowLoad;
+	myFlows[ix].linkrate = static_cast<double>(mSettings->mAppRate);
+	myFlows[ix].pool = fresh ? 0 : active;
+	myFlows[ix].periodic = (mSettings->mFlowArrivals == FLOWS_PERIODIC);
+    }
+    myFlows[1].final = 1;
+    flows_samplesize = 0;
+    flows_queued = 0;
+    rr_outstanding = 0;
+    rr_burst_id = 1;
+    // flows per second such that the mean flow size offers the load
+    double gap = 8.0 * pdf_sampler_mean(sizes) / (mSettings->mFlowLoad * mSettings->mAppRate);
+    struct pdf_sampler *arrivals = pdf_sampler_init(((mSettings->mFlowArrivals == FLOWS_PERIODIC) ? PDF_CONSTANT : PDF_EXPONENTIAL), gap, 0);
+    Timestamp start;
+    Timestamp nextarrival;
+    Timestamp nextreport;
+    Timestamp drain;
+    bool arriving = (arrivals != NULL) && (fresh || active);
+    if (mSettings->mInterval > 0)
+	nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+    while (!sInterupted && !peerclose && (arriving || flows_queued)) {
+	now.setnow();
+	if (arriving && (isModeTime(mSettings) && !now.before(mEndTime))) {
+	    arriving = false;
+	    drain = now;
+	    drain.add(FLOWS_DRAIN_TIMEOUT);
+	} else if (!arriving && !now.before(drain)) {
+	    break;
+	}
+	while (arriving && !now.before(nextarrival)) {
+	    double size = pdf_sample(sizes);
+	    int flowsize = (size < hdrlen) ? hdrlen : ((size > (INT_MAX / 2)) ? (INT_MAX / 2) : static_cast<int>(size));
+	    myFlows[0].arrivals++;
+	    myFlows[1].arrivals++;
+	    int connid = -1;
+	    if (fresh) {
+		if (nfree) {
+		    connid = freeconns[--nfree];
+		    if (!flows_connect(efd, &conns[connid], connid)) {
+			myFlows[0].fails++;
+			myFlows[1].fails++;
+			freeconns[nfree++] = connid;
+			connid = -1;
+		    }
+		} else {
+		    myFlows[0].overruns++;
+		    myFlows[1].overruns++;
+		}
+	    } else {
+		// the least loaded connection of the pool
+		for (ix = 0; ix < nconns; ix++) {
+		    if ((conns[ix].fd != INVALID_SOCKET) && (conns[ix].flowcnt < flowcap) && \
+			((connid < 0) || (conns[ix].flowcnt < conns[connid].flowcnt)))
+			connid = ix;
+		}
+		if (connid < 0) {
+		    myFlows[0].overruns++;
+		    myFlows[1].overruns++;
+		}
+	    }
+	    if (connid >= 0) {
+		struct RRConn *conn = &conns[connid];
+		struct FlowPending *flow = &conn->flows[(conn->flowhead + conn->flowcnt) % flowcap];
+		flow->arrival = nextarrival;
+		flow->size = flowsize;
+		conn->flowcnt++;
+		flows_queued++;
+		if (!fresh && !conn->wantout && !tcprr_service(efd, conn, connid, false)) {
+		    myFlows[0].fails += conn->flowcnt;
+		    myFlows[1].fails += conn->flowcnt;
+		    flows_queued -= conn->flowcnt;
+		    conn->flowcnt = 0;
+		}
+	    }
+	    if (isModeAmount(mSettings)) {
+		if (mSettings->mAmount > static_cast<uintmax_t>(flowsize)) {
+		    mSettings->mAmount -= flowsize;
+		} else {
+		    mSettings->mAmount = 0;
+		    arriving = false;
+		    drain = now;
+		    drain.add(FLOWS_DRAIN_TIMEOUT);
+		}
+	    }
+	    nextarrival.add(pdf_sample(arrivals));
+	}
+	// wait no longer than the next arrival
+	int timeout = 10;
+	if (arriving) {
+	    long usecs = nextarrival.subUsec(now);
+	    if (usecs < timeout * 1000)
+		timeout = (usecs > 0) ? static_cast<int>((usecs + 999) / 1000) : 0;
+	}
+	int n = epoll_wait(efd, events, nconns, timeout);
+	if ((n < 0) && (errno != EINTR)) {
+	    WARN_errno(1, "epoll_wait");
+	    break;
+	}
+	now.setnow();
+	for (int jx = 0; jx < n; jx++) {
+	    int connid = events[jx].data.u32;
+	    struct RRConn *conn = &conns[connid];
+	    if (conn->fd == INVALID_SOCKET)
+		continue;
+	    bool ok;
+	    if (conn->connecting) {
+		ok = flows_connected(efd, conn, connid) && tcprr_service(efd, conn, connid, false);
+		if (!ok && (conn->fd != INVALID_SOCKET)) {
+		    epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+		    close(conn->fd);
+		    conn->fd = INVALID_SOCKET;
+		}
+	    } else {
+		ok = tcprr_service(efd, conn, connid, (events[jx].events & (EPOLLIN | EPOLLERR | EPOLLHUP)));
+	    }
+	    if (!ok) {
+		// the flows of a failed connection fail with it
+		myFlows[0].fails += conn->flowcnt;
+		myFlows[1].fails += conn->flowcnt;
+		flows_queued -= conn->flowcnt;
+		conn->flowcnt = 0;
+		if (fresh)
+		    freeconns[nfree++] = connid;
+	    } else if (fresh && !conn->flowcnt) {
+		// the flow is done, as is its connection
+		epoll_ctl(efd, EPOLL_CTL_DEL, conn->fd, NULL);
+		close(conn->fd);
+		conn->fd = INVALID_SOCKET;
+		freeconns[nfree++] = connid;
+	    }
+	}
+	if ((mSettings->mInterval > 0) && !now.before(nextreport)) {
+	    myFlows[0].iEnd = nextreport.subSec(start);
+	    PostReportInOrder(myReport, InitFlowReport(mSettings, &myFlows[0]));
+	    FlowStatsReset(&myFlows[0]);
+	    myFlows[0].iStart = myFlows[0].iEnd;
+	    nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+	}
+    }
+    // flows which didn't complete in time fail
+    myFlows[0].fails += flows_queued;
+    myFlows[1].fails += flows_queued;
+    now.setnow();
+    myFlows[0].iEnd = now.subSec(start);
+    if ((mSettings->mInterval > 0) && (myFlows[0].iEnd > myFlows[0].iStart) && (myFlows[0].arrivals || myFlows[0].done))
+	PostReportInOrder(myReport, InitFlowReport(mSettings, &myFlows[0]));
+    myFlows[1].iEnd = myFlows[0].iEnd;
+    PostReportInOrder(myReport, InitFlowReport(mSettings, &myFlows[1]));
+    for (ix = 0; ix < nconns; ix++) {
+	if ((conns[ix].fd != INVALID_SOCKET) && (conns[ix].fd != mySocket)) {
+	    shutdown(conns[ix].fd, SHUT_WR);
+	    close(conns[ix].fd);
+	}
+    }
+    close(efd);
+    pdf_sampler_free(sizes);
+    pdf_sampler_free(arrivals);
+    DELETE_ARRAY(conns);
+    DELETE_ARRAY(pending);
+    DELETE_ARRAY(events);
+    DELETE_ARRAY(freeconns);
+    setsock_blocking(mySocket, true);
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    FinishTrafficActions();
+}
+#endif
 /* -------------------------------------------------------------------
  * Common traffic loop intializations
  * ------------------------------------------------------------------- */
@@ -529,11 +1650,22 @@ void Client::Run () {
 	// Launch the approprate UDP traffic loop
 	if (isIsochronous(mSettings)) {
 	    RunUDPIsochronous();
+	} else if (isUDPEcho(mSettings)) {
+	    RunUDPEcho();
 	} else {
 	    RunUDP();
 	}
     } else {
 	// Launch the approprate TCP traffic loop
+#if HAVE_SYS_EPOLL_H
+	if (isFlows(mSettings)) {
+	    RunFlows();
+	    return;
+	} else if (isTcpRR(mSettings)) {
+	    RunTcpRR();
+	    return;
+	}
+#endif
 	if (mSettings->mAppRate > 0) {
 	    RunRateLimitedTCP();
 	} else if (isNearCongest(mSettings)) {
@@ -610,7 +1742,12 @@ void Client::RunTCP () {
 	    // perform write
 	    if (isburst)
 		writelen = (mSettings->mBufLen > burst_remaining) ? burst_remaining : mSettings->mBufLen;
-	    reportstruct->packetLen = write(mySocket, mBuf, writelen);
+	    if (verifyPattern) {
+		// the stream carries the pattern per its offset, short writes included
+		reportstruct->packetLen = write(mySocket, verifyPattern + (verifyOffset & (PAYLOADVERIFY_PERIOD - 1)), writelen);
+	    } else {
+		reportstruct->packetLen = write(mySocket, mBuf, writelen);
+	    }
 	    now.setnow();
 	    reportstruct->packetTime.tv_sec = now.getSecs();
 	    reportstruct->packetTime.tv_usec = now.getUsecs();
@@ -634,6 +1771,8 @@ void Client::RunTCP () {
 	    reportstruct->emptyreport = 0;
 	    totLen += reportstruct->packetLen;
 	    reportstruct->errwrite=WriteNoErr;
+	    if (verifyPattern)
+		verifyOffset += reportstruct->packetLen;
 	    if (isburst) {
 		burst_remaining -= reportstruct->packetLen;
 		if (burst_remaining > 0) {
@@ -1205,6 +2344,323 @@ void Client::RunUDPIsochronous () {
 }
 // end RunUDPIsoch
 
+/*
+ * The --udp-echo probe loop.  Probes are paced per -b (or the pps
+ * rate) and written in batches of up to UDPECHO_BATCH per sendmmsg,
+ * each with its own UDP_datagram header ahead of the mBuf payload.
+ * The server reflects the header so the RTT is taken against the
+ * probe's own send timestamp, i.e. no clock sync.  Echoes are drained
+ * per recvmmsg between the batches and the thread waits in select
+ * only when no probe is due.  Loss and reordering are counted per
+ * direction, forward from the counts the server puts in its echoes
+ * and reverse from the server's echo ids.
+ */
+#ifdef HAVE_RECVMMSG
+#define UDPECHO_RXHDR(echo, ix) (echo->rxmsgs[ix].msg_hdr)
+#else
+#define UDPECHO_RXHDR(echo, ix) (echo->rxmsgs[ix])
+#endif
+struct UDPEcho {
+    struct UDP_datagram probes[UDPECHO_BATCH];
+    struct iovec txiovs[UDPECHO_BATCH][2];
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr txmsgs[UDPECHO_BATCH];
+#endif
+    struct UDP_echo_payload echoes[UDPECHO_BATCH];
+    struct iovec rxiovs[UDPECHO_BATCH];
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr rxmsgs[UDPECHO_BATCH];
+#else
+    struct msghdr rxmsgs[1];
+#endif
+    int rxlens[UDPECHO_BATCH];
+    intmax_t probes_sent;
+    intmax_t echoed;
+    intmax_t max_echo_id;
+    intmax_t fwd_lost; // the latest of the server's cumulative counts
+    intmax_t unresolved; // probes neither echoed nor known lost when the drain ended
+    intmax_t fwd_outoforder;
+    intmax_t rev_outoforder;
+};
+
+// Write count probes, returns the number written
+int Client::udpecho_send (struct UDPEcho *echo, int count) {
+    const int hdrlen = static_cast<int>(sizeof(struct UDP_datagram));
+    int len = mSettings->mBufLen;
+    if (isModeAmount(mSettings) && (mSettings->mAmount < static_cast<uintmax_t>(count * len)))
+	count = static_cast<int>((mSettings->mAmount + len - 1) / len);
+    intmax_t id = reportstruct->packetID;
+    for (int ix = 0; ix < count; ix++, id++) {
+	struct UDP_datagram *probe = &echo->probes[ix];
+	probe->id = htonl(static_cast<uint32_t>(id & 0xFFFFFFFFLL));
+	probe->id2 = htonl(static_cast<uint32_t>((id & 0xFFFFFFFF00000000LL) >> 32));
+	probe->tv_sec = htonl(now.getSecs());
+	probe->tv_usec = htonl(now.getUsecs());
+	echo->txiovs[ix][0].iov_base = probe;
+	echo->txiovs[ix][0].iov_len = hdrlen;
+	echo->txiovs[ix][1].iov_base = mBuf + hdrlen;
+	echo->txiovs[ix][1].iov_len = len - hdrlen;
+    }
+    int sent = 0;
+#ifdef HAVE_SENDMMSG
+    while (sent < count) {
+	int rc = sendmmsg(mySocket, &echo->txmsgs[sent], count - sent, 0);
+	if (rc <= 0)
+	    break;
+	sent += rc;
+    }
+#else
+    for (; sent < count; sent++) {
+	if (writev(mySocket, echo->txiovs[sent], 2) < 0)
+	    break;
+    }
+#endif
+    if ((sent < count) && FATALUDPWRITERR(errno)) {
+	WARN_errno(1, "udp-echo write");
+	peerclose = true;
+    }
+    if (sent > 0) {
+	echo->probes_sent += sent;
+	myTransactions[0].requests += sent;
+	myTransactions[1].requests += sent;
+	if (isModeAmount(mSettings)) {
+	    uintmax_t bytes = static_cast<uintmax_t>(sent) * len;
+	    mSettings->mAmount = (mSettings->mAmount > bytes) ? (mSettings->mAmount - bytes) : 0;
+	}
+	// one report per batch
+	reportstruct->packetID += sent - 1;
+	reportstruct->burstsize = sent;
+	reportstruct->packetLen = static_cast<unsigned long>(sent) * len;
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+	reportstruct->sentTime = reportstruct->packetTime;
+	reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+	reportstruct->errwrite = WriteNoErr;
+	reportstruct->emptyreport = 0;
+	myReportPacket();
+	reportstruct->burstsize = 0;
+	reportstruct->packetID++;
+	myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+    }
+    return sent;
+}
+
+// Read the echoes that are ready, returns the number read
+int Client::udpecho_recv (struct UDPEcho *echo) {
+    int total = 0;
+    int n;
+    do {
+#ifdef HAVE_RECVMMSG
+	int batch = UDPECHO_BATCH;
+#else
+	int batch = 1;
+#endif
+	for (int ix = 0; ix < batch; ix++) {
+	    struct msghdr *hdr = &UDPECHO_RXHDR(echo, ix);
+	    echo->rxiovs[ix].iov_base = &echo->echoes[ix];
+	    echo->rxiovs[ix].iov_len = sizeof(struct UDP_echo_payload);
+	    hdr->msg_iov = &echo->rxiovs[ix];
+	    hdr->msg_iovlen = 1;
+	    hdr->msg_flags = 0;
+	}
+#ifdef HAVE_RECVMMSG
+	n = recvmmsg(mySocket, echo->rxmsgs, batch, MSG_DONTWAIT, NULL);
+	for (int ix = 0; ix < n; ix++)
+	    echo->rxlens[ix] = echo->rxmsgs[ix].msg_len;
+#else
+	n = recvmsg(mySocket, &echo->rxmsgs[0], MSG_DONTWAIT);
+	if (n >= 0) {
+	    echo->rxlens[0] = n;
+	    n = 1;
+	}
+#endif
+	if (n <= 0)
+	    break;
+	now.setnow();
+	for (int ix = 0; ix < n; ix++) {
+	    // anything else, e.g. a stale header ack, isn't an echo
+	    if ((echo->rxlens[ix] != static_cast<int>(sizeof(struct UDP_echo_payload))) || \
+		(UDPECHO_RXHDR(echo, ix).msg_flags & MSG_TRUNC))
+		continue;
+	    struct UDP_echo_payload *reply = &echo->echoes[ix];
+	    Timestamp sent;
+	    sent.set(ntohl(reply->probe.tv_sec), ntohl(reply->probe.tv_usec));
+	    double rtt = now.subSec(sent);
+	    if (rtt < 0)
+		rtt = 0;
+	    meanminmax_update(&myTransactions[0].rtt, 1e3 * rtt);
+	    meanminmax_update(&myTransactions[1].rtt, 1e3 * rtt);
+	    histogram_insert(myTransactions[0].latency_histogram, rtt, NULL);
+	    histogram_insert(myTransactions[1].latency_histogram, rtt, NULL);
+	    echo->echoed++;
+	    intmax_t echo_id = ntohl(reply->echo_id);
+	    if (echo_id > echo->max_echo_id) {
+		echo->max_echo_id = echo_id;
+		echo->fwd_lost = ntohl(reply->fwd_lost);
+		echo->fwd_outoforder = ntohl(reply->fwd_outoforder);
+	    } else {
+		echo->rev_outoforder++;
+	    }
+	}
+	total += n;
+    } while (n == UDPECHO_BATCH);
+    return total;
+}
+
+// Fill in the loss and reordering counts of a report from the running totals less those of the last report
+static void udpecho_loss (struct UDPEcho *echo, struct TransactionInfo *report, struct TransactionInfo *base) {
+    intmax_t rev_lost = ((echo->max_echo_id > echo->echoed) ? (echo->max_echo_id - echo->echoed) : 0) + echo->unresolved;
+    report->fwd_lost = echo->fwd_lost - base->fwd_lost;
+    report->fwd_outoforder = echo->fwd_outoforder - base->fwd_outoforder;
+    report->rev_lost = rev_lost - base->rev_lost;
+    report->rev_outoforder = echo->rev_outoforder - base->rev_outoforder;
+    base->fwd_lost = echo->fwd_lost;
+    base->fwd_outoforder = echo->fwd_outoforder;
+    base->rev_lost = rev_lost;
+    base->rev_outoforder = echo->rev_outoforder;
+}
+
+void Client::RunUDPEcho () {
+    struct UDPEcho *echo = new struct UDPEcho;
+    memset(echo, 0, sizeof(struct UDPEcho));
+#ifdef HAVE_SENDMMSG
+    for (int ix = 0; ix < UDPECHO_BATCH; ix++) {
+	echo->txmsgs[ix].msg_hdr.msg_iov = echo->txiovs[ix];
+	echo->txmsgs[ix].msg_hdr.msg_iovlen = 2;
+    }
+#endif
+    // [0] is the interval, [1] the totals
+    for (int ix = 0; ix < 2; ix++) {
+	memset(&myTransactions[ix], 0, sizeof(struct TransactionInfo));
+	TransactionStatsReset(&myTransactions[ix]);
+	myTransactions[ix].transferID = mSettings->mTransferID;
+	myTransactions[ix].udpecho = 1;
+	myTransactions[ix].request = mSettings->mBufLen;
+	myTransactions[ix].response = static_cast<int>(sizeof(struct UDP_echo_payload));
+	myTransactions[ix].depth = 1;
+	myTransactions[ix].conns = 1;
+	myTransactions[ix].histogram_pdf = isHistogram(mSettings);
+	myTransactions[ix].latency_histogram = transaction_histogram(mSettings);
+    }
+    myTransactions[1].final = 1;
+    // The test header went out as the first datagram, id 1, with its
+    // send time and the server echoes it as any other, so it's probe one
+    if (reportstruct->packetID > 1) {
+	echo->probes_sent = reportstruct->packetID - 1;
+	myTransactions[0].requests = echo->probes_sent;
+	myTransactions[1].requests = echo->probes_sent;
+    }
+    if (isRPMProbe(mSettings)) {
+	myTransactions[1].rpm = 1;
+	rpm_epoch.set(mSettings->rpm_load_epoch.tv_sec, mSettings->rpm_load_epoch.tv_usec);
+    }
+    struct TransactionInfo base;
+    struct TransactionInfo totalbase;
+    memset(&base, 0, sizeof(struct TransactionInfo));
+    memset(&totalbase, 0, sizeof(struct TransactionInfo));
+    // units nanoseconds per probe, zero means as fast as possible
+    double delay_target = (isIPG(mSettings) || (mSettings->mAppRate > 0)) ? get_delay_target() : 0;
+    bool running = true;
+    bool draining = false;
+    Timestamp start;
+    Timestamp nextreport;
+    Timestamp drain;
+    Timestamp stop;
+    if (mSettings->mInterval > 0)
+	nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+    while (true) {
+	now.setnow();
+	if (running && (sInterupted || peerclose || (isModeTime(mSettings) && !now.before(mEndTime)) || \
+			(isModeAmount(mSettings) && (mSettings->mAmount <= 0))))
+	    running = false;
+	if (!running) {
+	    if (!draining) {
+		draining = true;
+		stop = now;
+		drain = now;
+		drain.add(UDPECHO_DRAIN_TIMEOUT);
+	    }
+	    // done when every probe is either echoed or known to be lost
+	    intmax_t rev_lost = (echo->max_echo_id > echo->echoed) ? (echo->max_echo_id - echo->echoed) : 0;
+	    if (sInterupted || peerclose || ((echo->echoed + echo->fwd_lost + rev_lost) >= echo->probes_sent) || !now.before(drain))
+		break;
+	}
+	int due = 0;
+	if (running) {
+	    if (delay_target > 0) {
+		double behind = (1e9 * now.subSec(start) / delay_target) + 1 - echo->probes_sent;
+		due = (behind > UDPECHO_BATCH) ? UDPECHO_BATCH : static_cast<int>(behind);
+	    } else {
+		due = UDPECHO_BATCH;
+	    }
+	    if (due > 0)
+		udpecho_send(echo, due);
+	}
+	int got = udpecho_recv(echo);
+	if (isRPMProbe(mSettings) && (myTransactions[1].rpm == 1) && !now.before(rpm_epoch)) {
+	    // the final loss counts are those of the loaded phase
+	    struct TransactionInfo idle;
+	    udpecho_loss(echo, &idle, &totalbase);
+	    rpm_phase(now.subSec(start));
+	}
+	if (running && (mSettings->mInterval > 0) && !now.before(nextreport)) {
+	    myTransactions[0].iEnd = nextreport.subSec(start);
+	    udpecho_loss(echo, &myTransactions[0], &base);
+	    PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[0]));
+	    TransactionStatsReset(&myTransactions[0]);
+	    myTransactions[0].latency_histogram = transaction_histogram(mSettings);
+	    myTransactions[0].iStart = myTransactions[0].iEnd;
+	    nextreport.add(static_cast<unsigned int>(mSettings->mInterval));
+	}
+	if ((due <= 0) && (got == 0)) {
+	    // nothing to do until the next probe is due or an echo arrives
+	    long usecs = 10000;
+	    if (running && (delay_target > 0)) {
+		long next = static_cast<long>((echo->probes_sent * delay_target / 1e3) - now.subUsec(start));
+		if (next < usecs)
+		    usecs = next;
+	    }
+	    if (usecs > 0) {
+		fd_set readSet;
+		struct timeval timeout;
+		FD_ZERO(&readSet);
+		FD_SET(mySocket, &readSet);
+		timeout.tv_sec = 0;
+		timeout.tv_usec = usecs;
+		if ((select(mySocket + 1, &readSet, NULL, NULL, &timeout) < 0) && (errno != EINTR)) {
+		    WARN_errno(1, "select");
+		    break;
+		}
+	    }
+	}
+    }
+    // Probes with no echo and no higher echo, e.g. the last ones or
+    // all of them when nothing comes back, are lost one way or the
+    // other, count them against the echo path
+    intmax_t rev_lost = (echo->max_echo_id > echo->echoed) ? (echo->max_echo_id - echo->echoed) : 0;
+    intmax_t unresolved = echo->probes_sent - echo->echoed - echo->fwd_lost - rev_lost;
+    if (unresolved > 0)
+	echo->unresolved = unresolved;
+    if (echo->probes_sent && !echo->echoed)
+	fprintf(stderr, "WARN: no echoes of %jd probes, the server may not support --udp-echo (e.g. --udp-demux)\n", echo->probes_sent);
+    // the echoes taken while draining count against the probe period
+    now.setnow();
+    myTransactions[0].iEnd = stop.subSec(start);
+    if ((mSettings->mInterval > 0) && (myTransactions[0].iEnd > myTransactions[0].iStart) && (myTransactions[0].requests || myTransactions[0].rtt.cnt)) {
+	udpecho_loss(echo, &myTransactions[0], &base);
+	PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[0]));
+    }
+    udpecho_loss(echo, &myTransactions[1], &totalbase);
+    myTransactions[1].iEnd = myTransactions[0].iEnd;
+    PostReportInOrder(myReport, InitTransactionReport(mSettings, &myTransactions[1]));
+    if (myTransactions[0].latency_histogram)
+	histogram_delete(myTransactions[0].latency_histogram);
+    DELETE_PTR(echo);
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    FinishTrafficActions();
+}
+
 inline void Client::WritePacketID (intmax_t packetID) {
     struct UDP_datagram * mBuf_UDP = reinterpret_cast<struct UDP_datagram *>(mBuf);
     // store datagram ID into buffer
@@ -1226,6 +2682,10 @@ inline void Client::WritePacketID (intmax_t packetID) {
 #else
     mBuf_UDP->id = htonl((reportstruct->packetID));
 #endif
+    if (verifyPattern) {
+	// the datagram's window of the pattern per its id, after the test header
+	memcpy(mBuf + PAYLOADVERIFY_UDPOFFSET, verifyPattern + payload_verify_phase(packetID), mSettings->mBufLen - PAYLOADVERIFY_UDPOFFSET);
+    }
 }
 
 inline void Client::WriteTcpTxHdr (struct ReportStruct *reportstruct, int burst_size, int burst_id) {
@@ -1355,7 +2815,11 @@ void Client::FinishTrafficActions () {
 	int rc = close(mySocket);
 	WARN_errno(rc == SOCKET_ERROR, "client close");
     }
-    Iperf_remove_host(mSettings);
+    if (mSettings->mScenarioGroup) {
+	scenario_group_remove(mSettings);
+    } else {
+	Iperf_remove_host(mSettings);
+    }
     FreeReport(myJob);
     if (framecounter)
 	DELETE_PTR(framecounter);
@@ -1398,6 +2862,9 @@ void Client::AwaitServerFinPacket () {
 	    // to contain the final server packet
 	    rc = read(mySocket, mBuf, MAXUDPBUF);
 
+	    // drop any --udp-echo echoes still in flight
+	    if (isUDPEcho(mSettings) && (rc == sizeof(struct UDP_echo_payload)))
+		continue;
 	    // dump any 2.0.13 client acks sent at the start of traffic
 	    if (rc == sizeof(client_hdr_ack)) {
 		struct client_hdr_ack *ack =  reinterpret_cast<struct client_hdr_ack *>(mBuf);
@@ -1489,6 +2956,11 @@ int Client::SendFirstPayload () {
 		pktlen = send(mySocket, mBuf, (pktlen > mSettings->mBufLen) ? pktlen : mSettings->mBufLen, 0);
 #endif
 		apply_first_udppkt_delay = true;
+	    } else if (tfo_deferred) {
+		pktlen = SendFirstPayloadTFO(pktlen);
+		if (isPeerVerDetect(mSettings) && !isServerReverse(mSettings)) {
+		    PeerXchange();
+		}
 	    } else {
 #if HAVE_DECL_MSG_DONTWAIT
 		pktlen = send(mySocket, mBuf, pktlen, MSG_DONTWAIT);
@@ -1502,9 +2974,52 @@ int Client::SendFirstPayload () {
 	    WARN_errno(pktlen < 0, "send_hdr");
 	}
     }
+    // No header to send, still complete a connect deferred per TCP fast open
+    if (tfo_deferred)
+	pktlen = SendFirstPayloadTFO(0);
     return pktlen;
 }
 
+/*
+ * The connect() was deferred per TCP_FASTOPEN_CONNECT so this write
+ * sends the SYN with (at least some of) the test header.  Wait for the
+ * handshake to complete so the connect time, and whether the server
+ * acked the SYN data, can be reported.  Then send any of the header
+ * which didn't fit in the SYN.  A zero length sends a SYN without
+ * data, completing the connect when there's no header to send.
+ */
+int Client::SendFirstPayloadTFO (int len) {
+    int sent = send(mySocket, mBuf, len, MSG_DONTWAIT);
+    if ((sent < 0) && (errno == EINPROGRESS))
+	sent = 0;
+    tfo_deferred = false;
+    if (sent >= 0) {
+	fd_set set;
+	struct timeval timeout;
+	int err = 0;
+	Socklen_t errlen = sizeof(err);
+	FD_ZERO(&set);
+	FD_SET(mySocket, &set);
+	timeout.tv_sec = TESTEXCHANGETIMEOUT / 1000000;
+	timeout.tv_usec = 0;
+	if ((select(mySocket + 1, NULL, &set, NULL, &timeout) == 1) && \
+	    (getsockopt(mySocket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err), &errlen) == 0) && !err) {
+	    connect_done.setnow();
+	    mSettings->connecttime = 1e3 * connect_done.subSec(connect_start);
+	    if (sent < len) {
+		int n = writen(mySocket, mBuf + sent, len - sent);
+		sent = (n < 0) ? n : (sent + n);
+	    }
+	} else {
+	    if (err)
+		errno = err;
+	    sent = -1;
+	}
+    }
+    PostConnectionReport((sent < 0) ? -1 : mSettings->connecttime);
+    return sent;
+}
+
 void Client::PeerXchange () {
     int n;
     client_hdr_ack ack;
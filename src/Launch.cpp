@@ -61,6 +61,8 @@
 #include "Server.hpp"
 #include "PerfSocket.hpp"
 #include "active_hosts.h"
+#include "scenario.h"
+#include "Locale.h"
 #include "SocketAddr.h"
 #include "delay.h"
 
@@ -120,8 +122,11 @@ int fullduplex_stop_barrier (struct BarrierMutex *barrier) {
  */
 void listener_spawn(struct thread_Settings *thread) {
     Listener *theListener = NULL;
-    // the Listener need to trigger a settings report
-    setReport(thread);
+    // the Listener need to trigger a settings report, only the first
+    // listener of a port does as it starts its --listeners (TCP) or
+    // --udp-demux siblings, which have a listener index above zero
+    if (thread->mListenerIndex == 0)
+	setReport(thread);
     // start up a listener
     theListener = new Listener(thread);
     // Start listening
@@ -144,6 +149,8 @@ void server_spawn(struct thread_Settings *thread) {
 #if HAVE_SCHED_SETSCHEDULER
     thread_setscheduler(thread);
 #endif
+    // pin before the allocations so they're node local
+    thread_setaffinity(thread);
     // Start up the server
     theServer = new Server(thread);
     if (isTxStartTime(thread)) {
@@ -169,7 +176,8 @@ static void clientside_client_basic (struct thread_Settings *thread, Client *the
 	// When -P > 1 then all threads finish connect before starting traffic
 	theClient->BarrierClient(thread->connects_done);
     if (theClient->isConnected()) {
-        if ((thread->mThreads > 1) || isSumOnly(thread))
+	// --scenario groups have their own sum, see scenario_init()
+        if (((thread->mThreads > 1) || isSumOnly(thread)) && !thread->mScenarioGroup)
 	    Iperf_push_host(thread);
 	theClient->StartSynch();
 	theClient->Run();
@@ -291,6 +299,12 @@ void client_spawn (struct thread_Settings *thread) {
 #if HAVE_SCHED_SETSCHEDULER
     thread_setscheduler(thread);
 #endif
+    // pin before the allocations so they're node local
+    thread_setaffinity(thread);
+    if (thread->mScenarioGroup) {
+	// a --scenario group waits out its start offset
+	clock_usleep_abstime(&thread->mScenarioGroup->start_time);
+    }
     // start up the client
     setTransferID(thread, 0);
     theClient = new Client(thread);
@@ -301,6 +315,10 @@ void client_spawn (struct thread_Settings *thread) {
     }
     Condition_Unlock(reporter_state.await);
 
+    if (isRPM(thread) && !isRPMProbe(thread)) {
+	// the bulk flows wait out the idle baseline of the --rpm probes
+	clock_usleep_abstime(&thread->rpm_load_epoch);
+    }
     if (isConnectOnly(thread)) {
 	theClient->ConnectPeriodic();
     } else if (!isServerReverse(thread)) {
@@ -340,6 +358,9 @@ void client_spawn (struct thread_Settings *thread) {
 void client_init(struct thread_Settings *clients) {
     struct thread_Settings *itr = NULL;
     struct thread_Settings *next = NULL;
+#ifdef HAVE_THREAD
+    struct thread_Settings *probe = NULL;
+#endif
 
     itr = clients;
     setReport(clients);
@@ -352,6 +373,11 @@ void client_init(struct thread_Settings *clients) {
         itr->runNow = next;
         itr = next;
     }
+    // The latency probes of --rpm run on a thread and socket of their
+    // own, generated first so the bulk copies inherit rpm_load_epoch
+    if (isRPM(clients)) {
+	Settings_GenerateRPMProbeSettings(clients, &probe);
+    }
     // For each of the needed threads create a copy of the
     // provided settings, unsetting the report flag and add
     // to the list of threads to start
@@ -383,6 +409,10 @@ void client_init(struct thread_Settings *clients) {
 	    }
 	}
     }
+    if (probe) {
+	itr->runNow = probe;
+	itr = probe;
+    }
 #else
     if (next != NULL) {
         // We don't have threads and we need to start a listener so
@@ -392,6 +422,60 @@ void client_init(struct thread_Settings *clients) {
 #endif
 }
 
+/*
+ * scenario_init sets up the flow groups of --scenario.  Each group is a
+ * client_init of its own settings and the groups are chained so they're
+ * all started by the one reporter.  A group's traffic threads wait out
+ * its start offset in client_spawn.  Returns the settings at the head of
+ * the chain which replace those of the command line
+ *
+ * Note: This runs in main thread context
+ */
+struct thread_Settings *scenario_init (struct thread_Settings *clients, struct ScenarioGroup *groups, int argc, char **argv) {
+    struct thread_Settings *head = NULL;
+    struct thread_Settings *itr = NULL;
+    struct SumReport *scenario_sum = NULL;
+    int count = 0;
+    int groupid = 0;
+    for (struct ScenarioGroup *group = groups; group != NULL; group = group->next)
+	count++;
+    Timestamp now;
+    struct timeval start;
+    start.tv_sec = now.getSecs();
+    start.tv_usec = now.getUsecs();
+    for (struct ScenarioGroup *group = groups; group != NULL; group = group->next) {
+	struct thread_Settings *settings = scenario_group_settings(group, argc, argv);
+	if (scenario_sum == NULL)
+	    scenario_sum = InitScenarioSumReport(settings, count, &start);
+	Timestamp groupstart = now;
+	groupstart.add(group->start);
+	group->start_time.tv_sec = groupstart.getSecs();
+	group->start_time.tv_usec = groupstart.getUsecs();
+	char *label = new char[strlen(group->name) + 4];
+	sprintf(label, "[%s] ", group->name);
+	group->sum_report = InitGroupSumReport(settings, ++groupid, label, scenario_sum);
+	DELETE_ARRAY(label);
+	HoldSumReport(group->sum_report);
+	group->threads = settings->mThreads * (1 + settings->mPortLast - settings->mPort);
+	group->connects_done.count = settings->mThreads;
+	settings->connects_done = &group->connects_done;
+	settings->mSumReport = group->sum_report;
+	// the groups' flows and sums report per the scenario's clock
+	settings->report_epoch = start;
+	printf(scenario_group_start, group->name, group->start, (group->options ? group->options : ""));
+	client_init(settings);
+	if (head == NULL) {
+	    head = settings;
+	} else {
+	    itr->runNow = settings;
+	}
+	for (itr = settings; itr->runNow != NULL; itr = itr->runNow);
+    }
+    fflush(stdout);
+    Settings_Destroy(clients);
+    return head;
+}
+
 void listeners_init(struct thread_Settings *listener) {
     struct thread_Settings *itr = listener;
     struct thread_Settings *next = NULL;
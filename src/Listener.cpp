@@ -83,9 +83,18 @@
 #include "SocketAddr.h"
 #include "payloads.h"
 #include "delay.h"
+#include "udp_demux.h"
 #if (defined HAVE_SSM_MULTICAST) && (defined HAVE_NET_IF_H)
 #include <net/if.h>
 #endif
+#if HAVE_DECL_CPU_SET
+#include <sched.h>
+#endif
+#if HAVE_SYS_EPOLL_H && HAVE_SYS_TIMERFD_H
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#define LISTENER_EPOLL 1
+#endif
 
 #if HAVE_DECL_MSG_WAITALL
 #define PEEK_FLAGS (MSG_PEEK | MSG_WAITALL)
@@ -101,6 +110,8 @@
 Listener::Listener (thread_Settings *inSettings) {
     mClients = inSettings->mThreads;
     ListenSocket = INVALID_SOCKET;
+    mEpollFd = -1;
+    mTimerFd = -1;
     /*
      * These thread settings are stored in three places
      *
@@ -126,6 +137,10 @@ Listener::~Listener () {
         int rc = close(ListenSocket);
         WARN_errno(rc == SOCKET_ERROR, "listener close");
     }
+    if (mTimerFd >= 0)
+	close(mTimerFd);
+    if (mEpollFd >= 0)
+	close(mEpollFd);
     DELETE_ARRAY(mBuf);
 } // end ~Listener
 
@@ -153,7 +168,16 @@ void Listener::Run () {
     }
     if (!isUDP(mSettings)) {
 	// TCP needs just one listen
-	my_listen(); // This will set ListenSocket to a new sock fd
+	if (mSettings->mListenerIndex > 0) {
+	    // a --listeners sibling whose socket was bound by the first listener
+	    ListenSocket = mSettings->mSock;
+	} else {
+	    my_listen(); // This will set ListenSocket to a new sock fd
+	    if (mSettings->mListeners > 1)
+		start_listeners();
+	}
+	if (isListenerCPU(mSettings))
+	    listener_affinity();
     }
     bool mMode_Time = isServerModeTime(mSettings) && !isDaemon(mSettings);
     if (mMode_Time) {
@@ -163,6 +187,13 @@ void Listener::Run () {
 	mEndTime.setnow();
 	mEndTime.add(mSettings->mListenerTimeout);
     }
+    if (isUDPDemux(mSettings)) {
+	udp_demux(mMode_Time);
+	return;
+    }
+#ifdef LISTENER_EPOLL
+    epoll_setup();
+#endif
     Timestamp now;
 #define SINGLECLIENTDELAY_DURATION 50000 // units is microseconds
     while (!sInterupted && mCount) {
@@ -180,13 +211,11 @@ void Listener::Run () {
 	int tc;
 	if ((isSingleClient(mSettings) || isMulticast(mSettings)) && \
 	    mCount && (tc = (thread_numtrafficthreads()) > 0)) {
-	    // Start with a delay in the event some traffic
-	    // threads are pending to be scheduled and haven't
-	    // had a chance to update the traffic thread count.
-	    // An event system between listener thread and traffic threads
-	    // might better but also more complex. This delay
-	    // really should be good enough unless the os scheduler sucks
-	    delay_loop(SINGLECLIENTDELAY_DURATION);
+	    // Wait for a traffic thread to end.  They signal an eventfd
+	    // (when supported) so the next test can start right away,
+	    // the delay is the upper bound.  Note: thread_start counts
+	    // traffic threads before they're scheduled
+	    wait_traffic_done(SINGLECLIENTDELAY_DURATION);
 #ifdef HAVE_THREAD_DEBUG
 	    thread_debug("Listener single client loop mc/t/mcast/sc %d/%d/%d/%d",mCount, tc, isMulticast(mSettings), isSingleClient(mSettings));
 #endif
@@ -196,10 +225,9 @@ void Listener::Run () {
 	    // UDP needs a new listen per every new socket
 	    my_listen(); // This will set ListenSocket to a new sock fd
 	}
-	// Use a select() with a timeout if -t is set or if this is a v1 -r or -d test
-	fd_set set;
+	// Wait with a timeout if -t is set or if this is a v1 -r or -d test
 	if ((mMode_Time) || isCompat(mSettings) || isPermitKey(mSettings)) {
-	    // Hang a select w/timeout on the listener socket
+	    // Hang a wait w/timeout on the listener socket
 	    struct timeval timeout;
 	    if (!isPermitKey(mSettings)) {
 		timeout.tv_sec = mSettings->mAmount / 100;
@@ -214,11 +242,9 @@ void Listener::Run () {
 		if (adjsecs > 0)
 		    timeout.tv_sec += adjsecs + 1;
 	    }
-	    FD_ZERO(&set);
-	    FD_SET(ListenSocket, &set);
-	    if (!(select(ListenSocket + 1, &set, NULL, NULL, &timeout) > 0)) {
+	    if (!wait_listen_socket(&timeout)) {
 #ifdef HAVE_THREAD_DEBUG
-		thread_debug("Listener select timeout");
+		thread_debug("Listener wait timeout");
 #endif
 		if (isCompat(mSettings)) {
 		    fprintf(stderr, "ERROR: expected reverse connect did not occur\n");
@@ -273,10 +299,8 @@ void Listener::Run () {
 	    (!isIPV6(mSettings) && SockAddr_isIPv6(&server->peer))) {
 	    // Not allowed, reset things and restart the loop
 	    // Don't forget to delete the UDP entry (inserted in my_accept)
+	    // which also releases the sum report
 	    Iperf_remove_host(server);
-	    if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		FreeSumReport(server->mSumReport);
-	    }
 	    if (!isUDP(server))
 	        close(server->mSock);
 	    assert(server != mSettings);
@@ -305,9 +329,6 @@ void Listener::Run () {
 		PostReport(reporthdr);
 	    }
 	    Iperf_remove_host(server);
-	    if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		FreeSumReport(server->mSumReport);
-	    }
 	    close(server->mSock);
 	    assert(server != mSettings);
 	    Settings_Destroy(server);
@@ -319,9 +340,6 @@ void Listener::Run () {
 	    if (!L2_setup(server, server->mSock)) {
 		// Requested L2 testing but L2 setup failed
 		Iperf_remove_host(server);
-		if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		    FreeSumReport(server->mSumReport);
-		}
 		assert(server != mSettings);
 		Settings_Destroy(server);
 		continue;
@@ -354,6 +372,8 @@ void Listener::Run () {
 		    Iperf_push_host(listener_client_settings);
 		if (isFullDuplex(server)) {
 		    assert(server->mSumReport != NULL);
+		    // Other --listeners may accept from this host concurrently
+		    Mutex_Lock(&server->mSumReport->reference.lock);
 		    if (!server->mSumReport->sum_fd_set) {
 			// Reset the sum output routine for the server sum report
 			// now that it's know to be full duplex. This wasn't known
@@ -361,6 +381,7 @@ void Listener::Run () {
 			SetSumHandlers(server, server->mSumReport);
 			server->mSumReport->sum_fd_set = 1;
 		    }
+		    Mutex_Unlock(&server->mSumReport->reference.lock);
 		    server->mFullDuplexReport = InitSumReport(server, server->mSock, 1);
 		    listener_client_settings->mFullDuplexReport = server->mFullDuplexReport;
 #if HAVE_THREAD_DEBUG
@@ -400,6 +421,145 @@ void Listener::Run () {
 #endif
 } // end Run
 
+/* -------------------------------------------------------------------
+ * Listener waits
+ *
+ * With epoll a timerfd gives the timeout and the traffic threads'
+ * eventfd (see thread_trafficdone_fd) wakes a single client (-1)
+ * listener as soon as the running test ends.  Otherwise these are a
+ * select() and a delay.  The listen socket is added to the epoll set
+ * per wait as UDP hands each listen socket to its server thread.
+ * ------------------------------------------------------------------- */
+#ifdef LISTENER_EPOLL
+void Listener::epoll_setup () {
+    struct epoll_event ev;
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    WARN_errno(mEpollFd < 0, "epoll_create1");
+    if (mEpollFd >= 0) {
+	mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	WARN_errno(mTimerFd < 0, "timerfd_create");
+	if (mTimerFd >= 0) {
+	    memset(&ev, 0, sizeof(ev));
+	    ev.events = EPOLLIN;
+	    ev.data.fd = mTimerFd;
+	    WARN_errno(epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mTimerFd, &ev) < 0, "epoll_ctl timerfd");
+	}
+	int donefd = thread_trafficdone_fd();
+	if (donefd >= 0) {
+	    memset(&ev, 0, sizeof(ev));
+	    ev.events = EPOLLIN;
+	    ev.data.fd = donefd;
+	    WARN_errno(epoll_ctl(mEpollFd, EPOLL_CTL_ADD, donefd, &ev) < 0, "epoll_ctl eventfd");
+	}
+	if (mTimerFd < 0) {
+	    close(mEpollFd);
+	    mEpollFd = -1;
+	}
+    }
+}
+
+// Wait on the epoll set per the timerfd armed to timeout, return the
+// ready fd, the timerfd on a timeout, or -1 on an error or interrupt
+int Listener::epoll_timedwait (struct timeval *timeout) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = timeout->tv_sec;
+    its.it_value.tv_nsec = timeout->tv_usec * 1000;
+    if ((its.it_value.tv_sec == 0) && (its.it_value.tv_nsec == 0))
+	its.it_value.tv_nsec = 1; // zero would disarm
+    timerfd_settime(mTimerFd, 0, &its, NULL);
+    int readyfd = -1;
+    struct epoll_event events[3];
+    while (!sInterupted && (readyfd < 0)) {
+	int n = epoll_wait(mEpollFd, events, 3, -1);
+	if (n < 0) {
+	    if (errno == EINTR)
+		continue;
+	    WARN_errno(1, "epoll_wait");
+	    break;
+	}
+	// prefer the listen socket, then the traffic threads, then the timer
+	for (int ix = 0; ix < n; ix++) {
+	    if ((readyfd < 0) || (readyfd == mTimerFd) || (events[ix].data.fd == ListenSocket))
+		readyfd = events[ix].data.fd;
+	}
+    }
+    // disarm the timer and clear a pending expiration
+    uint64_t expirations;
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(mTimerFd, 0, &its, NULL);
+    if (read(mTimerFd, &expirations, sizeof(expirations)) < 0) {
+	WARN_errno(errno != EAGAIN, "timerfd read");
+    }
+    return readyfd;
+}
+#endif
+
+// Returns true if the listen socket is readable, false on a timeout
+bool Listener::wait_listen_socket (struct timeval *timeout) {
+#ifdef LISTENER_EPOLL
+    if (mEpollFd >= 0) {
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = ListenSocket;
+	if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, ListenSocket, &ev) == 0) {
+	    // A traffic thread ending wakes the wait, only wait the
+	    // remaining time after so flows finishing can't stretch it
+	    Timestamp deadline;
+	    deadline.add(timeout);
+	    struct timeval remaining = *timeout;
+	    int readyfd;
+	    while (((readyfd = epoll_timedwait(&remaining)) >= 0) && (readyfd == thread_trafficdone_fd())) {
+		// not waiting on the traffic threads here
+		wait_traffic_done(0);
+		Timestamp now;
+		long usecs = deadline.subUsec(now);
+		if (usecs <= 0) {
+		    readyfd = mTimerFd;
+		    break;
+		}
+		remaining.tv_sec = usecs / 1000000;
+		remaining.tv_usec = usecs % 1000000;
+	    }
+	    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, ListenSocket, &ev);
+	    return (readyfd == ListenSocket);
+	}
+	WARN_errno(1, "epoll_ctl listen socket");
+    }
+#endif
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(ListenSocket, &set);
+    return (select(ListenSocket + 1, &set, NULL, NULL, timeout) > 0);
+}
+
+// Wait up to delay usecs for a traffic thread to end
+void Listener::wait_traffic_done (unsigned long delay) {
+    int donefd = thread_trafficdone_fd();
+    bool waited = false;
+#ifdef LISTENER_EPOLL
+    if ((mEpollFd >= 0) && (donefd >= 0)) {
+	if (delay > 0) {
+	    struct timeval timeout;
+	    timeout.tv_sec = delay / 1000000;
+	    timeout.tv_usec = delay % 1000000;
+	    epoll_timedwait(&timeout);
+	}
+	waited = true;
+    }
+#endif
+    if (!waited)
+	delay_loop(delay);
+    if (donefd >= 0) {
+	uint64_t count;
+	if (read(donefd, &count, sizeof(count)) < 0) {
+	    // not ready, i.e. a timeout
+	    WARN_errno(errno != EAGAIN, "eventfd read");
+	}
+    }
+}
+
 /* -------------------------------------------------------------------
  * Setup a socket listening on a port.
  * For TCP, this calls bind() and listen().
@@ -445,6 +605,24 @@ void Listener::my_listen () {
     int boolean = 1;
     Socklen_t len = sizeof(boolean);
     rc = setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char*>(&boolean), len);
+#if HAVE_DECL_SO_REUSEPORT
+    // the --udp-demux threads and the --listeners share the port,
+    // the kernel hashes each flow to one of them
+    if ((isUDPDemux(mSettings) && (mSettings->mDemuxThreads > 1)) || \
+	(!isUDP(mSettings) && (mSettings->mListeners > 1))) {
+	rc = setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<char*>(&boolean), len);
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_REUSEPORT");
+    }
+#endif
+#if HAVE_DECL_TCP_FASTOPEN
+    // accept the data in the SYN of clients presenting a TFO cookie, the
+    // queue limits the connects which haven't completed their handshakes
+    if (!isUDP(mSettings) && isTcpFastOpen(mSettings)) {
+	int qlen = mSettings->mTFOQueue;
+	rc = setsockopt(ListenSocket, IPPROTO_TCP, TCP_FASTOPEN, reinterpret_cast<char*>(&qlen), sizeof(qlen));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt TCP_FASTOPEN");
+    }
+#endif
     // bind socket to server address
 #ifdef WIN32
     if (SockAddr_isMulticast(&mSettings->local)) {
@@ -490,6 +668,343 @@ void Listener::my_listen () {
     }
 } // end my_listen()
 
+/* -------------------------------------------------------------------
+ * Sharded TCP accepts (--listeners)
+ *
+ * The first listener binds the other listeners' sockets to the same
+ * port with SO_REUSEPORT, in order, so the socket's index in the
+ * kernel's reuseport group is the listener index.  Each listener then
+ * runs its own accept loop.  Per ",cpu" a classic BPF program steers
+ * a new connection to the listener (cpu % n) of the cpu receiving it,
+ * and the listeners pin themselves to those cpus (see listener_affinity)
+ * ------------------------------------------------------------------- */
+void Listener::start_listeners () {
+    int count = mSettings->mListeners;
+    thread_Settings **siblings = new thread_Settings *[count];
+    FAIL(!siblings, "Out of Memory!!\n", mSettings);
+    int primary = ListenSocket;
+    for (int ix = 1; ix < count; ix++) {
+	my_listen(); // This will set ListenSocket and mSock to the sibling's sock fd
+	siblings[ix] = NULL;
+	Settings_Copy(mSettings, &siblings[ix], 1);
+	FAIL(!siblings[ix], "Failed memory allocation for listener settings", mSettings);
+	siblings[ix]->mListenerIndex = ix;
+    }
+    ListenSocket = primary;
+    mSettings->mSock = primary;
+#if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    if (isListenerCPU(mSettings)) {
+	// A = cpu % count, the index of the socket in the reuseport group
+	struct sock_filter code[] = {
+	    { BPF_LD  | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+	    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(count) },
+	    { BPF_RET | BPF_A, 0, 0, 0 }
+	};
+	struct sock_fprog prog = { static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+	int rc = setsockopt(ListenSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_ATTACH_REUSEPORT_CBPF");
+    }
+#else
+    if (isListenerCPU(mSettings)) {
+	fprintf(stderr, "WARN: --listeners cpu steering not supported on this platform\n");
+    }
+#endif
+    for (int ix = 1; ix < count; ix++) {
+	thread_start(siblings[ix]);
+    }
+    DELETE_ARRAY(siblings);
+}
+
+/*
+ * Pin a --listeners thread to the cpus whose connections the reuseport
+ * program steers to it so the accept and the test exchange stay on the
+ * cpu that took the SYN
+ */
+void Listener::listener_affinity () {
+#if HAVE_DECL_CPU_SET
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t myset;
+    CPU_ZERO(&myset);
+    for (long cpu = mSettings->mListenerIndex; (cpu < ncpus) && (cpu < CPU_SETSIZE); cpu += mSettings->mListeners) {
+	CPU_SET(cpu, &myset);
+    }
+    if (CPU_COUNT(&myset) > 0) {
+	WARN_errno(sched_setaffinity(0, sizeof(myset), &myset) != 0, "sched_setaffinity");
+    }
+#endif
+}
+
+/* -------------------------------------------------------------------
+ * Single socket UDP server (--udp-demux)
+ *
+ * Rather than a connected socket and a server thread per UDP flow,
+ * read the datagrams of all flows from the one unconnected listen
+ * socket, in batches with recvmmsg when available, and account them
+ * per flow in this thread.  Flows are found by peer address in a hash
+ * table and expired by a timer wheel when idle.  With --udp-demux=<n>
+ * the first thread starts n-1 more which bind the same port with
+ * SO_REUSEPORT.  The kernel hashes a flow to one socket so each thread
+ * owns its flows and no locks are needed.  Reports are processed inline
+ * per the single UDP (-U) path and there are no sum reports.
+ * ------------------------------------------------------------------- */
+#ifdef HAVE_RECVMMSG
+#define UDPDEMUX_MSGHDR(msgs, ix) (msgs[ix].msg_hdr)
+#else
+#define UDPDEMUX_MSGHDR(msgs, ix) (msgs[ix])
+#endif
+void Listener::udp_demux (bool mMode_Time) {
+    my_listen();
+    if ((mSettings->mListenerIndex == 0) && (mSettings->mDemuxThreads > 1)) {
+	for (int ix = 1; ix < mSettings->mDemuxThreads; ix++) {
+	    thread_Settings *worker = NULL;
+	    Settings_Copy(mSettings, &worker, 1);
+	    FAIL(!worker, "Failed memory allocation for udp demux settings", mSettings);
+	    worker->mListenerIndex = ix;
+	    thread_start(worker);
+	}
+    }
+    // The receive timeout is the wheel tick so idle flows expire and the
+    // loop checks for the end without any traffic
+    SetSocketOptionsReceiveTimeout(mSettings, UDPDEMUX_WHEELTICK);
+#if HAVE_DECL_SO_TIMESTAMP
+    int timestampOn = 1;
+    if (setsockopt(ListenSocket, SOL_SOCKET, SO_TIMESTAMP, &timestampOn, sizeof(timestampOn)) < 0) {
+	WARN_errno(1, "setsockopt SO_TIMESTAMP");
+    }
+#endif
+    struct UDPDemuxTable table;
+    struct UDPDemuxWheel wheel;
+    Timestamp now;
+    struct timeval tnow;
+    tnow.tv_sec = now.getSecs();
+    tnow.tv_usec = now.getUsecs();
+    udp_demux_table_init(&table, mSettings);
+    udp_demux_wheel_init(&wheel, &tnow);
+
+    int buflen = mSettings->mBufLen;
+    char *bufs = new char[UDPDEMUX_BATCH * buflen];
+    iperf_sockaddr peers[UDPDEMUX_BATCH];
+    struct iovec iovs[UDPDEMUX_BATCH];
+    int rxlens[UDPDEMUX_BATCH];
+#if HAVE_DECL_SO_TIMESTAMP
+    char ctrls[UDPDEMUX_BATCH][CMSG_SPACE(sizeof(struct timeval))];
+#endif
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[UDPDEMUX_BATCH];
+    int batch = UDPDEMUX_BATCH;
+#else
+    struct msghdr msgs[1];
+    int batch = 1;
+#endif
+    memset(msgs, 0, sizeof(msgs));
+
+    while (!sInterupted && !(mMode_Time && mEndTime.before(now))) {
+	for (int ix = 0; ix < batch; ix++) {
+	    struct msghdr *hdr = &UDPDEMUX_MSGHDR(msgs, ix);
+	    iovs[ix].iov_base = bufs + (ix * buflen);
+	    iovs[ix].iov_len = buflen;
+	    hdr->msg_name = &peers[ix];
+	    hdr->msg_namelen = sizeof(iperf_sockaddr);
+	    hdr->msg_iov = &iovs[ix];
+	    hdr->msg_iovlen = 1;
+#if HAVE_DECL_SO_TIMESTAMP
+	    hdr->msg_control = ctrls[ix];
+	    hdr->msg_controllen = sizeof(ctrls[ix]);
+#endif
+	    hdr->msg_flags = 0;
+	}
+#ifdef HAVE_RECVMMSG
+	int n = recvmmsg(ListenSocket, msgs, batch, MSG_WAITFORONE, NULL);
+	for (int ix = 0; ix < n; ix++)
+	    rxlens[ix] = msgs[ix].msg_len;
+#else
+	int n = recvmsg(ListenSocket, &msgs[0], 0);
+	if (n >= 0) {
+	    rxlens[0] = n;
+	    n = 1;
+	}
+#endif
+	now.setnow();
+	tnow.tv_sec = now.getSecs();
+	tnow.tv_usec = now.getUsecs();
+	if ((n < 0) && FATALUDPREADERR(errno)) {
+	    WARN_errno(1, "recvmmsg");
+	    break;
+	}
+	for (int ix = 0; ix < n; ix++) {
+	    struct msghdr *hdr = &UDPDEMUX_MSGHDR(msgs, ix);
+	    struct timeval rxtime = tnow;
+#if HAVE_DECL_SO_TIMESTAMP
+	    struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+	    if (cmsg && (cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMP) && \
+		(cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval)))) {
+		memcpy(&rxtime, CMSG_DATA(cmsg), sizeof(struct timeval));
+	    }
+#endif
+	    if (rxlens[ix] < static_cast<int>(sizeof(struct UDP_datagram)))
+		continue;
+	    struct UDPDemuxFlow *flow = udp_demux_lookup(&table, &peers[ix]);
+	    if (flow && flow->done) {
+		// A new test from the address and port of one that's done, e.g. a client with -B ip:port,
+		// any datagram but a FIN after a test that ran or the first one of a test after an ignored one
+		intmax_t packetID = udp_demux_packetid(flow, static_cast<char *>(iovs[ix].iov_base));
+		if ((packetID >= 0) && (flow->job || (packetID == 1))) {
+		    udp_demux_wheel_cancel(&wheel, flow);
+		    udp_demux_remove(&table, flow);
+		    udp_demux_freeflow(flow);
+		    flow = NULL;
+		}
+	    }
+	    if (!flow) {
+		flow = udp_demux_newflow(&peers[ix], hdr->msg_namelen, static_cast<char *>(iovs[ix].iov_base), rxlens[ix], &rxtime);
+		udp_demux_insert(&table, flow);
+		struct timeval due = rxtime;
+		due.tv_sec += UDPDEMUX_IDLETIMEOUT;
+		udp_demux_wheel_schedule(&wheel, flow, &due);
+	    }
+	    udp_demux_packet(flow, static_cast<char *>(iovs[ix].iov_base), rxlens[ix], &rxtime);
+	}
+	// Expire the flows which have been idle for the timeout
+	struct UDPDemuxFlow *flow = udp_demux_wheel_advance(&wheel, &tnow);
+	while (flow) {
+	    struct UDPDemuxFlow *next = flow->wheel_next;
+	    struct timeval due = flow->lastTime;
+	    due.tv_sec += UDPDEMUX_IDLETIMEOUT;
+	    if (timercmp(&due, &tnow, >)) {
+		udp_demux_wheel_schedule(&wheel, flow, &due);
+	    } else {
+		udp_demux_remove(&table, flow);
+		udp_demux_freeflow(flow);
+	    }
+	    flow = next;
+	}
+    }
+    for (int ix = 0; ix < table.size; ix++) {
+	if (table.slots[ix] != NULL)
+	    udp_demux_freeflow(table.slots[ix]);
+    }
+    udp_demux_table_destroy(&table);
+    DELETE_ARRAY(bufs);
+}
+
+struct UDPDemuxFlow *Listener::udp_demux_newflow (iperf_sockaddr *peer, Socklen_t size_peer, char *buf, int rxlen, struct timeval *rxtime) {
+    struct UDPDemuxFlow *flow = new UDPDemuxFlow();
+    FAIL(flow == NULL, "Out of Memory!!\n", mSettings);
+    flow->peer = *peer;
+    flow->size_peer = size_peer;
+    flow->lastTime = *rxtime;
+    Settings_Copy(mSettings, &flow->settings, 1);
+    FAIL(!flow->settings, "Failed memory allocation for server settings", mSettings);
+    thread_Settings *settings = flow->settings;
+    settings->mThreadMode = kMode_Server;
+    if (!isDataReport(mSettings))
+	setNoDataReport(settings);
+    settings->mSock = ListenSocket;
+    settings->peer = *peer;
+    settings->size_peer = size_peer;
+    settings->accept_time = *rxtime;
+    settings->mSumReport = NULL;
+    settings->peer_version_u = 0;
+    settings->peer_version_l = 0;
+    settings->mMode = kTest_Normal;
+    // apply_client_settings_udp() reads the first datagram from mBuf
+    memcpy(mBuf, buf, ((rxlen < mBufLen) ? rxlen : mBufLen));
+    apply_client_settings_udp(settings);
+    if ((settings->mThreadMode != kMode_Server) || isServerReverse(settings) || isFullDuplex(settings) || \
+	(settings->mMode != kTest_Normal) || isIsochronous(settings) || isL2LengthCheck(settings) || isUDPEcho(settings)) {
+	char tmpaddr[200];
+	SockAddr_getHostAddress(peer, tmpaddr, sizeof(tmpaddr));
+	fprintf(stderr, "WARN: ignoring UDP flow from %s port %d, its test isn't supported with --udp-demux\n", \
+		tmpaddr, SockAddr_getPort(peer));
+	flow->done = true;
+	return flow;
+    }
+    // Account this flow's packets in this thread, as with -U
+    setSingleUDP(settings);
+    setTransferID(settings, 0);
+    if (isConnectionReport(settings) && !isSumOnly(settings)) {
+	struct ReportHeader *reporthdr = InitConnectionReport(settings, 0);
+	struct ConnectionInfo *cr = static_cast<struct ConnectionInfo *>(reporthdr->this_report);
+	cr->connect_timestamp.tv_sec = settings->accept_time.tv_sec;
+	cr->connect_timestamp.tv_usec = settings->accept_time.tv_usec;
+	assert(reporthdr);
+	PostReport(reporthdr);
+    }
+    flow->job = InitIndividualReport(settings);
+    flow->report = static_cast<struct ReporterData *>(flow->job->this_report);
+    struct ReporterData *report = flow->report;
+    report->info.ts.startTime = settings->accept_time;
+    report->info.ts.IPGstart = report->info.ts.startTime;
+    if (!TimeZero(report->info.ts.intervalTime)) {
+	report->info.ts.nextTime = report->info.ts.startTime;
+	TimeAdd(report->info.ts.nextTime, report->info.ts.intervalTime);
+    }
+    return flow;
+}
+
+// Per Server::ReadPacketID(), negative for the client's FIN
+intmax_t Listener::udp_demux_packetid (struct UDPDemuxFlow *flow, char *buf) {
+    struct UDP_datagram *dgram = reinterpret_cast<struct UDP_datagram *>(buf);
+    if (isSeqNo64b(flow->settings))
+	return (static_cast<uint32_t>(ntohl(dgram->id))) | (static_cast<uintmax_t>(ntohl(dgram->id2)) << 32);
+    return static_cast<int32_t>(ntohl(dgram->id));
+}
+
+// Per Server::RunUDP() and Server::ReadPacketID()
+void Listener::udp_demux_packet (struct UDPDemuxFlow *flow, char *buf, int rxlen, struct timeval *rxtime) {
+    struct UDP_datagram *dgram = reinterpret_cast<struct UDP_datagram *>(buf);
+    intmax_t packetID = udp_demux_packetid(flow, buf);
+    bool lastpacket = (packetID < 0);
+    if (flow->done) {
+	// the client retransmits its FIN until the server stats arrive
+	if (lastpacket && flow->job && !isMulticast(flow->settings) && !isNoUDPfin(flow->settings))
+	    sendto_UDP_AckFIN(&flow->report->info);
+	return;
+    }
+    struct ReportStruct *reportstruct = &flow->packet;
+    struct ReporterData *report = flow->report;
+    reportstruct->emptyreport = 0;
+    reportstruct->packetLen = rxlen;
+    reportstruct->packetTime = *rxtime;
+    reportstruct->packetID = (lastpacket ? -packetID : packetID);
+    reportstruct->sentTime.tv_sec = ntohl(dgram->tv_sec);
+    reportstruct->sentTime.tv_usec = ntohl(dgram->tv_usec);
+    if (TimeZero(report->info.ts.prevpacketTime))
+	report->info.ts.prevpacketTime = reportstruct->packetTime;
+    reportstruct->prevSentTime = report->info.ts.prevsendTime;
+    reportstruct->prevPacketTime = report->info.ts.prevpacketTime;
+    report->info.ts.prevsendTime = reportstruct->sentTime;
+    report->info.ts.prevpacketTime = reportstruct->packetTime;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+    ReportPacket(report, reportstruct, NULL);
+#else
+    ReportPacket(report, reportstruct);
+#endif
+    flow->lastTime = *rxtime;
+    if (lastpacket) {
+	udp_demux_endflow(flow, rxtime);
+	if (!isMulticast(flow->settings) && !isNoUDPfin(flow->settings))
+	    sendto_UDP_AckFIN(&report->info);
+    }
+}
+
+void Listener::udp_demux_endflow (struct UDPDemuxFlow *flow, struct timeval *endtime) {
+    flow->packet.packetTime = *endtime;
+    flow->packet.packetLen = 0;
+    EndJob(flow->job, &flow->packet);
+    flow->done = true;
+}
+
+// A flow which went idle ends at its last datagram
+void Listener::udp_demux_freeflow (struct UDPDemuxFlow *flow) {
+    if (!flow->done)
+	udp_demux_endflow(flow, &flow->lastTime);
+    if (flow->job)
+	FreeReport(flow->job);
+    Settings_Destroy(flow->settings);
+    delete flow;
+}
+
 /* -------------------------------------------------------------------
  * Joins the multicast group or source and group (SSM S,G)
  *
@@ -919,6 +1434,10 @@ int Listener::my_accept (thread_Settings *server) {
 	Timestamp now;
 	server->accept_time.tv_sec = now.getSecs();
 	server->accept_time.tv_usec = now.getUsecs();
+	if (isIncomingCPU(server)) {
+	    // the server thread runs on the cpu the flow's packets arrive on (see thread_setaffinity)
+	    server->mIncomingCPU = getsock_incoming_cpu(server->mSock, &server->mNapiID);
+	}
     }
     return server->mSock;
 } // end my_accept
@@ -1031,6 +1550,12 @@ bool Listener::apply_client_settings_udp (thread_Settings *server) {
 		if (upperflags & HEADER_NOUDPFIN) {
 		    setNoUDPfin(server);
 		}
+		if (upperflags & HEADER_UDPECHO) {
+		    setUDPEcho(server);
+		}
+		if (upperflags & HEADER_PAYLOADVERIFY) {
+		    setPayloadVerify(server);
+		}
 	    }
 	    if (upperflags & HEADER_EPOCH_START) {
 		server->txstart_epoch.tv_sec = ntohl(hdr->start_fq.start_tv_sec);
@@ -1153,6 +1678,12 @@ bool Listener::apply_client_settings_tcp (thread_Settings *server) {
 			    server->mFPS = 1.0;
 			}
 		    }
+		    if (upperflags & HEADER_TCPRR) {
+			setTcpRR(server);
+		    }
+		    if (upperflags & HEADER_PAYLOADVERIFY) {
+			setPayloadVerify(server);
+		    }
 		    if (flags & HEADER_VERSION2) {
 			if (upperflags & HEADER_FULLDUPLEX) {
 			    setFullDuplex(server);
@@ -69,16 +69,23 @@ Usage: iperf [-s|-c host] [options]\n\
        iperf [-h|--help] [-v|--version]\n\
 \n\
 Client/Server:\n\
+      --affinity <cpus>|auto pin the traffic threads round robin to a cpu list, e.g. 0-3,8, auto for the cpus of the bound device's numa node\n\
   -b, --bandwidth #[kmgKMG | pps]  bandwidth to read/send at in bits/sec or packets/sec\n\
   -e, --enhanced    use enhanced reporting giving more tcp/udp and traffic information\n\
   -f, --format    [kmgKMG]   format to report: Kbits, Mbits, KBytes, MBytes\n\
   -i, --interval  #        seconds between periodic bandwidth reports\n\
+      --interval-series[=text|json] store interval reports in memory and output them with the final report\n\
   -l, --len       #[kmKM]    length of buffer in bytes to read or write (Defaults: TCP=128K, v4 UDP=1470, v6 UDP=1450)\n\
   -m, --print_mss          print TCP maximum segment size (MTU - TCP/IP header)\n\
   -o, --output    <filename> output the report or error message to this specified file\n\
   -p, --port      #        client/server port to listen/send on and to connect\n\
       --permit-key         permit key to be used to verify client and server (TCP only)\n\
+      --reporter-affinity <cpus> pin the reporter thread to a cpu list\n\
       --sum-only           output sum only reports\n\
+      --tcp-fastopen[=<n>] use TCP fast open, the server's queue of pending TFO connects is <n> (default 256)\n\
+      --trace-file <name>  capture per packet data into memory mapped file(s) <name>.<role>.<id>\n\
+      --thread-pool <n>[,cpu] run traffic threads on <n> prestarted workers, cpu pins them\n\
+      --trace-size #[kmgKMG] size of each trace file, oldest packets are overwritten (default 64M)\n\
   -u, --udp                use UDP rather than TCP\n\
   -w, --window    #[KM]    TCP window size (socket buffer size)\n"
 #ifdef HAVE_SCHED_SETSCHEDULER
@@ -102,6 +109,10 @@ Server specific:\n\
       --udp-histogram #,#  enable UDP latency histogram(s) with bin width and count, e.g. 1,1000=1(ms),1000(bins)\n\
   -B, --bind <ip>[%<dev>]  bind to multicast address and optional device\n\
   -U, --single_udp         run in single threaded UDP mode\n\
+      --udp-demux[=<n>]    receive all UDP flows on one socket per <n> threads (default 1)\n\
+      --busy-poll[=<usecs>[,spin]] busy poll reads per SO_BUSY_POLL (default 50 us), spin also spins on non-blocking reads\n\
+      --incoming-cpu       pin each server thread to the cpu receiving its flow per SO_INCOMING_CPU\n\
+      --listeners <n>[,cpu] accept TCP connections with <n> listener threads using SO_REUSEPORT, cpu steers per the receiving cpu\n\
       --sum-dstip          sum traffic threads based upon destination ip address (default is src ip)\n\
   -D, --daemon             run the server as a daemon\n"
 #ifdef WIN32
@@ -115,8 +126,12 @@ const char usage_long2[] = "\
 Client specific:\n\
   -c, --client    <host>   run in client mode, connecting to <host>\n\
       --connect-only       run a connect only test\n\
+      --connect-rate <rate>[,<n>] connect only test with <n> non-blocking connects in flight per thread, open loop at <rate> connects/sec (0 is closed loop)\n\
       --connect-retries #  number of times to retry tcp connect\n\
   -d, --dualtest           Do a bidirectional test simultaneously (multiple sockets)\n\
+      --flow-load <load>[,<poisson|periodic>] --flows load as a fraction of the -b link rate (default 0.5,poisson)\n\
+      --flow-pool <n>      run the --flows over a pool of <n> connections per thread rather than a fresh connection per flow\n\
+      --flows <cdf file>|<kind>:<params> flows of sizes per an empirical CDF or constant:, exponential:, normal: or lognormal:, reports flow completion times\n\
       --fq-rate #[kmgKMG]  bandwidth to socket pacing\n\
       --full-duplex        run full duplex test using same socket\n\
       --ipg                set the the interpacket gap (milliseconds) for packets within an isochronous frame\n\
@@ -129,12 +144,17 @@ Client specific:\n\
       --no-connect-sync    No sychronization after connect when -P or parallel traffic threads\n\
       --no-udp-fin         No final server to client stats at end of UDP test\n\
   -n, --num       #[kmgKMG]    number of bytes to transmit (instead of -t)\n\
+      --payload-verify     send a seeded test pattern which the server checks every read against, reporting corrupted reads or datagrams\n\
   -r, --tradeoff           Do a fullduplexectional test individually\n\
+      --rpm[=<tcp|udp>[,<rate>[,<idle>]]] responsiveness, probe latency idle and then under the load of the -P bulk flows (default tcp,100,2)\n\
+      --scenario <file>    run the flow groups of an ini file, each [name] section with options, start and duration keys, concurrently with one reporter\n\
+      --tcp-rr <req>[,<resp>[,<depth>[,<conns>]]] TCP request/response transactions with <depth> requests in flight on each of <conns> connections per thread\n\
       --tcp-write-prefetch set the socket's TCP_NOTSENT_LOWAT value in bytes and use event based writes\n\
   -t, --time      #        time in seconds to transmit for (default 10 secs)\n\
       --trip-times         enable end to end measurements (requires client and server clock sync)\n\
       --txdelay-time       time in seconds to hold back after connect and before first write\n\
       --txstart-time       unix epoch time to schedule first write and start traffic\n\
+      --udp-echo           UDP probes echoed by the server for RTT, loss and reordering per direction (no clock sync needed)\n\
   -B, --bind [<ip> | <ip:port>] bind ip (and optional port) from which to source traffic\n\
   -F, --fileinput <name>   input the data to be transmitted from a file\n\
   -H, --ssm-host <ip>      set the SSM source, use with -B for (S,G) \n\
@@ -264,6 +284,9 @@ const char client_fq_pacing [] =
  * Legacy reports
  * ------------------------------------------------------------------- */
 
+const char scenario_group_start[] =
+"[%s] scenario group starts at %.2f sec with options %s\n";
+
 const char report_bw_header[] =
 "[ ID] Interval       Transfer     Bandwidth\n";
 
@@ -306,6 +329,15 @@ const char client_write_size[] =
 const char server_read_size[] =
 "Read buffer size";
 
+const char report_incoming_cpu[] =
+"%sFlow received on cpu %d, server thread %s\n";
+
+const char report_incoming_cpu_napi[] =
+"%sFlow received on cpu %d (napi %u), server thread %s\n";
+
+const char report_busypoll[] =
+"%sBusy poll %d us%s: %.3f sec spinning (%" PRIuMAX " empty polls), %.3f sec in reads, %.1f%% of the read time spinning\n";
+
 const char report_bw_enhanced_format[] =
 "%s" IPERFTimeFrmt " sec  %ss  %ss/sec\n";
 
@@ -497,6 +529,54 @@ const char report_udp_fullduplex_enhanced_format[] =
 const char report_udp_fullduplex_sum_format[] =
 "[SUM] " IPERFTimeFrmt " sec  %ss  %ss/sec %" PRIdMAX "%8.0f pps\n";
 
+/* -------------------------------------------------------------------
+ * Interval series (deferred interval) reports
+ * ------------------------------------------------------------------- */
+const char report_interval_series_header[] =
+"%sInterval series of %" PRIuMAX " samples (%" PRIuMAX " dropped)\n";
+
+const char report_interval_series_format[] =
+"%s%4.4f-%4.4f sec  %ss  %ss/sec";
+
+const char report_interval_series_write[] =
+"  %d/%d (writes/err)";
+
+const char report_interval_series_tcpinfo[] =
+"  %d (retry)  %dK/%d us (cwnd/rtt)";
+
+const char report_interval_series_datagrams[] =
+"  %" PRIdMAX " (datagrams)";
+
+const char report_interval_series_read[] =
+"  %d (reads)";
+
+const char report_interval_series_udp_read[] =
+"  %6.3f ms  %" PRIdMAX "/%" PRIdMAX " (lost/total)  %" PRIdMAX " (ooo)";
+
+const char report_interval_series_latency[] =
+"  %.3f/%.3f/%.3f ms (min/avg/max)";
+
+const char report_interval_series_json_format[] =
+"{\"id\":\"%s\",\"start\":%.6f,\"end\":%.6f,\"bytes\":%" PRIuMAX ",\"bits_per_second\":%.0f";
+
+const char report_interval_series_json_write[] =
+",\"writes\":%d,\"write_errors\":%d";
+
+const char report_interval_series_json_tcpinfo[] =
+",\"retry\":%d,\"cwnd\":%d,\"rtt\":%d";
+
+const char report_interval_series_json_datagrams[] =
+",\"datagrams\":%" PRIdMAX;
+
+const char report_interval_series_json_read[] =
+",\"reads\":%d";
+
+const char report_interval_series_json_udp_read[] =
+",\"jitter_ms\":%.6f,\"lost\":%" PRIdMAX ",\"datagrams\":%" PRIdMAX ",\"outoforder\":%" PRIdMAX;
+
+const char report_interval_series_json_latency[] =
+",\"latency_ms\":{\"min\":%.6f,\"mean\":%.6f,\"max\":%.6f,\"cnt\":%d}";
+
 /* -------------------------------------------------------------------
  * Misc reports
  * ------------------------------------------------------------------- */
@@ -509,6 +589,15 @@ const char report_sumcnt_outoforder[] =
 const char report_l2statistics[] =
 "%s" IPERFTimeFrmt " sec   L2 processing detected errors, total(length/checksum/unknown) = %" PRIdMAX "(%" PRIdMAX "/%" PRIdMAX "/%" PRIdMAX ")\n";
 
+const char report_payloadverify[] =
+"%s" IPERFTimeFrmt " sec   Payload verify detected errors in %" PRIdMAX " of %" PRIdMAX " %s\n";
+
+const char report_seqwindow[] =
+"%s" IPERFTimeFrmt " sec  %" PRIdMAX " duplicates %" PRIdMAX " late %" PRIdMAX " beyond window, reorder distance max %" PRIdMAX " (%s)\n";
+
+const char report_lossruns[] =
+"%s" IPERFTimeFrmt " sec  %" PRIdMAX " loss runs avg/max %.1f/%" PRIdMAX " (%s) gaps avg/min/max %.1f/%" PRIdMAX "/%" PRIdMAX " Gilbert-Elliott p/r=%.3g/%.3g\n";
+
 const char report_sum_outoforder[] =
 "[SUM] " IPERFTimeFrmt " sec  %d datagrams received out-of-order\n";
 
@@ -533,6 +622,9 @@ const char report_datagrams[] =
 const char report_sumcnt_datagrams[] =
 "[SUM-%d] Sent %d datagrams\n";
 
+const char report_sumlabel_datagrams[] =
+"%sSent %d datagrams\n";
+
 const char report_sum_datagrams[] =
 "[SUM] Sent %d datagrams\n";
 
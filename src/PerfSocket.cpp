@@ -235,6 +235,20 @@ void SetSocketOptions (struct thread_Settings *inSettings) {
         WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_DONTROUTE");
     }
 #endif /* HAVE_DECL_SO_DONTROUTE */
+#ifdef SO_BUSY_POLL
+    // --busy-poll, set on the listen socket so accepted sockets inherit it.
+    // Reads poll the device queue for up to the usecs rather than sleep
+    if (isBusyPoll(inSettings) && (inSettings->mThreadMode != kMode_Client)) {
+	int usecs = inSettings->mBusyPoll;
+	int rc = setsockopt(inSettings->mSock, SOL_SOCKET, SO_BUSY_POLL, reinterpret_cast<char*>(&usecs), sizeof(usecs));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_BUSY_POLL");
+#ifdef SO_PREFER_BUSY_POLL
+	int prefer = 1;
+	rc = setsockopt(inSettings->mSock, SOL_SOCKET, SO_PREFER_BUSY_POLL, reinterpret_cast<char*>(&prefer), sizeof(prefer));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_PREFER_BUSY_POLL");
+#endif
+    }
+#endif
 }
 
 // Note that timer units are microseconds, be careful
@@ -127,8 +127,52 @@ static inline void _print_stats_common (struct TransferInfo *stats) {
     outbufferext[sizeof(outbufferext)-1]='\0';
 }
 
+static inline void _output_seqwindow(struct TransferInfo *stats) {
+    struct SeqWindow *win = stats->seqwindow;
+    char bins[SEQWINDOW_REORDERBINS * 24];
+    int ix, len = 0;
+    bins[0] = '\0';
+    for (ix = 0; ix < SEQWINDOW_REORDERBINS; ix++) {
+	if (!win->reorder[ix])
+	    continue;
+	if (ix == (SEQWINDOW_REORDERBINS - 1))
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s%d+:%" PRIdMAX, (len ? " " : ""), SEQWINDOW_BITS, win->reorder[ix]);
+	else if (!ix)
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s1:%" PRIdMAX, (len ? " " : ""), win->reorder[ix]);
+	else
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s%d-%d:%" PRIdMAX, (len ? " " : ""), (1 << ix), (1 << (ix + 1)) - 1, win->reorder[ix]);
+    }
+    printf(report_seqwindow, stats->common->transferIDStr, stats->ts.iStart, stats->ts.iEnd, \
+	   win->dups, win->late, win->beyond, win->maxreorder, bins);
+}
+
+static inline void _output_lossruns(struct TransferInfo *stats) {
+    struct LossRunCounters *counters = &stats->lossruns->interval;
+    char bins[LOSSRUN_BINS * 24];
+    int ix, len = 0;
+    bins[0] = '\0';
+    for (ix = 0; ix < LOSSRUN_BINS; ix++) {
+	if (!counters->bins[ix])
+	    continue;
+	if (ix == (LOSSRUN_BINS - 1))
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s%d+:%" PRIdMAX, (len ? " " : ""), (1 << ix), counters->bins[ix]);
+	else if (!ix)
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s1:%" PRIdMAX, (len ? " " : ""), counters->bins[ix]);
+	else
+	    len += snprintf(&bins[len], sizeof(bins) - len, "%s%d-%d:%" PRIdMAX, (len ? " " : ""), (1 << ix), (1 << (ix + 1)) - 1, counters->bins[ix]);
+    }
+    printf(report_lossruns, stats->common->transferIDStr, stats->ts.iStart, stats->ts.iEnd, \
+	   counters->runs, ((double) counters->lost / counters->runs), counters->maxrun, bins, \
+	   (counters->gaps ? ((double) counters->gapsum / counters->gaps) : 0.0), counters->mingap, counters->maxgap, \
+	   (counters->received ? ((double) counters->runs / counters->received) : 0.0), \
+	   ((double) counters->runs / counters->lost));
+}
+
 static inline void _output_outoforder(struct TransferInfo *stats) {
-    if (stats->cntOutofOrder > 0) {
+    if (stats->seqwindow) {
+	if (stats->seqwindow->dups || stats->seqwindow->late || stats->seqwindow->beyond)
+	    _output_seqwindow(stats);
+    } else if (stats->cntOutofOrder > 0) {
 	printf(report_outoforder,
 	       stats->common->transferIDStr, stats->ts.iStart,
 	       stats->ts.iEnd, stats->cntOutofOrder);
@@ -139,6 +183,9 @@ static inline void _output_outoforder(struct TransferInfo *stats) {
 	       stats->ts.iEnd, stats->l2counts.cnt, stats->l2counts.lengtherr,
 	       stats->l2counts.udpcsumerr, stats->l2counts.unknown);
     }
+    if (stats->lossruns && stats->lossruns->interval.runs) {
+	_output_lossruns(stats);
+    }
 }
 
 //
@@ -1149,6 +1196,264 @@ void reporter_connect_printf_tcp_final (struct ConnectionInfo * report) {
     fflush(stdout);
 }
 
+// Print the latency percentiles of a histogram, in ms
+static void print_latency_percentiles (struct histogram *h) {
+    static const double pcts[] = {50, 90, 99, 99.9, 99.99};
+    int ix;
+    for (ix = 0; ix < (int) (sizeof(pcts) / sizeof(double)); ix++) {
+	double value = histogram_percentile(h, pcts[ix]);
+	if (value < 0)
+	    printf("%s>%0.3f", (ix ? "/" : ""), (h->bincount * h->binwidth / h->units) * 1e3);
+	else
+	    printf("%s%0.3f", (ix ? "/" : ""), value * 1e3);
+    }
+}
+
+void reporter_print_connect_rate_report (struct ConnectRateInfo *report) {
+    char id[8];
+    intmax_t fails = 0;
+    int ix;
+    double duration = report->iEnd - report->iStart;
+    double cps = (duration > 0) ? (report->connect_times.cnt / duration) : 0;
+    double stdev = (report->connect_times.cnt < 2) ? 0 : sqrt(report->connect_times.m2 / (report->connect_times.cnt - 1));
+    double mean = report->connect_times.cnt ? report->connect_times.mean : 0;
+    double min = report->connect_times.cnt ? report->connect_times.min : 0;
+    for (ix = 0; ix < CONNECTFAIL_MAX; ix++)
+	fails += report->fails[ix];
+    if (report->threads > 1)
+	snprintf(id, sizeof(id), "SUM");
+    else
+	snprintf(id, sizeof(id), "%3d", report->transferID);
+    printf("[%s] " IPERFTimeFrmt " sec  %0.0f connects/sec%s ok/tries=%d/%jd fails=%jd latency(min/avg/max/stdev)=%0.3f/%0.3f/%0.3f/%0.3f ms", \
+	   id, report->iStart, report->iEnd, cps, (report->final ? "(f)" : ""), report->connect_times.cnt, report->tries, fails, \
+	   min, mean, report->connect_times.max, stdev);
+    if (report->rate > 0)
+	printf(" overruns=%jd", report->overruns);
+    printf("\n");
+    if (report->final) {
+	printf("[%s] " IPERFTimeFrmt " sec  connect fails(refused/timeout/unreach/reset/local/other)=%jd/%jd/%jd/%jd/%jd/%jd\n", \
+	       id, report->iStart, report->iEnd, report->fails[CONNECTFAIL_REFUSED], report->fails[CONNECTFAIL_TIMEOUT], \
+	       report->fails[CONNECTFAIL_UNREACH], report->fails[CONNECTFAIL_RESET], report->fails[CONNECTFAIL_LOCAL], \
+	       report->fails[CONNECTFAIL_OTHER]);
+    }
+    if (report->final && report->latency_histogram && report->connect_times.cnt) {
+	printf("[%s] " IPERFTimeFrmt " sec  connect latency percentiles(50/90/99/99.9/99.99)=", id, report->iStart, report->iEnd);
+	print_latency_percentiles(report->latency_histogram);
+	printf(" ms\n");
+	if (report->histogram_pdf) {
+	    report->latency_histogram->final = 1;
+	    histogram_print(report->latency_histogram, report->iStart, report->iEnd);
+	}
+    }
+    fflush(stdout);
+}
+
+void reporter_print_transaction_report (struct TransactionInfo *report) {
+    char id[8];
+    double duration = report->iEnd - report->iStart;
+    double tps = (duration > 0) ? (report->rtt.cnt / duration) : 0;
+    double stdev = (report->rtt.cnt < 2) ? 0 : sqrt(report->rtt.m2 / (report->rtt.cnt - 1));
+    double mean = report->rtt.cnt ? report->rtt.mean : 0;
+    double min = report->rtt.cnt ? report->rtt.min : 0;
+    double max = report->rtt.cnt ? report->rtt.max : 0;
+    if (report->threads > 1)
+	snprintf(id, sizeof(id), "SUM");
+    else
+	snprintf(id, sizeof(id), "%3d", report->transferID);
+    if (report->udpecho) {
+	printf("[%s] " IPERFTimeFrmt " sec  %0.0f echoes/sec%s echoes/probes=%d/%jd rtt(min/avg/max/stdev)=%0.3f/%0.3f/%0.3f/%0.3f ms", \
+	       id, report->iStart, report->iEnd, tps, (report->final ? "(f)" : ""), report->rtt.cnt, report->requests, \
+	       min, mean, max, stdev);
+    } else {
+	printf("[%s] " IPERFTimeFrmt " sec  %0.0f trans/sec%s done/requests=%d/%jd rtt(min/avg/max/stdev)=%0.3f/%0.3f/%0.3f/%0.3f ms", \
+	       id, report->iStart, report->iEnd, tps, (report->final ? "(f)" : ""), report->rtt.cnt, report->requests, \
+	       min, mean, max, stdev);
+    }
+    if (report->latency_histogram && report->rtt.cnt) {
+	printf(" percentiles(50/90/99/99.9/99.99)=");
+	print_latency_percentiles(report->latency_histogram);
+	printf(" ms");
+    }
+    if (report->udpecho) {
+	printf(" lost(fwd/rev)=%jd/%jd ooo(fwd/rev)=%jd/%jd", report->fwd_lost, report->rev_lost, \
+	       report->fwd_outoforder, report->rev_outoforder);
+	if (report->final)
+	    printf(" (probe=%d bytes)", report->request);
+    } else if (report->final) {
+	printf(" (req/resp=%d/%d bytes depth=%d conns=%d)", report->request, report->response, report->depth, report->conns);
+    }
+    printf("\n");
+    if (report->histogram_pdf && report->latency_histogram && report->rtt.cnt) {
+	report->latency_histogram->final = report->final;
+	histogram_print(report->latency_histogram, report->iStart, report->iEnd);
+    }
+    if (report->final && (report->rpm == 2)) {
+	// the idle baseline ran from the start up to the load
+	struct MeanMinMaxStats *idle = &report->idle_rtt;
+	double idle_stdev = (idle->cnt < 2) ? 0 : sqrt(idle->m2 / (idle->cnt - 1));
+	printf("[%s] " IPERFTimeFrmt " sec  idle rtt(min/avg/max/stdev)=%0.3f/%0.3f/%0.3f/%0.3f ms", id, 0.0, report->iStart, \
+	       (idle->cnt ? idle->min : 0), (idle->cnt ? idle->mean : 0), (idle->cnt ? idle->max : 0), idle_stdev);
+	if (report->idle_histogram && idle->cnt) {
+	    printf(" percentiles(50/90/99/99.9/99.99)=");
+	    print_latency_percentiles(report->idle_histogram);
+	    printf(" ms");
+	}
+	printf(" (%d probes)\n", idle->cnt);
+	if (report->histogram_pdf && report->idle_histogram && idle->cnt) {
+	    report->idle_histogram->final = 1;
+	    histogram_print(report->idle_histogram, 0.0, report->iStart);
+	}
+    }
+    fflush(stdout);
+}
+
+// --rpm, round trips per minute per the probe's mean rtts, timed as the bulk flows' final
+void reporter_print_rpm_report (struct RPMInfo *report) {
+    printf("%s" IPERFTimeFrmt " sec  RPM(idle/loaded)=%0.0f/%0.0f\n", report->id, report->iStart, report->iEnd, \
+	   ((report->idle > 0) ? (60000.0 / report->idle) : 0), ((report->loaded > 0) ? (60000.0 / report->loaded) : 0));
+    fflush(stdout);
+}
+
+static int flow_compare (const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double flow_percentile (double *sorted, intmax_t cnt, double p) {
+    intmax_t ix = (intmax_t) ceil(p * cnt) - 1;
+    return sorted[(ix < 0) ? 0 : ((ix >= cnt) ? (cnt - 1) : ix)];
+}
+
+/*
+ * The final --flows report also buckets the flow completion times by
+ * flow size.  The slowdown of a flow is its fct over the ideal, i.e.
+ * the base round trip plus the flow's time on an otherwise idle link,
+ * with the base taken as the smallest fct less the time on the link.
+ */
+static void reporter_print_flow_buckets (struct FlowInfo *report, char *id) {
+    static const struct {
+	const char *name;
+	double upper; // bytes
+    } buckets[] = {
+	{"<10K", 1e4},
+	{"10K-100K", 1e5},
+	{"100K-1M", 1e6},
+	{"1M-10M", 1e7},
+	{">=10M", 0}
+    };
+    double *fcts = (double *) malloc(report->samplecnt * sizeof(double));
+    double *slowdowns = (double *) malloc(report->samplecnt * sizeof(double));
+    if (!fcts || !slowdowns) {
+	free(fcts);
+	free(slowdowns);
+	return;
+    }
+    // The base rtt is the best fct of the smallest flows, those of the
+    // first bucket with any, which is mostly round trips.  A flow's
+    // ideal fct is the base plus its size at the link rate, that of -b
+    // unless flows ran faster, e.g. on loopback, when it's the fastest
+    // of them with a warning rather than a slowdown below 1
+    double base = 0;
+    bool found = false;
+    for (unsigned int bx = 0; !found && (bx < (sizeof(buckets) / sizeof(buckets[0]))); bx++) {
+	for (intmax_t ix = 0; ix < report->samplecnt; ix++) {
+	    if (!buckets[bx].upper || (report->samples[ix].size < buckets[bx].upper)) {
+		if (!found || (report->samples[ix].fct < base))
+		    base = report->samples[ix].fct;
+		found = true;
+	    }
+	}
+    }
+    double linkrate = report->linkrate;
+    double observed = 0;
+    for (intmax_t ix = 0; ix < report->samplecnt; ix++) {
+	double xfer = report->samples[ix].fct - base;
+	if ((xfer > 0) && ((8.0 * report->samples[ix].size / xfer) > observed))
+	    observed = 8.0 * report->samples[ix].size / xfer;
+    }
+    printf("[%s] " IPERFTimeFrmt " sec  flow completion times per flow size (base rtt=%0.3f ms)\n", id, report->iStart, report->iEnd, 1e3 * base);
+    if (observed > linkrate) {
+	printf("[%s] WARNING: flows ran at up to %0.0f Mbits/sec, above the -b link rate of %0.0f Mbits/sec, the ideal fcts use the former\n", \
+	       id, observed / 1e6, linkrate / 1e6);
+	linkrate = observed;
+    }
+    double lower = 0;
+    for (unsigned int bx = 0; bx < (sizeof(buckets) / sizeof(buckets[0])); bx++) {
+	intmax_t cnt = 0;
+	double fctsum = 0;
+	double slowsum = 0;
+	for (intmax_t ix = 0; ix < report->samplecnt; ix++) {
+	    double size = report->samples[ix].size;
+	    if ((size >= lower) && (!buckets[bx].upper || (size < buckets[bx].upper))) {
+		double ideal = base + (8.0 * size / linkrate);
+		fcts[cnt] = 1e3 * report->samples[ix].fct;
+		slowdowns[cnt] = (ideal > 0) ? (report->samples[ix].fct / ideal) : 1;
+		fctsum += fcts[cnt];
+		slowsum += slowdowns[cnt];
+		cnt++;
+	    }
+	}
+	lower = buckets[bx].upper;
+	if (!cnt)
+	    continue;
+	qsort(fcts, cnt, sizeof(double), flow_compare);
+	qsort(slowdowns, cnt, sizeof(double), flow_compare);
+	printf("[%s] " IPERFTimeFrmt " sec  %-8s %jd flows fct(avg/50/99/max)=%0.3f/%0.3f/%0.3f/%0.3f ms slowdown(avg/50/99)=%0.2f/%0.2f/%0.2f\n", \
+	       id, report->iStart, report->iEnd, buckets[bx].name, cnt, fctsum / cnt, flow_percentile(fcts, cnt, 0.5), \
+	       flow_percentile(fcts, cnt, 0.99), fcts[cnt - 1], slowsum / cnt, flow_percentile(slowdowns, cnt, 0.5), \
+	       flow_percentile(slowdowns, cnt, 0.99));
+    }
+    free(fcts);
+    free(slowdowns);
+}
+
+void reporter_print_flow_report (struct FlowInfo *report) {
+    char id[8];
+    double duration = report->iEnd - report->iStart;
+    double stdev = (report->fct.cnt < 2) ? 0 : sqrt(report->fct.m2 / (report->fct.cnt - 1));
+    snprintf(id, sizeof(id), "%3d", report->transferID);
+    printf("[%s] " IPERFTimeFrmt " sec  %0.0f flows/sec%s done/arrivals=%jd/%jd fct(min/avg/max/stdev)=%0.3f/%0.3f/%0.3f/%0.3f ms overruns=%jd fails=%jd", \
+	   id, report->iStart, report->iEnd, ((duration > 0) ? (report->done / duration) : 0), (report->final ? "(f)" : ""), \
+	   report->done, report->arrivals, (report->fct.cnt ? report->fct.min : 0), (report->fct.cnt ? report->fct.mean : 0), \
+	   (report->fct.cnt ? report->fct.max : 0), stdev, report->overruns, report->fails);
+    if (report->final) {
+	if (report->pool)
+	    printf(" (load=%0.2f of %0.0f Mbits/sec %s pool=%d)", report->load, report->linkrate / 1e6, \
+		   (report->periodic ? "periodic" : "poisson"), report->pool);
+	else
+	    printf(" (load=%0.2f of %0.0f Mbits/sec %s fresh connections)", report->load, report->linkrate / 1e6, \
+		   (report->periodic ? "periodic" : "poisson"));
+    }
+    printf("\n");
+    if (report->final && report->samplecnt)
+	reporter_print_flow_buckets(report, id);
+    fflush(stdout);
+}
+
+void reporter_print_payloadverify_report (struct TransferInfo *stats) {
+    printf(report_payloadverify, stats->common->transferIDStr, stats->ts.iStart, stats->ts.iEnd, \
+	   stats->l2counts.payloaderr, stats->l2counts.payloadchk, (isUDP(stats->common) ? "datagrams" : "reads"));
+}
+
+void reporter_print_busypoll_report (struct TransferInfo *stats) {
+    double readtime = stats->busypoll.spin + stats->busypoll.recv;
+    printf(report_busypoll, stats->common->transferIDStr, stats->common->BusyPoll, \
+	   (isBusyPollSpin(stats->common) ? " and spin" : ""), stats->busypoll.spin, stats->busypoll.polls, \
+	   stats->busypoll.recv, ((readtime > 0) ? (100.0 * stats->busypoll.spin / readtime) : 0));
+    fflush(stdout);
+}
+
+void reporter_print_incomingcpu_report (struct TransferInfo *stats) {
+    const char *pin = (stats->incomingcpu.pinned ? "pinned to it" : "not pinned");
+    if (stats->incomingcpu.napi_id) {
+	printf(report_incoming_cpu_napi, stats->common->transferIDStr, stats->incomingcpu.cpu, stats->incomingcpu.napi_id, pin);
+    } else {
+	printf(report_incoming_cpu, stats->common->transferIDStr, stats->incomingcpu.cpu, pin);
+    }
+    fflush(stdout);
+}
+
 void reporter_print_connection_report (struct ConnectionInfo *report) {
     assert(report->common);
     if (!(report->connecttime < 0)) {
@@ -1220,6 +1525,17 @@ void reporter_print_connection_report (struct ConnectionInfo *report) {
 	    snprintf(b, SNBUFFERSIZE-strlen(b), " (trip-times)");
 	    b += strlen(b);
 	}
+	if (!isUDP(report->common) && isTcpFastOpen(report->common) && (report->tfo >= 0)) {
+	    snprintf(b, SNBUFFERSIZE-strlen(b), (report->tfo ? " (tfo)" : " (no-tfo)"));
+	    b += strlen(b);
+	}
+	if (report->incoming_cpu >= 0) {
+	    if (report->napi_id)
+		snprintf(b, SNBUFFERSIZE-strlen(b), " (cpu %d napi %u)", report->incoming_cpu, report->napi_id);
+	    else
+		snprintf(b, SNBUFFERSIZE-strlen(b), " (cpu %d)", report->incoming_cpu);
+	    b += strlen(b);
+	}
 
 	if (isEnhanced(report->common)) {
 	    snprintf(b, SNBUFFERSIZE-strlen(b), " (sock=%d)", report->common->socket);;
@@ -1355,6 +1671,9 @@ void reporter_print_settings_report (struct ReportSettings *report) {
     } else {
 	reporter_output_client_settings(report);
     }
+    if (isAffinity(report->common) && thread_affinity_placement()) {
+	printf("%s", thread_affinity_placement());
+    }
     printf("%s", separator_line);
     fflush(stdout);
 }
@@ -60,6 +60,7 @@
 #include "PerfSocket.hpp"
 #include "SocketAddr.h"
 #include "histogram.h"
+#include "packet_trace.h"
 #include "delay.h"
 #include "packet_ring.h"
 #include "payloads.h"
@@ -81,6 +82,7 @@ static void reporter_reset_transfer_stats_client_tcp(struct TransferInfo *stats)
 static void reporter_reset_transfer_stats_client_udp(struct TransferInfo *stats);
 static void reporter_reset_transfer_stats_server_udp(struct TransferInfo *stats);
 static void reporter_reset_transfer_stats_server_tcp(struct TransferInfo *stats);
+static void reporter_scenario_sum(struct SumReport *groupsum, int final);
 
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
 static inline bool sample_tcpistats(struct ReporterData *data, struct ReportStruct *sample, struct tcp_info *tcp_stats);
@@ -88,6 +90,9 @@ static inline void reporter_handle_packet_tcpistats(struct ReporterData *data, s
 #endif
 
 static struct ConnectionInfo *myConnectionReport;
+static struct ConnectRateInfo *myConnectRateSum = NULL;
+static struct TransactionInfo *myTransactionSum = NULL;
+static struct RPMInfo myRPM;
 
 void PostReport (struct ReportHeader *reporthdr) {
 #ifdef HAVE_THREAD_DEBUG
@@ -121,6 +126,47 @@ void PostReport (struct ReportHeader *reporthdr) {
 #endif
     }
 }
+
+/*
+ * PostReportInOrder posts a stateless report of a traffic thread, e.g.
+ * a --tcp-rr interval, which has to be output in order with the
+ * thread's others.  The thread's data report holds them and they're
+ * output, oldest first, as the reporter processes the data report,
+ * the last of them ahead of the final packet from EndJob
+ */
+void PostReportInOrder (struct ReporterData *data, struct ReportHeader *reporthdr) {
+    if (!data) {
+	PostReport(reporthdr);
+    } else if (reporthdr) {
+	reporthdr->next = NULL;
+#ifdef HAVE_THREAD
+	Condition_Lock(ReportCond);
+	if (!data->inorder_head) {
+	    data->inorder_head = reporthdr;
+	} else {
+	    data->inorder_tail->next = reporthdr;
+	}
+	data->inorder_tail = reporthdr;
+	Condition_Unlock(ReportCond);
+#else
+	reporter_process_report(reporthdr);
+#endif
+    }
+}
+
+static void reporter_process_inorder_reports (struct ReporterData *data) {
+    Condition_Lock(ReportCond);
+    struct ReportHeader *reporthdr = data->inorder_head;
+    data->inorder_head = NULL;
+    data->inorder_tail = NULL;
+    Condition_Unlock(ReportCond);
+    while (reporthdr) {
+	struct ReportHeader *next = reporthdr->next;
+	reporter_process_report(reporthdr);
+	reporthdr = next;
+    }
+}
+
 /*
  * ReportPacket is called by a transfer agent to record
  * the arrival or departure of a "packet" (for TCP it
@@ -149,6 +195,8 @@ bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet, struc
 	    rc = sample_tcpistats(data, packet, tcp_stats);
 	}
     }
+    if (data->trace && !packet->emptyreport)
+	packet_trace_insert(data->trace, packet);
     // Note for threaded operation all that needs
     // to be done is to enqueue the packet data
     // into the ring.
@@ -179,6 +227,8 @@ void ReportPacket (struct ReporterData* data, struct ReportStruct *packet) {
 	thread_debug("Reporting last packet for %p  qdepth=%d sock=%d", (void *) data, packetring_getcount(data->packetring), data->info.common->socket);
     }
   #endif
+    if (data->trace && !packet->emptyreport)
+	packet_trace_insert(data->trace, packet);
     // Note for threaded operation all that needs
     // to be done is to enqueue the packet data
     // into the ring.
@@ -257,6 +307,13 @@ int EndJob (struct ReportHeader *reporthdr, struct ReportStruct *finalpacket) {
 	}
 	Condition_Unlock((*(report->packetring->awake_producer)));
     }
+    // the reporter is done with the data report, post any in order reports it didn't output
+    while (report->inorder_head) {
+	struct ReportHeader *reporthdr = report->inorder_head;
+	report->inorder_head = reporthdr->next;
+	PostReport(reporthdr);
+    }
+    report->inorder_tail = NULL;
     if (report->FullDuplexReport && isFullDuplex(report->FullDuplexReport->info.common)) {
 	if (fullduplex_stop_barrier(&report->FullDuplexReport->fullduplex_barrier)) {
 	    struct Condition *tmp = &report->FullDuplexReport->fullduplex_barrier.await;
@@ -282,15 +339,17 @@ struct ConsumptionDetectorType {
     int accounted_packets;
     int accounted_packet_threads;
     int reporter_thread_suspends ;
+    int backlogged;
 };
 struct ConsumptionDetectorType consumption_detector = \
-  {.accounted_packets = 0, .accounted_packet_threads = 0, .reporter_thread_suspends = 0};
+  {.accounted_packets = 0, .accounted_packet_threads = 0, .reporter_thread_suspends = 0, .backlogged = 0};
 
 static inline void reset_consumption_detector (void) {
     consumption_detector.accounted_packet_threads = thread_numtrafficthreads();
     if ((consumption_detector.accounted_packets = thread_numtrafficthreads() * MINPERQUEUEDEPTH) <= MINPACKETDEPTH) {
 	consumption_detector.accounted_packets = MINPACKETDEPTH;
     }
+    consumption_detector.backlogged = 0;
 }
 static inline void apply_consumption_detector (void) {
     if (--consumption_detector.accounted_packet_threads <= 0) {
@@ -298,8 +357,10 @@ static inline void apply_consumption_detector (void) {
 	// reset the thread counter and check the consumption rate
 	// If the rate is too low add some delay to the reporter
 	consumption_detector.accounted_packet_threads = thread_numtrafficthreads();
-	// Check to see if we need to suspend the reporter
-	if (consumption_detector.accounted_packets > 0) {
+	// Check to see if we need to suspend the reporter, never when
+	// a report stopped at an interval with packets still queued,
+	// e.g. sub millisecond intervals, as the rings would only back up
+	if ((consumption_detector.accounted_packets > 0) && !consumption_detector.backlogged) {
 	    /*
 	     * Suspend the reporter thread for some (e.g. 4) milliseconds
 	     *
@@ -389,11 +450,111 @@ static void reporter_update_connect_time (double connect_time) {
 	    myConnectionReport->connect_times.min = connect_time;
 	if (connect_time > myConnectionReport->connect_times.max)
 	    myConnectionReport->connect_times.max = connect_time;
-    } else {
+    } else if (connect_time < 0.0) {
+	// a zero time is UDP, i.e. no 3WHS, rather than a failed connect
 	myConnectionReport->connect_times.err++;
     }
 }
 
+// Combine the means and m2s of two populations
+static void reporter_merge_meanminmax (struct MeanMinMaxStats *a, struct MeanMinMaxStats *b) {
+    if (b->cnt) {
+	int n = a->cnt + b->cnt;
+	double delta = b->mean - a->mean;
+	a->m2 += b->m2 + (delta * delta * ((double) a->cnt * b->cnt / n));
+	a->mean += delta * b->cnt / n;
+	a->sum += b->sum;
+	a->cnt = n;
+	if (b->min < a->min)
+	    a->min = b->min;
+	if (b->max > a->max)
+	    a->max = b->max;
+    }
+}
+
+// Sum the --connect-rate final reports of the -P threads
+static void reporter_sum_connect_rate (struct ConnectRateInfo *report) {
+    if (!myConnectRateSum) {
+	myConnectRateSum = (struct ConnectRateInfo *) calloc(1, sizeof(struct ConnectRateInfo));
+	if (!myConnectRateSum)
+	    return;
+	ConnectRateStatsReset(myConnectRateSum);
+	myConnectRateSum->final = 1;
+	if (report->latency_histogram) {
+	    struct histogram *h = report->latency_histogram;
+	    char name[] = "C8";
+	    myConnectRateSum->latency_histogram = histogram_init(h->bincount, h->binwidth, h->offset, h->units, \
+								 h->ci_lower, h->ci_upper, 0, name);
+	}
+    }
+    struct ConnectRateInfo *sum = myConnectRateSum;
+    int ix;
+    sum->threads++;
+    sum->rate += report->rate;
+    if (report->iEnd > sum->iEnd)
+	sum->iEnd = report->iEnd;
+    sum->tries += report->tries;
+    sum->overruns += report->overruns;
+    for (ix = 0; ix < CONNECTFAIL_MAX; ix++)
+	sum->fails[ix] += report->fails[ix];
+    reporter_merge_meanminmax(&sum->connect_times, &report->connect_times);
+    if (sum->latency_histogram && report->latency_histogram)
+	histogram_add(sum->latency_histogram, report->latency_histogram);
+}
+
+// Sum the --tcp-rr or --udp-echo final reports of the -P threads
+static void reporter_sum_transactions (struct TransactionInfo *report) {
+    if (!myTransactionSum) {
+	myTransactionSum = (struct TransactionInfo *) calloc(1, sizeof(struct TransactionInfo));
+	if (!myTransactionSum)
+	    return;
+	TransactionStatsReset(myTransactionSum);
+	myTransactionSum->final = 1;
+	myTransactionSum->request = report->request;
+	myTransactionSum->response = report->response;
+	myTransactionSum->depth = report->depth;
+	myTransactionSum->histogram_pdf = report->histogram_pdf;
+	myTransactionSum->udpecho = report->udpecho;
+	if (report->latency_histogram) {
+	    struct histogram *h = report->latency_histogram;
+	    char name[] = "T8";
+	    myTransactionSum->latency_histogram = histogram_init(h->bincount, h->binwidth, h->offset, h->units, \
+								 h->ci_lower, h->ci_upper, 0, name);
+	}
+    }
+    struct TransactionInfo *sum = myTransactionSum;
+    sum->threads++;
+    sum->conns += report->conns;
+    if (report->iEnd > sum->iEnd)
+	sum->iEnd = report->iEnd;
+    sum->requests += report->requests;
+    sum->fwd_lost += report->fwd_lost;
+    sum->fwd_outoforder += report->fwd_outoforder;
+    sum->rev_lost += report->rev_lost;
+    sum->rev_outoforder += report->rev_outoforder;
+    reporter_merge_meanminmax(&sum->rtt, &report->rtt);
+    if (sum->latency_histogram && report->latency_histogram)
+	histogram_add(sum->latency_histogram, report->latency_histogram);
+}
+
+// --rpm, the RPM line follows the bulk flows' final sum, or the
+// probe's final should that come later
+static void reporter_rpm_final (void) {
+    if (myRPM.probe && myRPM.bulk) {
+	reporter_print_rpm_report(&myRPM);
+	myRPM.probe = 0;
+	myRPM.bulk = 0;
+    }
+}
+
+static void reporter_rpm_bulk_final (struct TransferInfo *stats, int sum) {
+    snprintf(myRPM.id, sizeof(myRPM.id), "%s", (sum ? "[SUM] " : stats->common->transferIDStr));
+    myRPM.iStart = stats->ts.iStart;
+    myRPM.iEnd = stats->ts.iEnd;
+    myRPM.bulk = 1;
+    reporter_rpm_final();
+}
+
 /*
  * This function is the loop that the reporter thread processes
  */
@@ -426,6 +587,7 @@ void reporter_spawn (struct thread_Settings *thread) {
     // set reporter thread to realtime if requested
     thread_setscheduler(thread);
 #endif
+    thread_setaffinity_reporter(thread);
     /*
      * Keep the reporter thread alive under the following conditions
      *
@@ -464,10 +626,10 @@ void reporter_spawn (struct thread_Settings *thread) {
 #ifdef HAVE_THREAD_DEBUG
 		  thread_debug("Jobq *REMOVE* %p", (void *) (*work_item));
 #endif
-		    // memory for *work_item is gone by now
+		    // memory for *work_item is gone by now, the next
+		    // report takes its place and is processed in turn
 		    *work_item = tmp;
-		    if (!tmp)
-			break;
+		    continue;
 		}
 		work_item = &(*work_item)->next;
 	    }
@@ -479,6 +641,18 @@ void reporter_spawn (struct thread_Settings *thread) {
 	}
 	FreeConnectionReport(myConnectionReport);
     }
+    if (myConnectRateSum) {
+	if (myConnectRateSum->threads > 1)
+	    reporter_print_connect_rate_report(myConnectRateSum);
+	FreeConnectRateReport(myConnectRateSum);
+	myConnectRateSum = NULL;
+    }
+    if (myTransactionSum) {
+	if (myTransactionSum->threads > 1)
+	    reporter_print_transaction_report(myTransactionSum);
+	FreeTransactionReport(myTransactionSum);
+	myTransactionSum = NULL;
+    }
 #ifdef HAVE_THREAD_DEBUG
     if (sInterupted)
         reporter_jobq_dump();
@@ -545,6 +719,8 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    advance_jobq = 1;
 	    // A last packet event was detected
 	    // printf("last packet event detected\n"); fflush(stdout);
+	    // the thread posted its in order reports, e.g. a --tcp-rr final, before EndJob
+	    reporter_process_inorder_reports(this_ireport);
 	    this_ireport->reporter_thread_suspends = consumption_detector.reporter_thread_suspends;
 	    if (this_ireport->packet_handler_pre_report) {
 		(*this_ireport->packet_handler_pre_report)(this_ireport, packet);
@@ -555,6 +731,9 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    this_ireport->info.ts.packetTime = packet->packetTime;
 	    assert(this_ireport->transfer_protocol_handler != NULL);
 	    (*this_ireport->transfer_protocol_handler)(this_ireport, 1);
+	    int rpmbulk = isRPM(this_ireport->info.common) && !isRPMProbe(this_ireport->info.common);
+	    if (rpmbulk && !sumstats)
+		reporter_rpm_bulk_final(&this_ireport->info, 0);
 	    // This is a final report so set the sum report header's packet time
 	    // Note, the thread with the max value will set this
 	    if (fullduplexstats && isEnhanced(this_ireport->info.common)) {
@@ -575,14 +754,33 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 		}
 		if (DecrSumReportRefCounter(this_ireport->GroupSumReport) == 0) {
 		    if (this_ireport->GroupSumReport->transfer_protocol_sum_handler && \
-			((this_ireport->GroupSumReport->reference.maxcount > 1) || isSumOnly(this_ireport->info.common))) {
+			((this_ireport->GroupSumReport->reference.maxcount > 1) || isSumOnly(this_ireport->info.common) || \
+			 this_ireport->GroupSumReport->parent)) {
 			(*this_ireport->GroupSumReport->transfer_protocol_sum_handler)(&this_ireport->GroupSumReport->info, 1);
 		    }
-		    FreeSumReport(this_ireport->GroupSumReport);
+		    // a group's datagram count is per its label and, as with -P 1, not for a single flow
+		    if (this_ireport->GroupSumReport->info.labeled && isUDP(this_ireport->info.common) && \
+			(this_ireport->GroupSumReport->reference.maxcount > 1) && \
+			(this_ireport->info.common->ReportMode != kReport_CSV)) {
+			printf(report_sumlabel_datagrams, this_ireport->GroupSumReport->info.common->transferIDStr, \
+			       this_ireport->GroupSumReport->info.total.Datagrams.current);
+			fflush(stdout);
+		    }
+		    if (rpmbulk)
+			reporter_rpm_bulk_final(&this_ireport->GroupSumReport->info, (this_ireport->GroupSumReport->reference.maxcount > 1));
+		    if (this_ireport->GroupSumReport->parent)
+			reporter_scenario_sum(this_ireport->GroupSumReport, 1);
+		    if (FinishSumReport(this_ireport->GroupSumReport))
+			FreeSumReport(this_ireport->GroupSumReport);
 		}
 	    }
 	}
     }
+    // after the packets' intervals, which are as old or older
+    if (!need_free && this_ireport->inorder_head)
+	reporter_process_inorder_reports(this_ireport);
+    if (advance_jobq && !need_free && (this_ireport->packetring->producer != this_ireport->packetring->consumer))
+	consumption_detector.backlogged = 1;
     return need_free;
 }
 /*
@@ -630,6 +828,34 @@ inline int reporter_process_report (struct ReportHeader *reporthdr) {
 	fflush(stdout);
 	FreeReport(reporthdr);
 	break;
+    case CONNECT_RATE_REPORT:
+    {
+	struct ConnectRateInfo *crreport = (struct ConnectRateInfo *)reporthdr->this_report;
+	reporter_print_connect_rate_report(crreport);
+	if (crreport->final)
+	    reporter_sum_connect_rate(crreport);
+	FreeReport(reporthdr);
+    }
+	break;
+    case TRANSACTION_REPORT:
+    {
+	struct TransactionInfo *trreport = (struct TransactionInfo *)reporthdr->this_report;
+	reporter_print_transaction_report(trreport);
+	if (trreport->final)
+	    reporter_sum_transactions(trreport);
+	if (trreport->final && (trreport->rpm == 2)) {
+	    myRPM.idle = trreport->idle_rtt.cnt ? trreport->idle_rtt.mean : 0;
+	    myRPM.loaded = trreport->rtt.cnt ? trreport->rtt.mean : 0;
+	    myRPM.probe = 1;
+	    reporter_rpm_final();
+	}
+	FreeReport(reporthdr);
+    }
+	break;
+    case FLOW_REPORT:
+	reporter_print_flow_report((struct FlowInfo *)reporthdr->this_report);
+	FreeReport(reporthdr);
+	break;
     default:
 	fprintf(stderr,"Invalid report type in process report %p\n", reporthdr->this_report);
 	assert(0);
@@ -655,8 +881,10 @@ void reporter_transfer_protocol_null (struct ReporterData *data, int final){
 inline void reporter_handle_packet_pps (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
     if (!packet->emptyreport) {
-        stats->total.Datagrams.current++;
-        stats->total.IPG.current++;
+	// a --udp-echo client reports a sendmmsg batch as one packet of burstsize datagrams
+	intmax_t cnt = (isUDPEcho(stats->common) && (packet->burstsize > 0)) ? packet->burstsize : 1;
+        stats->total.Datagrams.current += cnt;
+        stats->total.IPG.current += cnt;
     }
     stats->ts.IPGstart = packet->packetTime;
     stats->IPGsum += TimeDifference(packet->packetTime, packet->prevPacketTime);
@@ -821,11 +1049,24 @@ inline void reporter_handle_packet_isochronous (struct ReporterData *data, struc
     }
 }
 
+// --payload-verify, reads checked by the server thread against the client's pattern
+static inline void reporter_handle_packet_payloadverify (struct TransferInfo *stats, struct ReportStruct *packet) {
+    if (packet->l2errors & L2PAYLOADCHK) {
+	stats->l2counts.payloadchk++;
+	stats->l2counts.tot_payloadchk++;
+	if (packet->l2errors & L2PAYLOADERR) {
+	    stats->l2counts.payloaderr++;
+	    stats->l2counts.tot_payloaderr++;
+	}
+    }
+}
+
 inline void reporter_handle_packet_server_tcp (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
     if (packet->packetLen > 0) {
 	int bin;
 	stats->total.Bytes.current += packet->packetLen;
+	reporter_handle_packet_payloadverify(stats, packet);
 	// mean min max tests
 	stats->sock_callstats.read.cntRead++;
 	stats->sock_callstats.read.totcntRead++;
@@ -839,6 +1080,105 @@ inline void reporter_handle_packet_server_tcp (struct ReporterData *data, struct
     }
 }
 
+// O(1) amortized, a slot is cleared once per id the window slides over
+static inline void reporter_handle_packet_seqwindow (struct SeqWindow *win, intmax_t packetID) {
+    if (packetID > win->head) {
+	if ((packetID - win->head) >= SEQWINDOW_BITS) {
+	    memset(win->bitmap, 0, sizeof(win->bitmap));
+	} else {
+	    intmax_t id;
+	    for (id = win->head + 1; id < packetID; id++)
+		win->bitmap[(id & (SEQWINDOW_BITS - 1)) >> 6] &= ~((uint64_t) 1 << (id & 63));
+	}
+	win->head = packetID;
+    } else {
+	intmax_t distance = win->head - packetID;
+	int bin = 0;
+	if (distance >= SEQWINDOW_BITS) {
+	    // too old to tell a duplicate from a late packet
+	    win->beyond++;
+	    win->tot_beyond++;
+	    bin = SEQWINDOW_REORDERBINS - 1;
+	} else if (win->bitmap[(packetID & (SEQWINDOW_BITS - 1)) >> 6] & ((uint64_t) 1 << (packetID & 63))) {
+	    win->dups++;
+	    win->tot_dups++;
+	    return;
+	} else {
+	    win->late++;
+	    win->tot_late++;
+	    while ((distance >> (bin + 1)) && (bin < (SEQWINDOW_REORDERBINS - 2)))
+		bin++;
+	}
+	win->reorder[bin]++;
+	win->tot_reorder[bin]++;
+	if (distance > win->maxreorder)
+	    win->maxreorder = distance;
+	if (distance > win->tot_maxreorder)
+	    win->tot_maxreorder = distance;
+	if (bin == (SEQWINDOW_REORDERBINS - 1))
+	    return;
+    }
+    win->bitmap[(packetID & (SEQWINDOW_BITS - 1)) >> 6] |= ((uint64_t) 1 << (packetID & 63));
+}
+
+static inline void reporter_lossruns_insert (struct LossRunCounters *counters, intmax_t run, intmax_t goodrun) {
+    int bin = 0;
+    while ((run >> (bin + 1)) && (bin < (LOSSRUN_BINS - 1)))
+	bin++;
+    counters->bins[bin]++;
+    counters->runs++;
+    counters->lost += run;
+    if (run > counters->maxrun)
+	counters->maxrun = run;
+    if (goodrun) {
+	if (!counters->gaps || (goodrun < counters->mingap))
+	    counters->mingap = goodrun;
+	if (goodrun > counters->maxgap)
+	    counters->maxgap = goodrun;
+	counters->gaps++;
+	counters->gapsum += goodrun;
+    }
+}
+
+// Count the ids up to limit, in id order, as received or lost per the
+// sequence window.  Called before the window's head moves so ids above
+// the head are lost.  O(1) amortized, an id is counted once.
+static inline void reporter_lossruns_settle (struct LossRuns *lossruns, struct SeqWindow *win, intmax_t limit) {
+    intmax_t id;
+    for (id = lossruns->settled + 1; id <= limit; id++) {
+	if (id > win->head) {
+	    lossruns->lossrun += limit - id + 1;
+	    break;
+	}
+	if (((win->head - id) < SEQWINDOW_BITS) && \
+	    (win->bitmap[(id & (SEQWINDOW_BITS - 1)) >> 6] & ((uint64_t) 1 << (id & 63)))) {
+	    if (lossruns->lossrun) {
+		reporter_lossruns_insert(&lossruns->interval, lossruns->lossrun, lossruns->goodrun);
+		reporter_lossruns_insert(&lossruns->total, lossruns->lossrun, lossruns->goodrun);
+		lossruns->lossrun = 0;
+		lossruns->goodrun = 0;
+	    }
+	    lossruns->goodrun++;
+	    lossruns->interval.received++;
+	    lossruns->total.received++;
+	} else {
+	    lossruns->lossrun++;
+	}
+    }
+    if (limit > lossruns->settled)
+	lossruns->settled = limit;
+}
+
+// Packets counted as lost which arrived later.  Without a sequence window
+// assume out-of-order packets aren't duplicates.
+static inline intmax_t reporter_udp_recovered (struct TransferInfo *stats, intmax_t outoforder, int total) {
+    if (stats->seqwindow) {
+	return (total ? (stats->seqwindow->tot_late + stats->seqwindow->tot_beyond) : \
+		(stats->seqwindow->late + stats->seqwindow->beyond));
+    }
+    return outoforder;
+}
+
 inline void reporter_handle_packet_server_udp (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
     stats->ts.packetTime = packet->packetTime;
@@ -857,7 +1197,8 @@ inline void reporter_handle_packet_server_udp (struct ReporterData *data, struct
 	stats->total.Bytes.current += packet->packetLen;
 	// These are valid packets that need standard iperf accounting
 	// Do L2 accounting first (if needed)
-	if (packet->l2errors && (stats->total.Datagrams.current > L2DROPFILTERCOUNTER)) {
+	reporter_handle_packet_payloadverify(stats, packet);
+	if ((packet->l2errors & L2ERRORS) && (stats->total.Datagrams.current > L2DROPFILTERCOUNTER)) {
 	    stats->l2counts.cnt++;
 	    stats->l2counts.tot_cnt++;
 	    if (packet->l2errors & L2UNKNOWN) {
@@ -881,6 +1222,11 @@ inline void reporter_handle_packet_server_udp (struct ReporterData *data, struct
 		stats->total.Lost.current += packet->packetID - stats->PacketID - 1;
 	    }
 	}
+	// loss runs are allocated with the sequence window, settle ids before it slides
+	if (stats->lossruns && (packet->packetID > stats->seqwindow->head))
+	    reporter_lossruns_settle(stats->lossruns, stats->seqwindow, packet->packetID - LOSSRUN_SETTLE);
+	if (stats->seqwindow)
+	    reporter_handle_packet_seqwindow(stats->seqwindow, packet->packetID);
 	// never decrease datagramID (e.g. if we get an out-of-order packet)
 	if (packet->packetID > stats->PacketID) {
 	    stats->PacketID = packet->packetID;
@@ -961,28 +1307,30 @@ static inline void reporter_set_timestamps_time (struct ReportTimeStamps *times,
     // There is a corner case when the first packet is also the last where the start time (which comes
     // from app level syscall) is greater than the packetTime (which come for kernel level SO_TIMESTAMP)
     // For this case set the start and end time to both zero.
+    // The times are then moved by the start offset onto the shared clock, if any.
     if (TimeDifference(times->packetTime, times->startTime) < 0) {
-	times->iEnd = 0;
-	times->iStart = 0;
+	times->iEnd = times->startOffset;
+	times->iStart = times->startOffset;
     } else {
 	switch (tstype) {
 	case INTERVAL:
 	    times->iStart = times->iEnd;
-	    times->iEnd = TimeDifference(times->nextTime, times->startTime);
+	    times->iEnd = TimeDifference(times->nextTime, times->startTime) + times->startOffset;
 	    TimeAdd(times->nextTime, times->intervalTime);
 	    break;
 	case TOTAL:
-	    times->iStart = 0;
-	    times->iEnd = TimeDifference(times->packetTime, times->startTime);
+	    times->iStart = times->startOffset;
+	    times->iEnd = TimeDifference(times->packetTime, times->startTime) + times->startOffset;
 	    break;
 	case FINALPARTIAL:
 	    times->iStart = times->iEnd;
-	    times->iEnd = TimeDifference(times->packetTime, times->startTime);
+	    times->iEnd = TimeDifference(times->packetTime, times->startTime) + times->startOffset;
 	    break;
 	case FRAME:
 	    if ((times->iStart = TimeDifference(times->prevpacketTime, times->startTime)) < 0)
 		times->iStart = 0.0;
-	    times->iEnd = TimeDifference(times->packetTime, times->startTime);
+	    times->iStart += times->startOffset;
+	    times->iEnd = TimeDifference(times->packetTime, times->startTime) + times->startOffset;
 	    break;
 	default:
 	    times->iEnd = -1;
@@ -1002,6 +1350,7 @@ static inline void reporter_transfer_protocol_missed_reports (struct TransferInf
 	emptystats.ts.iStart = stats->ts.iStart;
 	emptystats.ts.iEnd = stats->ts.iEnd;
 	emptystats.common = stats->common;
+	emptystats.series = stats->series;
 	if ((stats->output_handler) && !(stats->filter_this_sample_output))
 	    (*stats->output_handler)(&emptystats);
     }
@@ -1051,6 +1400,8 @@ static inline void reporter_reset_transfer_stats_server_tcp (struct TransferInfo
     stats->transit.meanTransit = 0;
     stats->transit.m2Transit = 0;
     stats->IPGsum = 0;
+    stats->l2counts.payloadchk = 0;
+    stats->l2counts.payloaderr = 0;
 }
 
 static inline void reporter_reset_transfer_stats_server_udp (struct TransferInfo *stats) {
@@ -1059,6 +1410,7 @@ static inline void reporter_reset_transfer_stats_server_udp (struct TransferInfo
     stats->total.Datagrams.prev = stats->PacketID;
     stats->total.OutofOrder.prev = stats->total.OutofOrder.current;
     stats->total.Lost.prev = stats->total.Lost.current;
+    stats->total.Recovered.prev = stats->total.Recovered.current;
     stats->total.IPG.prev = stats->total.IPG.current;
     stats->transit.minTransit = FLT_MAX;
     stats->transit.maxTransit = FLT_MIN;
@@ -1074,6 +1426,18 @@ static inline void reporter_reset_transfer_stats_server_udp (struct TransferInfo
     stats->l2counts.unknown = 0;
     stats->l2counts.udpcsumerr = 0;
     stats->l2counts.lengtherr = 0;
+    stats->l2counts.payloadchk = 0;
+    stats->l2counts.payloaderr = 0;
+    if (stats->seqwindow) {
+	stats->seqwindow->dups = 0;
+	stats->seqwindow->late = 0;
+	stats->seqwindow->beyond = 0;
+	stats->seqwindow->maxreorder = 0;
+	memset(stats->seqwindow->reorder, 0, sizeof(stats->seqwindow->reorder));
+    }
+    if (stats->lossruns) {
+	memset(&stats->lossruns->interval, 0, sizeof(struct LossRunCounters));
+    }
     if (stats->cntDatagrams)
 	stats->IPGsum = 0;
 }
@@ -1087,12 +1451,15 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
     struct TransferInfo *stats = &data->info;
     struct TransferInfo *sumstats = (data->GroupSumReport != NULL) ? &data->GroupSumReport->info : NULL;
     struct TransferInfo *fullduplexstats = (data->FullDuplexReport != NULL) ? &data->FullDuplexReport->info : NULL;
+    // nothing more will arrive, count the ids still in the reorder window
+    if (final && stats->lossruns)
+	reporter_lossruns_settle(stats->lossruns, stats->seqwindow, stats->seqwindow->head);
     // print a interval report and possibly a partial interval report if this a final
     stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
     stats->cntOutofOrder = stats->total.OutofOrder.current - stats->total.OutofOrder.prev;
     // assume most of the  time out-of-order packets are
     // duplicate packets, so conditionally subtract them from the lost packets.
-    stats->cntError = stats->total.Lost.current - stats->total.Lost.prev - stats->cntOutofOrder;
+    stats->cntError = stats->total.Lost.current - stats->total.Lost.prev - reporter_udp_recovered(stats, stats->cntOutofOrder, 0);
     if (stats->cntError < 0)
 	stats->cntError = 0;
     stats->cntDatagrams = stats->PacketID - stats->total.Datagrams.prev;
@@ -1117,6 +1484,8 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	// assume most of the  time out-of-order packets are not
 	// duplicate packets, so conditionally subtract them from the lost packets.
 	sumstats->total.Lost.current += stats->total.Lost.current - stats->total.Lost.prev;
+	// the sum subtracts the flows' recovered packets by the same rule
+	sumstats->total.Recovered.current += reporter_udp_recovered(stats, stats->total.OutofOrder.current - stats->total.OutofOrder.prev, 0);
 	sumstats->total.Datagrams.current += stats->PacketID - stats->total.Datagrams.prev;
 	sumstats->total.Bytes.current += stats->cntBytes;
 	sumstats->total.IPG.current += stats->cntIPG;
@@ -1137,7 +1506,7 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	    // assume most of the  time out-of-order packets are not
 	    // duplicate packets, so conditionally subtract them from the lost packets.
 	    stats->cntError = stats->total.Lost.current - stats->total.Lost.prev;
-	    stats->cntError -= stats->cntOutofOrder;
+	    stats->cntError -= reporter_udp_recovered(stats, stats->cntOutofOrder, 0);
 	    if (stats->cntError < 0)
 		stats->cntError = 0;
 	    stats->cntDatagrams = stats->PacketID - stats->total.Datagrams.prev;
@@ -1154,7 +1523,7 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	// assume most of the  time out-of-order packets are not
 	// duplicate packets, so conditionally subtract them from the lost packets.
 	stats->cntError = stats->total.Lost.current;
-	stats->cntError -= stats->cntOutofOrder;
+	stats->cntError -= reporter_udp_recovered(stats, stats->cntOutofOrder, 1);
 	if (stats->cntError < 0)
 	    stats->cntError = 0;
 	stats->cntDatagrams = stats->PacketID;
@@ -1165,6 +1534,18 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	stats->l2counts.unknown = stats->l2counts.tot_unknown;
 	stats->l2counts.udpcsumerr = stats->l2counts.tot_udpcsumerr;
 	stats->l2counts.lengtherr = stats->l2counts.tot_lengtherr;
+	stats->l2counts.payloadchk = stats->l2counts.tot_payloadchk;
+	stats->l2counts.payloaderr = stats->l2counts.tot_payloaderr;
+	if (stats->seqwindow) {
+	    stats->seqwindow->dups = stats->seqwindow->tot_dups;
+	    stats->seqwindow->late = stats->seqwindow->tot_late;
+	    stats->seqwindow->beyond = stats->seqwindow->tot_beyond;
+	    stats->seqwindow->maxreorder = stats->seqwindow->tot_maxreorder;
+	    memcpy(stats->seqwindow->reorder, stats->seqwindow->tot_reorder, sizeof(stats->seqwindow->reorder));
+	}
+	if (stats->lossruns) {
+	    stats->lossruns->interval = stats->lossruns->total;
+	}
 	stats->transit.minTransit = stats->transit.totminTransit;
         stats->transit.maxTransit = stats->transit.totmaxTransit;
 	stats->transit.cntTransit = stats->transit.totcntTransit;
@@ -1186,6 +1567,12 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
     }
     if ((stats->output_handler) && !(stats->filter_this_sample_output))
 	(*stats->output_handler)(stats);
+    if (isPayloadVerify(stats->common) && (final || (stats->l2counts.payloaderr && !stats->series)) && (stats->common->ReportMode != kReport_CSV))
+	reporter_print_payloadverify_report(stats);
+    if (final && isBusyPoll(stats->common) && (stats->common->ReportMode != kReport_CSV))
+	reporter_print_busypoll_report(stats);
+    if (final && isIncomingCPU(stats->common) && stats->incomingcpu.found && (stats->common->ReportMode != kReport_CSV))
+	reporter_print_incomingcpu_report(stats);
     if (!final)
 	reporter_reset_transfer_stats_server_udp(stats);
 }
@@ -1193,11 +1580,12 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 void reporter_transfer_protocol_sum_server_udp (struct TransferInfo *stats, int final) {
     if (final) {
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
 	stats->cntOutofOrder = stats->total.OutofOrder.current;
 	// assume most of the  time out-of-order packets are not
 	// duplicate packets, so conditionally subtract them from the lost packets.
 	stats->cntError = stats->total.Lost.current;
-	stats->cntError -= stats->cntOutofOrder;
+	stats->cntError -= stats->total.Recovered.current;
 	if (stats->cntError < 0)
 	    stats->cntError = 0;
 	stats->cntDatagrams = stats->total.Datagrams.current;
@@ -1209,7 +1597,7 @@ void reporter_transfer_protocol_sum_server_udp (struct TransferInfo *stats, int
 	// assume most of the  time out-of-order packets are not
 	// duplicate packets, so conditionally subtract them from the lost packets.
 	stats->cntError = stats->total.Lost.current - stats->total.Lost.prev;
-	stats->cntError -= stats->cntOutofOrder;
+	stats->cntError -= stats->total.Recovered.current - stats->total.Recovered.prev;
 	if (stats->cntError < 0)
 	    stats->cntError = 0;
 	stats->cntDatagrams = stats->total.Datagrams.current - stats->total.Datagrams.prev;
@@ -1228,6 +1616,7 @@ void reporter_transfer_protocol_sum_server_udp (struct TransferInfo *stats, int
 void reporter_transfer_protocol_sum_client_udp (struct TransferInfo *stats, int final) {
     if (final) {
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
 	stats->cntDatagrams = stats->total.Datagrams.current;
@@ -1245,7 +1634,7 @@ void reporter_transfer_protocol_sum_client_udp (struct TransferInfo *stats, int
     if (!final) {
 	stats->threadcnt = 0;
 	reporter_reset_transfer_stats_client_udp(stats);
-    } else if ((stats->common->ReportMode != kReport_CSV) && !(stats->filter_this_sample_output)) {
+    } else if ((stats->common->ReportMode != kReport_CSV) && !(stats->filter_this_sample_output) && !stats->labeled) {
 	printf(report_sumcnt_datagrams, stats->threadcnt, stats->total.Datagrams.current);
 	fflush(stdout);
     }
@@ -1284,6 +1673,7 @@ void reporter_transfer_protocol_client_udp (struct ReporterData *data, int final
     }
     if (final) {
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
 	stats->cntBytes = stats->total.Bytes.current;
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
@@ -1370,6 +1760,8 @@ void reporter_transfer_protocol_server_tcp (struct ReporterData *data, int final
 	stats->transit.minTransit = stats->transit.totminTransit;
 	stats->transit.maxTransit = stats->transit.totmaxTransit;
 	stats->transit.m2Transit = stats->transit.totm2Transit;
+	stats->l2counts.payloadchk = stats->l2counts.tot_payloadchk;
+	stats->l2counts.payloaderr = stats->l2counts.tot_payloaderr;
 	if (stats->framelatency_histogram) {
 	    stats->framelatency_histogram->final = 1;
 	}
@@ -1384,6 +1776,10 @@ void reporter_transfer_protocol_server_tcp (struct ReporterData *data, int final
 	    histogram_print(stats->framelatency_histogram, stats->ts.iStart, stats->ts.iEnd);
 	}
     }
+    if (isPayloadVerify(stats->common) && (final || (stats->l2counts.payloaderr && !stats->series)) && (stats->common->ReportMode != kReport_CSV))
+	reporter_print_payloadverify_report(stats);
+    if (final && isBusyPoll(stats->common) && (stats->common->ReportMode != kReport_CSV))
+	reporter_print_busypoll_report(stats);
     if (!final)
 	reporter_reset_transfer_stats_server_tcp(stats);
 }
@@ -1459,6 +1855,7 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
 	}
 	stats->cntBytes = stats->total.Bytes.current;
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
     } else if (isIsochronous(stats->common)) {
 	stats->isochstats.cntFrames = stats->isochstats.framecnt.current - stats->isochstats.framecnt.prev;
 	stats->isochstats.cntFramesMissed = stats->isochstats.framelostcnt.current - stats->isochstats.framelostcnt.prev;
@@ -1498,6 +1895,7 @@ void reporter_transfer_protocol_sum_client_tcp (struct TransferInfo *stats, int
 #endif
 	stats->cntBytes = stats->total.Bytes.current;
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
 	if ((stats->output_handler) && !(stats->filter_this_sample_output))
 	    (*stats->output_handler)(stats);
     }
@@ -1527,6 +1925,7 @@ void reporter_transfer_protocol_sum_server_tcp (struct TransferInfo *stats, int
 	}
 	stats->cntBytes = stats->total.Bytes.current;
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
 	if ((stats->output_handler) && !(stats->filter_this_sample_output))
 	    (*stats->output_handler)(stats);
     }
@@ -1546,6 +1945,7 @@ void reporter_transfer_protocol_fullduplex_tcp (struct TransferInfo *stats, int
     if (final) {
 	stats->cntBytes = stats->total.Bytes.current;
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
     } else {
 	reporter_set_timestamps_time(&stats->ts, INTERVAL);
     }
@@ -1578,6 +1978,7 @@ void reporter_transfer_protocol_fullduplex_udp (struct TransferInfo *stats, int
 	stats->cntIPG = stats->total.IPG.current;
 	stats->IPGsum = TimeDifference(stats->ts.packetTime, stats->ts.startTime);
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	stats->final = true;
     } else {
 	reporter_set_timestamps_time(&stats->ts, INTERVAL);
     }
@@ -1585,6 +1986,80 @@ void reporter_transfer_protocol_fullduplex_udp (struct TransferInfo *stats, int
 	(*stats->output_handler)(stats);
 }
 
+/*
+ * The scenario wide sum closes an interval once it has heard of traffic
+ * past the interval's end and each group running in the interval has
+ * output its own, i.e. a group is placed by its start offset on the
+ * scenario's clock
+ */
+static bool reporter_scenario_interval_done (struct SumReport *scenario) {
+    struct TransferInfo *sumstats = &scenario->info;
+    if (TimeDifference(sumstats->ts.packetTime, sumstats->ts.nextTime) < 0)
+	return false;
+    double halfinterval = TimeDouble(sumstats->ts.intervalTime) / 2;
+    bool done = true;
+    for (int ix = 0; done && (ix < scenario->groupcnt); ix++) {
+	struct SumReport *groupsum = scenario->groups[ix];
+	if (groupsum == NULL)
+	    continue;
+	Mutex_Lock(&groupsum->reference.lock);
+	struct ReportTimeStamps ts = groupsum->info.ts;
+	Mutex_Unlock(&groupsum->reference.lock);
+	// not started or starting after the interval
+	if (TimeZero(ts.startTime) || (TimeDifference(ts.startTime, sumstats->ts.nextTime) > -halfinterval))
+	    continue;
+	// the end of the group's last interval, its next one less an interval
+	if ((TimeDifference(ts.nextTime, sumstats->ts.nextTime) - TimeDouble(ts.intervalTime)) < -halfinterval)
+	    done = false;
+    }
+    return done;
+}
+
+/*
+ * A --scenario group sum adds what it summed since its last call to the
+ * scenario wide sum, called after the group's interval or final sum
+ */
+static void reporter_scenario_sum (struct SumReport *groupsum, int final) {
+    struct SumReport *scenario = groupsum->parent;
+    struct TransferInfo *stats = &groupsum->info;
+    struct TransferInfo *sumstats = &scenario->info;
+    if (groupsum->finished)
+	return;
+    int writes = stats->sock_callstats.write.totWriteCnt - groupsum->parent_write.totWriteCnt;
+    int errs = stats->sock_callstats.write.totWriteErr - groupsum->parent_write.totWriteErr;
+    sumstats->total.Bytes.current += stats->total.Bytes.current - groupsum->parent_bytes;
+    sumstats->sock_callstats.write.WriteCnt += writes;
+    sumstats->sock_callstats.write.totWriteCnt += writes;
+    sumstats->sock_callstats.write.WriteErr += errs;
+    sumstats->sock_callstats.write.totWriteErr += errs;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+    int retries = stats->sock_callstats.write.totTCPretry - groupsum->parent_write.totTCPretry;
+    sumstats->sock_callstats.write.TCPretry += retries;
+    sumstats->sock_callstats.write.totTCPretry += retries;
+#endif
+    groupsum->parent_bytes = stats->total.Bytes.current;
+    groupsum->parent_write = stats->sock_callstats.write;
+    if (TimeDifference(stats->ts.packetTime, sumstats->ts.packetTime) > 0)
+	sumstats->ts.packetTime = stats->ts.packetTime;
+    int running = 0;
+    for (int ix = 0; ix < scenario->groupcnt; ix++) {
+	if (final && (scenario->groups[ix] == groupsum))
+	    scenario->groups[ix] = NULL;
+	if (scenario->groups[ix] != NULL)
+	    running++;
+    }
+    if (!TimeZero(sumstats->ts.intervalTime)) {
+	while (reporter_scenario_interval_done(scenario)) {
+	    reporter_set_timestamps_time(&sumstats->ts, INTERVAL);
+	    (*scenario->transfer_protocol_sum_handler)(sumstats, 0);
+	}
+    }
+    if (!running) {
+	(*scenario->transfer_protocol_sum_handler)(sumstats, 1);
+	FreeSumReport(scenario);
+    }
+}
+
 // Conditional print based on time
 int reporter_condprint_time_interval_report (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
@@ -1614,7 +2089,7 @@ int reporter_condprint_time_interval_report (struct ReporterData *data, struct R
 	    if ((++data->GroupSumReport->threads) == data->GroupSumReport->reference.count)   {
 		data->GroupSumReport->threads = 0;
 		if ((data->GroupSumReport->reference.count > 1) || \
-		    isSumOnly(data->info.common)) {
+		    isSumOnly(data->info.common) || data->GroupSumReport->parent) {
 		    sumstats->filter_this_sample_output = 0;
 		} else {
 		    sumstats->filter_this_sample_output = 1;
@@ -1622,6 +2097,8 @@ int reporter_condprint_time_interval_report (struct ReporterData *data, struct R
 		reporter_set_timestamps_time(&sumstats->ts, INTERVAL);
 		assert(data->GroupSumReport->transfer_protocol_sum_handler != NULL);
 		(*data->GroupSumReport->transfer_protocol_sum_handler)(sumstats, 0);
+		if (data->GroupSumReport->parent)
+		    reporter_scenario_sum(data->GroupSumReport, 0);
 	    }
 	}
         // In the (hopefully unlikely event) the reporter fell behind
@@ -1651,7 +2128,7 @@ int reporter_condprint_frame_interval_report_server_udp (struct ReporterData *da
 	// assume most of the  time out-of-order packets are not
 	// duplicate packets, so conditionally subtract them from the lost packets.
 	stats->cntError = stats->total.Lost.current - stats->total.Lost.prev;
-	stats->cntError -= stats->cntOutofOrder;
+	stats->cntError -= reporter_udp_recovered(stats, stats->cntOutofOrder, 0);
 	if (stats->cntError < 0)
 	    stats->cntError = 0;
 	stats->cntDatagrams = stats->PacketID - stats->total.Datagrams.prev;
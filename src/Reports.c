@@ -58,6 +58,8 @@
 #include "Locale.h"
 #include "active_hosts.h"
 #include "payloads.h"
+#include "interval_series.h"
+#include "packet_trace.h"
 static int transferid_counter = 0;
 
 static inline int my_str_copy(char **dst, char *src) {
@@ -130,6 +132,7 @@ static void common_copy (struct ReportCommon **common, struct thread_Settings *i
     (*common)->rtt_weight =inSettings->rtt_nearcongest_divider;
     (*common)->ListenerTimeout =inSettings->mListenerTimeout;
     (*common)->FPS = inSettings->mFPS;
+    (*common)->BusyPoll = inSettings->mBusyPoll;
 #if HAVE_DECL_TCP_WINDOW_CLAMP
     (*common)->ClampSize = inSettings->mClampSize;
 #endif
@@ -223,6 +226,23 @@ void setTransferID (struct thread_Settings *inSettings, int role_reversal) {
     }
 }
 
+// Defer interval output per --interval-series by interposing the series
+// output handler in front of the report's output handler.  This may be
+// called more than once per report, e.g. when the sum handlers are reset
+static void SetIntervalSeriesHandler (struct thread_Settings *inSettings, struct TransferInfo *stats, const char *label) {
+    if (!isIntervalSeries(inSettings) || (stats->output_handler == NULL) || \
+	(stats->output_handler == interval_series_output))
+	return;
+    if (!stats->series) {
+	stats->series = interval_series_init(interval_series_count(inSettings), label);
+	if (!stats->series) {
+	    FAIL(1, "Out of Memory!!\n", inSettings);
+	}
+    }
+    stats->series->output_handler = stats->output_handler;
+    stats->output_handler = interval_series_output;
+}
+
 void SetFullDuplexHandlers (struct thread_Settings *inSettings, struct SumReport* sumreport) {
     if (isUDP(inSettings)) {
 	sumreport->transfer_protocol_sum_handler = reporter_transfer_protocol_fullduplex_udp;
@@ -235,6 +255,7 @@ void SetFullDuplexHandlers (struct thread_Settings *inSettings, struct SumReport
 					      (isSumOnly(inSettings) ? NULL : \
 					       (isEnhanced(inSettings) ? tcp_output_fullduplex_enhanced : tcp_output_fullduplex)));
     }
+    SetIntervalSeriesHandler(inSettings, &sumreport->info, "[ FD] ");
 }
 
 void SetSumHandlers (struct thread_Settings *inSettings, struct SumReport* sumreport) {
@@ -288,6 +309,7 @@ void SetSumHandlers (struct thread_Settings *inSettings, struct SumReport* sumre
     // overide output handlers when csv reporting set
     if (inSettings->mReportMode == kReport_CSV)
 	sumreport->info.output_handler = NULL;
+    SetIntervalSeriesHandler(inSettings, &sumreport->info, "[SUM] ");
 }
 
 struct SumReport* InitSumReport(struct thread_Settings *inSettings, int inID, int fullduplex_report) {
@@ -333,6 +355,50 @@ struct SumReport* InitSumReport(struct thread_Settings *inSettings, int inID, in
     return sumreport;
 }
 
+// Replace the output of a sum report, keeping the --interval-series deferral (if any)
+static void SetSumOutputHandler (struct SumReport *sumreport, void (*output_handler) (struct TransferInfo *stats)) {
+    if (sumreport->info.series) {
+	sumreport->info.series->output_handler = output_handler;
+    } else if (sumreport->info.output_handler) {
+	sumreport->info.output_handler = output_handler;
+    }
+}
+
+/*
+ * The scenario wide sum of --scenario is fed by the group sums, i.e. not
+ * by the traffic threads, with the bytes and writes only so it's always
+ * output as a TCP client sum.  It starts at the scenario start so its
+ * intervals are on the scenario's clock
+ */
+struct SumReport* InitScenarioSumReport (struct thread_Settings *inSettings, int groups, struct timeval *start) {
+    struct SumReport *sumreport = InitSumReport(inSettings, 0, 0);
+    sumreport->transfer_protocol_sum_handler = reporter_transfer_protocol_sum_client_tcp;
+    SetSumOutputHandler(sumreport, (isEnhanced(inSettings) ? tcp_output_sum_write_enhanced : tcp_output_sum_write));
+    sumreport->groups = (struct SumReport **) calloc(groups, sizeof(struct SumReport *));
+    if (sumreport->groups == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    sumreport->info.ts.startTime = *start;
+    sumreport->info.ts.packetTime = *start;
+    if (!TimeZero(sumreport->info.ts.intervalTime)) {
+	sumreport->info.ts.nextTime = *start;
+	TimeAdd(sumreport->info.ts.nextTime, sumreport->info.ts.intervalTime);
+    }
+    return sumreport;
+}
+
+// A --scenario group sum is output with the group's label in place of [SUM]
+struct SumReport* InitGroupSumReport (struct thread_Settings *inSettings, int inID, const char *label, struct SumReport *parent) {
+    struct SumReport *sumreport = InitSumReport(inSettings, inID, 0);
+    free(sumreport->info.common->transferIDStr);
+    my_str_copy(&sumreport->info.common->transferIDStr, (char *) label);
+    sumreport->info.labeled = true;
+    SetSumOutputHandler(sumreport, (isUDP(inSettings) ? udp_output_fullduplex : tcp_output_fullduplex));
+    sumreport->parent = parent;
+    parent->groups[parent->groupcnt++] = sumreport;
+    return sumreport;
+}
+
 struct ConnectionInfo * InitConnectOnlyReport (struct thread_Settings *thread) {
     assert(thread != NULL);
     // this connection report used only by report for accumulate stats
@@ -356,7 +422,10 @@ void FreeSumReport (struct SumReport *sumreport) {
     thread_debug("Free sum report hdr=%p", (void *)sumreport);
 #endif
     Condition_Destroy_Reference(&sumreport->reference);
+    interval_series_free(sumreport->info.series);
     free_common_copy(sumreport->info.common);
+    if (sumreport->groups)
+	free(sumreport->groups);
     free(sumreport);
 }
 
@@ -383,6 +452,14 @@ static void Free_iReport (struct ReporterData *ireport) {
     if (ireport->info.framelatency_histogram) {
 	histogram_delete(ireport->info.framelatency_histogram);
     }
+    if (ireport->info.seqwindow) {
+	free(ireport->info.seqwindow);
+    }
+    if (ireport->info.lossruns) {
+	free(ireport->info.lossruns);
+    }
+    interval_series_free(ireport->info.series);
+    packet_trace_close(ireport->trace);
     free_common_copy(ireport->info.common);
     free(ireport);
 }
@@ -392,6 +469,26 @@ void FreeConnectionReport (struct ConnectionInfo *report) {
     free(report);
 }
 
+void FreeConnectRateReport (struct ConnectRateInfo *report) {
+    if (report->latency_histogram)
+	histogram_delete(report->latency_histogram);
+    free(report);
+}
+
+void FreeTransactionReport (struct TransactionInfo *report) {
+    if (report->latency_histogram)
+	histogram_delete(report->latency_histogram);
+    if (report->idle_histogram)
+	histogram_delete(report->idle_histogram);
+    free(report);
+}
+
+void FreeFlowReport (struct FlowInfo *report) {
+    if (report->samples)
+	free(report->samples);
+    free(report);
+}
+
 static void Free_sReport (struct ReportSettings *report) {
     free_common_copy(report->common);
     free(report);
@@ -422,6 +519,15 @@ void FreeReport (struct ReportHeader *reporthdr) {
     case SERVER_RELAY_REPORT:
 	Free_srReport((struct TransferInfo *)reporthdr->this_report);
 	break;
+    case CONNECT_RATE_REPORT:
+	FreeConnectRateReport((struct ConnectRateInfo *)reporthdr->this_report);
+	break;
+    case TRANSACTION_REPORT:
+	FreeTransactionReport((struct TransactionInfo *)reporthdr->this_report);
+	break;
+    case FLOW_REPORT:
+	FreeFlowReport((struct FlowInfo *)reporthdr->this_report);
+	break;
     default:
 	fprintf(stderr, "Invalid report type in free (%x)\n", reporthdr->type);
 	assert(0);
@@ -465,6 +571,42 @@ int DecrSumReportRefCounter (struct SumReport *sumreport) {
     return refcnt;
 }
 
+/*
+ * An active host table entry holds its sum report until the host's
+ * last traffic thread is removed from the table, which is after the
+ * reporter's final sum output.  The sum report is freed by the last of
+ * the two, i.e. a traffic thread starting from the host in between
+ * never gets a freed sum report.
+ */
+void HoldSumReport (struct SumReport *sumreport) {
+    assert(sumreport);
+    Mutex_Lock(&sumreport->reference.lock);
+    sumreport->tableheld = 1;
+    Mutex_Unlock(&sumreport->reference.lock);
+}
+
+// Called by the table, frees the sum report unless it's still in use
+void ReleaseSumReport (struct SumReport *sumreport) {
+    assert(sumreport);
+    Mutex_Lock(&sumreport->reference.lock);
+    sumreport->tableheld = 0;
+    int canfree = ((sumreport->reference.count <= 0) && \
+		   (sumreport->finished || (sumreport->reference.maxcount == 0)));
+    Mutex_Unlock(&sumreport->reference.lock);
+    if (canfree)
+	FreeSumReport(sumreport);
+}
+
+// Called by the reporter after the final sum, returns true if it should free the sum report
+int FinishSumReport (struct SumReport *sumreport) {
+    assert(sumreport);
+    Mutex_Lock(&sumreport->reference.lock);
+    sumreport->finished = 1;
+    int canfree = !sumreport->tableheld;
+    Mutex_Unlock(&sumreport->reference.lock);
+    return canfree;
+}
+
 
 // Note, this report structure needs to remain self contained and not coupled
 // to any settings structure pointers. This allows the thread settings to
@@ -626,9 +768,18 @@ struct ReportHeader* InitIndividualReport (struct thread_Settings *inSettings) {
     default:
 	FAIL(1, "InitIndividualReport\n", inSettings);
     }
+    if (inSettings->mIntervalMode == kInterval_Time)
+	SetIntervalSeriesHandler(inSettings, &ireport->info, inSettings->mTransferIDStr);
 
     if (inSettings->mThreadMode == kMode_Server) {
 	ireport->info.sock_callstats.read.binsize = inSettings->mBufLen / 8;
+	if (isUDP(inSettings) && isEnhanced(inSettings)) {
+	    ireport->info.seqwindow = (struct SeqWindow *) calloc(1, sizeof(struct SeqWindow));
+	    ireport->info.lossruns = (struct LossRuns *) calloc(1, sizeof(struct LossRuns));
+	    if (!ireport->info.seqwindow || !ireport->info.lossruns) {
+		FAIL(1, "Out of Memory!!\n", inSettings);
+	    }
+	}
 	if (isHistogram(inSettings) && isUDP(inSettings) && isTripTime(inSettings)) {
 	    char name[] = "T8";
 	    ireport->info.latency_histogram =  histogram_init(inSettings->mHistBins,inSettings->mHistBinsize,0,\
@@ -651,6 +802,20 @@ struct ReportHeader* InitIndividualReport (struct thread_Settings *inSettings) {
 							  inSettings->mHistci_lower, inSettings->mHistci_upper, ireport->info.common->transferID, name);
     }
 #endif
+    if (inSettings->mTraceFileName) {
+	char tracefile[1024];
+	uint32_t flags = 0;
+	if (isUDP(inSettings))
+	    flags |= PACKETTRACE_UDP;
+	if (inSettings->mThreadMode == kMode_Server)
+	    flags |= PACKETTRACE_SERVER;
+	if (isIsochronous(inSettings))
+	    flags |= PACKETTRACE_ISOCH;
+	// one file per traffic thread, i.e. <name>.<client|server>.<transfer id>
+	snprintf(tracefile, sizeof(tracefile), "%s.%s.%d", inSettings->mTraceFileName, \
+		 ((inSettings->mThreadMode == kMode_Server) ? "server" : "client"), ireport->info.common->transferID);
+	ireport->trace = packet_trace_open(tracefile, inSettings->mTraceFileSize, ireport->info.common->transferID, flags);
+    }
     return reporthdr;
 }
 
@@ -695,6 +860,14 @@ struct ReportHeader* InitConnectionReport (struct thread_Settings *inSettings, d
     } else {
 	creport->MSS = -1;
     }
+    if (!isUDP(inSettings) && isTcpFastOpen(inSettings) && (inSettings->mSock > 0) && \
+	!(ct <= 0.0 && (inSettings->mThreadMode == kMode_Client))) {
+	creport->tfo = getsock_tcp_fastopen(inSettings->mSock);
+    } else {
+	creport->tfo = -1;
+    }
+    creport->incoming_cpu = (isIncomingCPU(inSettings) ? inSettings->mIncomingCPU : -1);
+    creport->napi_id = inSettings->mNapiID;
     // Fill out known fields for the connection report
     reporter_peerversion(creport, inSettings->peer_version_u, inSettings->peer_version_l);
     creport->connecttime = ct;
@@ -849,6 +1022,144 @@ struct ReportHeader* InitServerRelayUDPReport(struct thread_Settings *inSettings
     return reporthdr;
 }
 
+/*
+ * The --connect-rate engine accumulates its stats in the traffic
+ * thread, i.e. there is no per connect report.  Interval and final
+ * stats are posted to the reporter as a copy, which takes ownership
+ * of the latency histogram (if any.)
+ */
+void ConnectRateStatsReset (struct ConnectRateInfo *stats) {
+    stats->tries = 0;
+    stats->overruns = 0;
+    memset(stats->fails, 0, sizeof(stats->fails));
+    memset(&stats->connect_times, 0, sizeof(struct MeanMinMaxStats));
+    stats->connect_times.min = FLT_MAX;
+    stats->connect_times.max = FLT_MIN;
+}
+
+struct ReportHeader* InitConnectRateReport (struct thread_Settings *inSettings, struct ConnectRateInfo *stats) {
+    struct ReportHeader *reporthdr = (struct ReportHeader *) calloc(1, sizeof(struct ReportHeader));
+    if (reporthdr == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->this_report = calloc(1, sizeof(struct ConnectRateInfo));
+    if (reporthdr->this_report == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->type = CONNECT_RATE_REPORT;
+    reporthdr->ReportMode = inSettings->mReportMode;
+    memcpy(reporthdr->this_report, stats, sizeof(struct ConnectRateInfo));
+    stats->latency_histogram = NULL;
+    return reporthdr;
+}
+
+/*
+ * Same for --tcp-rr and --udp-echo, the interval reports also carry a
+ * histogram so the traffic thread starts a new one after each post.
+ */
+void TransactionStatsReset (struct TransactionInfo *stats) {
+    stats->requests = 0;
+    stats->fwd_lost = 0;
+    stats->fwd_outoforder = 0;
+    stats->rev_lost = 0;
+    stats->rev_outoforder = 0;
+    memset(&stats->rtt, 0, sizeof(struct MeanMinMaxStats));
+    stats->rtt.min = FLT_MAX;
+    stats->rtt.max = FLT_MIN;
+}
+
+struct ReportHeader* InitTransactionReport (struct thread_Settings *inSettings, struct TransactionInfo *stats) {
+    struct ReportHeader *reporthdr = (struct ReportHeader *) calloc(1, sizeof(struct ReportHeader));
+    if (reporthdr == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->this_report = calloc(1, sizeof(struct TransactionInfo));
+    if (reporthdr->this_report == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->type = TRANSACTION_REPORT;
+    reporthdr->ReportMode = inSettings->mReportMode;
+    memcpy(reporthdr->this_report, stats, sizeof(struct TransactionInfo));
+    stats->latency_histogram = NULL;
+    stats->idle_histogram = NULL;
+    return reporthdr;
+}
+
+void FlowStatsReset (struct FlowInfo *stats) {
+    stats->arrivals = 0;
+    stats->done = 0;
+    stats->overruns = 0;
+    stats->fails = 0;
+    stats->bytes = 0;
+    memset(&stats->fct, 0, sizeof(struct MeanMinMaxStats));
+    stats->fct.min = FLT_MAX;
+    stats->fct.max = FLT_MIN;
+}
+
+struct ReportHeader* InitFlowReport (struct thread_Settings *inSettings, struct FlowInfo *stats) {
+    struct ReportHeader *reporthdr = (struct ReportHeader *) calloc(1, sizeof(struct ReportHeader));
+    if (reporthdr == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->this_report = calloc(1, sizeof(struct FlowInfo));
+    if (reporthdr->this_report == NULL) {
+	FAIL(1, "Out of Memory!!\n", inSettings);
+    }
+    reporthdr->type = FLOW_REPORT;
+    reporthdr->ReportMode = inSettings->mReportMode;
+    memcpy(reporthdr->this_report, stats, sizeof(struct FlowInfo));
+    stats->samples = NULL;
+    stats->samplecnt = 0;
+    return reporthdr;
+}
+
+// Fill in the final server stats to send back to a UDP client
+static void fill_UDP_AckFIN (struct TransferInfo *stats, char *ackPacket) {
+    struct UDP_datagram *UDP_Hdr = (struct UDP_datagram *)ackPacket;
+    struct server_hdr *hdr = (struct server_hdr *)(UDP_Hdr+1);
+    int flags = HEADER_VERSION1;
+    if (isEnhanced(stats->common) || isTripTime(stats->common))
+	flags |= SERVER_HEADER_EXTEND;
+#ifdef HAVE_INT64_T
+    flags |=  HEADER_SEQNO64B;
+#endif
+    hdr->base.flags        = htonl((long) flags);
+#ifdef HAVE_INT64_T
+    hdr->base.total_len1   = htonl((long) (stats->cntBytes >> 32));
+#else
+    hdr->base.total_len1   = htonl(0x0);
+#endif
+    hdr->base.total_len2   = htonl((long) (stats->cntBytes & 0xFFFFFFFF));
+    hdr->base.stop_sec     = htonl( (long) stats->ts.iEnd);
+    hdr->base.stop_usec    = htonl( (long)((stats->ts.iEnd - (long)stats->ts.iEnd) * rMillion));
+    hdr->base.error_cnt    = htonl((long) (stats->cntError & 0xFFFFFFFF));
+    hdr->base.outorder_cnt = htonl((long) (stats->cntOutofOrder  & 0xFFFFFFFF));
+    hdr->base.datagrams    = htonl((long) (stats->cntDatagrams & 0xFFFFFFFF));
+    if (flags & HEADER_SEQNO64B) {
+	hdr->extend2.error_cnt2    = htonl((long) (stats->cntError >> 32));
+	hdr->extend2.outorder_cnt2 = htonl((long) (stats->cntOutofOrder >> 32) );
+	hdr->extend2.datagrams2    = htonl((long) (stats->cntDatagrams >> 32));
+    }
+    hdr->base.jitter1      = htonl((long) stats->jitter);
+    hdr->base.jitter2      = htonl((long) ((stats->jitter - (long)stats->jitter) * rMillion));
+
+    hdr->extend.minTransit1  = htonl((long) stats->transit.totminTransit);
+    hdr->extend.minTransit2  = htonl((long) ((stats->transit.totminTransit - (long)stats->transit.totminTransit) * rMillion));
+    hdr->extend.maxTransit1  = htonl((long) stats->transit.totmaxTransit);
+    hdr->extend.maxTransit2  = htonl((long) ((stats->transit.totmaxTransit - (long)stats->transit.totmaxTransit) * rMillion));
+    hdr->extend.sumTransit1  = htonl((long) stats->transit.totsumTransit);
+    hdr->extend.sumTransit2  = htonl((long) ((stats->transit.totsumTransit - (long)stats->transit.totsumTransit) * rMillion));
+    hdr->extend.meanTransit1  = htonl((long) stats->transit.totmeanTransit);
+    hdr->extend.meanTransit2  = htonl((long) ((stats->transit.totmeanTransit - (long)stats->transit.totmeanTransit) * rMillion));
+    hdr->extend.m2Transit1  = htonl((long) stats->transit.totm2Transit);
+    hdr->extend.m2Transit2  = htonl((long) ((stats->transit.totm2Transit - (long)stats->transit.totm2Transit) * rMillion));
+    hdr->extend.vdTransit1  = htonl((long) stats->transit.totvdTransit);
+    hdr->extend.vdTransit2  = htonl((long) ((stats->transit.totvdTransit - (long)stats->transit.totvdTransit) * rMillion));
+    hdr->extend.cntTransit   = htonl(stats->transit.totcntTransit);
+    hdr->extend.cntIPG = htonl((long) (stats->cntDatagrams / (stats->ts.iEnd - stats->ts.iStart)));
+    hdr->extend.IPGsum = htonl(1);
+}
+
 /* -------------------------------------------------------------------
  * Send an AckFIN (a datagram acknowledging a FIN) on the socket,
  * then select on the socket for some time to check for silence.
@@ -864,52 +1175,7 @@ void write_UDP_AckFIN (struct TransferInfo *stats) {
     int success = 0;
     assert(ackPacket);
     if (ackPacket) {
-	struct UDP_datagram *UDP_Hdr = (struct UDP_datagram *)ackPacket;
-	struct server_hdr *hdr = (struct server_hdr *)(UDP_Hdr+1);
-
-	UDP_Hdr = (struct UDP_datagram*) ackPacket;
-	int flags = HEADER_VERSION1;
-	if (isEnhanced(stats->common) || isTripTime(stats->common))
-	    flags |= SERVER_HEADER_EXTEND;
-#ifdef HAVE_INT64_T
-	flags |=  HEADER_SEQNO64B;
-#endif
-	hdr->base.flags        = htonl((long) flags);
-#ifdef HAVE_INT64_T
-	hdr->base.total_len1   = htonl((long) (stats->cntBytes >> 32));
-#else
-	hdr->base.total_len1   = htonl(0x0);
-#endif
-	hdr->base.total_len2   = htonl((long) (stats->cntBytes & 0xFFFFFFFF));
-        hdr->base.stop_sec     = htonl( (long) stats->ts.iEnd);
-        hdr->base.stop_usec    = htonl( (long)((stats->ts.iEnd - (long)stats->ts.iEnd) * rMillion));
-	hdr->base.error_cnt    = htonl((long) (stats->cntError & 0xFFFFFFFF));
-	hdr->base.outorder_cnt = htonl((long) (stats->cntOutofOrder  & 0xFFFFFFFF));
-	hdr->base.datagrams    = htonl((long) (stats->cntDatagrams & 0xFFFFFFFF));
-	if (flags & HEADER_SEQNO64B) {
-	    hdr->extend2.error_cnt2    = htonl((long) (stats->cntError >> 32));
-	    hdr->extend2.outorder_cnt2 = htonl((long) (stats->cntOutofOrder >> 32) );
-	    hdr->extend2.datagrams2    = htonl((long) (stats->cntDatagrams >> 32));
-	}
-	hdr->base.jitter1      = htonl((long) stats->jitter);
-	hdr->base.jitter2      = htonl((long) ((stats->jitter - (long)stats->jitter) * rMillion));
-
-	hdr->extend.minTransit1  = htonl((long) stats->transit.totminTransit);
-	hdr->extend.minTransit2  = htonl((long) ((stats->transit.totminTransit - (long)stats->transit.totminTransit) * rMillion));
-	hdr->extend.maxTransit1  = htonl((long) stats->transit.totmaxTransit);
-	hdr->extend.maxTransit2  = htonl((long) ((stats->transit.totmaxTransit - (long)stats->transit.totmaxTransit) * rMillion));
-	hdr->extend.sumTransit1  = htonl((long) stats->transit.totsumTransit);
-	hdr->extend.sumTransit2  = htonl((long) ((stats->transit.totsumTransit - (long)stats->transit.totsumTransit) * rMillion));
-	hdr->extend.meanTransit1  = htonl((long) stats->transit.totmeanTransit);
-	hdr->extend.meanTransit2  = htonl((long) ((stats->transit.totmeanTransit - (long)stats->transit.totmeanTransit) * rMillion));
-	hdr->extend.m2Transit1  = htonl((long) stats->transit.totm2Transit);
-	hdr->extend.m2Transit2  = htonl((long) ((stats->transit.totm2Transit - (long)stats->transit.totm2Transit) * rMillion));
-	hdr->extend.vdTransit1  = htonl((long) stats->transit.totvdTransit);
-	hdr->extend.vdTransit2  = htonl((long) ((stats->transit.totvdTransit - (long)stats->transit.totvdTransit) * rMillion));
-	hdr->extend.cntTransit   = htonl(stats->transit.totcntTransit);
-	hdr->extend.cntIPG = htonl((long) (stats->cntDatagrams / (stats->ts.iEnd - stats->ts.iStart)));
-	hdr->extend.IPGsum = htonl(1);
-
+	fill_UDP_AckFIN(stats, ackPacket);
 #define TRYCOUNT 10
 	int count = TRYCOUNT;
 	while (--count) {
@@ -957,3 +1223,14 @@ void write_UDP_AckFIN (struct TransferInfo *stats) {
 	fprintf(stderr, warn_ack_failed, stats->common->socket);
 }
 // end write_UDP_AckFIN
+
+// Send the final server stats once to the peer of an unconnected socket,
+// the caller answers a retransmitted client FIN by calling this again
+void sendto_UDP_AckFIN (struct TransferInfo *stats) {
+    assert(stats!= NULL);
+    char ackPacket[sizeof(struct UDP_datagram) + sizeof(struct server_hdr)];
+    memset(ackPacket, 0, sizeof(ackPacket));
+    fill_UDP_AckFIN(stats, ackPacket);
+    int rc = sendto(stats->common->socket, ackPacket, sizeof(ackPacket), 0, (struct sockaddr *) &stats->common->peer, stats->common->size_peer);
+    WARN_errno(rc < 0, "sendto-ackfin");
+}
@@ -65,6 +65,7 @@
 #include "PerfSocket.hpp"
 #include "SocketAddr.h"
 #include "payloads.h"
+#include "payload_verify.h"
 #include <cmath>
 #if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
 #include "checksums.h"
@@ -86,6 +87,7 @@ Server::Server (thread_Settings *inSettings) {
     memset(&scratchpad, 0, sizeof(struct ReportStruct));
     mySocket = inSettings->mSock;
     peerclose = false;
+    incomingcpu_tries = 0;
 #if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
     myDropSocket = inSettings->mSockDrop;
     if (isL2LengthCheck(mSettings)) {
@@ -98,6 +100,12 @@ Server::Server (thread_Settings *inSettings) {
     mBufLen = (mSettings->mBufLen > MINMBUFALLOCSIZE) ? mSettings->mBufLen : MINMBUFALLOCSIZE;
     mBuf = new char[mBufLen];
     FAIL_errno(mBuf == NULL, "No memory for buffer\n", mSettings);
+    verifyPattern = NULL;
+    verifyOffset = 0;
+    if (isPayloadVerify(mSettings)) {
+	verifyPattern = payload_verify_pattern(mBufLen);
+	FAIL_errno(verifyPattern == NULL, "No memory for payload verify pattern\n", mSettings);
+    }
     if (mSettings->mBufLen < static_cast<int>(sizeof(UDP_datagram))) {
 	fprintf(stderr, warn_buffer_too_small, mSettings->mBufLen);
     }
@@ -114,7 +122,7 @@ Server::Server (thread_Settings *inSettings) {
     } else if (isServerModeTime(mSettings)) {
 	sorcvtimer = static_cast<int>(round(mSettings->mAmount * 10000) / 2);
     }
-    isburst = (isIsochronous(mSettings) || isPeriodicBurst(mSettings) || (isTripTime(mSettings) && !isUDP(mSettings)));
+    isburst = (isIsochronous(mSettings) || isPeriodicBurst(mSettings) || (isTripTime(mSettings) && !isUDP(mSettings)) || isTcpRR(mSettings));
     if (isburst && (mSettings->mFPS > 0.0)) {
 	sorcvtimer = static_cast<int>(round(2000000.0 / mSettings->mFPS));
     }
@@ -138,6 +146,7 @@ Server::~Server () {
     }
 #endif
     DELETE_ARRAY(mBuf);
+    payload_verify_free(verifyPattern);
 }
 
 inline bool Server::InProgress () {
@@ -188,7 +197,12 @@ void Server::RunTCP () {
 		readLen = (mSettings->mBufLen < burst_nleft) ? mSettings->mBufLen : burst_nleft;
 	    reportstruct->emptyreport=1;
 	    if (isburst && (burst_nleft == 0)) {
-		if ((n = recvn(mSettings->mSock, reinterpret_cast<char *>(&burst_info), sizeof(struct TCP_burst_payload), 0)) == sizeof(struct TCP_burst_payload)) {
+		if (isBusyPoll(mSettings))
+		    BusyPollSpin();
+		n = recvn(mSettings->mSock, reinterpret_cast<char *>(&burst_info), sizeof(struct TCP_burst_payload), 0);
+		if (isBusyPoll(mSettings))
+		    BusyPollRead();
+		if (n == sizeof(struct TCP_burst_payload)) {
 		    // burst_info.typelen.type = ntohl(burst_info.typelen.type);
 		    // burst_info.typelen.length = ntohl(burst_info.typelen.length);
 		    burst_info.flags = ntohl(burst_info.flags);
@@ -214,7 +228,7 @@ void Server::RunTCP () {
 		    }
 		    currLen += n;
 		    readLen = (mSettings->mBufLen < burst_nleft) ? mSettings->mBufLen : burst_nleft;
-		    WARN(burst_nleft <= 0, "invalid burst read req size");
+		    WARN(burst_nleft < 0, "invalid burst read req size");
 		    // thread_debug("***read burst header size %d id=%d", burst_info.burst_size, burst_info.burst_id);
 		} else {
 		    if (n > 0) {
@@ -229,9 +243,19 @@ void Server::RunTCP () {
 		}
 	    }
 	    if (!reportstruct->transit_ready) {
+		if (isBusyPoll(mSettings))
+		    BusyPollSpin();
 		n = recv(mSettings->mSock, mBuf, readLen, 0);
+		if (isBusyPoll(mSettings))
+		    BusyPollRead();
 		if (n > 0) {
 		    reportstruct->emptyreport = 0;
+		    if (verifyPattern) {
+			reportstruct->l2errors = L2PAYLOADCHK;
+			if (payload_verify_check(mBuf, n, verifyPattern, static_cast<int>(verifyOffset & (PAYLOADVERIFY_PERIOD - 1))))
+			    reportstruct->l2errors |= L2PAYLOADERR;
+			verifyOffset += n;
+		    }
 		    if (isburst) {
 			burst_nleft -= n;
 			if (burst_nleft == 0) {
@@ -264,6 +288,9 @@ void Server::RunTCP () {
 #else
 	    ReportPacket(myReport, reportstruct);
 #endif
+	    if (isTcpRR(mSettings) && reportstruct->transit_ready && !WriteTcpRRResponse(&burst_info)) {
+		peerclose = true;
+	    }
 	    // Check for reverse and amount where
 	    // the server stops after receiving
 	    // the expected byte count
@@ -293,6 +320,32 @@ void Server::RunTCP () {
     FreeReport(myJob);
 }
 
+/*
+ * Write the --tcp-rr response to the request just read.  The response
+ * leads with the request's header so the client gets back the burst id
+ * and its write timestamp, i.e. the client keeps no per request state.
+ */
+bool Server::WriteTcpRRResponse (struct TCP_burst_payload *request) {
+    int nleft = ntohl(request->reply_size);
+    if (nleft < static_cast<int>(sizeof(struct TCP_burst_payload)))
+	nleft = static_cast<int>(sizeof(struct TCP_burst_payload));
+    struct TCP_burst_payload *response = reinterpret_cast<struct TCP_burst_payload *>(mBuf);
+    memcpy(response, request, sizeof(struct TCP_burst_payload));
+    // the request's flags, id and size were converted to host order by the read
+    response->flags = htonl(request->flags);
+    response->burst_id = htonl(request->burst_id);
+    response->burst_size = htonl(nleft);
+    while (nleft > 0) {
+	int n = writen(mySocket, mBuf, ((nleft < mBufLen) ? nleft : mBufLen));
+	if (n <= 0) {
+	    WARN_errno(n < 0, "tcp-rr response");
+	    return false;
+	}
+	nleft -= n;
+    }
+    return true;
+}
+
 void Server::InitKernelTimeStamping () {
 #if HAVE_DECL_SO_TIMESTAMP
     iov[0].iov_base=mBuf;
@@ -442,9 +495,16 @@ bool Server::InitTrafficLoop () {
     }
     // skip the test exchange header to get to the first burst
     // The test exchange header was read in listener context
-    if (mSettings->skip && (isTripTime(mSettings) || isPeriodicBurst(mSettings) || isIsochronous(mSettings))) {
+    if (mSettings->skip && (isTripTime(mSettings) || isPeriodicBurst(mSettings) || isIsochronous(mSettings) || isTcpRR(mSettings) || \
+			    (isPayloadVerify(mSettings) && !isUDP(mSettings)))) {
 	reportstruct->packetLen = recvn(mSettings->mSock, mBuf, mSettings->skip, 0);
     }
+    if (isTcpRR(mSettings)) {
+	// responses go out as soon as their request is read
+	int nodelay = 1;
+	int rc = setsockopt(mSettings->mSock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&nodelay), sizeof(nodelay));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt TCP_NODELAY");
+    }
     SetReportStartTime();
     if (setfullduplexflag)
 	SetFullDuplexReportStartTime();
@@ -488,6 +548,8 @@ inline int Server::ReadWithRxTimestamp () {
     long currLen;
     int tsdone = 0;
 
+    if (isBusyPoll(mSettings))
+	BusyPollSpin();
 #if HAVE_DECL_SO_TIMESTAMP
     cmsg = reinterpret_cast<struct cmsghdr *>(&ctrl);
     currLen = recvmsg(mSettings->mSock, &message, mSettings->recvflags);
@@ -502,6 +564,8 @@ inline int Server::ReadWithRxTimestamp () {
 #else
     currLen = recv(mSettings->mSock, mBuf, mSettings->mBufLen, mSettings->recvflags);
 #endif
+    if (isBusyPoll(mSettings))
+	BusyPollRead();
     if (currLen <=0) {
 	// Socket read timeout or read error
 	reportstruct->emptyreport=1;
@@ -524,9 +588,9 @@ inline int Server::ReadWithRxTimestamp () {
 }
 
 // Returns true if the client has indicated this is the final packet
-inline bool Server::ReadPacketID () {
+inline bool Server::ReadPacketID (char *buf) {
     bool terminate = false;
-    struct UDP_datagram* mBuf_UDP  = reinterpret_cast<struct UDP_datagram*>(mBuf + mSettings->l4payloadoffset);
+    struct UDP_datagram* mBuf_UDP  = reinterpret_cast<struct UDP_datagram*>(buf + mSettings->l4payloadoffset);
 
     // terminate when datagram begins with negative index
     // the datagram ID should be correct, just negated
@@ -583,6 +647,9 @@ void Server::L2_processing () {
 	// perform UDP checksum test, returns zero on success
 	int rc;
 	rc = udpchecksum((void *)ip_hdr, (void *)udp_hdr, udplen, (isIPV6(mSettings) ? 1 : 0));
+	// v4 also carries a header checksum, v6 has none
+	if (!rc && !isIPV6(mSettings))
+	    rc = ipv4checksum((void *)ip_hdr);
 	if (rc) {
 	    reportstruct->l2errors |= L2CSUMERR;
 	    if ((!(reportstruct->l2errors & L2LENERR)) && (L2_quintuple_filter() != 0)) {
@@ -704,6 +771,10 @@ void Server::RunUDP () {
     int rxlen;
     bool lastpacket = false;
 
+    if (isUDPEcho(mSettings)) {
+	RunUDPEcho();
+	return;
+    }
     if (!InitTrafficLoop())
 	return;
 
@@ -720,12 +791,16 @@ void Server::RunUDP () {
 	// completely filled out.
 	reportstruct->emptyreport=1;
 	reportstruct->packetLen=0;
+	reportstruct->l2errors &= ~(L2PAYLOADCHK | L2PAYLOADERR);
 	// read the next packet with timestamp
 	// will also set empty report or not
 	rxlen=ReadWithRxTimestamp();
 	if (!peerclose && (rxlen > 0)) {
 	    reportstruct->emptyreport = 0;
 	    reportstruct->packetLen = rxlen;
+	    if (isIncomingCPU(mSettings) && (mSettings->mIncomingCPU < 0) && (incomingcpu_tries < INCOMINGCPU_TRIES)) {
+		IncomingCPU();
+	    }
 	    if (isL2LengthCheck(mSettings)) {
 		reportstruct->l2len = rxlen;
 		// L2 processing will set the reportstruct packet length with the length found in the udp header
@@ -739,12 +814,18 @@ void Server::RunUDP () {
 		// also sets the packet rx time in the reportstruct
 		reportstruct->prevSentTime = myReport->info.ts.prevsendTime;
 		reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
-		lastpacket = ReadPacketID();
+		lastpacket = ReadPacketID(mBuf);
 		myReport->info.ts.prevsendTime = reportstruct->sentTime;
 		myReport->info.ts.prevpacketTime = reportstruct->packetTime;
 		if (isIsochronous(mSettings)) {
 		    udp_isoch_processing(rxlen);
 		}
+		if (verifyPattern && !lastpacket && (rxlen > (mSettings->l4payloadoffset + PAYLOADVERIFY_UDPOFFSET))) {
+		    int offset = mSettings->l4payloadoffset + PAYLOADVERIFY_UDPOFFSET;
+		    reportstruct->l2errors |= L2PAYLOADCHK;
+		    if (payload_verify_check(mBuf + offset, rxlen - offset, verifyPattern, payload_verify_phase(reportstruct->packetID)))
+			reportstruct->l2errors |= L2PAYLOADERR;
+		}
 	    }
 	}
 #ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
@@ -753,6 +834,59 @@ void Server::RunUDP () {
 	ReportPacket(myReport, reportstruct);
 #endif
     }
+    FinishUDP();
+}
+
+/*
+ * --busy-poll, with spin the thread polls the socket with non-blocking
+ * peeks until it's readable rather than sleep in the read and take the
+ * wakeup.  A spin gives way to the blocking read after BUSYPOLL_SPINMAX
+ * so the read timeouts, and hence the interval reports, are as before.
+ * The times spinning and in the reads go to the final report, the cost
+ * in cpu of the lower latency.
+ */
+inline void Server::BusyPollSpin () {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    busypoll_mark = start;
+    if (isBusyPollSpin(mSettings)) {
+	char peek;
+	while (!sInterupted && (recv(mySocket, &peek, 1, MSG_PEEK | MSG_DONTWAIT) < 0) && \
+	       ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+	    myReport->info.busypoll.polls++;
+	    clock_gettime(CLOCK_MONOTONIC, &busypoll_mark);
+	    if (((busypoll_mark.tv_sec - start.tv_sec) + (1e-9 * (busypoll_mark.tv_nsec - start.tv_nsec))) > BUSYPOLL_SPINMAX)
+		break;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &busypoll_mark);
+	myReport->info.busypoll.spin += (busypoll_mark.tv_sec - start.tv_sec) + (1e-9 * (busypoll_mark.tv_nsec - start.tv_nsec));
+    }
+}
+
+inline void Server::BusyPollRead () {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    myReport->info.busypoll.recv += (end.tv_sec - busypoll_mark.tv_sec) + (1e-9 * (end.tv_nsec - busypoll_mark.tv_nsec));
+}
+
+/*
+ * A UDP flow's socket only learns its receive cpu once connect()ed,
+ * i.e. per the flow's later datagrams, so unlike TCP (see my_accept)
+ * its server thread moves to the cpu here
+ */
+void Server::IncomingCPU () {
+    incomingcpu_tries++;
+    mSettings->mIncomingCPU = getsock_incoming_cpu(mySocket, &mSettings->mNapiID);
+    if (mSettings->mIncomingCPU >= 0) {
+	// the reporter prints these with the final report
+	myReport->info.incomingcpu.pinned = (thread_setaffinity(mSettings) == 0);
+	myReport->info.incomingcpu.cpu = mSettings->mIncomingCPU;
+	myReport->info.incomingcpu.napi_id = mSettings->mNapiID;
+	myReport->info.incomingcpu.found = true;
+    }
+}
+
+void Server::FinishUDP () {
     disarm_itimer();
     int do_close = EndJob(myJob, reportstruct);
     if (!isMulticast(mSettings) && !isNoUDPfin(mSettings)) {
@@ -772,4 +906,161 @@ void Server::RunUDP () {
     Iperf_remove_host(mSettings);
     FreeReport(myJob);
 }
+
+#ifdef HAVE_RECVMMSG
+#define UDPECHO_MSGHDR(msgs, ix) (msgs[ix].msg_hdr)
+#else
+#define UDPECHO_MSGHDR(msgs, ix) (msgs[ix])
+#endif
+/*
+ * --udp-echo, reflect every probe's UDP_datagram header back to the
+ * client which computes the RTT from its own send timestamp.  Reads
+ * and echoes are batched per recvmmsg/sendmmsg so one thread keeps up
+ * with a high probe rate.  The echoes carry the server's own sequence
+ * number and the forward loss and reordering seen so far.
+ */
+void Server::RunUDPEcho () {
+    if (!InitTrafficLoop())
+	return;
+
+    bool lastpacket = false;
+    int buflen = mSettings->mBufLen;
+    char *bufs = new char[UDPECHO_BATCH * buflen];
+    struct iovec rxiovs[UDPECHO_BATCH];
+    struct UDP_echo_payload echoes[UDPECHO_BATCH];
+    int rxlens[UDPECHO_BATCH];
+#if HAVE_DECL_SO_TIMESTAMP
+    char ctrls[UDPECHO_BATCH][CMSG_SPACE(sizeof(struct timeval))];
+#endif
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr rxmsgs[UDPECHO_BATCH];
+    int batch = UDPECHO_BATCH;
+#else
+    struct msghdr rxmsgs[1];
+    int batch = 1;
+#endif
+#ifdef HAVE_SENDMMSG
+    struct iovec txiovs[UDPECHO_BATCH];
+    struct mmsghdr txmsgs[UDPECHO_BATCH];
+    memset(txmsgs, 0, sizeof(txmsgs));
+    for (int ix = 0; ix < UDPECHO_BATCH; ix++) {
+	txiovs[ix].iov_base = &echoes[ix];
+	txiovs[ix].iov_len = sizeof(struct UDP_echo_payload);
+	txmsgs[ix].msg_hdr.msg_iov = &txiovs[ix];
+	txmsgs[ix].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+    memset(rxmsgs, 0, sizeof(rxmsgs));
+    intmax_t maxid = 0;
+    intmax_t received = 0;
+    intmax_t outoforder = 0;
+    uint32_t echo_id = 0;
+
+    while (InProgress() && !lastpacket) {
+	for (int ix = 0; ix < batch; ix++) {
+	    struct msghdr *hdr = &UDPECHO_MSGHDR(rxmsgs, ix);
+	    rxiovs[ix].iov_base = bufs + (ix * buflen);
+	    rxiovs[ix].iov_len = buflen;
+	    hdr->msg_iov = &rxiovs[ix];
+	    hdr->msg_iovlen = 1;
+#if HAVE_DECL_SO_TIMESTAMP
+	    hdr->msg_control = ctrls[ix];
+	    hdr->msg_controllen = sizeof(ctrls[ix]);
+#endif
+	    hdr->msg_flags = 0;
+	}
+	if (isBusyPoll(mSettings))
+	    BusyPollSpin();
+#ifdef HAVE_RECVMMSG
+	int n = recvmmsg(mySocket, rxmsgs, batch, MSG_WAITFORONE, NULL);
+	for (int ix = 0; ix < n; ix++)
+	    rxlens[ix] = rxmsgs[ix].msg_len;
+#else
+	int n = recvmsg(mySocket, &rxmsgs[0], 0);
+	if (n >= 0) {
+	    rxlens[0] = n;
+	    n = 1;
+	}
+#endif
+	if (isBusyPoll(mSettings))
+	    BusyPollRead();
+	now.setnow();
+	if (n <= 0) {
+	    // receive timeout, let the reporter advance its intervals
+	    if ((n < 0) && FATALUDPREADERR(errno)) {
+		WARN_errno(1, "recvmmsg");
+		peerclose = true;
+	    }
+	    reportstruct->emptyreport = 1;
+	    reportstruct->packetLen = 0;
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+	    ReportPacket(myReport, reportstruct, NULL);
+#else
+	    ReportPacket(myReport, reportstruct);
+#endif
+	    continue;
+	}
+	int echocnt = 0;
+	for (int ix = 0; (ix < n) && !lastpacket; ix++) {
+	    if (rxlens[ix] < static_cast<int>(sizeof(struct UDP_datagram)))
+		continue;
+	    char *buf = static_cast<char *>(rxiovs[ix].iov_base);
+	    reportstruct->emptyreport = 0;
+	    reportstruct->packetLen = rxlens[ix];
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+#if HAVE_DECL_SO_TIMESTAMP
+	    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&UDPECHO_MSGHDR(rxmsgs, ix));
+	    if (cmsg && (cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMP) && \
+		(cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval)))) {
+		memcpy(&(reportstruct->packetTime), CMSG_DATA(cmsg), sizeof(struct timeval));
+	    }
+#endif
+	    if (TimeZero(myReport->info.ts.prevpacketTime))
+		myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+	    reportstruct->prevSentTime = myReport->info.ts.prevsendTime;
+	    reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+	    lastpacket = ReadPacketID(buf);
+	    myReport->info.ts.prevsendTime = reportstruct->sentTime;
+	    myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+	    ReportPacket(myReport, reportstruct, NULL);
+#else
+	    ReportPacket(myReport, reportstruct);
+#endif
+	    if (lastpacket)
+		break; // the client's final datagrams aren't probes
+	    received++;
+	    if (reportstruct->packetID > maxid)
+		maxid = reportstruct->packetID;
+	    else
+		outoforder++;
+	    struct UDP_echo_payload *echo = &echoes[echocnt++];
+	    memcpy(&echo->probe, buf, sizeof(struct UDP_datagram));
+	    echo->echo_id = htonl(++echo_id);
+	    echo->fwd_lost = htonl(static_cast<uint32_t>((maxid > received) ? (maxid - received) : 0));
+	    echo->fwd_outoforder = htonl(static_cast<uint32_t>(outoforder));
+	    echo->reserved = 0;
+	}
+	// an echo that can't be sent is simply reverse loss to the client
+#ifdef HAVE_SENDMMSG
+	int sent = 0;
+	while (sent < echocnt) {
+	    int rc = sendmmsg(mySocket, &txmsgs[sent], echocnt - sent, 0);
+	    if (rc <= 0)
+		break;
+	    sent += rc;
+	}
+#else
+	for (int ix = 0; ix < echocnt; ix++) {
+	    if (write(mySocket, &echoes[ix], sizeof(struct UDP_echo_payload)) < 0)
+		break;
+	}
+#endif
+    }
+    DELETE_ARRAY(bufs);
+    FinishUDP();
+}
 // end Recv
@@ -71,6 +71,7 @@
 #include "isochronous.hpp"
 #include "pdfs.h"
 #include "payloads.h"
+#include "packet_trace.h"
 #include <math.h>
 
 
@@ -102,6 +103,26 @@ static int permitkey = 0;
 static int permitkeytimeout = 0;
 static int rxwinclamp = 0;
 static int txnotsentlowwater = 0;
+static int intervalseries = 0;
+static int tracefile = 0;
+static int tracesize = 0;
+static int udpdemux = 0;
+static int listeners = 0;
+static int threadpool = 0;
+static int connectrate = 0;
+static int tcpfastopen = 0;
+static int tcprr = 0;
+static int udpecho = 0;
+static int rpm = 0;
+static int flows = 0;
+static int flowload = 0;
+static int flowpool = 0;
+static int scenario = 0;
+static int affinity = 0;
+static int reporteraffinity = 0;
+static int incomingcpu = 0;
+static int busypoll = 0;
+static int payloadverify = 0;
 
 void Settings_Interpret(char option, const char *optarg, struct thread_Settings *mExtSettings);
 // apply compound settings after the command line has been fully parsed
@@ -178,6 +199,7 @@ const struct option long_options[] =
 {"trip-times", no_argument, &triptime, 1},
 {"no-udp-fin", no_argument, &noudpfin, 1},
 {"connect-only", optional_argument, &connectonly, 1},
+{"connect-rate", required_argument, &connectrate, 1},
 {"connect-retries", required_argument, &connectretry, 1},
 {"no-connect-sync", no_argument, &noconnectsync, 1},
 {"full-duplex", no_argument, &fullduplextest, 1},
@@ -192,6 +214,25 @@ const struct option long_options[] =
 {"burst-period", optional_argument, &burstperiodic, 1},
 {"tcp-rx-window-clamp", required_argument, &rxwinclamp, 1},
 {"tcp-write-prefetch", required_argument, &txnotsentlowwater, 1}, // see doc/DESIGN_NOTES
+{"tcp-fastopen", optional_argument, &tcpfastopen, 1},
+{"tcp-rr", required_argument, &tcprr, 1},
+{"udp-echo", no_argument, &udpecho, 1},
+{"rpm", optional_argument, &rpm, 1},
+{"flows", required_argument, &flows, 1},
+{"flow-load", required_argument, &flowload, 1},
+{"flow-pool", required_argument, &flowpool, 1},
+{"scenario", required_argument, &scenario, 1},
+{"affinity", required_argument, &affinity, 1},
+{"reporter-affinity", required_argument, &reporteraffinity, 1},
+{"incoming-cpu", no_argument, &incomingcpu, 1},
+{"busy-poll", optional_argument, &busypoll, 1},
+{"payload-verify", no_argument, &payloadverify, 1},
+{"interval-series", optional_argument, &intervalseries, 1},
+{"trace-file", required_argument, &tracefile, 1},
+{"trace-size", required_argument, &tracesize, 1},
+{"udp-demux", optional_argument, &udpdemux, 1},
+{"listeners", required_argument, &listeners, 1},
+{"thread-pool", required_argument, &threadpool, 1},
 {"NUM_REPORT_STRUCTS", required_argument, &numreportstructs, 1},
 #ifdef WIN32
 {"reverse", no_argument, &reversetest, 1},
@@ -313,13 +354,126 @@ void Settings_Initialize (struct thread_Settings *main) {
     //main->mDomain     = kMode_IPv4;    // -V,
     //main->mSuggestWin = false;         // -W,  Suggest the window size.
     main->mListenerTimeout = -1;         //
+    main->mIncomingCPU = -1;             // --incoming-cpu, none until accepted
     main->mKeyCheck = true;
 #if (HAVE_DECL_SO_DONTROUTE) && (HAVE_DEFAULT_DONTROUTE_ON)
     setDontRoute(main);
 #endif
     main->mFPS = 1;
+    main->mTraceFileSize = PACKETTRACE_DEFAULTSIZE; // --trace-size
+    main->mFlowLoad = FLOWS_LOAD; // --flow-load
 } // end Settings
 
+/* -------------------------------------------------------------------
+ * Copy on write settings strings
+ *
+ * The string settings don't change once the command line is parsed
+ * but Settings_Copy is done per accepted connection (and more for
+ * reverse and full duplex tests.)  Rather than a new[] and strcpy
+ * per string per copy, the first copy moves the strings of the
+ * settings being copied into one refcounted block that it and all
+ * its copies point into.  A string set after that (i.e. outside the
+ * block) is owned by its settings as before.  A later copy rebuilds
+ * the block when the settings being copied own any strings.
+ * ------------------------------------------------------------------- */
+struct SettingsStrings {
+    struct ReferenceMutex reference;
+    size_t len;
+    char buf[1];
+};
+
+static const struct {
+    char* thread_Settings::*field;
+    bool malloced; // calloc'd vs new[]'d
+} settings_strings[] = {
+    {&thread_Settings::mFileName, false},
+    {&thread_Settings::mHost, false},
+    {&thread_Settings::mLocalhost, false},
+    {&thread_Settings::mOutputFileName, false},
+    {&thread_Settings::mIfrname, true},
+    {&thread_Settings::mIfrnametx, true},
+    {&thread_Settings::mSSMMulticastStr, false},
+    {&thread_Settings::mIsochronousStr, false},
+    {&thread_Settings::mHistogramStr, false},
+    {&thread_Settings::mTraceFileName, false},
+    {&thread_Settings::mFlowSizes, false},
+    {&thread_Settings::mScenario, false},
+    {&thread_Settings::mAffinity, false},
+    {&thread_Settings::mReporterAffinity, false},
+    {&thread_Settings::mCongestion, false}
+};
+#define NUM_SETTINGS_STRINGS (sizeof(settings_strings) / sizeof(settings_strings[0]))
+
+static inline bool settings_strings_shared (struct SettingsStrings *strings, char *str) {
+    return (strings && (str >= strings->buf) && (str < (strings->buf + strings->len)));
+}
+
+static void settings_strings_release (struct SettingsStrings *strings) {
+    if (strings) {
+	Mutex_Lock(&strings->reference.lock);
+	int refcnt = --strings->reference.count;
+	Mutex_Unlock(&strings->reference.lock);
+	if (refcnt == 0) {
+	    Mutex_Destroy(&strings->reference.lock);
+	    free(strings);
+	}
+    }
+}
+
+// Free a string owned by the settings, i.e. one not in the shared block
+static void settings_strings_free (struct thread_Settings *settings, unsigned int ix) {
+    char *str = settings->*settings_strings[ix].field;
+    if (str && !settings_strings_shared(settings->mStrings, str)) {
+	if (settings_strings[ix].malloced)
+	    free(str);
+	else
+	    delete [] str;
+    }
+    settings->*settings_strings[ix].field = NULL;
+}
+
+// Returns the block of from's strings with a reference taken for the copy
+static struct SettingsStrings *settings_strings_share (struct thread_Settings *from) {
+    size_t len = 0;
+    bool owned = false;
+    for (unsigned int ix = 0; ix < NUM_SETTINGS_STRINGS; ix++) {
+	char *str = from->*settings_strings[ix].field;
+	if (str) {
+	    len += strlen(str) + 1;
+	    if (!settings_strings_shared(from->mStrings, str))
+		owned = true;
+	}
+    }
+    if (owned) {
+	struct SettingsStrings *strings = static_cast<struct SettingsStrings *>(malloc(sizeof(struct SettingsStrings) + len));
+	if (!strings)
+	    return NULL;
+	Mutex_Initialize(&strings->reference.lock);
+	strings->reference.count = 1; // from's reference
+	strings->reference.maxcount = 1;
+	strings->len = len;
+	char *next = strings->buf;
+	for (unsigned int ix = 0; ix < NUM_SETTINGS_STRINGS; ix++) {
+	    char *str = from->*settings_strings[ix].field;
+	    if (str) {
+		strcpy(next, str);
+		settings_strings_free(from, ix);
+		from->*settings_strings[ix].field = next;
+		next += strlen(next) + 1;
+	    }
+	}
+	settings_strings_release(from->mStrings);
+	from->mStrings = strings;
+    }
+    if (from->mStrings) {
+	Mutex_Lock(&from->mStrings->reference.lock);
+	if (++from->mStrings->reference.count > from->mStrings->reference.maxcount)
+	    from->mStrings->reference.maxcount = from->mStrings->reference.count;
+	Mutex_Unlock(&from->mStrings->reference.lock);
+    }
+    return from->mStrings;
+}
+
 void Settings_Copy (struct thread_Settings *from, struct thread_Settings **into, int copyall) {
     *into = new struct thread_Settings;
     memset(*into, 0, sizeof(struct thread_Settings));
@@ -331,64 +485,32 @@ void Settings_Copy (struct thread_Settings *from, struct thread_Settings **into,
     thread_debug("Copy thread settings (malloc) from/to=%p/%p report/sum/fullduplex %p/%p/%p", \
 		 (void *)from, (void *)*into, (void *)(*into)->reporthdr, (void *)(*into)->mSumReport, (void *)(*into)->mFullDuplexReport);
 #endif
-    // Some settings don't need to be copied and will confuse things. Don't copy them unless copyall is set
-    if (copyall) {
-	// Don't allocate memory for these if this is a reverse client
-	if (from->mHost != NULL) {
-	    (*into)->mHost = new char[ strlen(from->mHost) + 1];
-	    strcpy((*into)->mHost, from->mHost);
-	}
-	if (from->mOutputFileName != NULL) {
-	    (*into)->mOutputFileName = new char[ strlen(from->mOutputFileName) + 1];
-	    strcpy((*into)->mOutputFileName, from->mOutputFileName);
-	}
-	if (from->mLocalhost != NULL) {
-	    (*into)->mLocalhost = new char[ strlen(from->mLocalhost) + 1];
-	    strcpy((*into)->mLocalhost, from->mLocalhost);
-	}
-	if (from->mFileName != NULL) {
-	    (*into)->mFileName = new char[ strlen(from->mFileName) + 1];
-	    strcpy((*into)->mFileName, from->mFileName);
-	}
-	if (from->mHistogramStr != NULL) {
-	    (*into)->mHistogramStr = new char[ strlen(from->mHistogramStr) + 1];
-	    strcpy((*into)->mHistogramStr, from->mHistogramStr);
-	}
-	if (from->mSSMMulticastStr != NULL) {
-	    (*into)->mSSMMulticastStr = new char[ strlen(from->mSSMMulticastStr) + 1];
-	    strcpy((*into)->mSSMMulticastStr, from->mSSMMulticastStr);
-	}
-	if (from->mIfrname != NULL) {
-	    (*into)->mIfrname = static_cast<char *>(calloc(strlen(from->mIfrname) + 1, sizeof(char)));
-	    strcpy((*into)->mIfrname, from->mIfrname);
-	}
-	if (from->mIfrnametx != NULL) {
-	    (*into)->mIfrnametx = static_cast<char *>(calloc(strlen(from->mIfrnametx) + 1, sizeof(char)));
-	    strcpy((*into)->mIfrnametx, from->mIfrnametx);
-	}
-	if (from->mIsochronousStr != NULL) {
-	    (*into)->mIsochronousStr = new char[strlen(from->mIsochronousStr) + 1];
-	    strcpy((*into)->mIsochronousStr, from->mIsochronousStr);
-	}
-	if (from->mCongestion != NULL) {
-	    (*into)->mCongestion = new char[strlen(from->mCongestion) + 1];
-	    strcpy((*into)->mCongestion, from->mCongestion);
+    // Share the strings, see settings_strings_share()
+    (*into)->mStrings = settings_strings_share(from);
+    for (unsigned int ix = 0; ix < NUM_SETTINGS_STRINGS; ix++) {
+	char *str = from->*settings_strings[ix].field;
+	if (str && !settings_strings_shared((*into)->mStrings, str)) {
+	    // no memory for the shared block, fall back to a copy
+	    char *copy;
+	    if (settings_strings[ix].malloced)
+		copy = static_cast<char *>(calloc(strlen(str) + 1, sizeof(char)));
+	    else
+		copy = new char[strlen(str) + 1];
+	    strcpy(copy, str);
+	    str = copy;
 	}
-    } else {
-	(*into)->mHost = NULL;
-	(*into)->mOutputFileName = NULL;
-	(*into)->mLocalhost = NULL;
-	(*into)->mFileName = NULL;
-	(*into)->mHistogramStr = NULL;
-	(*into)->mSSMMulticastStr = NULL;
-	(*into)->mIfrname = NULL;
-	(*into)->mIfrnametx = NULL;
-	(*into)->mIsochronousStr = NULL;
-	(*into)->mCongestion = NULL;
-	// apply the server side congestion setting to reverse clients
-	if (from->mIsochronousStr != NULL) {
-	    (*into)->mIsochronousStr = new char[ strlen(from->mIsochronousStr) + 1];
-	    strcpy((*into)->mIsochronousStr, from->mIsochronousStr);
+	(*into)->*settings_strings[ix].field = str;
+    }
+    // Some settings don't need to be copied and will confuse things. Don't copy them unless copyall is set
+    if (!copyall) {
+	// apply the server side isochronous setting to reverse clients
+	// and trace the reverse and full duplex traffic threads too,
+	// i.e. keep mIsochronousStr and mTraceFileName
+	for (unsigned int ix = 0; ix < NUM_SETTINGS_STRINGS; ix++) {
+	    if ((settings_strings[ix].field != &thread_Settings::mIsochronousStr) && \
+		(settings_strings[ix].field != &thread_Settings::mTraceFileName)) {
+		settings_strings_free(*into, ix);
+	    }
 	}
     }
 
@@ -417,17 +539,11 @@ void Settings_Destroy (struct thread_Settings *mSettings) {
     thread_debug("Free thread settings=%p", mSettings);
 #endif
     Condition_Destroy(&mSettings->awake_me);
-    DELETE_ARRAY(mSettings->mHost);
-    DELETE_ARRAY(mSettings->mLocalhost);
-    DELETE_ARRAY(mSettings->mFileName);
-    DELETE_ARRAY(mSettings->mOutputFileName);
-    DELETE_ARRAY(mSettings->mHistogramStr);
-    DELETE_ARRAY(mSettings->mSSMMulticastStr);
-    DELETE_ARRAY(mSettings->mCongestion);
-    FREE_ARRAY(mSettings->mIfrname);
-    FREE_ARRAY(mSettings->mIfrnametx);
+    for (unsigned int ix = 0; ix < NUM_SETTINGS_STRINGS; ix++) {
+	settings_strings_free(mSettings, ix);
+    }
+    settings_strings_release(mSettings->mStrings);
     FREE_ARRAY(mSettings->mTransferIDStr);
-    DELETE_ARRAY(mSettings->mIsochronousStr);
     DELETE_PTR(mSettings);
 } // end ~Settings
 
@@ -566,11 +682,9 @@ void Settings_Interpret (char option, const char *optarg, struct thread_Settings
 			fprintf (stderr, "Interval per -i cannot be zero\n");
 			exit(1);
 		    }
+		    // Note: the smallest interval check is done in Settings_ModalOptions
+		    // as --interval-series allows for smaller intervals
 		    mExtSettings->mIntervalMode = kInterval_Time;
-		    if (mExtSettings->mInterval < SMALLEST_INTERVAL) {
-			mExtSettings->mInterval = SMALLEST_INTERVAL;
-			fprintf (stderr, report_interval_small, (double) mExtSettings->mInterval / 1e3);
-		    }
 		}
 		delete [] tmp;
 	    }
@@ -921,6 +1035,148 @@ void Settings_Interpret (char option, const char *optarg, struct thread_Settings
 		  mExtSettings->connectonly_count = -1;
 		}
 	    }
+	    if (tcpfastopen) {
+		tcpfastopen = 0;
+#if HAVE_DECL_TCP_FASTOPEN
+		setTcpFastOpen(mExtSettings);
+		mExtSettings->mTFOQueue = TFO_QUEUE_DEFAULT;
+		if (optarg && (atoi(optarg) > 0)) {
+		    mExtSettings->mTFOQueue = atoi(optarg);
+		}
+#else
+		fprintf(stderr, "--tcp-fastopen not supported on this platform\n");
+#endif
+	    }
+	    if (connectrate) {
+		connectrate = 0;
+		setConnectOnly(mExtSettings);
+		unsetNoConnReport(mExtSettings);
+		mExtSettings->mConnectRate = atof(optarg);
+		mExtSettings->mConnectInflight = CONNECTRATE_INFLIGHT;
+		char *tmp = strchr(const_cast<char *>(optarg), ',');
+		if (tmp && (atoi(tmp + 1) > 0)) {
+		    mExtSettings->mConnectInflight = atoi(tmp + 1);
+		} else if (tmp) {
+		    fprintf(stderr, "WARN: --connect-rate in flight count %s ignored, expected <rate>[,<n>] with n > 0\n", tmp + 1);
+		}
+	    }
+	    if (udpecho) {
+		udpecho = 0;
+		setUDPEcho(mExtSettings);
+	    }
+	    if (rpm) {
+		rpm = 0;
+		// [<tcp|udp>[,<rate>[,<idle secs>]]]
+		setRPM(mExtSettings);
+		mExtSettings->mRPMProbe = RPM_PROBE_TCP;
+		mExtSettings->mRPMRate = RPM_PROBE_RATE;
+		mExtSettings->mRPMIdle = RPM_IDLE_TIME;
+		if (optarg) {
+		    char *tmp = strchr(const_cast<char *>(optarg), ',');
+		    if (strncmp(optarg, "udp", 3) == 0) {
+			mExtSettings->mRPMProbe = RPM_PROBE_UDP;
+		    } else if ((strncmp(optarg, "tcp", 3) != 0) && (tmp != optarg)) {
+			fprintf(stderr, "WARN: unknown --rpm probe %s, expected tcp or udp\n", optarg);
+		    }
+		    if (tmp) {
+			mExtSettings->mRPMRate = atoi(++tmp);
+			if ((tmp = strchr(tmp, ',')) != NULL)
+			    mExtSettings->mRPMIdle = atof(++tmp);
+		    }
+		}
+	    }
+	    if (flows) {
+		flows = 0;
+		setFlows(mExtSettings);
+		if (mExtSettings->mFlowSizes)
+		    delete [] mExtSettings->mFlowSizes;
+		mExtSettings->mFlowSizes = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mFlowSizes, optarg);
+	    }
+	    if (flowload) {
+		flowload = 0;
+		// <load>[,<poisson|periodic>]
+		mExtSettings->mFlowLoad = atof(optarg);
+		char *tmp = strchr(const_cast<char *>(optarg), ',');
+		if (tmp) {
+		    if (strcmp(++tmp, "periodic") == 0) {
+			mExtSettings->mFlowArrivals = FLOWS_PERIODIC;
+		    } else if (strcmp(tmp, "poisson") == 0) {
+			mExtSettings->mFlowArrivals = FLOWS_POISSON;
+		    } else {
+			fprintf(stderr, "WARN: unknown --flow-load arrivals %s, expected poisson or periodic\n", tmp);
+		    }
+		}
+	    }
+	    if (flowpool) {
+		flowpool = 0;
+		mExtSettings->mFlowPool = atoi(optarg);
+	    }
+	    if (scenario) {
+		scenario = 0;
+		setScenario(mExtSettings);
+		if (mExtSettings->mScenario)
+		    delete [] mExtSettings->mScenario;
+		mExtSettings->mScenario = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mScenario, optarg);
+	    }
+	    if (affinity) {
+		affinity = 0;
+		setAffinity(mExtSettings);
+		if (mExtSettings->mAffinity)
+		    delete [] mExtSettings->mAffinity;
+		mExtSettings->mAffinity = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mAffinity, optarg);
+	    }
+	    if (incomingcpu) {
+		incomingcpu = 0;
+		setIncomingCPU(mExtSettings);
+	    }
+	    if (busypoll) {
+		busypoll = 0;
+		setBusyPoll(mExtSettings);
+		mExtSettings->mBusyPoll = BUSYPOLL_DEFAULT;
+		if (optarg) {
+		    if (atoi(optarg) > 0)
+			mExtSettings->mBusyPoll = atoi(optarg);
+		    char *tmp = strchr(const_cast<char *>(optarg), ',');
+		    if (tmp && (strcmp(tmp + 1, "spin") == 0)) {
+			setBusyPollSpin(mExtSettings);
+		    } else if (tmp) {
+			fprintf(stderr, "WARN: unknown --busy-poll option %s, expected <usecs>[,spin]\n", tmp + 1);
+		    }
+		}
+	    }
+	    if (payloadverify) {
+		payloadverify = 0;
+		setPayloadVerify(mExtSettings);
+	    }
+	    if (reporteraffinity) {
+		reporteraffinity = 0;
+		setAffinity(mExtSettings);
+		if (mExtSettings->mReporterAffinity)
+		    delete [] mExtSettings->mReporterAffinity;
+		mExtSettings->mReporterAffinity = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mReporterAffinity, optarg);
+	    }
+	    if (tcprr) {
+		tcprr = 0;
+		// <request>[,<response>[,<depth>[,<connections>]]]
+		setTcpRR(mExtSettings);
+		mExtSettings->mRRRequest = static_cast<int>(byte_atoi(optarg));
+		mExtSettings->mRRResponse = mExtSettings->mRRRequest;
+		mExtSettings->mRRDepth = 1;
+		mExtSettings->mRRConns = 1;
+		char *tmp = strchr(const_cast<char *>(optarg), ',');
+		if (tmp) {
+		    mExtSettings->mRRResponse = static_cast<int>(byte_atoi(++tmp));
+		    if ((tmp = strchr(tmp, ',')) != NULL) {
+			mExtSettings->mRRDepth = atoi(++tmp);
+			if ((tmp = strchr(tmp, ',')) != NULL)
+			    mExtSettings->mRRConns = atoi(++tmp);
+		    }
+		}
+	    }
 	    if (connectretry) {
 		connectretry = 0;
 		mExtSettings->mConnectRetries = atoi(optarg);
@@ -1057,6 +1313,52 @@ void Settings_Interpret (char option, const char *optarg, struct thread_Settings
 		    mExtSettings->mBurstSize = byte_atoi(optarg);
 		}
 	    }
+	    if (intervalseries) {
+		intervalseries = 0;
+		setIntervalSeries(mExtSettings);
+		if (optarg) {
+		    if (strcmp(optarg, "json") == 0) {
+			setIntervalSeriesJSON(mExtSettings);
+		    } else if (strcmp(optarg, "text") != 0) {
+			fprintf(stderr, "Invalid value of '%s' for --interval-series, use text or json\n", optarg);
+			exit(1);
+		    }
+		}
+	    }
+	    if (tracefile) {
+		tracefile = 0;
+		mExtSettings->mTraceFileName = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTraceFileName, optarg);
+	    }
+	    if (tracesize) {
+		tracesize = 0;
+		mExtSettings->mTraceFileSize = byte_atoi(optarg);
+	    }
+	    if (udpdemux) {
+		udpdemux = 0;
+		setUDPDemux(mExtSettings);
+		mExtSettings->mDemuxThreads = (optarg ? atoi(optarg) : 1);
+	    }
+	    if (listeners) {
+		listeners = 0;
+		mExtSettings->mListeners = atoi(optarg);
+		char *tmp = strchr(const_cast<char *>(optarg), ',');
+		if (tmp && (strcmp(tmp + 1, "cpu") == 0)) {
+		    setListenerCPU(mExtSettings);
+		} else if (tmp) {
+		    fprintf(stderr, "WARN: unknown --listeners option %s, expected <n>[,cpu]\n", tmp + 1);
+		}
+	    }
+	    if (threadpool) {
+		threadpool = 0;
+		mExtSettings->mThreadPool = atoi(optarg);
+		char *tmp = strchr(const_cast<char *>(optarg), ',');
+		if (tmp && (strcmp(tmp + 1, "cpu") == 0)) {
+		    setThreadPoolCPU(mExtSettings);
+		} else if (tmp) {
+		    fprintf(stderr, "WARN: unknown --thread-pool option %s, expected <n>[,cpu]\n", tmp + 1);
+		}
+	    }
 	    if (numreportstructs) {
 		numreportstructs = 0;
 		mExtSettings->numreportstructs = byte_atoi(optarg);
@@ -1168,6 +1470,25 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
 	    fprintf(stderr, "WARNING: tcp congestion control will only be applied on transmit traffic, use -Z on the server\n");
 	}
     }
+    if (mExtSettings->mIntervalMode == kInterval_Time) {
+	unsigned int smallest = (isIntervalSeries(mExtSettings) ? SMALLEST_SERIES_INTERVAL : SMALLEST_INTERVAL);
+	if (mExtSettings->mInterval < smallest) {
+	    mExtSettings->mInterval = smallest;
+	    fprintf (stderr, report_interval_small, (double) mExtSettings->mInterval / 1e3);
+	}
+    } else if (isIntervalSeries(mExtSettings)) {
+	fprintf(stderr, "WARN: option of --interval-series requires -i <secs> interval reporting\n");
+	unsetIntervalSeries(mExtSettings);
+    }
+    if (isAffinity(mExtSettings) && isThreadPoolCPU(mExtSettings)) {
+	// the traffic threads pin themselves per --affinity, after the pool's worker pinning
+	fprintf(stderr, "WARN: option of --thread-pool cpu pinning not used with --affinity\n");
+	unsetThreadPoolCPU(mExtSettings);
+    }
+    if (isIntervalSeries(mExtSettings) && (mExtSettings->mReportMode == kReport_CSV)) {
+	fprintf(stderr, "WARN: option of --interval-series not supported with -y C reports\n");
+	unsetIntervalSeries(mExtSettings);
+    }
     // Bail outs
     bool bail = false;
     // compat mode doesn't support these test settings
@@ -1207,6 +1528,23 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
 	if (isSumServerDstIP(mExtSettings)) {
 	    fprintf(stderr, "WARN: option of --sum-dstip not supported on the client\n");
 	}
+	if (isUDPDemux(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --udp-demux not supported on the client\n");
+	    unsetUDPDemux(mExtSettings);
+	}
+	if (mExtSettings->mListeners > 1) {
+	    fprintf(stderr, "WARN: option of --listeners not supported on the client\n");
+	    mExtSettings->mListeners = 0;
+	    unsetListenerCPU(mExtSettings);
+	}
+	if (isIncomingCPU(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --incoming-cpu not supported on the client\n");
+	    unsetIncomingCPU(mExtSettings);
+	}
+	if (isBusyPoll(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --busy-poll not supported on the client\n");
+	    unsetBusyPoll(mExtSettings);
+	}
 	if (isRxClamp(mExtSettings)) {
 	    fprintf(stderr, "WARN: option of --tcp-rx-window-clamp not supported on the client\n");
 	    unsetRxClamp(mExtSettings);
@@ -1362,8 +1700,132 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
 		bail = true;			;
 	    }
 	}
-	if (isHistogram(mExtSettings) && !isWritePrefetch(mExtSettings)) {
-	    fprintf(stderr, "WARN: option of --histograms on the client requires --tcp-write-prefetch\n");
+	if (isTcpFastOpen(mExtSettings) && isConnectOnly(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tcp-fastopen not applied with --connect-only as there is no data for the SYN\n");
+	    unsetTcpFastOpen(mExtSettings);
+	}
+	if (isTcpRR(mExtSettings)) {
+	    if (isUDP(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --tcp-rr not supported with -u UDP\n");
+		unsetTcpRR(mExtSettings);
+	    } else if (isReverse(mExtSettings) || isFullDuplex(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || \
+		       isConnectOnly(mExtSettings) || isIsochronous(mExtSettings) || isPeriodicBurst(mExtSettings) || \
+		       isFileInput(mExtSettings) || isBWSet(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --tcp-rr cannot be applied with --reverse, --full-duplex, -d, -r, --connect-only, --isochronous, --burst-period, -F, -I or -b\n");
+		bail = true;
+	    } else if ((mExtSettings->mRRDepth < 1) || (mExtSettings->mRRConns < 1)) {
+		fprintf(stderr, "ERROR: option of --tcp-rr requires a depth and a connection count of one or more\n");
+		bail = true;
+	    } else {
+		int minsize = static_cast<int>(sizeof(struct TCP_burst_payload));
+		if ((mExtSettings->mRRRequest < minsize) || (mExtSettings->mRRResponse < minsize)) {
+		    fprintf(stderr, "WARN: --tcp-rr request and response sizes must be %d or greater\n", minsize);
+		    if (mExtSettings->mRRRequest < minsize)
+			mExtSettings->mRRRequest = minsize;
+		    if (mExtSettings->mRRResponse < minsize)
+			mExtSettings->mRRResponse = minsize;
+		}
+		// pipelined requests and responses shouldn't wait on Nagle
+		setNoDelay(mExtSettings);
+	    }
+#if !(HAVE_SYS_EPOLL_H)
+	    if (isTcpRR(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --tcp-rr requires epoll\n");
+		unsetTcpRR(mExtSettings);
+	    }
+#endif
+	}
+	if (isUDPEcho(mExtSettings)) {
+	    if (!isUDP(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --udp-echo requires -u UDP\n");
+		unsetUDPEcho(mExtSettings);
+	    } else if (isReverse(mExtSettings) || isFullDuplex(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || \
+		       isIsochronous(mExtSettings) || isFileInput(mExtSettings) || isTripTime(mExtSettings) || isL2LengthCheck(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --udp-echo cannot be applied with --reverse, --full-duplex, -d, -r, --isochronous, --trip-times, --l2checks, -F or -I\n");
+		bail = true;
+	    } else if (mExtSettings->mBufLen < static_cast<int>(sizeof(struct UDP_echo_payload))) {
+		fprintf(stderr, "WARN: --udp-echo requires a -l length of %d or greater\n", static_cast<int>(sizeof(struct UDP_echo_payload)));
+		mExtSettings->mBufLen = static_cast<int>(sizeof(struct UDP_echo_payload));
+	    }
+	}
+	if (isRPM(mExtSettings)) {
+	    if (isUDP(mExtSettings) || !isModeTime(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || isTcpRR(mExtSettings) || \
+		isUDPEcho(mExtSettings) || isConnectOnly(mExtSettings) || isTxStartTime(mExtSettings) || isTxHoldback(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --rpm runs TCP bulk flows per -t and cannot be applied with -u, -n, -d, -r, --tcp-rr, --udp-echo, --connect-only, --txstart-time or --txdelay-time\n");
+		bail = true;
+	    } else if ((mExtSettings->mRPMRate < 1) || (mExtSettings->mRPMIdle < 0)) {
+		fprintf(stderr, "ERROR: option of --rpm requires a probe rate of one or more and an idle time of zero or more\n");
+		bail = true;
+	    }
+#if !(HAVE_SYS_EPOLL_H)
+	    if (mExtSettings->mRPMProbe == RPM_PROBE_TCP) {
+		fprintf(stderr, "WARN: option of --rpm tcp probes requires epoll, using udp probes\n");
+		mExtSettings->mRPMProbe = RPM_PROBE_UDP;
+	    }
+#endif
+	}
+	if (isFlows(mExtSettings)) {
+	    struct pdf_sampler *sizes = pdf_sampler_parse(mExtSettings->mFlowSizes);
+	    if (!sizes || !(pdf_sampler_mean(sizes) > 0)) {
+		fprintf(stderr, "ERROR: option of --flows requires a CDF file of flow sizes or one of constant:, exponential:, normal: or lognormal:\n");
+		bail = true;
+	    } else if (isUDP(mExtSettings) || isReverse(mExtSettings) || isFullDuplex(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || \
+		       isConnectOnly(mExtSettings) || isIsochronous(mExtSettings) || isPeriodicBurst(mExtSettings) || isFileInput(mExtSettings) || \
+		       isTcpRR(mExtSettings) || isRPM(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --flows cannot be applied with -u, --reverse, --full-duplex, -d, -r, --connect-only, --isochronous, --burst-period, -F, -I, --tcp-rr or --rpm\n");
+		bail = true;
+	    } else if (!isBWSet(mExtSettings) || (mExtSettings->mAppRateUnits != kRate_BW)) {
+		fprintf(stderr, "ERROR: option of --flows requires -b <rate>, the link rate the --flow-load is a fraction of\n");
+		bail = true;
+	    } else if (!(mExtSettings->mFlowLoad > 0) || (mExtSettings->mFlowPool < 0)) {
+		fprintf(stderr, "ERROR: option of --flows requires a --flow-load greater than zero and a --flow-pool of zero or more\n");
+		bail = true;
+	    } else if (!mExtSettings->mFlowPool && isPeerVerDetect(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --flows with a fresh connection per flow cannot be applied with -X, use --flow-pool\n");
+		bail = true;
+	    } else {
+		// flows are --tcp-rr requests answered with a bare header
+		setTcpRR(mExtSettings);
+		mExtSettings->mRRRequest = static_cast<int>(sizeof(struct TCP_burst_payload));
+		mExtSettings->mRRResponse = mExtSettings->mRRRequest;
+		mExtSettings->mRRDepth = FLOWS_QUEUE;
+		mExtSettings->mRRConns = 1;
+		setNoDelay(mExtSettings);
+	    }
+	    pdf_sampler_free(sizes);
+#if !(HAVE_SYS_EPOLL_H)
+	    fprintf(stderr, "ERROR: option of --flows requires epoll\n");
+	    bail = true;
+#endif
+	}
+	if (isScenario(mExtSettings)) {
+	    // applies to the options of each group too, they're parsed with the command line
+	    if (isReverse(mExtSettings) || isFullDuplex(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || \
+		isRPM(mExtSettings) || isTxStartTime(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --scenario cannot be applied with --reverse, --full-duplex, -d, -r, --rpm or --txstart-time\n");
+		bail = true;
+	    }
+#ifndef HAVE_THREAD
+	    fprintf(stderr, "ERROR: option of --scenario requires threads\n");
+	    bail = true;
+#endif
+	}
+	if (isPayloadVerify(mExtSettings)) {
+	    if (isReverse(mExtSettings) || isFullDuplex(mExtSettings) || (mExtSettings->mMode != kTest_Normal) || isFileInput(mExtSettings) || \
+		isTcpRR(mExtSettings) || isUDPEcho(mExtSettings) || isRPM(mExtSettings) || isConnectOnly(mExtSettings) || isPermitKey(mExtSettings)) {
+		fprintf(stderr, "ERROR: option of --payload-verify cannot be applied with --reverse, --full-duplex, -d, -r, -F, -I, --tcp-rr, --flows, --udp-echo, --rpm, --connect-only or --permit-key\n");
+		bail = true;
+	    } else if (!isUDP(mExtSettings) && (isTripTime(mExtSettings) || isIsochronous(mExtSettings) || isPeriodicBurst(mExtSettings) || \
+					      isBWSet(mExtSettings) || isNearCongest(mExtSettings) || isWritePrefetch(mExtSettings))) {
+		fprintf(stderr, "ERROR: option of --payload-verify with TCP cannot be applied with --trip-times, --isochronous, --burst-period, -b, --near-congestion or --tcp-write-prefetch\n");
+		bail = true;
+	    } else if (isUDP(mExtSettings) && (mExtSettings->mBufLen <= PAYLOADVERIFY_UDPOFFSET)) {
+		fprintf(stderr, "ERROR: option of --payload-verify with -u UDP requires a -l length greater than %d\n", PAYLOADVERIFY_UDPOFFSET);
+		bail = true;
+	    }
+	}
+	if (isHistogram(mExtSettings) && !isWritePrefetch(mExtSettings) && !(mExtSettings->mConnectInflight > 0) && !isTcpRR(mExtSettings) && !isUDPEcho(mExtSettings) && !isRPM(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --histograms on the client requires --tcp-write-prefetch, --connect-rate, --tcp-rr, --udp-echo or --rpm\n");
 	}
 	if (isCongestionControl(mExtSettings) && isReverse(mExtSettings)) {
 	    fprintf(stderr, "ERROR: tcp congestion control -Z and --reverse cannot be applied together\n");
@@ -1409,6 +1871,30 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
         if (isIncrSrcIP(mExtSettings)) {
             fprintf(stderr, "WARN: setting of option --incr-srcip is not supported on the server\n");
 	}
+	if (isTcpRR(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tcp-rr is set by the client, not the server\n");
+	    unsetTcpRR(mExtSettings);
+	}
+	if (isUDPEcho(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --udp-echo is set by the client, not the server\n");
+	    unsetUDPEcho(mExtSettings);
+	}
+	if (isRPM(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --rpm is set by the client, not the server\n");
+	    unsetRPM(mExtSettings);
+	}
+	if (isFlows(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --flows is set by the client, not the server\n");
+	    unsetFlows(mExtSettings);
+	}
+	if (isScenario(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --scenario is not supported on the server\n");
+	    unsetScenario(mExtSettings);
+	}
+	if (isPayloadVerify(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --payload-verify is set by the client, not the server\n");
+	    unsetPayloadVerify(mExtSettings);
+	}
 	if (isVaryLoad(mExtSettings)) {
 	    fprintf(stderr, "WARN: option of variance per -b is not supported on the server\n");
 	}
@@ -1461,7 +1947,90 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
 	    fprintf(stderr, "WARN: option of --tcp-rx-window-clamp not supported using -u UDP \n");
 	    unsetRxClamp(mExtSettings);
 	}
+	if (isUDPDemux(mExtSettings)) {
+	    if (!isUDP(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --udp-demux requires -u UDP\n");
+		unsetUDPDemux(mExtSettings);
+	    } else if (isL2LengthCheck(mExtSettings) || isSingleUDP(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --udp-demux not supported with --l2checks or -U\n");
+		unsetUDPDemux(mExtSettings);
+	    } else if (mExtSettings->mDemuxThreads < 1) {
+		fprintf(stderr, "ERROR: option of --udp-demux requires one or more threads\n");
+		bail = true;
+	    }
+#if !HAVE_DECL_SO_REUSEPORT
+	    if (mExtSettings->mDemuxThreads > 1) {
+		fprintf(stderr, "WARN: option of --udp-demux threads requires SO_REUSEPORT, using one thread\n");
+		mExtSettings->mDemuxThreads = 1;
+	    }
+#endif
+	}
+	if (mExtSettings->mListeners > 1) {
+	    // the listeners accept independently so anything that
+	    // counts or serializes accepts across them isn't supported
+	    if (isUDP(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --listeners requires TCP, use --udp-demux=<n> for UDP\n");
+		mExtSettings->mListeners = 0;
+	    } else if ((mExtSettings->mThreads != 0) || isSingleClient(mExtSettings) || isPermitKey(mExtSettings)) {
+		fprintf(stderr, "WARN: option of --listeners not supported with -P, -1, --singleclient or --permit-key\n");
+		mExtSettings->mListeners = 0;
+	    }
+#if !HAVE_DECL_SO_REUSEPORT
+	    if (mExtSettings->mListeners > 1) {
+		fprintf(stderr, "WARN: option of --listeners requires SO_REUSEPORT, using one listener\n");
+		mExtSettings->mListeners = 0;
+	    }
+#endif
+	    if (mExtSettings->mListeners <= 1)
+		unsetListenerCPU(mExtSettings);
+	}
+#if !defined(SO_BUSY_POLL)
+	if (isBusyPoll(mExtSettings) && !isBusyPollSpin(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --busy-poll requires SO_BUSY_POLL, use --busy-poll=<usecs>,spin for spinning reads only\n");
+	    unsetBusyPoll(mExtSettings);
+	}
+#endif
+	if (isBusyPoll(mExtSettings) && isUDPDemux(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --busy-poll not supported with --udp-demux\n");
+	    unsetBusyPoll(mExtSettings);
+	}
+#if !defined(SO_INCOMING_CPU) || !(HAVE_DECL_CPU_SET)
+	if (isIncomingCPU(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --incoming-cpu requires SO_INCOMING_CPU and sched_setaffinity\n");
+	    unsetIncomingCPU(mExtSettings);
+	}
+#endif
+    }
+    if (isTcpFastOpen(mExtSettings) && isUDP(mExtSettings)) {
+	fprintf(stderr, "WARN: option of --tcp-fastopen not supported with -u UDP\n");
+	unsetTcpFastOpen(mExtSettings);
+    }
+    if (mExtSettings->mConnectInflight > 0) {
+	if (mExtSettings->mConnectRate < 0) {
+	    fprintf(stderr, "ERROR: option of --connect-rate requires a rate of zero or more connects per second\n");
+	    bail = true;
+	}
+#if !(HAVE_SYS_EPOLL_H)
+	fprintf(stderr, "WARN: option of --connect-rate requires epoll, running --connect-only\n");
+	mExtSettings->mConnectInflight = 0;
+#endif
     }
+    if (mExtSettings->mThreadPool < 0) {
+	fprintf(stderr, "ERROR: option of --thread-pool requires zero or more threads\n");
+	bail = true;
+    }
+#if !defined(HAVE_POSIX_THREAD)
+    if (mExtSettings->mThreadPool > 0) {
+	fprintf(stderr, "WARN: option of --thread-pool requires posix threads\n");
+	mExtSettings->mThreadPool = 0;
+    }
+#endif
+#if !(HAVE_DECL_CPU_SET)
+    if (isAffinity(mExtSettings)) {
+	fprintf(stderr, "WARN: options of --affinity and --reporter-affinity require sched_setaffinity\n");
+	unsetAffinity(mExtSettings);
+    }
+#endif
     if (bail)
 	exit(1);
 
@@ -1735,6 +2304,52 @@ void Settings_GenerateListenerSettings (struct thread_Settings *client, struct t
     }
 }
 
+/*
+ * Settings_GenerateRPMProbeSettings
+ * The --rpm latency probes are a thread of their own on a separate
+ * socket, either --tcp-rr transactions paced at the probe rate or
+ * --udp-echo probes.  The probe runs through the idle baseline and
+ * then alongside the bulk flows, which wait for rpm_load_epoch.
+ */
+void Settings_GenerateRPMProbeSettings (struct thread_Settings *client, struct thread_Settings **probe) {
+    Timestamp load;
+    // the probe's and the bulk flows' reports are timed from the probe's start
+    client->report_epoch.tv_sec = load.getSecs();
+    client->report_epoch.tv_usec = load.getUsecs();
+    load.add(client->mRPMIdle);
+    client->rpm_load_epoch.tv_sec = load.getSecs();
+    client->rpm_load_epoch.tv_usec = load.getUsecs();
+    Settings_Copy(client, probe, 1);
+    if (*probe == NULL)
+	return;
+    struct thread_Settings *p = *probe;
+    setRPMProbe(p);
+    unsetReverse(p);
+    unsetFullDuplex(p);
+    unsetBWSet(p);
+    unsetSumOnly(p);
+    p->mThreads = 1;
+    p->mAmount += static_cast<intmax_t>(client->mRPMIdle * 100);
+    p->mAppRate = 0;
+    if (client->mRPMProbe == RPM_PROBE_UDP) {
+	setUDP(p);
+	setUDPEcho(p);
+	unsetNoDelay(p);
+	p->mBufLen = static_cast<int>(sizeof(struct client_udp_testhdr));
+	p->mAppRate = client->mRPMRate;
+	p->mAppRateUnits = kRate_PPS;
+	setBWSet(p);
+    } else {
+	setTcpRR(p);
+	setNoDelay(p);
+	p->mRRRequest = static_cast<int>(sizeof(struct TCP_burst_payload));
+	p->mRRResponse = p->mRRRequest;
+	p->mRRDepth = 1;
+	p->mRRConns = 1;
+	p->mRRRate = client->mRPMRate;
+    }
+}
+
 void Settings_ReadClientSettingsIsoch (struct thread_Settings **client, struct client_hdrext_isoch_settings *hdr) {
     (*client)->mFPS = ntohl(hdr->FPSl);
     (*client)->mFPS += ntohl(hdr->FPSu) / static_cast<double>(rMillion);
@@ -2039,6 +2654,14 @@ int Settings_GenerateClientHdr (struct thread_Settings *client, void *testhdr, s
 	    flags |= (HEADER_UDPTESTS | HEADER_EXTEND);
 	    upperflags |= HEADER_NOUDPFIN;
 	}
+	if (isUDPEcho(client)) {
+	    flags |= (HEADER_UDPTESTS | HEADER_EXTEND);
+	    upperflags |= HEADER_UDPECHO;
+	}
+	if (isPayloadVerify(client)) {
+	    flags |= (HEADER_UDPTESTS | HEADER_EXTEND);
+	    upperflags |= HEADER_PAYLOADVERIFY;
+	}
 	if (isTripTime(client) || isFQPacing(client) || isTxStartTime(client)) {
 	    flags |= HEADER_UDPTESTS;
 	    if (isTripTime(client) || isTxStartTime(client)) {
@@ -2140,6 +2763,14 @@ int Settings_GenerateClientHdr (struct thread_Settings *client, void *testhdr, s
 	if (isReverse(client) || isFullDuplex(client)) {
 	    flags |= HEADER_VERSION2;
 	}
+	if (isTcpRR(client)) {
+	    // version 2 so the listener doesn't ack into the response stream
+	    upperflags |= HEADER_TCPRR;
+	    flags |= HEADER_VERSION2;
+	}
+	if (isPayloadVerify(client)) {
+	    upperflags |= HEADER_PAYLOADVERIFY;
+	}
 	hdr->extend.upperflags = htons(upperflags);
 	hdr->extend.lowerflags = htons(lowerflags);
 	if (len > 0) {
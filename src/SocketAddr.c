@@ -56,6 +56,11 @@
 #include "SocketAddr.h"
 #ifdef HAVE_IFADDRS_H
 #include <ifaddrs.h>
+#include <net/if.h>
+#endif
+#ifdef HAVE_LINUX_RTNETLINK_H
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #endif
 
 #ifdef __cplusplus
@@ -519,6 +524,201 @@ int SockAddr_Hostare_Equal (iperf_sockaddr* first, iperf_sockaddr *second) {
     return 0;
 
 }
+#ifdef HAVE_IFADDRS_H
+/* -------------------------------------------------------------------
+ * Process wide interface address to name cache
+ *
+ * getifaddrs() is a full netlink dump (or ioctl walk) of every address
+ * on the host, too slow to do per accepted socket on hosts with many
+ * addresses.  Build an open addressed hash table of the addresses once
+ * and rebuild it when the addresses change.  On linux a nonblocking
+ * rtnetlink socket subscribed to the address groups flags the changes,
+ * otherwise (or if that socket overflows) a miss rebuilds, at most once
+ * per IFCACHE_MISS_REFRESH seconds.
+ * ------------------------------------------------------------------- */
+#define IFCACHE_MINSLOTS 64
+#define IFCACHE_MISS_REFRESH 1
+
+struct IfcacheEntry {
+    int family;
+    unsigned char addr[16];
+    char name[IFNAMSIZ];
+};
+
+static struct {
+    Mutex lock;
+    struct IfcacheEntry *slots;
+    int size;
+    int built;
+    time_t buildtime;
+    int nlsock;
+} ifcache;
+
+static uint32_t ifcache_hash (int family, const unsigned char *addr) {
+    int len = ((family == AF_INET) ? 4 : 16);
+    uint32_t hash = 2166136261U; // FNV-1a
+    int ix;
+    for (ix = 0; ix < len; ix++) {
+	hash ^= addr[ix];
+	hash *= 16777619U;
+    }
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static int ifcache_addr (const struct sockaddr *sa, unsigned char *addr) {
+    if (sa->sa_family == AF_INET) {
+	memcpy(addr, &((const struct sockaddr_in*)sa)->sin_addr, 4);
+	return 1;
+    }
+#if defined(HAVE_IPV6)
+    if (sa->sa_family == AF_INET6) {
+	memcpy(addr, ((const struct sockaddr_in6*)sa)->sin6_addr.s6_addr, 16);
+	return 1;
+    }
+#endif
+    return 0;
+}
+
+// Find the slot holding the address or the empty slot where it goes
+static int ifcache_slot (int family, const unsigned char *addr) {
+    int mask = ifcache.size - 1;
+    int ix = ifcache_hash(family, addr) & mask;
+    while (ifcache.slots[ix].family != 0) {
+	if ((ifcache.slots[ix].family == family) && \
+	    !memcmp(ifcache.slots[ix].addr, addr, ((family == AF_INET) ? 4 : 16)))
+	    break;
+	ix = (ix + 1) & mask;
+    }
+    return ix;
+}
+
+// Rebuild the table from getifaddrs(), with the lock held
+static void ifcache_build (void) {
+    struct ifaddrs* ifaddr;
+    struct ifaddrs* ifa;
+    int count = 0;
+    ifcache.built = 1;
+    ifcache.buildtime = time(NULL);
+    if (getifaddrs(&ifaddr) != 0) {
+	return;
+    }
+    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+	count++;
+    }
+    // keep the load at or below 1/2 so probes stay short
+    int size = IFCACHE_MINSLOTS;
+    while (size < (2 * count)) {
+	size <<= 1;
+    }
+    if (size != ifcache.size) {
+	free(ifcache.slots);
+	ifcache.slots = (struct IfcacheEntry *) calloc(size, sizeof(struct IfcacheEntry));
+	ifcache.size = (ifcache.slots ? size : 0);
+    } else {
+	memset(ifcache.slots, 0, size * sizeof(struct IfcacheEntry));
+    }
+    if (ifcache.slots) {
+	for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+	    unsigned char addr[16];
+	    if (ifa->ifa_addr && ifa->ifa_name && ifcache_addr(ifa->ifa_addr, addr)) {
+		int ix = ifcache_slot(ifa->ifa_addr->sa_family, addr);
+		// the first interface listed with an address wins
+		if (ifcache.slots[ix].family == 0) {
+		    ifcache.slots[ix].family = ifa->ifa_addr->sa_family;
+		    memcpy(ifcache.slots[ix].addr, addr, sizeof(addr));
+		    strncpy(ifcache.slots[ix].name, ifa->ifa_name, IFNAMSIZ - 1);
+		}
+	    }
+	}
+    }
+    freeifaddrs(ifaddr);
+}
+
+// Drain the rtnetlink socket, returns true if there were address changes
+static int ifcache_changed (void) {
+    int changed = 0;
+#ifdef HAVE_LINUX_RTNETLINK_H
+    if (ifcache.nlsock >= 0) {
+	char buf[4096];
+	ssize_t rc;
+	while ((rc = recv(ifcache.nlsock, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+	    if (rc < 0) {
+		// ENOBUFS means messages were lost
+		if (errno == ENOBUFS)
+		    changed = 1;
+		else if (errno != EINTR)
+		    break;
+	    } else {
+		changed = 1;
+	    }
+	}
+    }
+#endif
+    return changed;
+}
+
+// Copy the interface name of an address, returns 0 if found, -1 if not
+static int ifcache_lookup (int family, const unsigned char *addr, char *name) {
+    int rc = -1;
+    Mutex_Lock(&ifcache.lock);
+    if (!ifcache.built || ifcache_changed()) {
+	ifcache_build();
+    }
+    int pass;
+    for (pass = 0; (pass < 2) && (ifcache.size > 0); pass++) {
+	int ix = ifcache_slot(family, addr);
+	if (ifcache.slots[ix].family != 0) {
+	    memcpy(name, ifcache.slots[ix].name, IFNAMSIZ);
+	    rc = 0;
+	    break;
+	}
+	// A miss may be a new address, rebuild unless that was just done
+	if ((pass > 0) || ((time(NULL) - ifcache.buildtime) < IFCACHE_MISS_REFRESH))
+	    break;
+	ifcache_build();
+    }
+    Mutex_Unlock(&ifcache.lock);
+    return rc;
+}
+#endif // HAVE_IFADDRS_H
+
+void SockAddr_Ifcache_Initialize (void) {
+#ifdef HAVE_IFADDRS_H
+    Mutex_Initialize(&ifcache.lock);
+    ifcache.slots = NULL;
+    ifcache.size = 0;
+    ifcache.built = 0;
+    ifcache.nlsock = -1;
+#ifdef HAVE_LINUX_RTNETLINK_H
+    ifcache.nlsock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (ifcache.nlsock >= 0) {
+	struct sockaddr_nl nladdr;
+	memset(&nladdr, 0, sizeof(nladdr));
+	nladdr.nl_family = AF_NETLINK;
+	nladdr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+	if (bind(ifcache.nlsock, (struct sockaddr *)&nladdr, sizeof(nladdr)) < 0) {
+	    close(ifcache.nlsock);
+	    ifcache.nlsock = -1;
+	}
+    }
+#endif
+#endif
+}
+
+void SockAddr_Ifcache_Destroy (void) {
+#ifdef HAVE_IFADDRS_H
+    if (ifcache.nlsock >= 0) {
+	close(ifcache.nlsock);
+	ifcache.nlsock = -1;
+    }
+    free(ifcache.slots);
+    ifcache.slots = NULL;
+    ifcache.size = 0;
+    Mutex_Destroy(&ifcache.lock);
+#endif
+}
+
 /* -------------------------------------------------------------------
  * Find the interface name of a connected socket (when not already set)
  * Can be forced with -B <ip>%<name> (server), -c <ip>%<name> (client)
@@ -533,35 +733,24 @@ int SockAddr_Ifrname (struct thread_Settings *inSettings) {
 #ifdef HAVE_IFADDRS_H
     if (inSettings->mIfrname == NULL) {
 	struct sockaddr_storage myaddr;
-	struct ifaddrs* ifaddr;
-	struct ifaddrs* ifa;
 	socklen_t addr_len;
+	char name[IFNAMSIZ];
+	unsigned char addr[16];
+	int family = 0;
 	addr_len = sizeof(struct sockaddr_storage);
 	getsockname(inSettings->mSock, (struct sockaddr*)&myaddr, &addr_len);
-	getifaddrs(&ifaddr);
 
         // look which interface contains the desired IP per getsockname() which sets myaddr
-        // When found, ifa->ifa_name contains the name of the interface (eth0, eth1, ppp0...)
 	if (myaddr.ss_family == AF_INET) {
 	    // v4 socket family (supports v4 only)
-	    struct sockaddr_in* addr = (struct sockaddr_in*)&myaddr;
-	    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-		if ((ifa->ifa_addr) && (ifa->ifa_addr->sa_family == AF_INET)) {
-		    struct sockaddr_in* inaddr = (struct sockaddr_in*)ifa->ifa_addr;
-		    if ((inaddr->sin_addr.s_addr == addr->sin_addr.s_addr) && (ifa->ifa_name)) {
-			// Found v4 address in v4 addr family, copy it to thread settings structure
-			inSettings->mIfrname = calloc (strlen(ifa->ifa_name) + 1, sizeof(char));
-			strcpy(inSettings->mIfrname, ifa->ifa_name);
-			break;
-		    }
-		}
-	    }
+	    family = AF_INET;
+	    ifcache_addr((struct sockaddr*)&myaddr, addr);
 	} else if (myaddr.ss_family == AF_INET6) {
 	    // v6 socket family (supports both v4 and v6)
-	    struct sockaddr_in6* addr = (struct sockaddr_in6*)&myaddr;
+	    struct sockaddr_in6* addr6 = (struct sockaddr_in6*)&myaddr;
 	    // Link local address are shared amongst all devices
 	    // Try to pull the interface from the destination
-	    if ((inSettings->mThreadMode == kMode_Client) && (IN6_IS_ADDR_LINKLOCAL(&addr->sin6_addr))) {
+	    if ((inSettings->mThreadMode == kMode_Client) && (IN6_IS_ADDR_LINKLOCAL(&addr6->sin6_addr))) {
 		char *results;
 		char *copy = (char *)malloc(strlen(inSettings->mHost)+1);
 		strcpy(copy,(const char *)inSettings->mHost);
@@ -570,36 +759,20 @@ int SockAddr_Ifrname (struct thread_Settings *inSettings) {
 		    strcpy(inSettings->mIfrname, results);
 		}
 		free(copy);
-	    } else if ((inSettings->mThreadMode == kMode_Server) && (IN6_IS_ADDR_V4MAPPED (&addr->sin6_addr))) {
-		for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-		    if ((ifa->ifa_addr) && (ifa->ifa_addr->sa_family == AF_INET)) {
-			struct sockaddr_in* inaddr = (struct sockaddr_in*)ifa->ifa_addr;
-			uint32_t v4;
-			memcpy(&v4, &addr->sin6_addr.s6_addr[12], 4);
-			if ((ifa->ifa_name) && (inaddr->sin_addr.s_addr == v4)) {
-			    // Found v4 address in v4 addr family, copy it to thread settings structure
-			    inSettings->mIfrname = calloc (strlen(ifa->ifa_name) + 1, sizeof(char));
-			    strcpy(inSettings->mIfrname, ifa->ifa_name);
-			    break;
-			}
-		    }
-		}
+	    } else if ((inSettings->mThreadMode == kMode_Server) && (IN6_IS_ADDR_V4MAPPED (&addr6->sin6_addr))) {
+		family = AF_INET;
+		memcpy(addr, &addr6->sin6_addr.s6_addr[12], 4);
 	    } else {
 		// Hunt the v6 interfaces
-		for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
-		    if ((ifa->ifa_addr) && (ifa->ifa_addr->sa_family == AF_INET6)) {
-			struct sockaddr_in6* inaddr = (struct sockaddr_in6*)ifa->ifa_addr;
-			if ((ifa->ifa_name) && (IN6_ARE_ADDR_EQUAL(&addr->sin6_addr, &inaddr->sin6_addr))) {
-			    // Found v6 address in v6 addr family, copy it to thread settings structure
-			    inSettings->mIfrname = calloc (strlen(ifa->ifa_name) + 1, sizeof(char));
-			    strcpy(inSettings->mIfrname, ifa->ifa_name);
-			    break;
-			}
-		    }
-		}
+		family = AF_INET6;
+		ifcache_addr((struct sockaddr*)&myaddr, addr);
 	    }
 	}
-	freeifaddrs(ifaddr);
+	if (family && (ifcache_lookup(family, addr, name) == 0)) {
+	    // Found the address, copy its interface to thread settings structure
+	    inSettings->mIfrname = calloc (strlen(name) + 1, sizeof(char));
+	    strcpy(inSettings->mIfrname, name);
+	}
     }
 #endif
     return ((inSettings->mIfrname == NULL) ? -1 : 0);
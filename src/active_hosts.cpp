@@ -47,7 +47,7 @@
  * active_hosts.c (was List.cpp)
  * rewrite by Robert McMahon
  *
- * This is a list to hold active traffic and create sum groups
+ * This is a table to hold active traffic and create sum groups
  * sum groups are traffic sessions from the same client host
  * -------------------------------------------------------------------
  */
@@ -61,8 +61,6 @@
  * Global table with active hosts, their sum reports and active thread counts
  */
 static struct Iperf_Table active_table;
-static bool Iperf_host_port_present (iperf_sockaddr *find);
-static struct Iperf_ListEntry* Iperf_host_present (iperf_sockaddr *find);
 
 #if HAVE_THREAD_DEBUG
 static void active_table_show_entry(const char *action, Iperf_ListEntry *entry, int found) {
@@ -72,8 +70,8 @@ static void active_table_show_entry(const char *action, Iperf_ListEntry *entry,
     size_t len=200;
     unsigned short port = SockAddr_getPort(&(entry->host));
     SockAddr_getHostAddress(&(entry->host), tmpaddr, len);
-    thread_debug("active table: %s %s port %d (flag=%d) rootp=%p entryp=%p totcnt/activecnt/hostcnt = %d/%d/%d", \
-		 action, tmpaddr, port, found, (void *) active_table.root, (void *) entry, active_table.total_count, \
+    thread_debug("active table: %s %s port %d (flag=%d) entryp=%p totcnt/activecnt/hostcnt = %d/%d/%d", \
+		 action, tmpaddr, port, found, (void *) entry, active_table.total_count, \
 		 active_table.count, entry->thread_count);
 }
 static void active_table_show_compare(const char *action, Iperf_ListEntry *entry, iperf_sockaddr *host, const char *type) {
@@ -90,42 +88,164 @@ static void active_table_show_compare(const char *action, Iperf_ListEntry *entry
 }
 #endif
 
+/*
+ * Hash the host address only (not the port) as there is one entry per host.
+ * The low bits select the stripe and the remaining bits the slot
+ */
+static uint32_t active_table_hash (iperf_sockaddr *host) {
+    const unsigned char *addr = NULL;
+    size_t len = 0;
+    uint32_t hash = 2166136261U; // FNV-1a
+    if (((struct sockaddr*)host)->sa_family == AF_INET) {
+	addr = (const unsigned char *) &((struct sockaddr_in*)host)->sin_addr.s_addr;
+	len = sizeof(struct in_addr);
+    }
+#if defined(HAVE_IPV6)
+    else if (((struct sockaddr*)host)->sa_family == AF_INET6) {
+	addr = ((struct sockaddr_in6*)host)->sin6_addr.s6_addr;
+	len = sizeof(struct in6_addr);
+    }
+#endif
+    for (size_t ix = 0; ix < len; ix++) {
+	hash ^= addr[ix];
+	hash *= 16777619U;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+static inline struct Iperf_TableStripe *active_table_stripe (uint32_t hash) {
+    return &active_table.stripes[hash & (ACTIVE_TABLE_STRIPES - 1)];
+}
+
+static inline int active_stripe_home (struct Iperf_TableStripe *stripe, uint32_t hash) {
+    return (int) ((hash / ACTIVE_TABLE_STRIPES) & (stripe->size - 1));
+}
+
 void Iperf_initialize_active_table () {
     Mutex_Initialize(&active_table.my_mutex);
-    active_table.root = NULL;
+    for (int ix = 0; ix < ACTIVE_TABLE_STRIPES; ix++) {
+	struct Iperf_TableStripe *stripe = &active_table.stripes[ix];
+	Mutex_Initialize(&stripe->my_mutex);
+	stripe->slots = NULL;
+	stripe->size = 0;
+	stripe->count = 0;
+    }
+    active_table.count = 0;
+    active_table.total_count = 0;
     active_table.groupid = 0;
 }
 
 /*
- * Add Entry add to the list or update thread count
+ * Find the slot of a host in a (locked) stripe, returns -1 if not present
+ */
+static int active_stripe_lookup (struct Iperf_TableStripe *stripe, uint32_t hash, iperf_sockaddr *find) {
+    if (stripe->size == 0)
+	return -1;
+    int mask = stripe->size - 1;
+    int ix = active_stripe_home(stripe, hash);
+    while (stripe->slots[ix] != NULL) {
+	if (SockAddr_Hostare_Equal(&stripe->slots[ix]->host, find)) {
+#if HAVE_THREAD_DEBUG
+	    active_table_show_compare("match", stripe->slots[ix], find, "client ip");
+#endif
+	    return ix;
+	}
+#if HAVE_THREAD_DEBUG
+	active_table_show_compare("miss", stripe->slots[ix], find, "client ip");
+#endif
+	ix = (ix + 1) & mask;
+    }
+    return -1;
+}
+
+static void active_stripe_place (struct Iperf_TableStripe *stripe, struct Iperf_ListEntry *entry) {
+    int mask = stripe->size - 1;
+    int ix = active_stripe_home(stripe, active_table_hash(&entry->host));
+    while (stripe->slots[ix] != NULL) {
+	ix = (ix + 1) & mask;
+    }
+    stripe->slots[ix] = entry;
+}
+
+// Keep the load at or below 3/4 so probes stay short and always end
+static void active_stripe_insert (struct Iperf_TableStripe *stripe, struct Iperf_ListEntry *entry) {
+    if ((stripe->count + 1) * 4 > stripe->size * 3) {
+	struct Iperf_ListEntry **old = stripe->slots;
+	int oldsize = stripe->size;
+	stripe->size = (oldsize ? (oldsize * 2) : ACTIVE_STRIPE_MINSLOTS);
+	stripe->slots = (struct Iperf_ListEntry **) calloc(stripe->size, sizeof(struct Iperf_ListEntry *));
+	assert(stripe->slots != NULL);
+	for (int ix = 0; ix < oldsize; ix++) {
+	    if (old[ix] != NULL)
+		active_stripe_place(stripe, old[ix]);
+	}
+	if (old != NULL)
+	    free(old);
+    }
+    active_stripe_place(stripe, entry);
+    stripe->count++;
+}
+
+// Delete by shifting back later entries of the probe run, i.e. no tombstones
+static void active_stripe_remove (struct Iperf_TableStripe *stripe, int ix) {
+    int mask = stripe->size - 1;
+    int next = (ix + 1) & mask;
+    stripe->slots[ix] = NULL;
+    stripe->count--;
+    while (stripe->slots[next] != NULL) {
+	int home = active_stripe_home(stripe, active_table_hash(&stripe->slots[next]->host));
+	if (((next - home) & mask) >= ((next - ix) & mask)) {
+	    stripe->slots[ix] = stripe->slots[next];
+	    stripe->slots[next] = NULL;
+	    ix = next;
+	}
+	next = (next + 1) & mask;
+    }
+}
+
+/*
+ * Add a new entry to the (locked) stripe or update its thread count,
+ * returns the group id
  */
-static void active_table_update (iperf_sockaddr *host, struct thread_Settings *agent) {
+static int active_table_update (struct Iperf_TableStripe *stripe, uint32_t hash, iperf_sockaddr *host, struct thread_Settings *agent) {
     assert(host != NULL);
     assert(agent != NULL);
-    Iperf_ListEntry *this_entry = Iperf_host_present(host);
-    active_table.total_count++;
-    if (this_entry == NULL) {
-	this_entry = new Iperf_ListEntry();
+    int ix = active_stripe_lookup(stripe, hash, host);
+    int groupid;
+    if (ix < 0) {
+	Iperf_ListEntry *this_entry = new Iperf_ListEntry();
 	assert(this_entry != NULL);
 	this_entry->host = *host;
-	this_entry->next = active_table.root;
 	this_entry->thread_count = 1;
 	this_entry->socket = agent->mSock;
+	active_stripe_insert(stripe, this_entry);
+	Mutex_Lock(&active_table.my_mutex);
+	int total_count = ++active_table.total_count;
 	active_table.count++;
-	active_table.groupid++;
-	active_table.root = this_entry;
+	groupid = ++active_table.groupid;
 #if HAVE_THREAD_DEBUG
 	active_table_show_entry("new entry", this_entry, ((SockAddr_are_Equal(&this_entry->host, host) && SockAddr_Hostare_Equal(&this_entry->host, host))));
 #endif
-	this_entry->sum_report = InitSumReport(agent, active_table.total_count, 0);
+	Mutex_Unlock(&active_table.my_mutex);
+	this_entry->sum_report = InitSumReport(agent, total_count, 0);
+	HoldSumReport(this_entry->sum_report);
 	agent->mSumReport = this_entry->sum_report;
     } else {
+	Iperf_ListEntry *this_entry = stripe->slots[ix];
 	this_entry->thread_count++;
 	agent->mSumReport = this_entry->sum_report;
+	Mutex_Lock(&active_table.my_mutex);
+	active_table.total_count++;
+	groupid = active_table.groupid;
 #if HAVE_THREAD_DEBUG
 	active_table_show_entry("incr entry", this_entry, 1);
 #endif
+	Mutex_Unlock(&active_table.my_mutex);
     }
+    return groupid;
 }
 
 static inline iperf_sockaddr *active_table_get_host_key (struct thread_Settings *agent) {
@@ -136,24 +256,34 @@ static inline iperf_sockaddr *active_table_get_host_key (struct thread_Settings
 // Thread access to store a host
 int Iperf_push_host (struct thread_Settings *agent) {
     iperf_sockaddr *host = active_table_get_host_key(agent);
-    Mutex_Lock(&active_table.my_mutex);
-    active_table_update(host, agent);
-    int groupid = active_table.groupid;
-    Mutex_Unlock(&active_table.my_mutex);
+    uint32_t hash = active_table_hash(host);
+    struct Iperf_TableStripe *stripe = active_table_stripe(hash);
+    Mutex_Lock(&stripe->my_mutex);
+    int groupid = active_table_update(stripe, hash, host, agent);
+    Mutex_Unlock(&stripe->my_mutex);
     return groupid;
 }
 
 // Used for UDP push of a new host, returns negative value if the host/port is already present
 // This is critical because UDP is connectionless and designed to be stateless
+// There is one entry per host so the host/port is present when the entry for
+// the host was created by that same port
 int Iperf_push_host_port_conditional (struct thread_Settings *agent) {
     iperf_sockaddr *host = active_table_get_host_key(agent);
+    uint32_t hash = active_table_hash(host);
+    struct Iperf_TableStripe *stripe = active_table_stripe(hash);
     int rc = -1;
-    Mutex_Lock(&active_table.my_mutex);
-    if (!Iperf_host_port_present(host)) {
-	active_table_update(host, agent);
-	rc = active_table.groupid;
+    Mutex_Lock(&stripe->my_mutex);
+    int ix = active_stripe_lookup(stripe, hash, host);
+    if ((ix < 0) || !SockAddr_are_Equal(&stripe->slots[ix]->host, host)) {
+	rc = active_table_update(stripe, hash, host, agent);
+    }
+#if HAVE_THREAD_DEBUG
+    else {
+	active_table_show_compare("match", stripe->slots[ix], host, "client ip/port");
     }
-    Mutex_Unlock(&active_table.my_mutex);
+#endif
+    Mutex_Unlock(&stripe->my_mutex);
     return (rc);
 }
 
@@ -162,94 +292,49 @@ int Iperf_push_host_port_conditional (struct thread_Settings *agent) {
  */
 void Iperf_remove_host (struct thread_Settings *agent) {
     iperf_sockaddr *del = active_table_get_host_key(agent);
-    // remove_list_entry(entry) {
-    //     indirect = &head;
-    //     while ((*indirect) != entry) {
-    //	       indirect = &(*indirect)->next;
-    //     }
-    //     *indirect = entry->next
-    Mutex_Lock(&active_table.my_mutex);
-    Iperf_ListEntry **tmp = &active_table.root;
-    while ((*tmp) && !(SockAddr_Hostare_Equal(&(*tmp)->host, del))) {
-#if HAVE_THREAD_DEBUG
-        active_table_show_compare("miss", *tmp, del, "client ip");
-#endif
-	tmp = &(*tmp)->next;
-    }
-    if (*tmp) {
-	if (--(*tmp)->thread_count == 0) {
-	    Iperf_ListEntry *remove = (*tmp);
+    uint32_t hash = active_table_hash(del);
+    struct Iperf_TableStripe *stripe = active_table_stripe(hash);
+    Mutex_Lock(&stripe->my_mutex);
+    int ix = active_stripe_lookup(stripe, hash, del);
+    if (ix >= 0) {
+	Iperf_ListEntry *entry = stripe->slots[ix];
+	if (--entry->thread_count == 0) {
+	    active_stripe_remove(stripe, ix);
+	    ReleaseSumReport(entry->sum_report);
+	    Mutex_Lock(&active_table.my_mutex);
 	    active_table.count--;
 #if HAVE_THREAD_DEBUG
-	    active_table_show_entry("delete", remove, 1);
+	    active_table_show_entry("delete", entry, 1);
 #endif
-	    *tmp = remove->next;
-	    delete remove;
+	    Mutex_Unlock(&active_table.my_mutex);
+	    delete entry;
 	} else {
 #if HAVE_THREAD_DEBUG
-	    active_table_show_entry("decr", (*tmp), 1);
+	    active_table_show_entry("decr", entry, 1);
 #endif
 	}
     }
-    Mutex_Unlock(&active_table.my_mutex);
+    Mutex_Unlock(&stripe->my_mutex);
 }
 
 /*
  * Destroy the table
  */
 void Iperf_destroy_active_table () {
-    Iperf_ListEntry *itr1 = active_table.root, *itr2;
-    while (itr1 != NULL) {
-        itr2 = itr1->next;
-        delete itr1;
-        itr1 = itr2;
+    for (int ix = 0; ix < ACTIVE_TABLE_STRIPES; ix++) {
+	struct Iperf_TableStripe *stripe = &active_table.stripes[ix];
+	for (int jx = 0; jx < stripe->size; jx++) {
+	    if (stripe->slots[jx] != NULL)
+		delete stripe->slots[jx];
+	}
+	if (stripe->slots != NULL)
+	    free(stripe->slots);
+	stripe->slots = NULL;
+	stripe->size = 0;
+	stripe->count = 0;
+	Mutex_Destroy(&stripe->my_mutex);
     }
     Mutex_Destroy(&active_table.my_mutex);
-    active_table.root = NULL;
     active_table.count = 0;
     active_table.total_count = 0;
 }
-
-/*
- * Check if the host and port are present in the active table
- */
-bool Iperf_host_port_present (iperf_sockaddr *find) {
-    Iperf_ListEntry *itr = active_table.root;
-    bool rc = false;
-    while (itr != NULL) {
-        if (SockAddr_are_Equal(&itr->host, find)) {
-#if HAVE_THREAD_DEBUG
-	    active_table_show_compare("match", itr, find, "client ip/port");
-#endif
-	    rc = true;
-            break;
-        } else {
-#if HAVE_THREAD_DEBUG
-	    active_table_show_compare("miss", itr, find, "client ip/port");
-#endif
-	    itr = itr->next;
-	}
-    }
-    return rc;
-}
-
-/*
- * Check if the host is present in the active table
- */
-static Iperf_ListEntry* Iperf_host_present (iperf_sockaddr *find) {
-    Iperf_ListEntry *itr = active_table.root;
-    while (itr != NULL) {
-        if (SockAddr_Hostare_Equal(&itr->host, find)) {
-#if HAVE_THREAD_DEBUG
-	    active_table_show_compare("match", itr, find, "client ip");
-#endif
-            break;
-        } else {
-#if HAVE_THREAD_DEBUG
-	    active_table_show_compare("miss", itr, find, "client ip");
-#endif
-	    itr = itr->next;
-	}
-    }
-    return itr;
-}
@@ -0,0 +1,231 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * checkchecksums.c
+ * Check the checksum kernels against the scalar (16 bits at a time)
+ * sum over random buffers and UDP/IP packets and benchmark them
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "checksums.h"
+
+#define CHECKCSUM_MAXKERNELS 8
+#define CHECKCSUM_MAXOFFSET 64
+#define CHECKCSUM_IPV4HDR 20
+#define CHECKCSUM_IPV6HDR 40
+#define CHECKCSUM_UDPHDR 8
+
+static uint64_t xorshift_state = 88172645463325252ULL;
+
+static inline uint64_t xorshift64 (void) {
+    xorshift_state ^= xorshift_state << 13;
+    xorshift_state ^= xorshift_state >> 7;
+    xorshift_state ^= xorshift_state << 17;
+    return xorshift_state;
+}
+
+static double now (void) {
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec + (t1.tv_nsec / 1e9));
+#else
+    struct timeval t1;
+    gettimeofday(&t1, NULL);
+    return (t1.tv_sec + (t1.tv_usec / 1e6));
+#endif
+}
+
+static void fill_random (uint8_t *buf, int len) {
+    int ix;
+    // every so often all ones, the worst case for the carries
+    int ones = ((xorshift64() % 8) == 0);
+    for (ix = 0; ix < len; ix++)
+	buf[ix] = ones ? 0xff : (uint8_t) xorshift64();
+}
+
+// Write the ones complement of the sum into the 16 bit field at check (which must be zero)
+static void set_check (uint8_t *check, uint64_t sum) {
+    uint16_t word = csum_fold(sum) ^ 0xffff;
+    if (!word)
+	word = 0xffff;
+    memcpy(check, &word, sizeof(word));
+}
+
+// Build an ip header plus a udp datagram of udplen bytes with valid checksums,
+// the sums are done here independently of udpchecksum() and ipv4checksum()
+static int build_packet (uint8_t *pkt, int udplen, int v6) {
+    int l3len = v6 ? CHECKCSUM_IPV6HDR : CHECKCSUM_IPV4HDR;
+    uint8_t *udp = pkt + l3len;
+    uint16_t word;
+    uint64_t sum;
+    fill_random(pkt, l3len + udplen);
+    if (v6) {
+	pkt[0] = 0x60;
+	pkt[6] = 17;
+	sum = csum_partial_scalar(pkt + 8, 32, 0);
+    } else {
+	pkt[0] = 0x45;
+	pkt[9] = 17;
+	pkt[10] = pkt[11] = 0;
+	set_check(pkt + 10, csum_partial_scalar(pkt, l3len, 0));
+	sum = csum_partial_scalar(pkt + 12, 8, 0);
+    }
+    word = htons(udplen);
+    memcpy(udp + 4, &word, sizeof(word));
+    udp[6] = udp[7] = 0;
+    sum += htons(17) + htons(udplen);
+    set_check(udp + 6, csum_partial_scalar(udp, udplen, sum));
+    return l3len;
+}
+
+static int check_buffers (csum_kernel_fn *kernels, const char **names, int kcnt, uint8_t *buf, int maxlen, int tests) {
+    int k, t, rc = 0;
+    for (k = 0; k < kcnt; k++) {
+	int errors = 0;
+	for (t = 0; t < tests; t++) {
+	    int len = (int) (xorshift64() % (maxlen + 1));
+	    int offset = (int) (xorshift64() % CHECKCSUM_MAXOFFSET);
+	    uint64_t sum = (uint32_t) xorshift64();
+	    fill_random(buf + offset, len);
+	    if (csum_fold((*kernels[k])(buf + offset, len, sum)) != csum_fold(csum_partial_scalar(buf + offset, len, sum)))
+		errors++;
+	}
+	fprintf(stdout, "%-6s %d random buffers (lengths 0-%d, offsets 0-%d): %s\n", names[k], tests, maxlen, \
+		CHECKCSUM_MAXOFFSET - 1, (errors ? "FAIL" : "match"));
+	if (errors)
+	    rc = 1;
+    }
+    return rc;
+}
+
+static int check_packets (uint8_t *buf, int maxlen, int tests) {
+    int t, errors = 0;
+    for (t = 0; t < tests; t++) {
+	int v6 = (int) (xorshift64() & 0x1);
+	int udplen = CHECKCSUM_UDPHDR + (int) (xorshift64() % (maxlen - CHECKCSUM_UDPHDR + 1));
+	uint8_t *pkt = buf + (xorshift64() % CHECKCSUM_MAXOFFSET);
+	int l3len = build_packet(pkt, udplen, v6);
+	uint8_t *udp = pkt + l3len;
+	uint32_t rc = udpchecksum(pkt, udp, udplen, v6);
+	if (rc || (rc != udpchecksum_scalar(pkt, udp, udplen, v6)))
+	    errors++;
+	if (!v6 && ipv4checksum(pkt))
+	    errors++;
+	// a single byte change is always detected, skip the udp check field so it can't become zero (no checksum)
+	int ix = (int) (xorshift64() % (udplen - 2));
+	if (ix >= 6)
+	    ix += 2;
+	udp[ix] += (uint8_t) (1 + (xorshift64() % 255));
+	rc = udpchecksum(pkt, udp, udplen, v6);
+	if (!rc || (rc != udpchecksum_scalar(pkt, udp, udplen, v6)))
+	    errors++;
+	if (!v6) {
+	    pkt[xorshift64() % l3len] ^= 0x10;
+	    if (!ipv4checksum(pkt))
+		errors++;
+	}
+	// a zero udp check means none for v4, and is an error for v6
+	udp[6] = udp[7] = 0;
+	if ((udpchecksum(pkt, udp, udplen, v6) != 0) != (v6 != 0))
+	    errors++;
+    }
+    fprintf(stdout, "%-6s %d random v4/v6 udp packets (lengths %d-%d), good and corrupted: %s\n", csum_kernel_name(), tests, \
+	    CHECKCSUM_UDPHDR, maxlen, (errors ? "FAIL" : "match"));
+    return (errors ? 1 : 0);
+}
+
+int main (int argc, char **argv) {
+    csum_kernel_fn kernels[CHECKCSUM_MAXKERNELS];
+    const char *names[CHECKCSUM_MAXKERNELS];
+    int lens[2] = {1472, 9000};
+    int c, k, kcnt, l, tests = 20000, maxlen = 9000, iterations = 100000, rc = 0;
+    volatile uint16_t sink = 0;
+    while ((c = getopt(argc, argv, "n:l:i:s:")) != -1) {
+	switch (c) {
+	case 'n':
+	    tests = atoi(optarg);
+	    break;
+	case 'l':
+	    maxlen = atoi(optarg);
+	    break;
+	case 'i':
+	    iterations = atoi(optarg);
+	    break;
+	case 's':
+	    xorshift_state = (uint64_t) atoll(optarg) | 1;
+	    break;
+	default:
+	    fprintf(stderr, "Usage -n random tests, -l max length, -i benchmark iterations, -s random seed\n");
+	    return 1;
+	}
+    }
+    if ((tests < 1) || (maxlen < 64) || (iterations < 1)) {
+	fprintf(stderr, "tests and iterations must be positive and max length at least 64\n");
+	return 1;
+    }
+    uint8_t *buf = (uint8_t *) malloc(maxlen + CHECKCSUM_IPV6HDR + CHECKCSUM_MAXOFFSET);
+    if (!buf) {
+	fprintf(stderr, "Out of Memory!!\n");
+	return 1;
+    }
+    kcnt = csum_kernel_list(kernels, names, CHECKCSUM_MAXKERNELS);
+    fprintf(stdout, "Checking %d kernel(s), dispatched kernel is %s\n", kcnt, csum_kernel_name());
+    rc |= check_buffers(kernels, names, kcnt, buf, maxlen, tests);
+    rc |= check_packets(buf, maxlen, tests);
+    if (lens[1] > maxlen)
+	lens[1] = maxlen;
+    fill_random(buf, maxlen);
+    for (l = 0; l < 2; l++) {
+	for (k = 0; k < kcnt; k++) {
+	    double start = now();
+	    int iter;
+	    for (iter = 0; iter < iterations; iter++)
+		sink += csum_fold((*kernels[k])(buf, lens[l], 0));
+	    double elapsed = now() - start;
+	    fprintf(stdout, "%-6s %5d bytes %.1f Gbit/s (%.1f ns/packet)\n", names[k], lens[l], \
+		    (elapsed > 0) ? (lens[l] * 8.0 * iterations / elapsed / 1e9) : 0.0, elapsed * 1e9 / iterations);
+	}
+    }
+    (void) sink;
+    free(buf);
+    return rc;
+}
@@ -0,0 +1,105 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * checkpayloadverify.c
+ * Check that payload_verify_check() passes the pattern's windows and
+ * detects a corrupted byte or a read from the wrong offset
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "payload_verify.h"
+
+static uint64_t xorshift_state = 88172645463325252ULL;
+
+static inline uint64_t xorshift64 (void) {
+    xorshift_state ^= xorshift_state << 13;
+    xorshift_state ^= xorshift_state >> 7;
+    xorshift_state ^= xorshift_state << 17;
+    return xorshift_state;
+}
+
+int main (int argc, char **argv) {
+    int c, t, tests = 20000, maxlen = 9000, errors = 0;
+    while ((c = getopt(argc, argv, "n:l:s:")) != -1) {
+	switch (c) {
+	case 'n':
+	    tests = atoi(optarg);
+	    break;
+	case 'l':
+	    maxlen = atoi(optarg);
+	    break;
+	case 's':
+	    xorshift_state = (uint64_t) atoll(optarg) | 1;
+	    break;
+	default:
+	    fprintf(stderr, "Usage -n random tests, -l max length, -s random seed\n");
+	    return 1;
+	}
+    }
+    if ((tests < 1) || (maxlen < 8)) {
+	fprintf(stderr, "tests must be positive and max length at least 8\n");
+	return 1;
+    }
+    char *pattern = payload_verify_pattern(maxlen);
+    char *buf = (char *) malloc(maxlen);
+    if (!pattern || !buf) {
+	fprintf(stderr, "Out of Memory!!\n");
+	return 1;
+    }
+    for (t = 0; t < tests; t++) {
+	// at least 8 bytes so no other offset of the pattern matches
+	int len = 8 + (int) (xorshift64() % (maxlen - 7));
+	int phase = payload_verify_phase((intmax_t) xorshift64());
+	int other = (phase + 1 + (int) (xorshift64() % (PAYLOADVERIFY_PERIOD - 1))) & (PAYLOADVERIFY_PERIOD - 1);
+	memcpy(buf, pattern + phase, len);
+	if (payload_verify_check(buf, len, pattern, phase))
+	    errors++;
+	if (!payload_verify_check(buf, len, pattern, other))
+	    errors++;
+	buf[xorshift64() % len] ^= (char) (1 + (xorshift64() % 255));
+	if (!payload_verify_check(buf, len, pattern, phase))
+	    errors++;
+    }
+    fprintf(stdout, "%d random windows (lengths 8-%d), intact, misplaced and corrupted: %s\n", tests, maxlen, (errors ? "FAIL" : "match"));
+    payload_verify_free(pattern);
+    free(buf);
+    return (errors ? 1 : 0);
+}
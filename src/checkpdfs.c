@@ -93,8 +93,9 @@ int main (int argc, char **argv) {
     int random = FALSE;
     double total;
     double binwidth=1.0;
+    struct pdf_sampler *sampler = NULL;
 
-    while ((c=getopt(argc, argv, "b:c:lm:prsv:w:")) != -1)
+    while ((c=getopt(argc, argv, "b:c:f:lm:prsv:w:")) != -1)
 	switch (c) {
 	case 'b':
 	    bincount = atoi(optarg);
@@ -102,6 +103,11 @@ int main (int argc, char **argv) {
 	case 'c':
 	    count = atoi(optarg);
 	    break;
+	case 'f':
+	    sampler = pdf_sampler_parse(optarg);
+	    if (!sampler)
+		exit(-1);
+	    break;
 	case 'l':
 	    gaussian = FALSE;
 	    break;
@@ -125,7 +131,7 @@ int main (int argc, char **argv) {
 	    break;
 	case '?':
 	default:
-	    fprintf(stderr,"Usage -b bins, -c count, -l log normal, -m mean, -p print, -s speed only, -v variance");
+	    fprintf(stderr,"Usage -b bins, -c count, -f cdf file or <kind>:<params>, -l log normal, -m mean, -p print, -s speed only, -v variance");
 	    exit(-1);
 	}
     if (bincount > MAXBINS) {
@@ -146,7 +152,20 @@ int main (int argc, char **argv) {
     struct timeval t1;
     gettimeofday( &t1, NULL );
 #endif
-    if (gaussian) {
+    if (sampler) {
+	for( i = 0 ; i < count ; i++ )  {
+	    int result = round(pdf_sample(sampler)/binwidth);
+	    if (!speedonly) {
+		if (result >= 0 && result < (MAXBINS - 1)) {
+		    histogram[result]++;
+		    if (result < minbin)
+			minbin = result;
+		    if (result > maxbin)
+			maxbin = result;
+		}
+	    }
+	}
+    } else if (gaussian) {
 	for( i = 0 ; i < count ; i++ )  {
 	    int result = round(normal(mean,variance)/binwidth);
 	    if (!speedonly) {
@@ -189,7 +208,10 @@ int main (int argc, char **argv) {
     exectime = round(1e9 * total / count);
     if (!printout) {
 	printf("Total time=%f secs, count= %d, average generate time of %d nanoseconds\n", total, count, exectime);
+	if (sampler)
+	    printf("Distribution mean=%f\n", pdf_sampler_mean(sampler));
     }
+    pdf_sampler_free(sampler);
     return(0);
 }
 #ifdef HAVE_CLOCK_GETTIME
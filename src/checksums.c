@@ -48,10 +48,20 @@
  * -------------------------------------------------------------------
  */
 #include "headers.h"
+#include "checksums.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKSUMS_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define CHECKSUMS_NEON 1
+#include <arm_neon.h>
+#endif
 
 /*
  *
- * Compute Internet Checksum for UDP packets (assumes 32 bit system)
+ * Compute Internet Checksum for UDP packets
  *
  * IPV4 Notes:
  *
@@ -166,13 +176,180 @@
 #define IPV6SIZE 8 // units is number of 16 bits, i.e. 128 bits is eight 16 bits
 #define IPV4SIZE 2 // v4 is two 16 bits (32 bits)
 #define UDPPROTO 17 // UDP protocol value for psuedo header
-uint32_t udpchecksum(const void *l3pdu, const void *l4pdu, int udplen, int v6) {
-    register uint32_t sum = 0;
-    const uint16_t *data;
-    int i;
+#define UDPCHECKOFFSET 6 // the udp checksum offset from the l4 pdu
+#define IPV4MINHDRLEN 20
+
+// 64 bit one's complement add, i.e. with an end around carry
+static inline uint64_t csum_add64 (uint64_t a, uint64_t b) {
+    uint64_t sum = a + b;
+    return (sum + (sum < a));
+}
+
+uint64_t csum_partial_scalar (const void *buf, int len, uint64_t sum) {
+    const uint8_t *data = (const uint8_t *) buf;
+    uint16_t word;
+    while (len > 1) {
+	memcpy(&word, data, sizeof(word));
+	sum += word;
+	data += 2;
+	len -= 2;
+    }
+    /*  Add left-over byte, if any, padded with a zero octet */
+    if (len > 0) {
+	word = 0;
+	memcpy(&word, data, 1);
+	sum += word;
+    }
+    return sum;
+}
+
+uint16_t csum_fold (uint64_t sum) {
+    /*  Fold 64-bit sum to 16 bits, 2^32 and 2^16 are both 1 mod 0xffff */
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffffffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t) sum;
+}
+
+#ifdef CHECKSUMS_X86
+__attribute__((target("sse2")))
+static uint64_t csum_partial_sse2 (const void *buf, int len, uint64_t sum) {
+    const uint8_t *data = (const uint8_t *) buf;
+    uint64_t lanes[2];
+    if (len >= 32) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc0 = _mm_setzero_si128();
+	__m128i acc1 = _mm_setzero_si128();
+	while (len >= 32) {
+	    __m128i v0 = _mm_loadu_si128((const __m128i *) data);
+	    __m128i v1 = _mm_loadu_si128((const __m128i *) (data + 16));
+	    // widen the 32 bit words into 64 bit lanes so nothing carries out
+	    acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+	    acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+	    acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v1, zero));
+	    acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v1, zero));
+	    data += 32;
+	    len -= 32;
+	}
+	_mm_storeu_si128((__m128i *) lanes, _mm_add_epi64(acc0, acc1));
+	sum = csum_add64(sum, csum_add64(lanes[0], lanes[1]));
+    }
+    return csum_add64(sum, csum_partial_scalar(data, len, 0));
+}
 
-    const struct udphdr *udp_hdr = (const struct udphdr *)l4pdu;
-    if (!udp_hdr->check) {
+__attribute__((target("avx2")))
+static uint64_t csum_partial_avx2 (const void *buf, int len, uint64_t sum) {
+    const uint8_t *data = (const uint8_t *) buf;
+    uint64_t lanes[4];
+    if (len >= 64) {
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	while (len >= 64) {
+	    __m256i v0 = _mm256_loadu_si256((const __m256i *) data);
+	    __m256i v1 = _mm256_loadu_si256((const __m256i *) (data + 32));
+	    acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+	    acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+	    acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+	    acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+	    data += 64;
+	    len -= 64;
+	}
+	_mm256_storeu_si256((__m256i *) lanes, _mm256_add_epi64(acc0, acc1));
+	sum = csum_add64(sum, csum_add64(csum_add64(lanes[0], lanes[1]), csum_add64(lanes[2], lanes[3])));
+    }
+    return csum_partial_sse2(data, len, sum);
+}
+#endif
+
+#ifdef CHECKSUMS_NEON
+static uint64_t csum_partial_neon (const void *buf, int len, uint64_t sum) {
+    const uint8_t *data = (const uint8_t *) buf;
+    if (len >= 32) {
+	uint64x2_t acc0 = vdupq_n_u64(0);
+	uint64x2_t acc1 = vdupq_n_u64(0);
+	while (len >= 32) {
+	    // pairwise add the 32 bit words into the 64 bit lanes
+	    acc0 = vpadalq_u32(acc0, vreinterpretq_u32_u8(vld1q_u8(data)));
+	    acc1 = vpadalq_u32(acc1, vreinterpretq_u32_u8(vld1q_u8(data + 16)));
+	    data += 32;
+	    len -= 32;
+	}
+	uint64x2_t acc = vaddq_u64(acc0, acc1);
+	sum = csum_add64(sum, csum_add64(vgetq_lane_u64(acc, 0), vgetq_lane_u64(acc, 1)));
+    }
+    return csum_add64(sum, csum_partial_scalar(data, len, 0));
+}
+#endif
+
+int csum_kernel_list (csum_kernel_fn *kernels, const char **names, int max) {
+    int cnt = 0;
+#ifdef CHECKSUMS_X86
+    __builtin_cpu_init();
+    if ((cnt < max) && __builtin_cpu_supports("avx2")) {
+	kernels[cnt] = csum_partial_avx2;
+	names[cnt++] = "avx2";
+    }
+    if ((cnt < max) && __builtin_cpu_supports("sse2")) {
+	kernels[cnt] = csum_partial_sse2;
+	names[cnt++] = "sse2";
+    }
+#endif
+#ifdef CHECKSUMS_NEON
+    if (cnt < max) {
+	kernels[cnt] = csum_partial_neon;
+	names[cnt++] = "neon";
+    }
+#endif
+    if (cnt < max) {
+	kernels[cnt] = csum_partial_scalar;
+	names[cnt++] = "scalar";
+    }
+    return cnt;
+}
+
+static csum_kernel_fn csum_kernel = NULL;
+static const char *csum_kernelname = NULL;
+#ifdef HAVE_POSIX_THREAD
+static pthread_once_t csum_kernel_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void csum_kernel_select (void) {
+    csum_kernel_fn kernels[1];
+    const char *names[1];
+    // The list is ordered best first
+    csum_kernel_list(kernels, names, 1);
+    csum_kernelname = names[0];
+    csum_kernel = kernels[0];
+}
+
+// Concurrent server threads checksum through here, select only once
+static inline void csum_kernel_init (void) {
+#ifdef HAVE_POSIX_THREAD
+    pthread_once(&csum_kernel_once, csum_kernel_select);
+#else
+    if (!csum_kernel)
+	csum_kernel_select();
+#endif
+}
+
+uint64_t csum_partial (const void *buf, int len, uint64_t sum) {
+    csum_kernel_init();
+    return (*csum_kernel)(buf, len, sum);
+}
+
+const char *csum_kernel_name (void) {
+    csum_kernel_init();
+    return csum_kernelname;
+}
+
+static uint32_t udpchecksum_kernel (csum_kernel_fn kernel, const void *l3pdu, const void *l4pdu, int udplen, int v6) {
+    uint64_t sum;
+    uint16_t check;
+
+    memcpy(&check, (const char *)l4pdu + UDPCHECKOFFSET, sizeof(check));
+    if (!check) {
 	if (v6)
 	    // v6 requires checksums
 	    return -1;
@@ -186,20 +363,14 @@ uint32_t udpchecksum(const void *l3pdu, const void *l4pdu, int udplen, int v6) {
      *  (which are in network byte order) and
      *  the protocol of UDP (value of 17).  Also, the IP dst
      *  addr immediately follows the src so double the size
-     *  per each loop to cover both addrs
+     *  to cover both addrs
      */
     if (v6) {
 	// skip to the ip header v6 src field, offset 8 (see ipv6 header)
-	data = (const uint16_t *)((char *)l3pdu + IPV6SRCOFFSET);
-	for (i = 0; i < (2 * IPV6SIZE); i++) {
-	    sum += *data++;
-	}
+	sum = (*kernel)((const char *)l3pdu + IPV6SRCOFFSET, (2 * IPV6SIZE * 2), 0);
     } else {
 	// skip to the ip header v4 src field, offset 12 (see ipv4 header)
-	data = (const uint16_t *)((char *)l3pdu + IPV4SRCOFFSET);
-	for (i = 0; i < (2 * IPV4SIZE); i++) {
-	    sum += *data++;
-	}
+	sum = (*kernel)((const char *)l3pdu + IPV4SRCOFFSET, (2 * IPV4SIZE * 2), 0);
     }
     //  These should work for both v4 and v6 even though
     //  v6 psuedo header uses 32 bit values because the
@@ -210,20 +381,30 @@ uint32_t udpchecksum(const void *l3pdu, const void *l4pdu, int udplen, int v6) {
     /*
      * UDP hdr + payload
      */
-    data = (const uint16_t *) l4pdu;
-    while( udplen > 1 )  {
-	sum += *data++;
-	udplen -= 2;
-    }
-    /*  Add left-over byte, if any */
-    if( udplen > 0 )
-	sum += * (uint8_t *) data;
-
-    /*  Fold 32-bit sum to 16 bits */
-    while (sum>>16)
-	sum = (sum & 0xffff) + (sum >> 16);
+    sum = (*kernel)(l4pdu, udplen, sum);
 
     /* return ones complement */
-    sum = (sum ^ 0xffff);
-    return sum;
+    return (csum_fold(sum) ^ 0xffff);
+}
+
+uint32_t udpchecksum (const void *l3pdu, const void *l4pdu, int udplen, int v6) {
+    csum_kernel_init();
+    return udpchecksum_kernel(csum_kernel, l3pdu, l4pdu, udplen, v6);
+}
+
+uint32_t udpchecksum_scalar (const void *l3pdu, const void *l4pdu, int udplen, int v6) {
+    return udpchecksum_kernel(csum_partial_scalar, l3pdu, l4pdu, udplen, v6);
+}
+
+/*
+ * IPv4 header checksum (RFC 791), the one's complement sum over the
+ * header including options, i.e. IHL 32 bit words
+ *
+ *  Returns zero on checksum success, non zero otherwise
+ */
+uint32_t ipv4checksum (const void *l3pdu) {
+    int hlen = (*(const uint8_t *) l3pdu & 0x0f) << 2;
+    if (hlen < IPV4MINHDRLEN)
+	return -1;
+    return (csum_fold(csum_partial(l3pdu, hlen, 0)) ^ 0xffff);
 }
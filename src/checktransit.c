@@ -0,0 +1,237 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * checktransit.c
+ * Check the batch transit kernels against the scalar (per packet)
+ * recurrence and benchmark them
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "transit_kernel.h"
+#include <math.h>
+
+#define CHECKTRANSIT_MAXKERNELS 8
+
+static uint64_t xorshift_state = 88172645463325252ULL;
+
+static inline uint64_t xorshift64 (void) {
+    xorshift_state ^= xorshift_state << 13;
+    xorshift_state ^= xorshift_state >> 7;
+    xorshift_state ^= xorshift_state << 17;
+    return xorshift_state;
+}
+
+static double now (void) {
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec + (t1.tv_nsec / 1e9));
+#else
+    struct timeval t1;
+    gettimeofday(&t1, NULL);
+    return (t1.tv_sec + (t1.tv_usec / 1e6));
+#endif
+}
+
+static inline double relerr (double a, double b) {
+    double scale = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return ((scale > 0) ? (fabs(a - b) / scale) : 0.0);
+}
+
+// feed the transits in batches of (random) sizes up to batch
+static void run_kernel (transit_kernel_fn kernel, const double *transit, size_t n, size_t batch, int randombatch, int flowstart, struct transit_stats *stats) {
+    size_t ix = 0;
+    memset(stats, 0, sizeof(struct transit_stats));
+    stats->flowstart = flowstart;
+    while (ix < n) {
+	size_t len = randombatch ? (1 + (xorshift64() % batch)) : batch;
+	if (len > (n - ix))
+	    len = n - ix;
+	(*kernel)(transit + ix, len, stats);
+	ix += len;
+    }
+}
+
+// The live Reporter path, i.e. reporter_handle_packet_oneway_transit() with the
+// per interval resets of reporter_reset_transfer_stats_server_udp()
+static void run_reporter (const double *transit, size_t n, size_t interval, struct transit_stats *ivs) {
+    intmax_t totcntTransit = 0;
+    size_t ix;
+    for (ix = 0; ix < n; ix++) {
+	struct transit_stats *iv = &ivs[ix / interval];
+	double usec_transit = transit[ix] * 1e6;
+	if ((ix % interval) == 0) {
+	    iv->minTransit = FLT_MAX;
+	    iv->maxTransit = FLT_MIN;
+	    iv->sumTransit = 0;
+	    iv->cntTransit = 0;
+	    iv->meanTransit = 0;
+	    iv->m2Transit = 0;
+	}
+	if (totcntTransit == 0) {
+	    iv->minTransit = transit[ix];
+	    iv->maxTransit = transit[ix];
+	    iv->sumTransit = transit[ix];
+	    iv->cntTransit = 1;
+	    iv->meanTransit = usec_transit;
+	    iv->m2Transit = usec_transit * usec_transit;
+	} else {
+	    double vdTransit;
+	    iv->sumTransit += transit[ix];
+	    iv->cntTransit++;
+	    if (transit[ix] < iv->minTransit)
+		iv->minTransit = transit[ix];
+	    if (transit[ix] > iv->maxTransit)
+		iv->maxTransit = transit[ix];
+	    vdTransit = usec_transit - iv->meanTransit;
+	    iv->meanTransit = iv->meanTransit + (vdTransit / iv->cntTransit);
+	    iv->m2Transit = iv->m2Transit + (vdTransit * (usec_transit - iv->meanTransit));
+	}
+	totcntTransit++;
+    }
+}
+
+int main (int argc, char **argv) {
+    transit_kernel_fn kernels[CHECKTRANSIT_MAXKERNELS];
+    const char *names[CHECKTRANSIT_MAXKERNELS];
+    struct transit_stats ref, stats;
+    size_t n = 1000000, batch = 64, interval = 10000, ix;
+    int c, k, kcnt, iterations = 10, rc = 0;
+    while ((c = getopt(argc, argv, "n:b:r:i:s:")) != -1) {
+	switch (c) {
+	case 'n':
+	    n = (size_t) atol(optarg);
+	    break;
+	case 'b':
+	    batch = (size_t) atol(optarg);
+	    break;
+	case 'r':
+	    interval = (size_t) atol(optarg);
+	    break;
+	case 'i':
+	    iterations = atoi(optarg);
+	    break;
+	case 's':
+	    xorshift_state = (uint64_t) atoll(optarg) | 1;
+	    break;
+	default:
+	    fprintf(stderr, "Usage -n samples, -b batch size, -r samples per report interval, -i benchmark iterations, -s random seed\n");
+	    return 1;
+	}
+    }
+    if (!n || !batch || !interval || (iterations < 1)) {
+	fprintf(stderr, "samples, batch, interval and iterations must be positive\n");
+	return 1;
+    }
+    double *transit = (double *) malloc(n * sizeof(double));
+    if (!transit) {
+	fprintf(stderr, "Out of Memory!!\n");
+	return 1;
+    }
+    // about 1 ms of base delay, usec noise, and the occasional queueing spike
+    for (ix = 0; ix < n; ix++) {
+	transit[ix] = 0.001 + (xorshift64() % 1000) * 1e-9 + (((xorshift64() % 1000) == 0) ? (xorshift64() % 50000) * 1e-6 : 0.0);
+    }
+    kcnt = transit_kernel_list(kernels, names, CHECKTRANSIT_MAXKERNELS);
+    fprintf(stdout, "Checking %d kernel(s) over %zu samples, batch size %zu, dispatched kernel is %s\n", kcnt, n, batch, transit_kernel_name());
+    memset(&ref, 0, sizeof(ref));
+    transit_kernel_scalar(transit, n, &ref);
+    for (k = 0; k < kcnt; k++) {
+	int randombatch;
+	for (randombatch = 0; randombatch < 2; randombatch++) {
+	    run_kernel(kernels[k], transit, n, batch, randombatch, 0, &stats);
+	    int exact = ((stats.cntTransit == ref.cntTransit) && (stats.minTransit == ref.minTransit) && \
+			 (stats.maxTransit == ref.maxTransit) && (stats.jitter == ref.jitter) && \
+			 (stats.lastTransit == ref.lastTransit));
+	    double err = relerr(stats.sumTransit, ref.sumTransit);
+	    if (relerr(stats.meanTransit, ref.meanTransit) > err)
+		err = relerr(stats.meanTransit, ref.meanTransit);
+	    if (relerr(stats.m2Transit, ref.m2Transit) > err)
+		err = relerr(stats.m2Transit, ref.m2Transit);
+	    fprintf(stdout, "%-6s %s batches: cnt/min/max/jitter %s, sum/mean/m2 max relative error %.3e %s\n", names[k], \
+		    (randombatch ? "random" : "fixed "), (exact ? "match" : "MISMATCH"), err, \
+		    ((err <= TRANSIT_KERNEL_TOLERANCE) ? "ok" : "FAIL"));
+	    if (!exact || (err > TRANSIT_KERNEL_TOLERANCE))
+		rc = 1;
+	}
+    }
+    // per report interval, the way traceanalyze -f uses the kernels, vs the live Reporter
+    size_t ivcnt = (n + interval - 1) / interval;
+    struct transit_stats *ivs = (struct transit_stats *) calloc(ivcnt, sizeof(struct transit_stats));
+    if (!ivs) {
+	fprintf(stderr, "Out of Memory!!\n");
+	return 1;
+    }
+    run_reporter(transit, n, interval, ivs);
+    for (k = 0; k < kcnt; k++) {
+	int exact = 1;
+	double err = 0;
+	size_t iv;
+	for (iv = 0; iv < ivcnt; iv++) {
+	    size_t len = ((iv + 1) * interval > n) ? (n - iv * interval) : interval;
+	    run_kernel(kernels[k], transit + iv * interval, len, batch, 1, (iv == 0), &stats);
+	    if ((stats.cntTransit != ivs[iv].cntTransit) || (stats.minTransit != ivs[iv].minTransit) || \
+		(stats.maxTransit != ivs[iv].maxTransit))
+		exact = 0;
+	    if (relerr(stats.sumTransit, ivs[iv].sumTransit) > err)
+		err = relerr(stats.sumTransit, ivs[iv].sumTransit);
+	    if (relerr(stats.meanTransit, ivs[iv].meanTransit) > err)
+		err = relerr(stats.meanTransit, ivs[iv].meanTransit);
+	    if (relerr(stats.m2Transit, ivs[iv].m2Transit) > err)
+		err = relerr(stats.m2Transit, ivs[iv].m2Transit);
+	}
+	fprintf(stdout, "%-6s vs reporter, %zu intervals: cnt/min/max %s, sum/mean/m2 max relative error %.3e %s\n", names[k], \
+		ivcnt, (exact ? "match" : "MISMATCH"), err, ((err <= TRANSIT_KERNEL_TOLERANCE) ? "ok" : "FAIL"));
+	if (!exact || (err > TRANSIT_KERNEL_TOLERANCE))
+	    rc = 1;
+    }
+    free(ivs);
+    for (k = 0; k < kcnt; k++) {
+	double start = now();
+	int iter;
+	for (iter = 0; iter < iterations; iter++)
+	    run_kernel(kernels[k], transit, n, batch, 0, 0, &stats);
+	double elapsed = now() - start;
+	fprintf(stdout, "%-6s %.1f Mpps (%.2f ns/sample)\n", names[k], (elapsed > 0) ? (n * (double) iterations / elapsed / 1e6) : 0.0, \
+		elapsed * 1e9 / ((double) n * iterations));
+    }
+    free(transit);
+    return rc;
+}
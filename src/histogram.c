@@ -64,7 +64,7 @@ struct histogram *histogram_init(unsigned int bincount, unsigned int binwidth, f
         free(this);
         return(NULL);
     }
-    this->myname = (char *) malloc(sizeof(strlen(name)));
+    this->myname = (char *) malloc(strlen(name) + 1);
     if (!this->myname) {
         fprintf(stderr,"Malloc failure in histogram init n\n");
         free(this->mybins);
@@ -94,6 +94,9 @@ struct histogram *histogram_init(unsigned int bincount, unsigned int binwidth, f
     this->prev = NULL;
     this->maxbin = -1;
     this->fmaxbin = -1;
+    this->maxval = 0;
+    this->fmaxval = 0;
+    this->final = 0;
     this->maxts.tv_sec = 0;
     this->maxts.tv_usec = 0;
     this->fmaxts.tv_sec = 0;
@@ -115,6 +118,8 @@ void histogram_delete(struct histogram *h) {
 	free(h->mybins);
     if (h->myname)
 	free(h->myname);
+    if (h->outbuf)
+	free(h->outbuf);
     free(h);
   }
 }
@@ -142,7 +147,7 @@ int histogram_insert(struct histogram *h, float value, struct timeval *ts) {
     if (bin < 0) {
 	h->cntloweroutofbounds++;
 	return(-1);
-    } else if (bin > (int) h->bincount) {
+    } else if (bin >= (int) h->bincount) {
 	h->cntupperoutofbounds++;
 	return(-2);
     }
@@ -170,6 +175,25 @@ void histogram_add(struct histogram *to, struct histogram *from) {
     for (ix=0; ix < to->bincount; ix ++) {
 	to->mybins[ix] += from->mybins[ix];
     }
+    to->populationcnt += from->populationcnt;
+    to->cntloweroutofbounds += from->cntloweroutofbounds;
+    to->cntupperoutofbounds += from->cntupperoutofbounds;
+}
+
+// Return the upper edge of the bin holding the pct percentile, units
+// is seconds, or a negative value if it's out of the histogram's bounds
+double histogram_percentile(struct histogram *h, double pct) {
+    unsigned int ix;
+    double target = h->populationcnt * pct / 100.0;
+    double running = h->cntloweroutofbounds;
+    if (!h->populationcnt || (running >= target))
+	return (h->populationcnt ? 0 : -1);
+    for (ix = 0; ix < h->bincount; ix++) {
+	running += h->mybins[ix];
+	if (running >= target)
+	    return (h->offset + ((double) (ix + 1) * h->binwidth / h->units));
+    }
+    return -1;
 }
 
 void histogram_print(struct histogram *h, double start, double end) {
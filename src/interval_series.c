@@ -0,0 +1,250 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * interval_series.c
+ * Deferred output of interval reports, see interval_series.h
+ *
+ * The append is done in the reporter thread's interval path so it has
+ * to be cheap, i.e. a copy of the deltas into a preallocated array.
+ * All formatting is deferred until the report's final output.
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "Settings.hpp"
+#include "Reporter.h"
+#include "Locale.h"
+#include "util.h"
+#include "interval_series.h"
+#ifdef HAVE_THREAD_DEBUG
+// needed for thread_debug
+#include "Thread.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size the preallocation per the test duration and the interval time
+size_t interval_series_count (struct thread_Settings *inSettings) {
+    size_t count = INTERVALSERIES_DEFAULTCOUNT;
+    if (isModeTime(inSettings) && (inSettings->mInterval > 0)) {
+	// mAmount units are 10 ms, mInterval units are usecs
+	uintmax_t intervals = (inSettings->mAmount * 10000) / inSettings->mInterval;
+	// allow for the final partial and some missed reports
+	count = (intervals < INTERVALSERIES_MAXPREALLOC) ? (size_t) (intervals + 16) : INTERVALSERIES_MAXPREALLOC;
+    }
+    return count;
+}
+
+struct IntervalSeries *interval_series_init (size_t capacity, const char *label) {
+    struct IntervalSeries *series = (struct IntervalSeries *) calloc(1, sizeof(struct IntervalSeries));
+    if (series) {
+	series->samples = (struct IntervalSample *) calloc(capacity, sizeof(struct IntervalSample));
+	if (!series->samples) {
+	    free(series);
+	    return NULL;
+	}
+	series->capacity = capacity;
+	snprintf(series->label, sizeof(series->label), "%s", (label ? label : ""));
+#ifdef HAVE_THREAD_DEBUG
+	thread_debug("Init interval series=%p with %d samples (%d bytes)", (void *) series, (int) capacity, (int) (capacity * sizeof(struct IntervalSample)));
+#endif
+    }
+    return series;
+}
+
+void interval_series_free (struct IntervalSeries *series) {
+    if (series) {
+	if (series->samples)
+	    free(series->samples);
+	free(series);
+    }
+}
+
+static inline void interval_series_append (struct IntervalSeries *series, struct TransferInfo *stats) {
+    if (series->count == series->capacity) {
+	// Out of preallocated samples, grow rather than lose the tail of the test
+	size_t capacity = series->capacity * 2;
+	struct IntervalSample *samples = (struct IntervalSample *) realloc(series->samples, capacity * sizeof(struct IntervalSample));
+	if (!samples) {
+	    series->dropped++;
+	    return;
+	}
+	series->samples = samples;
+	series->capacity = capacity;
+    }
+    struct IntervalSample *sample = &series->samples[series->count++];
+    sample->iStart = stats->ts.iStart;
+    sample->iEnd = stats->ts.iEnd;
+    sample->bytes = stats->cntBytes;
+    sample->datagrams = stats->cntDatagrams;
+    sample->lost = stats->cntError;
+    sample->outoforder = stats->cntOutofOrder;
+    sample->jitter = stats->jitter;
+    sample->cntTransit = stats->transit.cntTransit;
+    if (sample->cntTransit > 0) {
+	sample->minTransit = stats->transit.minTransit;
+	sample->maxTransit = stats->transit.maxTransit;
+	sample->meanTransit = stats->transit.sumTransit / stats->transit.cntTransit;
+    } else {
+	sample->minTransit = 0;
+	sample->maxTransit = 0;
+	sample->meanTransit = 0;
+    }
+    if (stats->common->ThreadMode == kMode_Server) {
+	sample->calls = stats->sock_callstats.read.cntRead;
+	sample->errors = 0;
+	sample->retry = 0;
+	sample->cwnd = 0;
+	sample->rtt = 0;
+    } else {
+	sample->calls = stats->sock_callstats.write.WriteCnt;
+	sample->errors = stats->sock_callstats.write.WriteErr;
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+	sample->retry = stats->sock_callstats.write.TCPretry;
+	sample->cwnd = stats->sock_callstats.write.cwnd;
+	sample->rtt = stats->sock_callstats.write.rtt;
+#else
+	sample->retry = 0;
+	sample->cwnd = 0;
+	sample->rtt = 0;
+#endif
+    }
+}
+
+static void interval_series_render_text (struct IntervalSeries *series, struct ReportCommon *common) {
+    char bytebuf[40];
+    char ratebuf[40];
+    bool server = (common->ThreadMode == kMode_Server);
+    size_t ix;
+    printf(report_interval_series_header, series->label, (uintmax_t) series->count, series->dropped);
+    for (ix = 0; ix < series->count; ix++) {
+	struct IntervalSample *sample = &series->samples[ix];
+	double duration = sample->iEnd - sample->iStart;
+	byte_snprintf(bytebuf, sizeof(bytebuf), (double) sample->bytes, toupper((int)common->Format));
+	byte_snprintf(ratebuf, sizeof(ratebuf), ((duration > 0) ? ((double) sample->bytes / duration) : 0.0), common->Format);
+	printf(report_interval_series_format, series->label, sample->iStart, sample->iEnd, bytebuf, ratebuf);
+	if (server) {
+	    if (isUDP(common)) {
+		printf(report_interval_series_udp_read, (sample->jitter * 1e3), sample->lost, sample->datagrams, sample->outoforder);
+		if (sample->cntTransit > 0)
+		    printf(report_interval_series_latency, (sample->minTransit * 1e3), (sample->meanTransit * 1e3), (sample->maxTransit * 1e3));
+	    } else {
+		printf(report_interval_series_read, sample->calls);
+	    }
+	} else {
+	    printf(report_interval_series_write, sample->calls, sample->errors);
+	    if (isUDP(common)) {
+		printf(report_interval_series_datagrams, sample->datagrams);
+	    } else if (isEnhanced(common)) {
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+		printf(report_interval_series_tcpinfo, sample->retry, sample->cwnd, sample->rtt);
+#endif
+	    }
+	}
+	printf("\n");
+    }
+}
+
+static void interval_series_render_json (struct IntervalSeries *series, struct ReportCommon *common) {
+    char id[sizeof(series->label)];
+    bool server = (common->ThreadMode == kMode_Server);
+    size_t ix, jx = 0;
+    // strip the brackets and padding from the report's label, e.g. "[  1] " -> "1"
+    for (ix = 0; (series->label[ix] != '\0') && (jx < (sizeof(id) - 1)); ix++) {
+	if ((series->label[ix] != '[') && (series->label[ix] != ']') && (series->label[ix] != ' ') && (series->label[ix] != '"'))
+	    id[jx++] = series->label[ix];
+    }
+    id[jx] = '\0';
+    for (ix = 0; ix < series->count; ix++) {
+	struct IntervalSample *sample = &series->samples[ix];
+	double duration = sample->iEnd - sample->iStart;
+	printf(report_interval_series_json_format, id, sample->iStart, sample->iEnd, sample->bytes, \
+	       ((duration > 0) ? ((double) sample->bytes * 8 / duration) : 0.0));
+	if (server) {
+	    if (isUDP(common)) {
+		printf(report_interval_series_json_udp_read, (sample->jitter * 1e3), sample->lost, sample->datagrams, sample->outoforder);
+		if (sample->cntTransit > 0)
+		    printf(report_interval_series_json_latency, (sample->minTransit * 1e3), (sample->meanTransit * 1e3), \
+			   (sample->maxTransit * 1e3), sample->cntTransit);
+	    } else {
+		printf(report_interval_series_json_read, sample->calls);
+	    }
+	} else {
+	    printf(report_interval_series_json_write, sample->calls, sample->errors);
+	    if (isUDP(common)) {
+		printf(report_interval_series_json_datagrams, sample->datagrams);
+	    } else if (isEnhanced(common)) {
+#ifdef HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS
+		printf(report_interval_series_json_tcpinfo, sample->retry, sample->cwnd, sample->rtt);
+#endif
+	    }
+	}
+	printf("}\n");
+    }
+}
+
+// This is installed as the report's output handler.  Interval reports
+// are appended to the series, the final report renders the series and
+// then calls the original output handler for the final (total) output
+void interval_series_output (struct TransferInfo *stats) {
+    struct IntervalSeries *series = stats->series;
+    assert(series != NULL);
+    if (!stats->final) {
+	interval_series_append(series, stats);
+    } else {
+	if (series->count || series->dropped) {
+	    if (isIntervalSeriesJSON(stats->common))
+		interval_series_render_json(series, stats->common);
+	    else
+		interval_series_render_text(series, stats->common);
+	    series->count = 0;
+	    series->dropped = 0;
+	}
+	if (series->output_handler)
+	    (*series->output_handler)(stats);
+	fflush(stdout);
+    }
+}
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
@@ -68,6 +68,8 @@
 #include "Timestamp.hpp"
 #include "Listener.hpp"
 #include "active_hosts.h"
+#include "scenario.h"
+#include "SocketAddr.h"
 #include "util.h"
 #include "Reporter.h"
 
@@ -112,6 +114,8 @@ extern "C" {
 // signal we do not prematurely exit
 nthread_t sThread;
 static thread_Settings* ext_gSettings;
+// flow groups of --scenario
+static struct ScenarioGroup *scenario_groups = NULL;
 // The main thread uses this function to wait
 // for all other threads to complete
 void waitUntilQuit();
@@ -148,6 +152,7 @@ int main(int argc, char **argv) {
 
     // Initialize global mutexes and conditions
     Iperf_initialize_active_table();
+    SockAddr_Ifcache_Initialize();
     Condition_Initialize (&ReportCond);
 
 #ifdef HAVE_THREAD_DEBUG
@@ -224,6 +229,12 @@ int main(int argc, char **argv) {
 
     }
 
+    if (isAffinity(ext_gSettings)) {
+	// auto places the threads per the numa node of the bound device
+	const char *device = (ext_gSettings->mIfrnametx ? ext_gSettings->mIfrnametx : ext_gSettings->mIfrname);
+	if (thread_affinity_init(ext_gSettings->mAffinity, ext_gSettings->mReporterAffinity, device) < 0)
+	    return 1;
+    }
     unsetReport(ext_gSettings);
     switch (ext_gSettings->mThreadMode) {
     case kMode_Client :
@@ -231,10 +242,17 @@ int main(int argc, char **argv) {
 	    fprintf(stderr, "Iperf client cannot be run as a daemon\n");
 	    return 0;
 	}
-        // initialize client(s)
-	transmits_start.count = ext_gSettings->mThreads;
-	ext_gSettings->connects_done = &transmits_start;
-        client_init(ext_gSettings);
+	if (isScenario(ext_gSettings)) {
+	    // the flow groups of a scenario file replace the command line client(s)
+	    if (scenario_load(ext_gSettings->mScenario, &scenario_groups) < 0)
+		return 1;
+	    ext_gSettings = scenario_init(ext_gSettings, scenario_groups, argc, argv);
+	} else {
+	    // initialize client(s)
+	    transmits_start.count = ext_gSettings->mThreads;
+	    ext_gSettings->connects_done = &transmits_start;
+	    client_init(ext_gSettings);
+	}
 	ReporterThreadMode = kMode_ReporterClient;
 	break;
     case kMode_Listener :
@@ -270,6 +288,10 @@ int main(int argc, char **argv) {
 	fprintf(stderr, "unknown mode");
 	break;
     }
+    // Prestart the traffic thread pool, after daemon() as a fork only keeps this thread
+    if (ext_gSettings->mThreadPool > 0) {
+	thread_pool_init(ext_gSettings->mThreadPool, isThreadPoolCPU(ext_gSettings));
+    }
 #ifdef HAVE_THREAD
     // Last step is to initialize the reporter then start all threads
     {
@@ -340,6 +362,9 @@ void cleanup () {
 #endif
     // clean up the list of active clients
     Iperf_destroy_active_table();
+    scenario_free(scenario_groups);
+    thread_affinity_destroy();
+    SockAddr_Ifcache_Destroy();
     // done actions
     // Destroy global mutexes and conditions
 
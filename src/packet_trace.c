@@ -0,0 +1,250 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * packet_trace.c
+ * Per packet binary trace capture, see packet_trace.h for the format
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "packet_ring.h"
+#include "packet_trace.h"
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
+#ifdef HAVE_THREAD_DEBUG
+// needed for thread_debug
+#include "Thread.h"
+#endif
+
+#define PACKETTRACE_PAGESIZE 4096
+#define PACKETTRACE_USECS(tv) (((int64_t) (tv).tv_sec * 1000000) + (tv).tv_usec)
+
+size_t packet_trace_blockbytes (uint32_t blocksize) {
+    size_t bytes = sizeof(struct packet_trace_block) + ((size_t) blocksize * PACKETTRACE_RECORDSIZE);
+    // keep blocks page aligned within the file
+    return ((bytes + PACKETTRACE_PAGESIZE - 1) / PACKETTRACE_PAGESIZE) * PACKETTRACE_PAGESIZE;
+}
+
+static inline void packet_trace_setblock (struct PacketTrace *trace, uint32_t blockix) {
+    uint32_t n = trace->hdr->blocksize;
+    trace->blockix = blockix;
+    trace->block = (struct packet_trace_block *) (trace->map + trace->hdr->hdrsize + (blockix * trace->hdr->blockbytes));
+    trace->packetID = PACKETTRACE_PACKETID(trace->block, n);
+    trace->sentTime = PACKETTRACE_SENTTIME(trace->block, n);
+    trace->packetTime = PACKETTRACE_PACKETTIME(trace->block, n);
+    trace->frameID = PACKETTRACE_FRAMEID(trace->block, n);
+    trace->length = PACKETTRACE_LENGTH(trace->block, n);
+    trace->l2errors = PACKETTRACE_L2ERRORS(trace->block, n);
+    // Invalidate the block before reuse so a reader never mixes old and new records
+    trace->block->seqno = 0;
+    trace->block->count = 0;
+    trace->block->firstTime = 0;
+    trace->block->lastTime = 0;
+    trace->count = 0;
+    trace->block->seqno = ++trace->hdr->seqno;
+}
+
+struct PacketTrace *packet_trace_open (const char *filename, size_t filesize, int transferID, uint32_t flags) {
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    size_t blockbytes = packet_trace_blockbytes(PACKETTRACE_BLOCKSIZE);
+    size_t blockcnt = (filesize > PACKETTRACE_HDRSIZE) ? ((filesize - PACKETTRACE_HDRSIZE) / blockbytes) : 0;
+    if (blockcnt < 2)
+	blockcnt = 2;
+    struct PacketTrace *trace = (struct PacketTrace *) calloc(1, sizeof(struct PacketTrace));
+    if (!trace) {
+	fprintf(stderr, "WARN: no memory for packet trace %s\n", filename);
+	return NULL;
+    }
+    trace->mapsize = PACKETTRACE_HDRSIZE + (blockcnt * blockbytes);
+    trace->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (trace->fd < 0) {
+	fprintf(stderr, "WARN: failed to open packet trace file %s: %s\n", filename, strerror(errno));
+	free(trace);
+	return NULL;
+    }
+    // Preallocate the whole file up front, the capture path never extends it
+    if (ftruncate(trace->fd, (off_t) trace->mapsize) < 0) {
+	fprintf(stderr, "WARN: failed to size packet trace file %s to %zu bytes: %s\n", filename, trace->mapsize, strerror(errno));
+	close(trace->fd);
+	free(trace);
+	return NULL;
+    }
+    int mapflags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // prefault the pages now rather than in the traffic thread
+    mapflags |= MAP_POPULATE;
+#endif
+    trace->map = (char *) mmap(NULL, trace->mapsize, PROT_READ | PROT_WRITE, mapflags, trace->fd, 0);
+    if (trace->map == MAP_FAILED) {
+	fprintf(stderr, "WARN: failed to map packet trace file %s: %s\n", filename, strerror(errno));
+	close(trace->fd);
+	free(trace);
+	return NULL;
+    }
+    trace->hdr = (struct packet_trace_hdr *) trace->map;
+    trace->hdr->magic = PACKETTRACE_MAGIC;
+    trace->hdr->version = PACKETTRACE_VERSION;
+    trace->hdr->hdrsize = PACKETTRACE_HDRSIZE;
+    trace->hdr->blocksize = PACKETTRACE_BLOCKSIZE;
+    trace->hdr->blockcnt = (uint32_t) blockcnt;
+    trace->hdr->blockbytes = blockbytes;
+    trace->hdr->transferID = transferID;
+    trace->hdr->flags = flags;
+    trace->hdr->startTime = 0;
+    trace->hdr->seqno = 0;
+    packet_trace_setblock(trace, 0);
+#ifdef HAVE_THREAD_DEBUG
+    thread_debug("Packet trace %s opened with %d blocks of %d records (%d bytes)", filename, (int) blockcnt, PACKETTRACE_BLOCKSIZE, (int) trace->mapsize);
+#endif
+    return trace;
+#else
+    fprintf(stderr, "WARN: --trace-file not supported on this platform\n");
+    return NULL;
+#endif
+}
+
+// Called by the traffic thread per packet, keep this fast, i.e. no syscalls
+void packet_trace_insert (struct PacketTrace *trace, struct ReportStruct *packet) {
+    if (trace->count == trace->hdr->blocksize) {
+	// rotate in place, the oldest block gets overwritten
+	packet_trace_setblock(trace, ((trace->blockix + 1) < trace->hdr->blockcnt) ? (trace->blockix + 1) : 0);
+    }
+    uint32_t ix = trace->count;
+    int64_t packetTime = PACKETTRACE_USECS(packet->packetTime);
+    trace->packetID[ix] = packet->packetID;
+    trace->sentTime[ix] = PACKETTRACE_USECS(packet->sentTime);
+    trace->packetTime[ix] = packetTime;
+    trace->frameID[ix] = packet->frameID;
+    trace->length[ix] = (int32_t) packet->packetLen;
+    trace->l2errors[ix] = packet->l2errors;
+    if (!ix) {
+	trace->block->firstTime = packetTime;
+	if (!trace->hdr->startTime)
+	    trace->hdr->startTime = packetTime;
+    }
+    trace->block->lastTime = packetTime;
+    trace->count = ++ix;
+    trace->block->count = ix;
+}
+
+void packet_trace_close (struct PacketTrace *trace) {
+    if (trace) {
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+	if (trace->map && (trace->map != MAP_FAILED))
+	    munmap(trace->map, trace->mapsize);
+#endif
+	if (trace->fd >= 0)
+	    close(trace->fd);
+	free(trace);
+    }
+}
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+static int packet_trace_seqno_cmp (const void *a, const void *b) {
+    uint64_t seqa = (*(struct packet_trace_block * const *) a)->seqno;
+    uint64_t seqb = (*(struct packet_trace_block * const *) b)->seqno;
+    return ((seqa > seqb) - (seqa < seqb));
+}
+#endif
+
+struct PacketTraceReader *packet_trace_reader_open (const char *filename) {
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    struct stat st;
+    struct PacketTraceReader *reader = (struct PacketTraceReader *) calloc(1, sizeof(struct PacketTraceReader));
+    if (!reader)
+	return NULL;
+    reader->fd = open(filename, O_RDONLY);
+    if ((reader->fd < 0) || (fstat(reader->fd, &st) < 0) || (st.st_size < PACKETTRACE_HDRSIZE)) {
+	fprintf(stderr, "ERROR: unable to read trace file %s\n", filename);
+	packet_trace_reader_close(reader);
+	return NULL;
+    }
+    reader->mapsize = (size_t) st.st_size;
+    reader->map = (char *) mmap(NULL, reader->mapsize, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (reader->map == MAP_FAILED) {
+	reader->map = NULL;
+	fprintf(stderr, "ERROR: unable to map trace file %s: %s\n", filename, strerror(errno));
+	packet_trace_reader_close(reader);
+	return NULL;
+    }
+    reader->hdr = (struct packet_trace_hdr *) reader->map;
+    if ((reader->hdr->magic != PACKETTRACE_MAGIC) || (reader->hdr->version != PACKETTRACE_VERSION) || \
+	(reader->hdr->blockbytes != packet_trace_blockbytes(reader->hdr->blocksize)) || \
+	((reader->hdr->hdrsize + ((size_t) reader->hdr->blockcnt * reader->hdr->blockbytes)) > reader->mapsize)) {
+	fprintf(stderr, "ERROR: %s is not a valid trace file\n", filename);
+	packet_trace_reader_close(reader);
+	return NULL;
+    }
+    reader->blocks = (struct packet_trace_block **) calloc(reader->hdr->blockcnt, sizeof(struct packet_trace_block *));
+    if (!reader->blocks) {
+	packet_trace_reader_close(reader);
+	return NULL;
+    }
+    uint32_t ix;
+    for (ix = 0; ix < reader->hdr->blockcnt; ix++) {
+	struct packet_trace_block *blk = (struct packet_trace_block *) (reader->map + reader->hdr->hdrsize + (ix * reader->hdr->blockbytes));
+	if (blk->seqno && blk->count && (blk->count <= reader->hdr->blocksize)) {
+	    reader->blocks[reader->blockcnt++] = blk;
+	    reader->records += blk->count;
+	}
+    }
+    qsort(reader->blocks, reader->blockcnt, sizeof(struct packet_trace_block *), packet_trace_seqno_cmp);
+    return reader;
+#else
+    fprintf(stderr, "ERROR: trace files not supported on this platform\n");
+    return NULL;
+#endif
+}
+
+void packet_trace_reader_close (struct PacketTraceReader *reader) {
+    if (reader) {
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+	if (reader->map)
+	    munmap(reader->map, reader->mapsize);
+#endif
+	if (reader->fd >= 0)
+	    close(reader->fd);
+	if (reader->blocks)
+	    free(reader->blocks);
+	free(reader);
+    }
+}
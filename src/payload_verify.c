@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2021
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * payload_verify.c
+ * The test pattern for --payload-verify, see payload_verify.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "payload_verify.h"
+
+/*
+ * Return the pattern extended out to PAYLOADVERIFY_PERIOD + maxlen
+ * bytes, the words are splitmix64 of the seed stored a byte at a time
+ * so both peers build the same pattern regardless of byte order
+ */
+char *payload_verify_pattern (int maxlen) {
+    int len = PAYLOADVERIFY_PERIOD + ((maxlen > 0) ? maxlen : 0);
+    char *pattern = (char *) malloc(len);
+    if (pattern) {
+	uint64_t state = PAYLOADVERIFY_SEED;
+	int ix, jx;
+	for (ix = 0; ix < PAYLOADVERIFY_PERIOD; ix += 8) {
+	    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	    z ^= (z >> 31);
+	    for (jx = 0; jx < 8; jx++) {
+		pattern[ix + jx] = (char) (z >> (56 - (8 * jx)));
+	    }
+	}
+	for (ix = PAYLOADVERIFY_PERIOD; ix < len; ix += PAYLOADVERIFY_PERIOD) {
+	    memcpy(pattern + ix, pattern, (((len - ix) < PAYLOADVERIFY_PERIOD) ? (len - ix) : PAYLOADVERIFY_PERIOD));
+	}
+    }
+    return pattern;
+}
+
+void payload_verify_free (char *pattern) {
+    if (pattern)
+	free(pattern);
+}
@@ -57,6 +57,7 @@
 #include <time.h>
 #include <math.h>
 #include "headers.h"
+#include "util.h"
 #include "pdfs.h"
 
 #define FALSE 0
@@ -98,3 +99,168 @@ float lognormal(float mu, float sigma) {
     float sigma_prime = sqrtf(logf((phi * phi)/(mu * mu)));
     return (expf(normal(mu_prime,sigma_prime)));
 }
+
+// uniform on (0,1), i.e. safe for a log()
+static double uniform (void) {
+    return ((double) rand() + 1.0) / ((double) RAND_MAX + 2.0);
+}
+
+struct pdf_sampler *pdf_sampler_init (enum pdf_kind kind, double mean, double sigma) {
+    struct pdf_sampler *pdf = (struct pdf_sampler *) calloc(1, sizeof(struct pdf_sampler));
+    if (pdf) {
+	pdf->kind = kind;
+	pdf->mean = mean;
+	pdf->sigma = sigma;
+    }
+    return pdf;
+}
+
+/*
+ * Load an empirical distribution, one <value> <cumulative probability>
+ * pair per line with both nondecreasing, '#' starts a comment.  The
+ * probabilities may also be given as percents.  The mean is that of
+ * the piecewise linear CDF.
+ */
+struct pdf_sampler *pdf_sampler_load (const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+	fprintf(stderr, "pdf: unable to open %s\n", filename);
+	return NULL;
+    }
+    struct pdf_sampler *pdf = pdf_sampler_init(PDF_EMPIRICAL, 0, 0);
+    int size = 0;
+    int lineno = 0;
+    int ok = (pdf != NULL);
+    char line[256];
+    while (ok && fgets(line, sizeof(line), fp)) {
+	double value, prob;
+	lineno++;
+	char *comment = strchr(line, '#');
+	if (comment)
+	    *comment = '\0';
+	int n = sscanf(line, "%lf %lf", &value, &prob);
+	if (n <= 0)
+	    continue;
+	if ((n != 2) || (value < 0) || (prob < 0) || \
+	    (pdf->points && ((value < pdf->values[pdf->points - 1]) || (prob < pdf->cdf[pdf->points - 1])))) {
+	    fprintf(stderr, "pdf: %s line %d isn't a nondecreasing <value> <cdf> pair\n", filename, lineno);
+	    ok = 0;
+	    break;
+	}
+	if (pdf->points == size) {
+	    size = size ? (2 * size) : 64;
+	    double *values = (double *) realloc(pdf->values, size * sizeof(double));
+	    if (values)
+		pdf->values = values;
+	    double *cdf = (double *) realloc(pdf->cdf, size * sizeof(double));
+	    if (cdf)
+		pdf->cdf = cdf;
+	    if (!values || !cdf) {
+		ok = 0;
+		break;
+	    }
+	}
+	pdf->values[pdf->points] = value;
+	pdf->cdf[pdf->points] = prob;
+	pdf->points++;
+    }
+    fclose(fp);
+    if (ok) {
+	double last = pdf->points ? pdf->cdf[pdf->points - 1] : 0;
+	if (!(((last >= 0.999) && (last <= 1.001)) || ((last >= 99.9) && (last <= 100.1)))) {
+	    fprintf(stderr, "pdf: %s must end at a cumulative probability of 1 (or 100 percent)\n", filename);
+	    ok = 0;
+	}
+    }
+    if (!ok) {
+	pdf_sampler_free(pdf);
+	return NULL;
+    }
+    double scale = pdf->cdf[pdf->points - 1];
+    double prev = 0;
+    for (int ix = 0; ix < pdf->points; ix++) {
+	pdf->cdf[ix] /= scale;
+	// the mass of a step is spread evenly between its values
+	if (ix)
+	    pdf->mean += (pdf->cdf[ix] - prev) * (pdf->values[ix - 1] + pdf->values[ix]) / 2;
+	else
+	    pdf->mean += pdf->cdf[ix] * pdf->values[ix];
+	prev = pdf->cdf[ix];
+    }
+    return pdf;
+}
+
+/*
+ * Parse a distribution, either a CDF file name or
+ * constant:<value>, exponential:<mean>, normal:<mean>,<sigma> or
+ * lognormal:<mean>,<sigma> with values per byte_atoi, e.g. 64K
+ */
+struct pdf_sampler *pdf_sampler_parse (const char *spec) {
+    static const struct {
+	const char *name;
+	enum pdf_kind kind;
+	int params;
+    } kinds[] = {
+	{"constant:", PDF_CONSTANT, 1},
+	{"exponential:", PDF_EXPONENTIAL, 1},
+	{"normal:", PDF_NORMAL, 2},
+	{"lognormal:", PDF_LOGNORMAL, 2}
+    };
+    for (unsigned int ix = 0; ix < (sizeof(kinds) / sizeof(kinds[0])); ix++) {
+	size_t len = strlen(kinds[ix].name);
+	if (strncmp(spec, kinds[ix].name, len) == 0) {
+	    const char *params = spec + len;
+	    const char *sigma = strchr(params, ',');
+	    double mean = (double) byte_atoi(params);
+	    if ((mean <= 0) || ((kinds[ix].params == 2) && !sigma)) {
+		fprintf(stderr, "pdf: %s needs %s\n", spec, ((kinds[ix].params == 2) ? "<mean>,<sigma>" : "a value > 0"));
+		return NULL;
+	    }
+	    return pdf_sampler_init(kinds[ix].kind, mean, ((kinds[ix].params == 2) ? (double) byte_atoi(sigma + 1) : 0));
+	}
+    }
+    return pdf_sampler_load(spec);
+}
+
+double pdf_sample (struct pdf_sampler *pdf) {
+    switch (pdf->kind) {
+    case PDF_NORMAL:
+	return normal(pdf->mean, pdf->sigma);
+    case PDF_LOGNORMAL:
+	return lognormal(pdf->mean, pdf->sigma);
+    case PDF_EXPONENTIAL:
+	return -pdf->mean * log(uniform());
+    case PDF_EMPIRICAL:
+    {
+	double u = uniform();
+	int lo = 0;
+	int hi = pdf->points - 1;
+	// the first point at or above u
+	while (lo < hi) {
+	    int mid = (lo + hi) / 2;
+	    if (pdf->cdf[mid] < u)
+		lo = mid + 1;
+	    else
+		hi = mid;
+	}
+	if (!lo || (pdf->cdf[lo] <= pdf->cdf[lo - 1]))
+	    return pdf->values[lo];
+	return pdf->values[lo - 1] + (u - pdf->cdf[lo - 1]) / (pdf->cdf[lo] - pdf->cdf[lo - 1]) * (pdf->values[lo] - pdf->values[lo - 1]);
+    }
+    case PDF_CONSTANT:
+    default:
+	return pdf->mean;
+    }
+}
+
+double pdf_sampler_mean (struct pdf_sampler *pdf) {
+    return pdf->mean;
+}
+
+void pdf_sampler_free (struct pdf_sampler *pdf) {
+    if (pdf) {
+	free(pdf->values);
+	free(pdf->cdf);
+	free(pdf);
+    }
+}
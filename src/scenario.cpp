@@ -0,0 +1,227 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * scenario.cpp
+ * Scenario file parsing and the flow groups of --scenario, see scenario.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "scenario.h"
+#include "Reporter.h"
+#include "gnu_getopt.h"
+#include "util.h"
+
+static char *scenario_trim (char *str) {
+    while (isspace(static_cast<unsigned char>(*str)))
+	str++;
+    char *end = str + strlen(str);
+    while ((end > str) && isspace(static_cast<unsigned char>(*(end - 1))))
+	end--;
+    *end = '\0';
+    return str;
+}
+
+static char *scenario_strdup (const char *str) {
+    char *copy = new char[strlen(str) + 1];
+    strcpy(copy, str);
+    return copy;
+}
+
+/*
+ * Read the groups of a scenario file, returns the number of groups
+ * or -1 on an error (which is printed)
+ */
+int scenario_load (const char *filename, struct ScenarioGroup **groups) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+	fprintf(stderr, "ERROR: scenario file %s: %s\n", filename, strerror(errno));
+	return -1;
+    }
+    char line[SCENARIO_LINEMAX];
+    struct ScenarioGroup *group = NULL;
+    struct ScenarioGroup **tail = groups;
+    int lineno = 0;
+    int count = 0;
+    *groups = NULL;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	lineno++;
+	char *str = scenario_trim(line);
+	if ((*str == '\0') || (*str == '#') || (*str == ';'))
+	    continue;
+	if (*str == '[') {
+	    char *end = strchr(str, ']');
+	    if ((end == NULL) || (end == (str + 1))) {
+		fprintf(stderr, "ERROR: scenario file %s line %d: expected a [name] of a group\n", filename, lineno);
+		count = -1;
+		break;
+	    }
+	    *end = '\0';
+	    group = new ScenarioGroup();
+	    group->name = scenario_strdup(scenario_trim(str + 1));
+	    Mutex_Initialize(&group->lock);
+	    Condition_Initialize(&group->connects_done.await);
+	    *tail = group;
+	    tail = &group->next;
+	    count++;
+	    continue;
+	}
+	char *value = strchr(str, '=');
+	if ((group == NULL) || (value == NULL)) {
+	    fprintf(stderr, "ERROR: scenario file %s line %d: expected a [name] of a group or a <key> = <value>\n", filename, lineno);
+	    count = -1;
+	    break;
+	}
+	*value++ = '\0';
+	char *key = scenario_trim(str);
+	value = scenario_trim(value);
+	if (strcmp(key, "options") == 0) {
+	    DELETE_ARRAY(group->options);
+	    group->options = scenario_strdup(value);
+	} else if (strcmp(key, "start") == 0) {
+	    group->start = atof(value);
+	} else if (strcmp(key, "duration") == 0) {
+	    group->duration = atof(value);
+	} else {
+	    fprintf(stderr, "ERROR: scenario file %s line %d: unknown key %s, expected options, start or duration\n", filename, lineno, key);
+	    count = -1;
+	    break;
+	}
+	if ((group->start < 0) || (group->duration < 0)) {
+	    fprintf(stderr, "ERROR: scenario file %s line %d: start and duration can't be negative\n", filename, lineno);
+	    count = -1;
+	    break;
+	}
+    }
+    fclose(fp);
+    if (count == 0) {
+	fprintf(stderr, "ERROR: scenario file %s has no groups\n", filename);
+	count = -1;
+    }
+    return count;
+}
+
+// Split the options of a group in place into argv style tokens, double quotes group a token
+static int scenario_tokenize (char *options, char **tokens) {
+    int count = 0;
+    char *str = options;
+    while (*str != '\0') {
+	while (isspace(static_cast<unsigned char>(*str)))
+	    str++;
+	if (*str == '\0')
+	    break;
+	char *token = str;
+	char *end = str;
+	bool quoted = false;
+	while ((*str != '\0') && (quoted || !isspace(static_cast<unsigned char>(*str)))) {
+	    if (*str == '"') {
+		quoted = !quoted;
+	    } else {
+		*end++ = *str;
+	    }
+	    str++;
+	}
+	if (*str != '\0')
+	    str++;
+	*end = '\0';
+	tokens[count++] = token;
+    }
+    return count;
+}
+
+/*
+ * The settings of a group are parsed from scratch with the options of the
+ * group appended to the command line, i.e. the compound settings of
+ * Settings_ModalOptions apply to the group as a whole
+ */
+struct thread_Settings *scenario_group_settings (struct ScenarioGroup *group, int argc, char **argv) {
+    char *options = scenario_strdup(group->options ? group->options : "");
+    char **gargv = new char *[argc + strlen(options) + 3];
+    char duration[32];
+    char durationopt[] = "-t";
+    int gargc = 0;
+    for (int ix = 0; ix < argc; ix++) {
+	gargv[gargc++] = argv[ix];
+    }
+    gargc += scenario_tokenize(options, &gargv[gargc]);
+    if (group->duration > 0) {
+	snprintf(duration, sizeof(duration), "%f", group->duration);
+	gargv[gargc++] = durationopt;
+	gargv[gargc++] = duration;
+    }
+    gargv[gargc] = NULL;
+    struct thread_Settings *settings = new thread_Settings;
+    Settings_Initialize(settings);
+    Settings_ParseEnvironment(settings);
+    gnu_optind = 0; // restart the option scan
+    Settings_ParseCommandLine(gargc, gargv, settings);
+    DELETE_ARRAY(gargv);
+    DELETE_ARRAY(options);
+    if (settings->mThreadMode != kMode_Client) {
+	fprintf(stderr, "ERROR: the options of scenario group %s must be client options\n", group->name);
+	exit(1);
+    }
+    unsetScenario(settings);
+    settings->mScenarioGroup = group;
+    return settings;
+}
+
+// A traffic thread of a group is done, the last one releases the group sum
+void scenario_group_remove (struct thread_Settings *thread) {
+    struct ScenarioGroup *group = thread->mScenarioGroup;
+    assert(group != NULL);
+    Mutex_Lock(&group->lock);
+    int last = (--group->threads == 0);
+    Mutex_Unlock(&group->lock);
+    if (last && group->sum_report)
+	ReleaseSumReport(group->sum_report);
+}
+
+void scenario_free (struct ScenarioGroup *groups) {
+    while (groups != NULL) {
+	struct ScenarioGroup *next = groups->next;
+	Mutex_Destroy(&groups->lock);
+	Condition_Destroy(&groups->connects_done.await);
+	DELETE_ARRAY(groups->name);
+	DELETE_ARRAY(groups->options);
+	delete groups;
+	groups = next;
+    }
+}
@@ -116,6 +116,48 @@ int getsock_tcp_mss  (int inSock) {
     return theMSS;
 } /* end getsock_tcp_mss */
 
+/* -------------------------------------------------------------------
+ * Returns 1 if the data sent (or received) in the SYN was acked, i.e.
+ * the connection used TCP fast open, 0 if not, -1 if unknown
+ * ------------------------------------------------------------------- */
+int getsock_tcp_fastopen (int inSock) {
+    int tfo = -1;
+#if defined(HAVE_STRUCT_TCP_INFO_TCPI_TOTAL_RETRANS) && defined(TCPI_OPT_SYN_DATA)
+    struct tcp_info tcp_info_buf;
+    Socklen_t len = sizeof(tcp_info_buf);
+    assert(inSock >= 0);
+    if (getsockopt(inSock, IPPROTO_TCP, TCP_INFO, (char *)&tcp_info_buf, &len) == 0) {
+	tfo = ((tcp_info_buf.tcpi_options & TCPI_OPT_SYN_DATA) != 0);
+    }
+#endif
+    return tfo;
+} /* end getsock_tcp_fastopen */
+
+/* -------------------------------------------------------------------
+ * Return the cpu that last received for the socket, i.e. the cpu of
+ * its RX queue per RSS/RPS, or -1 when unknown. The NAPI id, which
+ * names that queue, is set when available, zero otherwise
+ * ------------------------------------------------------------------- */
+int getsock_incoming_cpu (int inSock, unsigned int *napi_id) {
+    int cpu = -1;
+    *napi_id = 0;
+#if defined(SO_INCOMING_CPU)
+    Socklen_t len = sizeof(cpu);
+    assert(inSock >= 0);
+    if (getsockopt(inSock, SOL_SOCKET, SO_INCOMING_CPU, (char *)&cpu, &len) < 0) {
+	cpu = -1;
+    }
+#endif
+#if defined(SO_INCOMING_NAPI_ID)
+    unsigned int id = 0;
+    Socklen_t idlen = sizeof(id);
+    if (getsockopt(inSock, SOL_SOCKET, SO_INCOMING_NAPI_ID, (char *)&id, &idlen) == 0) {
+	*napi_id = id;
+    }
+#endif
+    return cpu;
+} /* end getsock_incoming_cpu */
+
 /* -------------------------------------------------------------------
  * Attempts to reads n bytes from a socket.
  * Returns number actually read, or -1 on error.
@@ -0,0 +1,756 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * traceanalyze.c
+ * Offline, multi-threaded analysis of --trace-file captures
+ *
+ * The per packet math is that of the server's live reporter, i.e.
+ * reporter_handle_packet_server_udp() and
+ * reporter_handle_packet_oneway_transit(), so a trace re-sliced with
+ * the same interval gives the live interval reports.  Intervals can be
+ * any size, e.g. -i 0.001, and are computed from the capture only.
+ *
+ * The work is split in phases over chunks of the (block ordered)
+ * record sequence:
+ *
+ *   1) parallel: transit kernel and raw interval bins per record
+ *   2) parallel: bins are made non-decreasing (a late packet stays in
+ *      the current interval, as it does live) then chunks are re-cut
+ *      on interval boundaries
+ *   3) parallel: per interval accounting, loss runs, reorder distance
+ *      and interval percentiles (each interval lives in one chunk.)
+ *      With -f the interval transit stats use the vectorized batch
+ *      kernel (transit_kernel.h) rather than the per packet recurrence
+ *   4) serial:   the RFC 1889 jitter and the total Welford recurrences
+ *   5) parallel: sort of the transits for the total percentiles
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "util.h"
+#include "packet_trace.h"
+#include "transit_kernel.h"
+#include <math.h>
+
+#define ANALYZE_MAXTHREADS 64
+#define ANALYZE_MAXPCTS 8
+#define ANALYZE_RUNBINS 16
+
+struct analyze_interval {
+    intmax_t records;
+    intmax_t bytes;
+    intmax_t lost;
+    intmax_t outoforder;
+    intmax_t l2errors;
+    int64_t maxID; // largest packet id at the interval end
+    int64_t lastTime;
+    intmax_t cntTransit;
+    double minTransit;
+    double maxTransit;
+    double sumTransit;
+    double meanTransit;
+    double m2Transit;
+    double jitter;
+    double pct[ANALYZE_MAXPCTS];
+};
+
+struct analyze_chunk {
+    struct analyze *an;
+    uint64_t lo;
+    uint64_t hi;
+    uint32_t maxbin;
+    uint32_t seedbin;
+    int64_t maxID;
+    int64_t seedID;
+    intmax_t lossruns[ANALYZE_RUNBINS];
+    intmax_t reorder[ANALYZE_RUNBINS + 1]; // [0] is duplicates
+    intmax_t maxlossrun;
+    intmax_t maxreorder;
+    uint64_t sorted; // valid transits sorted to the front of the chunk
+};
+
+struct analyze {
+    struct PacketTraceReader *reader;
+    const char *filename;
+    uint32_t n; // records per block
+    uint64_t records;
+    int udp;
+    int server;
+    int64_t start; // usecs
+    int64_t interval; // usecs, zero for totals only
+    int threads;
+    int pctcnt;
+    int batch; // use the (vector) batch kernel for the interval stats
+    double pcts[ANALYZE_MAXPCTS];
+    double *transit; // NAN if the record has no transit
+    uint32_t *bin;
+    uint32_t bincnt;
+    uint64_t firstTransit; // index of the very first transit sample
+    int64_t seedID;
+    struct analyze_interval *intervals;
+    struct analyze_chunk chunks[ANALYZE_MAXTHREADS];
+};
+
+// Records [ix, ix + len) which are contiguous in one block, blocks other than the newest are full
+static inline uint64_t analyze_segment (struct analyze *an, uint64_t ix, uint64_t hi, struct packet_trace_block **blk, uint64_t *offset) {
+    uint64_t len;
+    *blk = an->reader->blocks[ix / an->n];
+    *offset = ix % an->n;
+    len = an->n - *offset;
+    return (((hi - ix) < len) ? (hi - ix) : len);
+}
+
+static void usage (void) {
+    fprintf(stderr, "Usage: traceanalyze [-f] [-i secs] [-t threads] [-p pct[,pct...]] [-s start] <tracefile> [<tracefile> ...]\n"
+	    "  -f           fast interval stats using the batch kernel (sum/mean/stdev within 1e-9 relative)\n"
+	    "  -i secs      interval reports every secs seconds (default totals only)\n"
+	    "  -t threads   worker threads (default online cpus)\n"
+	    "  -p pcts      one way delay percentiles (default 50,90,99)\n"
+	    "  -s start     start time as epoch secs, e.g. from a live report (default first packet)\n");
+}
+
+static void analyze_parallel (struct analyze *an, void *(*fn)(void *)) {
+    int ix;
+#ifdef HAVE_POSIX_THREAD
+    pthread_t tids[ANALYZE_MAXTHREADS];
+    for (ix = 0; ix < an->threads; ix++) {
+	if (pthread_create(&tids[ix], NULL, fn, &an->chunks[ix]) != 0) {
+	    fn(&an->chunks[ix]);
+	    tids[ix] = pthread_self();
+	}
+    }
+    for (ix = 0; ix < an->threads; ix++) {
+	if (!pthread_equal(tids[ix], pthread_self()))
+	    pthread_join(tids[ix], NULL);
+    }
+#else
+    for (ix = 0; ix < an->threads; ix++)
+	fn(&an->chunks[ix]);
+#endif
+}
+
+static inline uint32_t analyze_log2bin (intmax_t value) {
+    uint32_t bin = 0;
+    while ((value >>= 1) && (bin < (ANALYZE_RUNBINS - 1)))
+	bin++;
+    return bin;
+}
+
+// Transit kernel, the same double math as TimeDifference() on the timevals
+static void analyze_transit_kernel (const int64_t *packetTime, const int64_t *sentTime, double *transit, uint64_t len) {
+    uint64_t ix;
+    for (ix = 0; ix < len; ix++) {
+	transit[ix] = (double) (packetTime[ix] / rMillion - sentTime[ix] / rMillion) + \
+	    (packetTime[ix] % rMillion - sentTime[ix] % rMillion) / ((double) rMillion);
+    }
+}
+
+// Phase 1: transits and raw bins
+static void *analyze_phase1 (void *arg) {
+    struct analyze_chunk *chunk = (struct analyze_chunk *) arg;
+    struct analyze *an = chunk->an;
+    struct packet_trace_block *blk;
+    uint64_t i, j, len;
+    chunk->maxbin = 0;
+    for (i = chunk->lo; i < chunk->hi; i += len) {
+	len = analyze_segment(an, i, chunk->hi, &blk, &j);
+	int64_t *packetID = PACKETTRACE_PACKETID(blk, an->n) + j;
+	int64_t *packetTime = PACKETTRACE_PACKETTIME(blk, an->n) + j;
+	double *transit = an->transit + i;
+	uint64_t k;
+	if (an->server) {
+	    analyze_transit_kernel(packetTime, PACKETTRACE_SENTTIME(blk, an->n) + j, transit, len);
+	}
+	for (k = 0; k < len; k++) {
+	    uint32_t bin = 0;
+	    if (an->interval && (packetTime[k] > an->start))
+		bin = (uint32_t) ((packetTime[k] - an->start - 1) / an->interval);
+	    an->bin[i + k] = bin;
+	    if (bin > chunk->maxbin)
+		chunk->maxbin = bin;
+	    // only valid datagrams are accounted by the server
+	    if (!an->server || (an->udp && (packetID[k] <= 0)))
+		transit[k] = NAN;
+	}
+    }
+    return NULL;
+}
+
+// Phase 2: a packet never goes back to an earlier interval, also find the largest packet id
+static void *analyze_phase2 (void *arg) {
+    struct analyze_chunk *chunk = (struct analyze_chunk *) arg;
+    struct analyze *an = chunk->an;
+    uint32_t running = chunk->seedbin;
+    uint64_t ix;
+    for (ix = chunk->lo; ix < chunk->hi; ix++) {
+	if (an->bin[ix] < running)
+	    an->bin[ix] = running;
+	else
+	    running = an->bin[ix];
+    }
+    return NULL;
+}
+
+static void *analyze_maxid (void *arg) {
+    struct analyze_chunk *chunk = (struct analyze_chunk *) arg;
+    struct analyze *an = chunk->an;
+    struct packet_trace_block *blk;
+    uint64_t i, j, len;
+    chunk->maxID = 0;
+    for (i = chunk->lo; i < chunk->hi; i += len) {
+	len = analyze_segment(an, i, chunk->hi, &blk, &j);
+	int64_t *packetID = PACKETTRACE_PACKETID(blk, an->n) + j;
+	uint64_t k;
+	for (k = 0; k < len; k++) {
+	    if (packetID[k] > chunk->maxID)
+		chunk->maxID = packetID[k];
+	}
+    }
+    return NULL;
+}
+
+static int analyze_cmp (const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return ((da > db) - (da < db));
+}
+
+static inline double analyze_rank (const double *sorted, uint64_t cnt, double pct) {
+    uint64_t rank = (uint64_t) ceil(pct / 100.0 * cnt);
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+// The interval's transits are complete
+static void analyze_interval_done (struct analyze *an, struct analyze_interval *iv, double *scratch, uint64_t cnt) {
+    int ix;
+    if (cnt && an->batch) {
+	struct transit_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	// the flow's first transit seeds m2, as reporter_handle_packet_oneway_transit()
+	stats.flowstart = (iv == &an->intervals[an->bin[an->firstTransit]]);
+	transit_kernel_batch(scratch, cnt, &stats);
+	iv->cntTransit = stats.cntTransit;
+	iv->minTransit = stats.minTransit;
+	iv->maxTransit = stats.maxTransit;
+	iv->sumTransit = stats.sumTransit;
+	iv->meanTransit = stats.meanTransit;
+	iv->m2Transit = stats.m2Transit;
+    }
+    if (cnt && an->pctcnt) {
+	qsort(scratch, cnt, sizeof(double), analyze_cmp);
+	for (ix = 0; ix < an->pctcnt; ix++)
+	    iv->pct[ix] = analyze_rank(scratch, cnt, an->pcts[ix]);
+    }
+}
+
+// Phase 3: per interval accounting, i.e. reporter_handle_packet_server_udp()
+static void *analyze_phase3 (void *arg) {
+    struct analyze_chunk *chunk = (struct analyze_chunk *) arg;
+    struct analyze *an = chunk->an;
+    struct packet_trace_block *blk;
+    uint64_t i, j, len;
+    int64_t maxID = chunk->seedID;
+    uint64_t scratchsize = 1024, scratchcnt = 0;
+    double *scratch = (double *) malloc(scratchsize * sizeof(double));
+    struct analyze_interval *iv = NULL;
+    if (!scratch) {
+	fprintf(stderr, "Out of Memory!!\n");
+	exit(1);
+    }
+    for (i = chunk->lo; i < chunk->hi; i += len) {
+	len = analyze_segment(an, i, chunk->hi, &blk, &j);
+	int64_t *packetID = PACKETTRACE_PACKETID(blk, an->n) + j;
+	int64_t *packetTime = PACKETTRACE_PACKETTIME(blk, an->n) + j;
+	int32_t *length = PACKETTRACE_LENGTH(blk, an->n) + j;
+	int32_t *l2errors = PACKETTRACE_L2ERRORS(blk, an->n) + j;
+	uint64_t k;
+	for (k = 0; k < len; k++) {
+	    struct analyze_interval *next = &an->intervals[an->bin[i + k]];
+	    if (next != iv) {
+		if (iv)
+		    analyze_interval_done(an, iv, scratch, scratchcnt);
+		scratchcnt = 0;
+		iv = next;
+	    }
+	    iv->lastTime = packetTime[k];
+	    if (an->udp && (packetID[k] <= 0))
+		continue;
+	    iv->records++;
+	    iv->bytes += length[k];
+	    if (l2errors[k])
+		iv->l2errors++;
+	    if (an->udp) {
+		// packet loss occured if the datagram numbers aren't sequential
+		if (packetID[k] != maxID + 1) {
+		    if (packetID[k] < maxID + 1) {
+			intmax_t distance = maxID - packetID[k];
+			iv->outoforder++;
+			chunk->reorder[distance ? (analyze_log2bin(distance) + 1) : 0]++;
+			if (distance > chunk->maxreorder)
+			    chunk->maxreorder = distance;
+		    } else {
+			intmax_t run = packetID[k] - maxID - 1;
+			iv->lost += run;
+			chunk->lossruns[analyze_log2bin(run)]++;
+			if (run > chunk->maxlossrun)
+			    chunk->maxlossrun = run;
+		    }
+		}
+		// never decrease datagramID (e.g. if we get an out-of-order packet)
+		if (packetID[k] > maxID)
+		    maxID = packetID[k];
+		iv->maxID = maxID;
+	    }
+	    if (!isnan(an->transit[i + k])) {
+		// reporter_handle_packet_oneway_transit(), interval part
+		double transit = an->transit[i + k];
+		double usec_transit = transit * 1e6;
+		if (an->batch) {
+		    // done by the batch kernel once the interval completes
+		} else if ((i + k) == an->firstTransit) {
+		    iv->minTransit = transit;
+		    iv->maxTransit = transit;
+		    iv->sumTransit = transit;
+		    iv->cntTransit = 1;
+		    iv->meanTransit = usec_transit;
+		    iv->m2Transit = usec_transit * usec_transit;
+		} else {
+		    double vdTransit;
+		    if (!iv->cntTransit || (transit < iv->minTransit))
+			iv->minTransit = transit;
+		    if (!iv->cntTransit || (transit > iv->maxTransit))
+			iv->maxTransit = transit;
+		    iv->sumTransit += transit;
+		    iv->cntTransit++;
+		    vdTransit = usec_transit - iv->meanTransit;
+		    iv->meanTransit = iv->meanTransit + (vdTransit / iv->cntTransit);
+		    iv->m2Transit = iv->m2Transit + (vdTransit * (usec_transit - iv->meanTransit));
+		}
+		if (an->pctcnt || an->batch) {
+		    if (scratchcnt == scratchsize) {
+			scratchsize *= 2;
+			if ((scratch = (double *) realloc(scratch, scratchsize * sizeof(double))) == NULL) {
+			    fprintf(stderr, "Out of Memory!!\n");
+			    exit(1);
+			}
+		    }
+		    scratch[scratchcnt++] = transit;
+		}
+	    }
+	}
+    }
+    if (iv)
+	analyze_interval_done(an, iv, scratch, scratchcnt);
+    free(scratch);
+    return NULL;
+}
+
+// Phase 4: the recurrences which are sequential by nature, done exactly as live
+static void analyze_phase4 (struct analyze *an, struct analyze_interval *total) {
+    double lastTransit = 0, jitter = 0;
+    uint64_t ix;
+    for (ix = 0; ix < an->records; ix++) {
+	double transit = an->transit[ix];
+	if (!isnan(transit)) {
+	    double usec_transit = transit * 1e6;
+	    if (ix == an->firstTransit) {
+		total->minTransit = transit;
+		total->maxTransit = transit;
+		total->sumTransit = transit;
+		total->cntTransit = 1;
+		total->meanTransit = usec_transit;
+		total->m2Transit = usec_transit * usec_transit;
+	    } else {
+		double vdTransit;
+		// from RFC 1889, Real Time Protocol (RTP)
+		// J = J + ( | D(i-1,i) | - J ) /
+		double deltaTransit = transit - lastTransit;
+		if (deltaTransit < 0.0) {
+		    deltaTransit = -deltaTransit;
+		}
+		jitter += (deltaTransit - jitter) / (16.0);
+		total->sumTransit += transit;
+		total->cntTransit++;
+		if (transit < total->minTransit)
+		    total->minTransit = transit;
+		if (transit > total->maxTransit)
+		    total->maxTransit = transit;
+		vdTransit = usec_transit - total->meanTransit;
+		total->meanTransit = total->meanTransit + (vdTransit / total->cntTransit);
+		total->m2Transit = total->m2Transit + (vdTransit * (usec_transit - total->meanTransit));
+	    }
+	    lastTransit = transit;
+	    an->intervals[an->bin[ix]].jitter = jitter;
+	}
+    }
+    total->jitter = jitter;
+}
+
+// Phase 5: sort the valid transits of each chunk in place
+static void *analyze_phase5 (void *arg) {
+    struct analyze_chunk *chunk = (struct analyze_chunk *) arg;
+    struct analyze *an = chunk->an;
+    double *transit = an->transit + chunk->lo;
+    uint64_t ix, cnt = 0;
+    for (ix = 0; ix < (chunk->hi - chunk->lo); ix++) {
+	if (!isnan(transit[ix]))
+	    transit[cnt++] = transit[ix];
+    }
+    qsort(transit, cnt, sizeof(double), analyze_cmp);
+    chunk->sorted = cnt;
+    return NULL;
+}
+
+// Count of sorted values <= value over all the chunks
+static uint64_t analyze_countle (struct analyze *an, double value) {
+    uint64_t cnt = 0;
+    int ix;
+    for (ix = 0; ix < an->threads; ix++) {
+	double *sorted = an->transit + an->chunks[ix].lo;
+	uint64_t lo = 0, hi = an->chunks[ix].sorted;
+	while (lo < hi) {
+	    uint64_t mid = lo + (hi - lo) / 2;
+	    if (sorted[mid] <= value)
+		lo = mid + 1;
+	    else
+		hi = mid;
+	}
+	cnt += lo;
+    }
+    return cnt;
+}
+
+// Map a double to an unsigned key with the same ordering
+static inline uint64_t analyze_key (double value) {
+    uint64_t key;
+    memcpy(&key, &value, sizeof(key));
+    return ((key & 0x8000000000000000ULL) ? ~key : (key | 0x8000000000000000ULL));
+}
+
+static inline double analyze_value (uint64_t key) {
+    double value;
+    key = ((key & 0x8000000000000000ULL) ? (key & ~0x8000000000000000ULL) : ~key);
+    memcpy(&value, &key, sizeof(value));
+    return value;
+}
+
+// rank-th smallest (1 based) over the sorted chunks, i.e. bisect the key space
+static double analyze_select (struct analyze *an, uint64_t rank, double min, double max) {
+    uint64_t lo = analyze_key(min), hi = analyze_key(max);
+    while (lo < hi) {
+	uint64_t mid = lo + (hi - lo) / 2;
+	if (analyze_countle(an, analyze_value(mid)) >= rank)
+	    hi = mid;
+	else
+	    lo = mid + 1;
+    }
+    return analyze_value(lo);
+}
+
+static void analyze_output (struct analyze *an, struct analyze_interval *iv, double iStart, double iEnd, intmax_t datagrams) {
+    char bytes[40], rate[40];
+    double duration = iEnd - iStart;
+    byte_snprintf(bytes, sizeof(bytes), (double) iv->bytes, 'A');
+    byte_snprintf(rate, sizeof(rate), (duration > 0) ? ((double) iv->bytes / duration) : 0.0, 'a');
+    fprintf(stdout, "[%3d] %6.4f-%6.4f sec  %ss  %ss/sec", an->reader->hdr->transferID, iStart, iEnd, bytes, rate);
+    if (an->udp && an->server) {
+	// assume most of the time out-of-order packets are duplicates
+	intmax_t lost = iv->lost - iv->outoforder;
+	if (lost < 0)
+	    lost = 0;
+	fprintf(stdout, " %6.3f ms %4jd/%5jd (%.2g%%)", iv->jitter * 1e3, lost, datagrams, \
+		(datagrams > 0) ? (100.0 * lost / datagrams) : 0.0);
+	if (iv->outoforder)
+	    fprintf(stdout, " %jd OOO", iv->outoforder);
+    }
+    if (iv->cntTransit) {
+	int ix;
+	fprintf(stdout, " %.3f/%.3f/%.3f/%.3f ms", (iv->sumTransit / iv->cntTransit) * 1e3, iv->minTransit * 1e3, iv->maxTransit * 1e3, \
+		(iv->cntTransit < 2) ? 0 : sqrt(iv->m2Transit / (iv->cntTransit - 1)) / 1e3);
+	for (ix = 0; ix < an->pctcnt; ix++)
+	    fprintf(stdout, "%s%.3f", ix ? "/" : " ", iv->pct[ix] * 1e3);
+	if (an->pctcnt)
+	    fprintf(stdout, " ms");
+    }
+    fprintf(stdout, " %.0f pps", (duration > 0) ? (iv->records / duration) : 0.0);
+    if (iv->l2errors)
+	fprintf(stdout, " %jd L2 errors", iv->l2errors);
+    fprintf(stdout, "\n");
+}
+
+static void analyze_runs_output (struct analyze *an, const char *name, intmax_t *bins, int dups, intmax_t max) {
+    int ix;
+    intmax_t cnt = 0;
+    for (ix = 0; ix < (ANALYZE_RUNBINS + dups); ix++)
+	cnt += bins[ix];
+    fprintf(stdout, "[%3d] %s count=%jd max=%jd", an->reader->hdr->transferID, name, cnt, max);
+    if (dups) {
+	fprintf(stdout, " dup:%jd", bins[0]);
+	bins++;
+    }
+    for (ix = 0; ix < ANALYZE_RUNBINS; ix++) {
+	if (!bins[ix])
+	    continue;
+	if (!ix)
+	    fprintf(stdout, " 1:%jd", bins[ix]);
+	else if (ix == (ANALYZE_RUNBINS - 1))
+	    fprintf(stdout, " %jd+:%jd", (intmax_t) 1 << ix, bins[ix]);
+	else
+	    fprintf(stdout, " %jd-%jd:%jd", (intmax_t) 1 << ix, ((intmax_t) 1 << (ix + 1)) - 1, bins[ix]);
+    }
+    fprintf(stdout, "\n");
+}
+
+static int analyze_file (struct analyze *an) {
+    struct analyze_interval total;
+    uint64_t ix, per;
+    int t, rc = 1;
+    if ((an->reader = packet_trace_reader_open(an->filename)) == NULL)
+	return 1;
+    an->n = an->reader->hdr->blocksize;
+    an->udp = (an->reader->hdr->flags & PACKETTRACE_UDP);
+    an->server = (an->reader->hdr->flags & PACKETTRACE_SERVER);
+    // Only the newest block can be partially filled
+    an->records = (an->reader->blockcnt ? (((uint64_t) (an->reader->blockcnt - 1) * an->n) + \
+					    an->reader->blocks[an->reader->blockcnt - 1]->count) : 0);
+    if (!an->records) {
+	fprintf(stdout, "%s: no records\n", an->filename);
+	packet_trace_reader_close(an->reader);
+	return 0;
+    }
+    if (!an->start)
+	an->start = an->reader->blocks[0]->firstTime;
+    an->transit = (double *) malloc(an->records * sizeof(double));
+    an->bin = (uint32_t *) malloc(an->records * sizeof(uint32_t));
+    if (!an->transit || !an->bin) {
+	fprintf(stderr, "Out of Memory!!\n");
+	goto out;
+    }
+    per = (an->records + an->threads - 1) / an->threads;
+    for (t = 0; t < an->threads; t++) {
+	memset(&an->chunks[t], 0, sizeof(struct analyze_chunk));
+	an->chunks[t].an = an;
+	an->chunks[t].lo = ((t * per) < an->records) ? (t * per) : an->records;
+	an->chunks[t].hi = (((t + 1) * per) < an->records) ? ((t + 1) * per) : an->records;
+    }
+    analyze_parallel(an, analyze_phase1);
+    an->bincnt = 0;
+    for (t = 0; t < an->threads; t++) {
+	an->chunks[t].seedbin = an->bincnt;
+	if (an->chunks[t].maxbin > an->bincnt)
+	    an->bincnt = an->chunks[t].maxbin;
+    }
+    an->bincnt++;
+    analyze_parallel(an, analyze_phase2);
+    // Re-cut the chunks on interval boundaries so an interval is owned by one thread
+    for (t = 1; t < an->threads; t++) {
+	uint64_t cut = an->chunks[t].lo;
+	if (cut < an->chunks[t - 1].lo)
+	    cut = an->chunks[t - 1].lo;
+	while ((cut > 0) && (cut < an->records) && (an->bin[cut] == an->bin[cut - 1]))
+	    cut++;
+	an->chunks[t - 1].hi = cut;
+	an->chunks[t].lo = cut;
+    }
+    an->chunks[an->threads - 1].hi = an->records;
+    an->firstTransit = an->records;
+    for (ix = 0; ix < an->records; ix++) {
+	if (!isnan(an->transit[ix])) {
+	    an->firstTransit = ix;
+	    break;
+	}
+    }
+    // A wrapped trace starts mid stream, don't count the overwritten packets as lost
+    an->seedID = 0;
+    if (an->udp && (an->reader->blocks[0]->seqno > 1)) {
+	struct packet_trace_block *blk = an->reader->blocks[0];
+	int64_t *packetID = PACKETTRACE_PACKETID(blk, an->n);
+	for (ix = 0; ix < blk->count; ix++) {
+	    if (packetID[ix] > 0) {
+		an->seedID = packetID[ix] - 1;
+		break;
+	    }
+	}
+    }
+    analyze_parallel(an, analyze_maxid);
+    int64_t maxID = an->seedID;
+    for (t = 0; t < an->threads; t++) {
+	an->chunks[t].seedID = maxID;
+	if (an->chunks[t].maxID > maxID)
+	    maxID = an->chunks[t].maxID;
+    }
+    if ((an->intervals = (struct analyze_interval *) calloc(an->bincnt, sizeof(struct analyze_interval))) == NULL) {
+	fprintf(stderr, "Out of Memory!!\n");
+	goto out;
+    }
+    analyze_parallel(an, analyze_phase3);
+    memset(&total, 0, sizeof(struct analyze_interval));
+    analyze_phase4(an, &total);
+    for (ix = 0; ix < an->bincnt; ix++) {
+	struct analyze_interval *iv = &an->intervals[ix];
+	total.records += iv->records;
+	total.bytes += iv->bytes;
+	total.lost += iv->lost;
+	total.outoforder += iv->outoforder;
+	total.l2errors += iv->l2errors;
+	if (iv->lastTime > total.lastTime)
+	    total.lastTime = iv->lastTime;
+    }
+    fprintf(stdout, "%s: id=%d %s %s records=%" PRIu64 " threads=%d%s%s\n", an->filename, an->reader->hdr->transferID, \
+	    (an->udp ? "udp" : "tcp"), (an->server ? "server" : "client"), an->records, an->threads, \
+	    (an->batch ? " kernel=" : ""), (an->batch ? transit_kernel_name() : ""));
+    double end = (total.lastTime - an->start) / 1e6;
+    if (an->interval) {
+	int64_t prevID = an->seedID;
+	double jitter = 0;
+	for (ix = 0; ix < an->bincnt; ix++) {
+	    struct analyze_interval *iv = &an->intervals[ix];
+	    double iStart = (double) (ix * an->interval) / 1e6;
+	    double iEnd = (ix == (an->bincnt - 1)) ? end : ((double) ((ix + 1) * an->interval) / 1e6);
+	    // jitter carries over empty intervals
+	    if (!iv->cntTransit)
+		iv->jitter = jitter;
+	    jitter = iv->jitter;
+	    if (!iv->maxID)
+		iv->maxID = prevID;
+	    analyze_output(an, iv, iStart, iEnd, (intmax_t) (iv->maxID - prevID));
+	    prevID = iv->maxID;
+	}
+    }
+    if (an->pctcnt && total.cntTransit) {
+	analyze_parallel(an, analyze_phase5);
+	for (t = 0; t < an->pctcnt; t++) {
+	    uint64_t rank = (uint64_t) ceil(an->pcts[t] / 100.0 * total.cntTransit);
+	    total.pct[t] = analyze_select(an, (rank ? rank : 1), total.minTransit, total.maxTransit);
+	}
+    }
+    analyze_output(an, &total, 0.0, end, (intmax_t) (maxID - an->seedID));
+    if (an->udp && an->server) {
+	for (t = 1; t < an->threads; t++) {
+	    int k;
+	    for (k = 0; k < ANALYZE_RUNBINS; k++) {
+		an->chunks[0].lossruns[k] += an->chunks[t].lossruns[k];
+		an->chunks[0].reorder[k] += an->chunks[t].reorder[k];
+	    }
+	    an->chunks[0].reorder[ANALYZE_RUNBINS] += an->chunks[t].reorder[ANALYZE_RUNBINS];
+	    if (an->chunks[t].maxlossrun > an->chunks[0].maxlossrun)
+		an->chunks[0].maxlossrun = an->chunks[t].maxlossrun;
+	    if (an->chunks[t].maxreorder > an->chunks[0].maxreorder)
+		an->chunks[0].maxreorder = an->chunks[t].maxreorder;
+	}
+	analyze_runs_output(an, "loss runs", an->chunks[0].lossruns, 0, an->chunks[0].maxlossrun);
+	analyze_runs_output(an, "reorder distance", an->chunks[0].reorder, 1, an->chunks[0].maxreorder);
+    }
+    rc = 0;
+  out:
+    if (an->intervals)
+	free(an->intervals);
+    if (an->transit)
+	free(an->transit);
+    if (an->bin)
+	free(an->bin);
+    an->intervals = NULL;
+    an->transit = NULL;
+    an->bin = NULL;
+    packet_trace_reader_close(an->reader);
+    return rc;
+}
+
+int main (int argc, char **argv) {
+    struct analyze *an = (struct analyze *) calloc(1, sizeof(struct analyze));
+    int c, rc = 0;
+    int64_t start = 0;
+    if (!an) {
+	fprintf(stderr, "Out of Memory!!\n");
+	return 1;
+    }
+#ifdef _SC_NPROCESSORS_ONLN
+    an->threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    an->pctcnt = 3;
+    an->pcts[0] = 50;
+    an->pcts[1] = 90;
+    an->pcts[2] = 99;
+    while ((c = getopt(argc, argv, "fi:t:p:s:")) != -1) {
+	switch (c) {
+	case 'f':
+	    an->batch = 1;
+	    break;
+	case 'i':
+	    an->interval = (int64_t) (atof(optarg) * 1e6 + 0.5);
+	    break;
+	case 't':
+	    an->threads = atoi(optarg);
+	    break;
+	case 'p':
+	{
+	    char *results = strtok(optarg, ",");
+	    an->pctcnt = 0;
+	    while (results && (an->pctcnt < ANALYZE_MAXPCTS)) {
+		double pct = atof(results);
+		if ((pct > 0) && (pct <= 100))
+		    an->pcts[an->pctcnt++] = pct;
+		results = strtok(NULL, ",");
+	    }
+	}
+	    break;
+	case 's':
+	    start = (int64_t) (atof(optarg) * 1e6 + 0.5);
+	    break;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind >= argc) {
+	usage();
+	return 1;
+    }
+    if (an->threads < 1)
+	an->threads = 1;
+    if (an->threads > ANALYZE_MAXTHREADS)
+	an->threads = ANALYZE_MAXTHREADS;
+    for (; optind < argc; optind++) {
+	an->filename = argv[optind];
+	an->start = start;
+	rc |= analyze_file(an);
+    }
+    free(an);
+    return rc;
+}
@@ -0,0 +1,163 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * tracedump.c
+ * Decode and summarize a --trace-file per packet capture
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "packet_trace.h"
+
+#define TRACEDUMP_USECS 1e-6
+
+static void usage (void) {
+    fprintf(stderr, "Usage: tracedump [-d] [-n count] <tracefile> [<tracefile> ...]\n"
+	    "  -d        dump every record as csv, i.e. packetid,sent,received,transit,length,frameid,l2errors\n"
+	    "  -n count  limit the dump to count records\n");
+}
+
+static int tracedump (const char *filename, int dump, intmax_t dumpcnt) {
+    struct PacketTraceReader *reader = packet_trace_reader_open(filename);
+    if (!reader)
+	return 1;
+    struct packet_trace_hdr *hdr = reader->hdr;
+    int udp = (hdr->flags & PACKETTRACE_UDP);
+    int server = (hdr->flags & PACKETTRACE_SERVER);
+    intmax_t records = 0, bytes = 0, l2errors = 0;
+    intmax_t lost = 0, outoforder = 0, cntTransit = 0;
+    int64_t nextID = 0, firstTime = 0, lastTime = 0;
+    double minTransit = 0, maxTransit = 0, sumTransit = 0;
+    uint32_t blkix, ix;
+    for (blkix = 0; blkix < reader->blockcnt; blkix++) {
+	struct packet_trace_block *blk = reader->blocks[blkix];
+	uint32_t n = hdr->blocksize;
+	int64_t *packetID = PACKETTRACE_PACKETID(blk, n);
+	int64_t *sentTime = PACKETTRACE_SENTTIME(blk, n);
+	int64_t *packetTime = PACKETTRACE_PACKETTIME(blk, n);
+	int64_t *frameID = PACKETTRACE_FRAMEID(blk, n);
+	int32_t *length = PACKETTRACE_LENGTH(blk, n);
+	int32_t *l2err = PACKETTRACE_L2ERRORS(blk, n);
+	for (ix = 0; ix < blk->count; ix++) {
+	    double transit = 0;
+	    if (!records || (packetTime[ix] < firstTime))
+		firstTime = packetTime[ix];
+	    if (packetTime[ix] > lastTime)
+		lastTime = packetTime[ix];
+	    records++;
+	    bytes += length[ix];
+	    l2errors += l2err[ix];
+	    // same sequence accounting as the server's udp packet handler
+	    if (udp && (packetID[ix] > 0)) {
+		if (!nextID || (packetID[ix] == nextID)) {
+		    nextID = packetID[ix] + 1;
+		} else if (packetID[ix] > nextID) {
+		    lost += packetID[ix] - nextID;
+		    nextID = packetID[ix] + 1;
+		} else {
+		    outoforder++;
+		    if (lost > 0)
+			lost--;
+		}
+	    }
+	    if (server && sentTime[ix]) {
+		transit = (packetTime[ix] - sentTime[ix]) * TRACEDUMP_USECS;
+		if (!cntTransit || (transit < minTransit))
+		    minTransit = transit;
+		if (!cntTransit || (transit > maxTransit))
+		    maxTransit = transit;
+		sumTransit += transit;
+		cntTransit++;
+	    }
+	    if (dump && (dumpcnt != 0)) {
+		fprintf(stdout, "%" PRIdMAX ",%" PRId64 ".%06" PRId64 ",%" PRId64 ".%06" PRId64 ",%.6f,%d,%" PRIdMAX ",%d\n", \
+			(intmax_t) packetID[ix], sentTime[ix] / 1000000, sentTime[ix] % 1000000, \
+			packetTime[ix] / 1000000, packetTime[ix] % 1000000, transit, length[ix], \
+			(intmax_t) frameID[ix], l2err[ix]);
+		if (dumpcnt > 0)
+		    dumpcnt--;
+	    }
+	}
+    }
+    double span = (lastTime - firstTime) * TRACEDUMP_USECS;
+    fprintf(stdout, "%s: id=%d %s %s%s blocks=%u/%u records=%" PRIdMAX " (%s)\n", filename, hdr->transferID, \
+	    (udp ? "udp" : "tcp"), (server ? "server" : "client"), ((hdr->flags & PACKETTRACE_ISOCH) ? " isoch" : ""), \
+	    reader->blockcnt, hdr->blockcnt, records, ((reader->blockcnt == hdr->blockcnt) && (hdr->seqno > hdr->blockcnt)) ? "wrapped" : "complete");
+    if (records) {
+	fprintf(stdout, "%s: span=%.6f sec bytes=%" PRIdMAX " rate=%.0f bits/sec", filename, span, bytes, \
+		((span > 0) ? (bytes * 8.0 / span) : 0.0));
+	if (udp)
+	    fprintf(stdout, " pps=%.0f lost=%" PRIdMAX " out-of-order=%" PRIdMAX, ((span > 0) ? (records / span) : 0.0), lost, outoforder);
+	if (l2errors)
+	    fprintf(stdout, " l2errors=%" PRIdMAX, l2errors);
+	fprintf(stdout, "\n");
+	if (cntTransit) {
+	    fprintf(stdout, "%s: transit min/avg/max=%.3f/%.3f/%.3f ms (%" PRIdMAX " samples)\n", filename, \
+		    minTransit * 1e3, (sumTransit / cntTransit) * 1e3, maxTransit * 1e3, cntTransit);
+	}
+    }
+    packet_trace_reader_close(reader);
+    return 0;
+}
+
+int main (int argc, char **argv) {
+    int c, dump = 0, rc = 0;
+    intmax_t dumpcnt = -1;
+    while ((c = getopt(argc, argv, "dn:")) != -1) {
+	switch (c) {
+	case 'd':
+	    dump = 1;
+	    break;
+	case 'n':
+	    dumpcnt = atoi(optarg);
+	    break;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind >= argc) {
+	usage();
+	return 1;
+    }
+    for (; optind < argc; optind++) {
+	rc |= tracedump(argv[optind], dump, dumpcnt);
+    }
+    return rc;
+}
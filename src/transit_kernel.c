@@ -0,0 +1,360 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * transit_kernel.c
+ * Batch transit statistics, see transit_kernel.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "transit_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRANSIT_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define TRANSIT_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Per packet, exactly as reporter_handle_packet_oneway_transit()
+void transit_kernel_scalar (const double *transit, size_t n, struct transit_stats *stats) {
+    size_t ix;
+    for (ix = 0; ix < n; ix++) {
+	double usec_transit = transit[ix] * 1e6;
+	if (stats->cntTransit == 0) {
+	    stats->minTransit = transit[ix];
+	    stats->maxTransit = transit[ix];
+	    stats->sumTransit = transit[ix];
+	    stats->cntTransit = 1;
+	    stats->meanTransit = usec_transit;
+	    stats->m2Transit = stats->flowstart ? (usec_transit * usec_transit) : 0;
+	    stats->flowstart = 0;
+	} else {
+	    double deltaTransit = transit[ix] - stats->lastTransit;
+	    double vdTransit;
+	    if (deltaTransit < 0.0) {
+		deltaTransit = -deltaTransit;
+	    }
+	    stats->jitter += (deltaTransit - stats->jitter) / (16.0);
+	    stats->sumTransit += transit[ix];
+	    stats->cntTransit++;
+	    if (transit[ix] < stats->minTransit) {
+		stats->minTransit = transit[ix];
+	    }
+	    if (transit[ix] > stats->maxTransit) {
+		stats->maxTransit = transit[ix];
+	    }
+	    vdTransit = usec_transit - stats->meanTransit;
+	    stats->meanTransit = stats->meanTransit + (vdTransit / stats->cntTransit);
+	    stats->m2Transit = stats->m2Transit + (vdTransit * (usec_transit - stats->meanTransit));
+	}
+	stats->lastTransit = transit[ix];
+    }
+}
+
+// The sequential part, RFC 1889 jitter, which the vector kernels share
+static inline void transit_kernel_jitter (const double *transit, size_t n, struct transit_stats *stats) {
+    double lastTransit = stats->lastTransit;
+    double jitter = stats->jitter;
+    size_t ix = 0;
+    if (stats->cntTransit == 0) {
+	lastTransit = transit[0];
+	ix = 1;
+    }
+    for (; ix < n; ix++) {
+	double deltaTransit = transit[ix] - lastTransit;
+	if (deltaTransit < 0.0) {
+	    deltaTransit = -deltaTransit;
+	}
+	jitter += (deltaTransit - jitter) / (16.0);
+	lastTransit = transit[ix];
+    }
+    stats->jitter = jitter;
+    stats->lastTransit = lastTransit;
+}
+
+// Merge a batch's min/max/sum/mean/m2 into the running stats (Chan et al.)
+static inline void transit_kernel_merge (struct transit_stats *stats, const double *transit, size_t n, double min, double max, double sum, double mean, double m2) {
+    if (stats->cntTransit == 0) {
+	stats->minTransit = min;
+	stats->maxTransit = max;
+	stats->sumTransit = sum;
+	stats->meanTransit = mean;
+	stats->m2Transit = m2;
+	stats->cntTransit = n;
+	if (stats->flowstart) {
+	    stats->m2Transit += (transit[0] * 1e6) * (transit[0] * 1e6);
+	    stats->flowstart = 0;
+	}
+    } else {
+	double cnt = (double) stats->cntTransit + n;
+	double delta = mean - stats->meanTransit;
+	if (min < stats->minTransit)
+	    stats->minTransit = min;
+	if (max > stats->maxTransit)
+	    stats->maxTransit = max;
+	stats->sumTransit += sum;
+	stats->meanTransit += delta * n / cnt;
+	stats->m2Transit += m2 + delta * delta * stats->cntTransit * n / cnt;
+	stats->cntTransit += n;
+    }
+}
+
+#ifdef TRANSIT_KERNEL_X86
+__attribute__((target("sse2")))
+static void transit_kernel_sse2 (const double *transit, size_t n, struct transit_stats *stats) {
+    size_t ix;
+    double min, max, sum, mean, m2;
+    double lanes[2];
+    if (n < 4) {
+	transit_kernel_scalar(transit, n, stats);
+	return;
+    }
+    transit_kernel_jitter(transit, n, stats);
+    __m128d vmin = _mm_loadu_pd(transit);
+    __m128d vmax = vmin;
+    __m128d vsum = _mm_setzero_pd();
+    for (ix = 0; (ix + 2) <= n; ix += 2) {
+	__m128d v = _mm_loadu_pd(transit + ix);
+	vmin = _mm_min_pd(vmin, v);
+	vmax = _mm_max_pd(vmax, v);
+	vsum = _mm_add_pd(vsum, v);
+    }
+    _mm_storeu_pd(lanes, vmin);
+    min = (lanes[1] < lanes[0]) ? lanes[1] : lanes[0];
+    _mm_storeu_pd(lanes, vmax);
+    max = (lanes[1] > lanes[0]) ? lanes[1] : lanes[0];
+    _mm_storeu_pd(lanes, vsum);
+    sum = lanes[0] + lanes[1];
+    for (; ix < n; ix++) {
+	if (transit[ix] < min)
+	    min = transit[ix];
+	if (transit[ix] > max)
+	    max = transit[ix];
+	sum += transit[ix];
+    }
+    // second pass for m2, working units are microseconds
+    mean = sum * 1e6 / n;
+    __m128d vmean = _mm_set1_pd(mean);
+    __m128d vusec = _mm_set1_pd(1e6);
+    __m128d vm2 = _mm_setzero_pd();
+    for (ix = 0; (ix + 2) <= n; ix += 2) {
+	__m128d d = _mm_sub_pd(_mm_mul_pd(_mm_loadu_pd(transit + ix), vusec), vmean);
+	vm2 = _mm_add_pd(vm2, _mm_mul_pd(d, d));
+    }
+    _mm_storeu_pd(lanes, vm2);
+    m2 = lanes[0] + lanes[1];
+    for (; ix < n; ix++) {
+	double d = transit[ix] * 1e6 - mean;
+	m2 += d * d;
+    }
+    transit_kernel_merge(stats, transit, n, min, max, sum, mean, m2);
+}
+
+__attribute__((target("avx2")))
+static void transit_kernel_avx2 (const double *transit, size_t n, struct transit_stats *stats) {
+    size_t ix;
+    double min, max, sum, mean, m2;
+    double lanes[4];
+    int k;
+    if (n < 8) {
+	transit_kernel_scalar(transit, n, stats);
+	return;
+    }
+    transit_kernel_jitter(transit, n, stats);
+    __m256d vmin = _mm256_loadu_pd(transit);
+    __m256d vmax = vmin;
+    __m256d vsum0 = _mm256_setzero_pd();
+    __m256d vsum1 = _mm256_setzero_pd();
+    for (ix = 0; (ix + 8) <= n; ix += 8) {
+	__m256d v0 = _mm256_loadu_pd(transit + ix);
+	__m256d v1 = _mm256_loadu_pd(transit + ix + 4);
+	vmin = _mm256_min_pd(vmin, _mm256_min_pd(v0, v1));
+	vmax = _mm256_max_pd(vmax, _mm256_max_pd(v0, v1));
+	vsum0 = _mm256_add_pd(vsum0, v0);
+	vsum1 = _mm256_add_pd(vsum1, v1);
+    }
+    _mm256_storeu_pd(lanes, vmin);
+    min = lanes[0];
+    for (k = 1; k < 4; k++) {
+	if (lanes[k] < min)
+	    min = lanes[k];
+    }
+    _mm256_storeu_pd(lanes, vmax);
+    max = lanes[0];
+    for (k = 1; k < 4; k++) {
+	if (lanes[k] > max)
+	    max = lanes[k];
+    }
+    _mm256_storeu_pd(lanes, _mm256_add_pd(vsum0, vsum1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; ix < n; ix++) {
+	if (transit[ix] < min)
+	    min = transit[ix];
+	if (transit[ix] > max)
+	    max = transit[ix];
+	sum += transit[ix];
+    }
+    // second pass for m2, working units are microseconds
+    mean = sum * 1e6 / n;
+    __m256d vmean = _mm256_set1_pd(mean);
+    __m256d vusec = _mm256_set1_pd(1e6);
+    __m256d vm2 = _mm256_setzero_pd();
+    for (ix = 0; (ix + 4) <= n; ix += 4) {
+	__m256d d = _mm256_sub_pd(_mm256_mul_pd(_mm256_loadu_pd(transit + ix), vusec), vmean);
+	vm2 = _mm256_add_pd(vm2, _mm256_mul_pd(d, d));
+    }
+    _mm256_storeu_pd(lanes, vm2);
+    m2 = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; ix < n; ix++) {
+	double d = transit[ix] * 1e6 - mean;
+	m2 += d * d;
+    }
+    transit_kernel_merge(stats, transit, n, min, max, sum, mean, m2);
+}
+#endif
+
+#ifdef TRANSIT_KERNEL_NEON
+static void transit_kernel_neon (const double *transit, size_t n, struct transit_stats *stats) {
+    size_t ix;
+    double min, max, sum, mean, m2;
+    if (n < 4) {
+	transit_kernel_scalar(transit, n, stats);
+	return;
+    }
+    transit_kernel_jitter(transit, n, stats);
+    float64x2_t vmin = vld1q_f64(transit);
+    float64x2_t vmax = vmin;
+    float64x2_t vsum = vdupq_n_f64(0.0);
+    for (ix = 0; (ix + 2) <= n; ix += 2) {
+	float64x2_t v = vld1q_f64(transit + ix);
+	vmin = vminq_f64(vmin, v);
+	vmax = vmaxq_f64(vmax, v);
+	vsum = vaddq_f64(vsum, v);
+    }
+    min = vminvq_f64(vmin);
+    max = vmaxvq_f64(vmax);
+    sum = vgetq_lane_f64(vsum, 0) + vgetq_lane_f64(vsum, 1);
+    for (; ix < n; ix++) {
+	if (transit[ix] < min)
+	    min = transit[ix];
+	if (transit[ix] > max)
+	    max = transit[ix];
+	sum += transit[ix];
+    }
+    // second pass for m2, working units are microseconds
+    mean = sum * 1e6 / n;
+    float64x2_t vmean = vdupq_n_f64(mean);
+    float64x2_t vm2 = vdupq_n_f64(0.0);
+    for (ix = 0; (ix + 2) <= n; ix += 2) {
+	float64x2_t d = vsubq_f64(vmulq_n_f64(vld1q_f64(transit + ix), 1e6), vmean);
+	vm2 = vfmaq_f64(vm2, d, d);
+    }
+    m2 = vgetq_lane_f64(vm2, 0) + vgetq_lane_f64(vm2, 1);
+    for (; ix < n; ix++) {
+	double d = transit[ix] * 1e6 - mean;
+	m2 += d * d;
+    }
+    transit_kernel_merge(stats, transit, n, min, max, sum, mean, m2);
+}
+#endif
+
+int transit_kernel_list (transit_kernel_fn *kernels, const char **names, int max) {
+    int cnt = 0;
+#ifdef TRANSIT_KERNEL_X86
+    __builtin_cpu_init();
+    if ((cnt < max) && __builtin_cpu_supports("avx2")) {
+	kernels[cnt] = transit_kernel_avx2;
+	names[cnt++] = "avx2";
+    }
+    if ((cnt < max) && __builtin_cpu_supports("sse2")) {
+	kernels[cnt] = transit_kernel_sse2;
+	names[cnt++] = "sse2";
+    }
+#endif
+#ifdef TRANSIT_KERNEL_NEON
+    if (cnt < max) {
+	kernels[cnt] = transit_kernel_neon;
+	names[cnt++] = "neon";
+    }
+#endif
+    if (cnt < max) {
+	kernels[cnt] = transit_kernel_scalar;
+	names[cnt++] = "scalar";
+    }
+    return cnt;
+}
+
+static transit_kernel_fn transit_kernel = NULL;
+static const char *transit_kernelname = NULL;
+#ifdef HAVE_POSIX_THREAD
+static pthread_once_t transit_kernel_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void transit_kernel_select (void) {
+    transit_kernel_fn kernels[1];
+    const char *names[1];
+    // The list is ordered best first
+    transit_kernel_list(kernels, names, 1);
+    transit_kernelname = names[0];
+    transit_kernel = kernels[0];
+}
+
+// Reporter and trace threads all dispatch through here, select only once
+static inline void transit_kernel_init (void) {
+#ifdef HAVE_POSIX_THREAD
+    pthread_once(&transit_kernel_once, transit_kernel_select);
+#else
+    if (!transit_kernel)
+	transit_kernel_select();
+#endif
+}
+
+void transit_kernel_batch (const double *transit, size_t n, struct transit_stats *stats) {
+    transit_kernel_init();
+    if (n)
+	(*transit_kernel)(transit, n, stats);
+}
+
+const char *transit_kernel_name (void) {
+    transit_kernel_init();
+    return transit_kernelname;
+}
@@ -0,0 +1,222 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2023
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * udp_demux.cpp
+ * Flow table and idle timer wheel for --udp-demux, see udp_demux.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "udp_demux.h"
+#include "SocketAddr.h"
+#include "util.h"
+
+// Hash of the peer address and port
+static uint32_t udp_demux_hash (iperf_sockaddr *peer) {
+    const unsigned char *addr = NULL;
+    size_t len = 0;
+    uint16_t port = 0;
+    uint32_t hash = 2166136261U; // FNV-1a
+    if (((struct sockaddr*)peer)->sa_family == AF_INET) {
+	addr = (const unsigned char *) &((struct sockaddr_in*)peer)->sin_addr.s_addr;
+	len = sizeof(struct in_addr);
+	port = ((struct sockaddr_in*)peer)->sin_port;
+    }
+#if defined(HAVE_IPV6)
+    else if (((struct sockaddr*)peer)->sa_family == AF_INET6) {
+	addr = ((struct sockaddr_in6*)peer)->sin6_addr.s6_addr;
+	len = sizeof(struct in6_addr);
+	port = ((struct sockaddr_in6*)peer)->sin6_port;
+    }
+#endif
+    for (size_t ix = 0; ix < len; ix++) {
+	hash ^= addr[ix];
+	hash *= 16777619U;
+    }
+    hash ^= port;
+    hash *= 16777619U;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+void udp_demux_table_init (struct UDPDemuxTable *table, struct thread_Settings *settings) {
+    table->settings = settings;
+    table->size = UDPDEMUX_MINSLOTS;
+    table->count = 0;
+    table->slots = (struct UDPDemuxFlow **) calloc(table->size, sizeof(struct UDPDemuxFlow *));
+    FAIL(table->slots == NULL, "Out of Memory!!\n", table->settings);
+}
+
+// The flows themselves are owned and freed by the caller
+void udp_demux_table_destroy (struct UDPDemuxTable *table) {
+    if (table->slots)
+	free(table->slots);
+    table->slots = NULL;
+    table->size = 0;
+    table->count = 0;
+}
+
+struct UDPDemuxFlow *udp_demux_lookup (struct UDPDemuxTable *table, iperf_sockaddr *peer) {
+    uint32_t hash = udp_demux_hash(peer);
+    int mask = table->size - 1;
+    int ix = (int) (hash & mask);
+    while (table->slots[ix] != NULL) {
+	struct UDPDemuxFlow *flow = table->slots[ix];
+	if ((flow->hash == hash) && SockAddr_are_Equal(&flow->peer, peer))
+	    return flow;
+	ix = (ix + 1) & mask;
+    }
+    return NULL;
+}
+
+static void udp_demux_place (struct UDPDemuxTable *table, struct UDPDemuxFlow *flow) {
+    int mask = table->size - 1;
+    int ix = (int) (flow->hash & mask);
+    while (table->slots[ix] != NULL) {
+	ix = (ix + 1) & mask;
+    }
+    table->slots[ix] = flow;
+}
+
+// Keep the load at or below 3/4 so probes stay short and always end
+void udp_demux_insert (struct UDPDemuxTable *table, struct UDPDemuxFlow *flow) {
+    flow->hash = udp_demux_hash(&flow->peer);
+    if ((table->count + 1) * 4 > table->size * 3) {
+	struct UDPDemuxFlow **old = table->slots;
+	int oldsize = table->size;
+	table->size = oldsize * 2;
+	table->slots = (struct UDPDemuxFlow **) calloc(table->size, sizeof(struct UDPDemuxFlow *));
+	FAIL(table->slots == NULL, "Out of Memory!!\n", table->settings);
+	for (int ix = 0; ix < oldsize; ix++) {
+	    if (old[ix] != NULL)
+		udp_demux_place(table, old[ix]);
+	}
+	free(old);
+    }
+    udp_demux_place(table, flow);
+    table->count++;
+}
+
+// Delete by shifting back later entries of the probe run, i.e. no tombstones
+void udp_demux_remove (struct UDPDemuxTable *table, struct UDPDemuxFlow *flow) {
+    int mask = table->size - 1;
+    int ix = (int) (flow->hash & mask);
+    while ((table->slots[ix] != NULL) && (table->slots[ix] != flow)) {
+	ix = (ix + 1) & mask;
+    }
+    if (table->slots[ix] == NULL)
+	return;
+    table->slots[ix] = NULL;
+    table->count--;
+    int next = (ix + 1) & mask;
+    while (table->slots[next] != NULL) {
+	int home = (int) (table->slots[next]->hash & mask);
+	if (((next - home) & mask) >= ((next - ix) & mask)) {
+	    table->slots[ix] = table->slots[next];
+	    table->slots[next] = NULL;
+	    ix = next;
+	}
+	next = (next + 1) & mask;
+    }
+}
+
+static inline long udp_demux_wheel_tick (struct UDPDemuxWheel *wheel, struct timeval *when) {
+    long usecs = ((long) (when->tv_sec - wheel->start.tv_sec) * 1000000L) + (when->tv_usec - wheel->start.tv_usec);
+    return ((usecs > 0) ? (usecs / UDPDEMUX_WHEELTICK) : 0);
+}
+
+void udp_demux_wheel_init (struct UDPDemuxWheel *wheel, struct timeval *now) {
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+    wheel->start = *now;
+    wheel->tick = 0;
+}
+
+// A due time past the wheel's span lands in a slot that comes up early,
+// the flow is then just rescheduled by the caller
+void udp_demux_wheel_schedule (struct UDPDemuxWheel *wheel, struct UDPDemuxFlow *flow, struct timeval *due) {
+    flow->expire = udp_demux_wheel_tick(wheel, due);
+    if (flow->expire <= wheel->tick)
+	flow->expire = wheel->tick + 1;
+    struct UDPDemuxFlow **slot = &wheel->slots[flow->expire & (UDPDEMUX_WHEELSLOTS - 1)];
+    flow->wheel_prev = NULL;
+    flow->wheel_next = *slot;
+    if (*slot)
+	(*slot)->wheel_prev = flow;
+    *slot = flow;
+}
+
+void udp_demux_wheel_cancel (struct UDPDemuxWheel *wheel, struct UDPDemuxFlow *flow) {
+    if (flow->wheel_prev) {
+	flow->wheel_prev->wheel_next = flow->wheel_next;
+    } else {
+	struct UDPDemuxFlow **slot = &wheel->slots[flow->expire & (UDPDEMUX_WHEELSLOTS - 1)];
+	if (*slot == flow)
+	    *slot = flow->wheel_next;
+    }
+    if (flow->wheel_next)
+	flow->wheel_next->wheel_prev = flow->wheel_prev;
+    flow->wheel_next = NULL;
+    flow->wheel_prev = NULL;
+}
+
+// Unlink and return (chained by wheel_next) the flows of the slots that
+// came due since the last call
+struct UDPDemuxFlow *udp_demux_wheel_advance (struct UDPDemuxWheel *wheel, struct timeval *now) {
+    struct UDPDemuxFlow *due = NULL;
+    long tick = udp_demux_wheel_tick(wheel, now);
+    if ((tick - wheel->tick) > UDPDEMUX_WHEELSLOTS)
+	wheel->tick = tick - UDPDEMUX_WHEELSLOTS;
+    while (wheel->tick < tick) {
+	wheel->tick++;
+	struct UDPDemuxFlow **slot = &wheel->slots[wheel->tick & (UDPDEMUX_WHEELSLOTS - 1)];
+	struct UDPDemuxFlow *flow = *slot;
+	*slot = NULL;
+	while (flow) {
+	    struct UDPDemuxFlow *next = flow->wheel_next;
+	    flow->wheel_prev = NULL;
+	    flow->wheel_next = due;
+	    due = flow;
+	    flow = next;
+	}
+    }
+    return due;
+}
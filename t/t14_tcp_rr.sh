@@ -0,0 +1,16 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -P 1 -i 1 -t 3     \
+    -c $ip -P 1 --tcp-rr 100,1k,4 -i 1 -t 2
+
+[[ "$results" =~ trans/sec\(f\) ]]
+# a thread's intervals are all output ahead of its final
+awk '/trans\/sec/ { id = $2; if (/\(f\)/) done[id] = 1; else if (done[id]) late = 1 } END { exit late }' <<< "$results"
@@ -0,0 +1,19 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -u -P 1 -i 1 -t 3  \
+    -c $ip -u -P 1 --udp-echo -b 1000pps -i 1 -t 2
+
+[[ "$results" =~ echoes/sec\(f\) ]]
+# the test header is echoed too and counts as a probe, echoes never exceed probes
+while read echoes probes; do
+    (( echoes <= probes ))
+done < <(grep -o 'echoes/probes=[0-9]*/[0-9]*' <<< "$results" | tr '=/' '  ' | cut -d' ' -f3,4)
+[[ "$results" =~ echoes/probes=[0-9]+/[0-9]+ ]]
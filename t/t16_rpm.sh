@@ -0,0 +1,17 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 5  \
+    -c $ip -P 2 --rpm=tcp,100,1 -i 1 -t 2
+
+[[ "$results" =~ RPM\(idle/loaded\) ]]
+# with the final sum and on the probe's clock, the load starts after the 1 second idle
+[[ "$results" =~ \[SUM\]\ 1\.00-3\.0[0-9]\ sec\ +RPM\(idle/loaded\)=[0-9]+/[0-9]+ ]]
+[[ "$results" =~ \[SUM\]\ 1\.00-2\.00\ sec ]]
@@ -0,0 +1,20 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 4  \
+    -c $ip --flows lognormal:20K,40K -b 100m --flow-load 0.3 --flow-pool 2 -i 1 -t 2
+
+[[ "$results" =~ "flow completion times per flow size" ]]
+# loopback is faster than -b, the base rtt must still come out and the
+# ideal fcts use the rate the flows ran at, with a warning
+[[ "$results" =~ base\ rtt=[0-9]+\.[0-9]+\ ms ]]
+[[ ! "$results" =~ base\ rtt=0\.000\  ]]
+[[ "$results" =~ WARNING:\ flows\ ran\ at\ up\ to\ [0-9]+\ Mbits/sec,\ above\ the\ -b\ link\ rate ]]
+[[ "$results" =~ slowdown\(avg/50/99\)=[1-9] ]]
@@ -0,0 +1,32 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+scenario=$(mktemp)
+trap "rm -f $scenario" EXIT
+cat > $scenario <<END
+# a bulk group and a rate limited group starting a second later
+[bulk]
+options = -P 2
+duration = 2
+
+[paced]
+options = -b 10m
+start = 1
+duration = 1
+END
+
+run_iperf    \
+    -s -i 1 -t 4  \
+    -c $ip --scenario $scenario -i 1
+
+[[ "$results" =~ "[paced] scenario group starts at 1.00 sec" ]]
+[[ "$results" =~ "[bulk] 0.00-2" ]]
+[[ "$results" =~ "[SUM] 1.00-2.00 sec" ]]
+# the group sums and their flows are on the scenario's clock too
+[[ "$results" =~ "[paced] 1.00-2.00 sec" ]]
@@ -0,0 +1,14 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 3 --affinity 0 \
+    -c $ip -i 1 -t 1 -P 2 --affinity 0 --reporter-affinity 0
+
+[[ "$results" =~ "CPU affinity: traffic threads round robin on cpus 0, reporter on cpus 0" ]]
@@ -0,0 +1,21 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 3 -e --incoming-cpu \
+    -c $ip -i 1 -t 1 -P 2
+
+[[ "$results" =~ connected\ with.*\(cpu\ [0-9]+ ]]
+
+# UDP flows find their cpu in the first reads, the reporter prints it
+run_iperf    \
+    -s -u -i 1 -t 3 -e --incoming-cpu \
+    -c $ip -u -i 1 -t 1
+
+[[ "$results" =~ Flow\ received\ on\ cpu\ [0-9]+.*,\ server\ thread\ (pinned\ to\ it|not\ pinned) ]]
@@ -0,0 +1,14 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 3 --busy-poll=20,spin \
+    -c $ip -i 1 -t 1 --tcp-rr 100
+
+[[ "$results" =~ Busy\ poll\ 20\ us\ and\ spin:\ [0-9.]+\ sec\ spinning ]]
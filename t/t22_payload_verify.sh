@@ -0,0 +1,19 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s -i 1 -t 3 \
+    -c $ip -i 1 -t 1 -l 1000 --payload-verify
+
+[[ "$results" =~ Payload\ verify\ detected\ errors\ in\ 0\ of\ [1-9][0-9]*\ reads ]]
+
+# a corrupted or misplaced read is detected, per the check program (--enable-checkprograms)
+if [[ -x src/checkpayloadverify ]]; then
+    src/checkpayloadverify -n 2000 | grep -q ": match$"
+fi
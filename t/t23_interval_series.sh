@@ -0,0 +1,17 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+# 100 usec intervals must not back up the reporter past the end of the test
+run_iperf    \
+    -s -i 1 -t 3 \
+    -c $ip -i 0.0001 -t 1 --interval-series
+
+[[ "$results" =~ Interval\ series\ of\ [1-9][0-9]*\ samples ]]
+[[ "$results" =~ 0\.0000-0\.0001\ sec ]]
+[[ "$results" =~ 0\.00-1\.0[0-9]\ sec ]]
@@ -0,0 +1,39 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# Reordered packets must not be counted as loss runs.  The iperf
+# client has no way to reorder so send the datagrams from bash, ids
+# 10 and 20 arrive three packets late and 30 is lost.
+
+# one datagram, the 16 byte UDP header (id, sec, usec, id2) and padding,
+# dd makes it a single write as printf flushes at each newline byte
+send() {
+    local now=$EPOCHREALTIME hdr= b i
+    for i in $1 ${now%.*} $((10#${now#*.})) $(( $1 < 0 ? -1 : 0 )); do
+	printf -v b '%08x' $(( i & 0xffffffff ))
+	hdr+="\\x${b:0:2}\\x${b:2:2}\\x${b:4:2}\\x${b:6:2}"
+    done
+    printf "$hdr$pad" | dd iflag=fullblock bs=116 count=1 status=none >&3
+}
+
+sender() {
+    pad=$(printf '\\x00%.0s' {1..100})
+    exec 3<>/dev/udp/$ip/$port
+    for id in $(seq 1 60 | sed -e '/^\(10\|20\|30\)$/d' -e 's/^\([12]\)3$/&\n\10/'); do
+	send $id
+    done
+    # final packet, repeated as the client would
+    for k in 1 2 3; do
+	send -61
+	sleep 0.1
+    done
+}
+
+results=$(src/iperf -p $port -s -u -e -t 2 2>&1 | {
+	awk '{print};/listening/{exit 0}';
+	sender; cat;
+    } 2>&1 | tee /dev/stderr)
+
+[[ "$results" =~ 1/61\ \( ]]
+[[ "$results" =~ 2\ late ]]
+[[ "$results" =~ 1\ loss\ runs\ avg/max\ 1\.0/1\  ]]